@@ -0,0 +1,684 @@
+#include <catch2/catch_all.hpp>
+#include <vector3d.h>
+#include <vector3darray.h>
+#include <rotation3d.h>
+#include <quaternion.h>
+#include <transform3d.h>
+#include <vector3dsort.h>
+#include <vector3dexpr.h>
+#include <vector3dindex.h>
+#include <vector3dfile.h>
+#include <vector3dtext.h>
+#include <vector3dweld.h>
+#include <vector3dstream.h>
+#include <vector3dcurve.h>
+#include <vector3dmesh.h>
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+   struct Workload
+   {
+      std::size_t items;
+      std::size_t bytes;
+   };
+
+   struct Result
+   {
+      std::string name;
+      Workload workload;
+      double mean;
+      double deviation;
+      std::size_t samples;
+   };
+
+   std::string jsonPath;
+   std::size_t maxSize=std::size_t(1)<<22;
+   Workload currentWorkload={1,0};
+   std::vector<Result> results;
+
+   /**
+    * @brief Input sizes from L1 resident to well past the last level cache, 24 bytes per vector
+    */
+   std::vector<std::size_t> sizes(std::size_t limit=std::size_t(-1))
+   {
+      std::vector<std::size_t> list;
+      for(std::size_t size : {std::size_t(1)<<10,std::size_t(1)<<14,std::size_t(1)<<18,std::size_t(1)<<22})
+      {
+         if(size<=maxSize && size<=limit) list.push_back(size);
+      }
+      return list;
+   }
+
+   std::vector<Vector3D> randomVectors(std::size_t count, unsigned seed)
+   {
+      std::mt19937 generator(seed);
+      std::uniform_real_distribution<double> distribution(-50.0,50.0);
+      std::vector<Vector3D> vectors(count);
+      for(Vector3D &vector : vectors) vector=Vector3D(distribution(generator),distribution(generator),distribution(generator));
+      return vectors;
+   }
+
+   /**
+    * @brief Sets the work done by the next benchmark, so the listener can derive ns/op, throughput and GB/s
+    */
+   std::string workload(const std::string &name, std::size_t size, std::size_t bytesPerItem)
+   {
+      currentWorkload={size,size*bytesPerItem};
+      return name+"/"+std::to_string(size);
+   }
+
+   std::string escape(const std::string &text)
+   {
+      std::string result;
+      for(char c : text)
+      {
+         if(c=='"' || c=='\\') result+='\\';
+         result+=c;
+      }
+      return result;
+   }
+
+   void writeJson(std::ostream &out)
+   {
+      out << std::setprecision(9);
+      out << "{\n  \"instruction_set\": \"" << Vector3DBatch::instructionSetName(Vector3DBatch::instructionSet()) << "\",\n  \"benchmarks\": [\n";
+      for(std::size_t i=0;i<results.size();i++)
+      {
+         const Result &result=results[i];
+         double seconds=result.mean*1.0e-9;
+         out << "    {\"name\": \"" << escape(result.name) << "\", \"items\": " << result.workload.items << ", \"bytes\": " << result.workload.bytes
+             << ", \"samples\": " << result.samples << ", \"mean_ns\": " << result.mean << ", \"stddev_ns\": " << result.deviation
+             << ", \"ns_per_op\": " << result.mean/static_cast<double>(result.workload.items)
+             << ", \"items_per_second\": " << static_cast<double>(result.workload.items)/seconds
+             << ", \"gb_per_second\": " << static_cast<double>(result.workload.bytes)/seconds*1.0e-9 << "}" << (i+1<results.size() ? ",\n" : "\n");
+      }
+      out << "  ]\n}\n";
+   }
+}
+
+/**
+ * @brief Collects every benchmark result, prints the derived metrics and writes them as JSON when --json is given
+ */
+class BenchmarkMetrics : public Catch::EventListenerBase
+{
+   public:
+      using Catch::EventListenerBase::EventListenerBase;
+
+      void benchmarkEnded(const Catch::BenchmarkStats<> &stats) override
+      {
+         results.push_back({stats.info.name,currentWorkload,stats.mean.point.count(),stats.standardDeviation.point.count(),stats.samples.size()});
+      }
+
+      void testRunEnded(const Catch::TestRunStats &) override
+      {
+         if(results.empty()) return;
+         std::cout << "\n" << std::left << std::setw(40) << "benchmark" << std::right << std::setw(12) << "ns/op" << std::setw(14) << "Mop/s" << std::setw(10) << "GB/s" << "\n";
+         std::cout << std::fixed << std::setprecision(3);
+         for(const Result &result : results)
+         {
+            double seconds=result.mean*1.0e-9;
+            std::cout << std::left << std::setw(40) << result.name << std::right << std::setw(12) << result.mean/static_cast<double>(result.workload.items)
+                      << std::setw(14) << static_cast<double>(result.workload.items)/seconds*1.0e-6 << std::setw(10) << static_cast<double>(result.workload.bytes)/seconds*1.0e-9 << "\n";
+         }
+         std::cout.unsetf(std::ios::floatfield);
+         if(jsonPath.empty()) return;
+         std::ofstream file(jsonPath);
+         writeJson(file);
+      }
+};
+
+CATCH_REGISTER_LISTENER(BenchmarkMetrics)
+
+TEST_CASE("Scalar methods","[scalar]")
+{
+   Vector3D axis(48.561,23.648,36.697),point(-6.250,-35.281,36.325);
+   constexpr std::size_t vectorBytes=sizeof(Vector3D);
+
+   for(std::size_t size : sizes())
+   {
+      std::vector<Vector3D> vectors=randomVectors(size,1),others=randomVectors(size,2),results(size);
+
+      BENCHMARK(workload("length",size,vectorBytes))
+      {
+         double sum=0.0;
+         for(const Vector3D &vector : vectors) sum+=vector.length();
+         return sum;
+      };
+
+      BENCHMARK(workload("lengthSquared",size,vectorBytes))
+      {
+         double sum=0.0;
+         for(const Vector3D &vector : vectors) sum+=vector.lengthSquared();
+         return sum;
+      };
+
+      BENCHMARK(workload("distance",size,vectorBytes))
+      {
+         double sum=0.0;
+         for(const Vector3D &vector : vectors) sum+=vector.distance(point);
+         return sum;
+      };
+
+      BENCHMARK(workload("angle",size,vectorBytes))
+      {
+         double sum=0.0;
+         for(const Vector3D &vector : vectors) sum+=vector.angle(point);
+         return sum;
+      };
+
+      BENCHMARK(workload("angle.fast",size,vectorBytes))
+      {
+         double sum=0.0;
+         for(const Vector3D &vector : vectors) sum+=vector.angle(point,Vector3D::Radians,Vector3D::Fast);
+         return sum;
+      };
+
+      BENCHMARK(workload("isZero",size,vectorBytes))
+      {
+         std::size_t count=0;
+         for(const Vector3D &vector : vectors) count+=vector.isZero();
+         return count;
+      };
+
+      BENCHMARK(workload("isNaN",size,vectorBytes))
+      {
+         std::size_t count=0;
+         for(const Vector3D &vector : vectors) count+=vector.isNaN();
+         return count;
+      };
+
+      BENCHMARK(workload("operator<",size,2*vectorBytes))
+      {
+         std::size_t count=0;
+         for(std::size_t i=0;i<size;i++) count+=vectors[i]<others[i];
+         return count;
+      };
+
+      BENCHMARK(workload("operator+",size,3*vectorBytes))
+      {
+         for(std::size_t i=0;i<size;i++) results[i]=vectors[i]+others[i];
+         return results.back().x();
+      };
+
+      BENCHMARK(workload("operator*",size,2*vectorBytes))
+      {
+         for(std::size_t i=0;i<size;i++) results[i]=vectors[i]*1.5;
+         return results.back().x();
+      };
+
+      BENCHMARK(workload("operator/",size,2*vectorBytes))
+      {
+         for(std::size_t i=0;i<size;i++) results[i]=vectors[i]/1.5;
+         return results.back().x();
+      };
+
+      BENCHMARK(workload("setLength",size,2*vectorBytes))
+      {
+         for(Vector3D &vector : vectors) vector.setLength(10.0);
+         return vectors.back().x();
+      };
+
+      BENCHMARK(workload("setLength.fast",size,2*vectorBytes))
+      {
+         for(Vector3D &vector : vectors) vector.setLength(10.0,Vector3D::Fast);
+         return vectors.back().x();
+      };
+
+      BENCHMARK(workload("rotate",size,2*vectorBytes))
+      {
+         for(Vector3D &vector : vectors) vector.rotate(axis,0.3);
+         return vectors.back().x();
+      };
+
+      BENCHMARK(workload("rotate.fast",size,2*vectorBytes))
+      {
+         for(Vector3D &vector : vectors) vector.rotate(axis,0.3,Vector3D::Radians,Vector3D::Fast);
+         return vectors.back().x();
+      };
+
+      Rotation3D rotation(axis,0.3);
+      BENCHMARK(workload("Rotation3D::apply",size,2*vectorBytes))
+      {
+         for(Vector3D &vector : vectors) rotation.apply(vector);
+         return vectors.back().x();
+      };
+
+      Transform3D transform=Transform3D(rotation,1.0,point);
+      BENCHMARK(workload("Transform3D::apply",size,2*vectorBytes))
+      {
+         for(std::size_t i=0;i<size;i++) results[i]=transform*vectors[i];
+         return results.back().x();
+      };
+
+      BENCHMARK(workload("Vector3DExpr::assign",size,3*vectorBytes))
+      {
+         return Vector3DExpr::assign(results,Vector3DExpr::lazy(vectors)+Vector3DExpr::lazy(others)*1.5-point);
+      };
+   }
+
+   BENCHMARK(workload("Quaternion::operator*",1,0))
+   {
+      return (Quaternion(axis,0.3)*Quaternion(point,-1.2)).w();
+   };
+
+   BENCHMARK(workload("Quaternion::slerp",1,0))
+   {
+      return Quaternion::slerp(Quaternion(axis,0.3),Quaternion(point,-1.2),0.25).w();
+   };
+}
+
+TEST_CASE("Sorting","[scalar]")
+{
+   Vector3D point(-6.250,-35.281,36.325);
+   for(std::size_t size : sizes(std::size_t(1)<<18))
+   {
+      std::vector<Vector3D> vectors=randomVectors(size,3);
+
+      BENCHMARK_ADVANCED(workload("Vector3DSort::sortByLength",size,2*sizeof(Vector3D)))(Catch::Benchmark::Chronometer meter)
+      {
+         std::vector<std::vector<Vector3D>> copies(static_cast<std::size_t>(meter.runs()),vectors);
+         meter.measure([&](int run) { Vector3DSort::sortByLength(copies[run].begin(),copies[run].end()); });
+      };
+
+      BENCHMARK_ADVANCED(workload("Vector3DSort::nthElementByDistance",size,2*sizeof(Vector3D)))(Catch::Benchmark::Chronometer meter)
+      {
+         std::vector<std::vector<Vector3D>> copies(static_cast<std::size_t>(meter.runs()),vectors);
+         meter.measure([&](int run) { Vector3DSort::nthElementByDistance(copies[run].begin(),copies[run].begin()+size/2,copies[run].end(),point); });
+      };
+   }
+}
+
+TEST_CASE("Spatial index","[index]")
+{
+   for(std::size_t size : sizes(std::size_t(1)<<20))
+   {
+      std::vector<Vector3D> points=randomVectors(size,4),queries=randomVectors(1024,5);
+      Vector3DIndex index(points);
+      std::vector<Vector3DIndex::Neighbor> neighbors(queries.size()*8);
+
+      BENCHMARK(workload("Vector3DIndex::build",size,sizeof(Vector3D))) { return Vector3DIndex(points).size(); };
+      BENCHMARK(workload("Vector3DIndex::nearest/"+std::to_string(size),queries.size(),sizeof(Vector3D)))
+      {
+         std::size_t sum=0;
+         for(const Vector3D &query : queries) sum+=index.nearest(query).id;
+         return sum;
+      };
+      BENCHMARK(workload("Vector3DIndex::nearest8.batch/"+std::to_string(size),queries.size(),sizeof(Vector3D))) { return index.nearest(queries,8,neighbors); };
+      BENCHMARK(workload("Vector3DIndex::radius/"+std::to_string(size),queries.size(),sizeof(Vector3D)))
+      {
+         std::size_t sum=0;
+         for(const Vector3D &query : queries) sum+=index.radius(query,2.0).size();
+         return sum;
+      };
+   }
+}
+
+TEST_CASE("Batch methods","[batch]")
+{
+   Vector3D axis(48.561,23.648,36.697),point(-6.250,-35.281,36.325);
+   Rotation3D rotation(axis,0.3);
+   Transform3D transform=Transform3D(rotation,1.5,point);
+   Vector3DBatch::InstructionSet defaultSet=Vector3DBatch::instructionSet();
+
+   for(Vector3DBatch::InstructionSet set : {Vector3DBatch::Scalar,Vector3DBatch::SSE2,Vector3DBatch::AVX2,Vector3DBatch::AVX512})
+   {
+      if(!Vector3DBatch::setInstructionSet(set)) continue;
+      std::string prefix=std::string("batch/")+Vector3DBatch::instructionSetName(set)+"/";
+
+      for(std::size_t size : sizes())
+      {
+         std::vector<Vector3D> vectors=randomVectors(size,1),others=randomVectors(size,2);
+         Vector3DArray array1(vectors),array2(others),result(size);
+         std::vector<double> values(size);
+         std::vector<std::uint8_t> flags(size);
+         constexpr std::size_t vectorBytes=3*sizeof(double);
+
+         BENCHMARK(workload(prefix+"add",size,3*vectorBytes)) { return Vector3DBatch::add(array1,array2,result); };
+         BENCHMARK(workload(prefix+"subtract",size,3*vectorBytes)) { return Vector3DBatch::subtract(array1,array2,result); };
+         BENCHMARK(workload(prefix+"translate",size,2*vectorBytes)) { return Vector3DBatch::add(array1,point,result); };
+         BENCHMARK(workload(prefix+"scale",size,2*vectorBytes)) { return Vector3DBatch::scale(array1,1.5,result); };
+         BENCHMARK(workload(prefix+"rotate",size,2*vectorBytes)) { return Vector3DBatch::rotate(array1,rotation,result); };
+         BENCHMARK(workload(prefix+"transform",size,2*vectorBytes)) { return Vector3DBatch::transform(array1,transform,result); };
+         BENCHMARK(workload(prefix+"transform.parallel",size,2*vectorBytes)) { return Vector3DBatch::transform(Vector3DExecution::parallel(),array1,transform,result); };
+         BENCHMARK(workload(prefix+"rotate.aos",size,2*vectorBytes)) { return Vector3DBatch::rotate(vectors,rotation,others); };
+         BENCHMARK(workload(prefix+"length",size,vectorBytes+sizeof(double))) { return Vector3DBatch::length(array1,values); };
+         BENCHMARK(workload(prefix+"distance",size,vectorBytes+sizeof(double))) { return Vector3DBatch::distance(array1,point,values); };
+         BENCHMARK(workload(prefix+"angle",size,vectorBytes+sizeof(double))) { return Vector3DBatch::angle(array1,point,values); };
+         BENCHMARK(workload(prefix+"isZero",size,vectorBytes+1)) { return Vector3DBatch::isZero(array1,flags); };
+         BENCHMARK(workload(prefix+"isNaN",size,vectorBytes+1)) { return Vector3DBatch::isNaN(array1,flags); };
+         BENCHMARK(workload(prefix+"sum",size,vectorBytes)) { return Vector3DBatch::sum(array1); };
+         BENCHMARK(workload(prefix+"sum.compensated",size,vectorBytes)) { return Vector3DBatch::sum(array1,Vector3DBatch::Compensated); };
+         BENCHMARK(workload(prefix+"sum.pairwise",size,vectorBytes)) { return Vector3DBatch::sum(array1,Vector3DBatch::Pairwise); };
+         BENCHMARK(workload(prefix+"covariance",size,2*vectorBytes)) { std::array<double,9> matrix; Vector3DBatch::covariance(array1,matrix); return matrix[0]; };
+         BENCHMARK(workload(prefix+"boundingBox",size,vectorBytes)) { Vector3D minimum,maximum; Vector3DBatch::boundingBox(array1,minimum,maximum); return minimum; };
+         BENCHMARK(workload(prefix+"lengthRange",size,vectorBytes)) { double minimum,maximum; Vector3DBatch::lengthRange(array1,minimum,maximum); return maximum; };
+      }
+   }
+   Vector3DBatch::setInstructionSet(defaultSet);
+}
+
+TEST_CASE("Binary file","[file]")
+{
+   std::string path=(std::filesystem::temp_directory_path()/"vector3d_bench.v3d").string();
+   for(std::size_t size : sizes(std::size_t(1)<<22))
+   {
+      Vector3DArray array(Vector3DArrayConstView(randomVectors(size,6))),result(size);
+      std::size_t vectorBytes=3*sizeof(double);
+
+      BENCHMARK(workload("Vector3DFile::write",size,vectorBytes)) { return Vector3DFile::write(path,array); };
+      BENCHMARK(workload("Vector3DFile::open",size,0)) { return Vector3DFile(path).chunk(0).size(); };
+      Vector3DFile file(path);
+      BENCHMARK(workload("Vector3DFile::read",size,2*vectorBytes)) { return file.read(0,result); };
+      Vector3DFile::write(path,array,Vector3DFile::SoA,Vector3DFile::Float32);
+      Vector3DFile floats(path);
+      BENCHMARK(workload("Vector3DFile::read.float32",size,vectorBytes+3*sizeof(float))) { return floats.read(0,result); };
+   }
+   std::filesystem::remove(path);
+}
+
+TEST_CASE("Text conversion","[text]")
+{
+   for(std::size_t size : sizes(std::size_t(1)<<20))
+   {
+      Vector3DArray array(Vector3DArrayConstView(randomVectors(size,7)));
+      std::ostringstream out;
+      Vector3DText::writeXYZ(out,array);
+      std::string text=out.str();
+      std::size_t lineBytes=text.size()/size;
+
+      BENCHMARK(workload("Vector3DText::writeXYZ",size,lineBytes))
+      {
+         std::ostringstream stream;
+         return Vector3DText::writeXYZ(stream,array);
+      };
+      BENCHMARK(workload("Vector3DText::readXYZ",size,lineBytes))
+      {
+         std::istringstream stream(text);
+         Vector3DArray read;
+         read.reserve(size);
+         Vector3DText::readXYZ(stream,read);
+         return read.size();
+      };
+   }
+}
+
+TEST_CASE("Vertex welding","[weld]")
+{
+   for(std::size_t size : sizes())
+   {
+      // Every vertex shared by about six triangles, as in an unindexed triangle mesh
+      std::vector<Vector3D> vertices=randomVectors(size/6+1,11),vectors(size);
+      for(std::size_t i=0;i<size;i++) vectors[i]=vertices[(i*7919)%vertices.size()];
+      Vector3DArray array(vectors),unique;
+      std::vector<std::size_t> remap(size);
+
+      BENCHMARK(workload("Vector3DWeld::weld",size,sizeof(Vector3D)+sizeof(std::size_t))) { return Vector3DWeld::weld(array,remap,unique,1.0e-9); };
+      BENCHMARK(workload("Vector3DWeld::weld.parallel",size,sizeof(Vector3D)+sizeof(std::size_t))) { return Vector3DWeld::weld(Vector3DExecution::parallel(),array,remap,unique,1.0e-9); };
+   }
+}
+
+TEST_CASE("All pairs","[pairs]")
+{
+   for(std::size_t size : sizes())
+   {
+      // size pairs between two square sets, the work counted per pair
+      std::size_t side=static_cast<std::size_t>(std::sqrt(static_cast<double>(size)));
+      std::vector<Vector3D> vectors1=randomVectors(side,13),vectors2=randomVectors(side,17);
+      Vector3DArray array1(vectors1),array2(vectors2);
+      std::vector<double> matrix(side*side);
+      std::vector<Vector3DBatch::Pair> nearest(side*8),within;
+
+      BENCHMARK(workload("Vector3D::angle.pairs",size,sizeof(double)))
+      {
+         for(std::size_t i=0;i<side;i++)
+         {
+            for(std::size_t j=0;j<side;j++) matrix[i*side+j]=vectors1[i].angle(vectors2[j]);
+         }
+         return matrix[0];
+      };
+      BENCHMARK(workload("Vector3DBatch::distanceMatrix",size,sizeof(double))) { return Vector3DBatch::distanceMatrix(array1,array2,matrix); };
+      BENCHMARK(workload("Vector3DBatch::angleMatrix",size,sizeof(double))) { return Vector3DBatch::angleMatrix(array1,array2,matrix); };
+      BENCHMARK(workload("Vector3DBatch::angleMatrix.parallel",size,sizeof(double))) { return Vector3DBatch::angleMatrix(Vector3DExecution::parallel(),array1,array2,matrix); };
+      BENCHMARK(workload("Vector3DBatch::nearestDistances",size,0)) { return Vector3DBatch::nearestDistances(array1,array2,8,nearest); };
+      BENCHMARK(workload("Vector3DBatch::distancesWithin",size,0)) { return Vector3DBatch::distancesWithin(array1,array2,10.0,within); };
+      BENCHMARK(workload("Vector3DBatch::anglesWithin",size,0)) { return Vector3DBatch::anglesWithin(array1,array2,0.1,within); };
+   }
+}
+
+TEST_CASE("Streaming pipeline","[stream]")
+{
+   std::string path=(std::filesystem::temp_directory_path()/"vector3d_bench_stream.v3d").string();
+   Rotation3D rotation(Vector3D(1.0,2.0,3.0),0.7);
+   Vector3D offset(1.0,-2.0,0.5);
+   for(std::size_t size : sizes(std::size_t(1)<<22))
+   {
+      Vector3DArray array(Vector3DArrayConstView(randomVectors(size,19))),result(size);
+      Vector3DFile::write(path,array);
+      Vector3DFile file(path);
+      std::size_t vectorBytes=3*sizeof(double);
+      Vector3D sum;
+
+      BENCHMARK(workload("Vector3DFile::read.eager",size,vectorBytes))
+      {
+         file.read(0,result);
+         Vector3DBatch::rotate(result,rotation,result);
+         Vector3DBatch::scale(result,2.0,result);
+         Vector3DBatch::add(result,offset,result);
+         return Vector3DBatch::sum(result);
+      };
+      BENCHMARK(workload("Vector3DStream::fromFile",size,vectorBytes)) { return Vector3DStream::fromFile(file).rotate(rotation).scale(2.0).translate(offset).sum(sum); };
+      BENCHMARK(workload("Vector3DStream::fromFile.prefetch",size,vectorBytes)) { return Vector3DStream::fromFile(file).prefetch().rotate(rotation).scale(2.0).translate(offset).sum(sum); };
+   }
+   std::filesystem::remove(path);
+}
+
+TEST_CASE("Space-filling curves","[curve]")
+{
+   for(std::size_t size : sizes())
+   {
+      std::vector<Vector3D> vectors=randomVectors(size,23);
+      Vector3DArray array(vectors),sorted(vectors),unique;
+      Vector3D minimum,maximum;
+      Vector3DBatch::boundingBox(array,minimum,maximum);
+      std::vector<std::uint64_t> keys(size);
+      std::vector<std::size_t> permutation(size),remap(size);
+
+      BENCHMARK(workload("Vector3DCurve::keys",size,sizeof(Vector3D)+sizeof(std::uint64_t))) { return Vector3DCurve::keys(array,minimum,maximum,keys); };
+      BENCHMARK(workload("Vector3DCurve::keys.hilbert",size,sizeof(Vector3D)+sizeof(std::uint64_t))) { return Vector3DCurve::keys(array,minimum,maximum,keys,Vector3DCurve::Hilbert); };
+      BENCHMARK(workload("std::stable_sort.keys",size,sizeof(std::size_t)))
+      {
+         for(std::size_t i=0;i<size;i++) permutation[i]=i;
+         std::stable_sort(permutation.begin(),permutation.end(),[&keys](std::size_t index1, std::size_t index2) { return keys[index1]<keys[index2]; });
+         return permutation[0];
+      };
+      BENCHMARK(workload("Vector3DCurve::order",size,sizeof(Vector3D)+sizeof(std::size_t))) { return Vector3DCurve::order(array,permutation); };
+      BENCHMARK(workload("Vector3DCurve::order.parallel",size,sizeof(Vector3D)+sizeof(std::size_t))) { return Vector3DCurve::order(Vector3DExecution::parallel(),array,permutation); };
+      Vector3DCurve::sort(sorted,permutation);
+      BENCHMARK(workload("Vector3DWeld::weld.unsorted",size,sizeof(Vector3D)+sizeof(std::size_t))) { return Vector3DWeld::weld(array,remap,unique,1.0e-9); };
+      BENCHMARK(workload("Vector3DWeld::weld.morton",size,sizeof(Vector3D)+sizeof(std::size_t))) { return Vector3DWeld::weld(sorted,remap,unique,1.0e-9); };
+   }
+}
+
+TEST_CASE("Dot, cross and projection","[products]")
+{
+   for(std::size_t size : sizes())
+   {
+      std::vector<Vector3D> vectors=randomVectors(size,29),vectors2=randomVectors(size,31),result(size);
+      Vector3DArray array(vectors),array2(vectors2),batchResult(size);
+      std::vector<double> dots(size);
+      Vector3D axis(3.25,-1.5,0.75);
+
+      BENCHMARK(workload("Vector3D::dot",size,2*sizeof(Vector3D)+sizeof(double)))
+      {
+         for(std::size_t i=0;i<size;i++) dots[i]=vectors[i].dot(vectors2[i]);
+         return dots[0];
+      };
+      BENCHMARK(workload("Vector3DBatch::dot",size,2*sizeof(Vector3D)+sizeof(double))) { return Vector3DBatch::dot(array,array2,dots); };
+      BENCHMARK(workload("Vector3D::cross",size,3*sizeof(Vector3D)))
+      {
+         for(std::size_t i=0;i<size;i++) result[i]=vectors[i].cross(vectors2[i]);
+         return result[0];
+      };
+      BENCHMARK(workload("Vector3DBatch::cross",size,3*sizeof(Vector3D))) { return Vector3DBatch::cross(array,array2,batchResult); };
+      BENCHMARK(workload("Vector3D::project",size,2*sizeof(Vector3D)))
+      {
+         for(std::size_t i=0;i<size;i++) result[i]=vectors[i].project(axis);
+         return result[0];
+      };
+      BENCHMARK(workload("Vector3DBatch::project",size,2*sizeof(Vector3D))) { return Vector3DBatch::project(array,axis,batchResult); };
+      BENCHMARK(workload("Vector3DBatch::reject.parallel",size,2*sizeof(Vector3D))) { return Vector3DBatch::reject(Vector3DExecution::parallel(),array,axis,batchResult); };
+   }
+}
+
+TEST_CASE("Compaction","[compact]")
+{
+   for(std::size_t size : sizes())
+   {
+      std::vector<Vector3D> vectors=randomVectors(size,37),survivors;
+      for(std::size_t i=0;i<size;i+=17) vectors[i]=Vector3D();
+      for(std::size_t i=5;i<size;i+=23) vectors[i]=Vector3D(std::nan(""),0.0,0.0);
+      Vector3DArray array(vectors);
+      std::vector<std::uint64_t> mask(Vector3DBatch::maskWords(size));
+      std::vector<std::uint8_t> flags(size);
+
+      BENCHMARK(workload("Vector3D::isNaN.isZero.copy",size,2*sizeof(Vector3D)))
+      {
+         survivors.clear();
+         for(const Vector3D &vector : vectors)
+         {
+            if(!vector.isNaN() && !vector.isZero()) survivors.push_back(vector);
+         }
+         return survivors.size();
+      };
+      BENCHMARK(workload("Vector3DBatch::isNaN.flags",size,sizeof(Vector3D)+1)) { return Vector3DBatch::isNaN(array,flags); };
+      BENCHMARK(workload("Vector3DBatch::filterMask",size,sizeof(Vector3D))) { return Vector3DBatch::filterMask(array,Vector3DBatch::DropNaN|Vector3DBatch::DropZero,mask); };
+      BENCHMARK_ADVANCED(workload("Vector3DBatch::compact",size,2*sizeof(Vector3D)))(Catch::Benchmark::Chronometer meter)
+      {
+         std::vector<Vector3DArray> copies(static_cast<std::size_t>(meter.runs()),array);
+         meter.measure([&](int run) { return Vector3DBatch::compact(copies[run],Vector3DBatch::DropNaN|Vector3DBatch::DropZero); });
+      };
+      BENCHMARK_ADVANCED(workload("Vector3DBatch::compact.aos",size,2*sizeof(Vector3D)))(Catch::Benchmark::Chronometer meter)
+      {
+         std::vector<std::vector<Vector3D>> copies(static_cast<std::size_t>(meter.runs()),vectors);
+         meter.measure([&](int run) { return Vector3DBatch::compact(copies[run],Vector3DBatch::DropNaN|Vector3DBatch::DropZero); });
+      };
+      BENCHMARK_ADVANCED(workload("Vector3DBatch::compact.parallel",size,2*sizeof(Vector3D)))(Catch::Benchmark::Chronometer meter)
+      {
+         std::vector<Vector3DArray> copies(static_cast<std::size_t>(meter.runs()),array);
+         meter.measure([&](int run) { return Vector3DBatch::compact(Vector3DExecution::parallel(),copies[run],Vector3DBatch::DropNaN|Vector3DBatch::DropZero); });
+      };
+   }
+}
+
+TEST_CASE("Mesh normals","[mesh]")
+{
+   for(std::size_t size : sizes())
+   {
+      // a square height field of about size vertices, two triangles per cell
+      std::size_t side=static_cast<std::size_t>(std::sqrt(static_cast<double>(size)));
+      std::vector<Vector3D> vertices,normals;
+      std::vector<std::uint32_t> indices;
+      for(std::size_t row=0;row<side;row++)
+      {
+         for(std::size_t column=0;column<side;column++) vertices.emplace_back(0.1*column,0.1*row,0.2*std::sin(0.3*column)*std::cos(0.2*row));
+      }
+      for(std::uint32_t row=0;row+1<side;row++)
+      {
+         for(std::uint32_t column=0;column+1<side;column++)
+         {
+            std::uint32_t corner=row*static_cast<std::uint32_t>(side)+column,above=corner+static_cast<std::uint32_t>(side);
+            indices.insert(indices.end(),{corner,corner+1,above+1,corner,above+1,above});
+         }
+      }
+      std::size_t faces=indices.size()/3;
+      Vector3DArray array(vertices),faceNormals(faces),vertexNormals(vertices.size());
+
+      BENCHMARK(workload("Vector3D::cross.setLength.faces",faces,3*sizeof(Vector3D)))
+      {
+         normals.assign(faces,Vector3D());
+         for(std::size_t face=0;face<faces;face++)
+         {
+            const Vector3D &a=vertices[indices[3*face]],&b=vertices[indices[3*face+1]],&c=vertices[indices[3*face+2]];
+            normals[face]=(b-a).cross(c-a);
+            normals[face].setLength(1.0);
+         }
+         return normals[0];
+      };
+      BENCHMARK(workload("Vector3DMesh::faceNormals",faces,3*sizeof(Vector3D))) { return Vector3DMesh::faceNormals(array,indices,faceNormals); };
+      BENCHMARK(workload("Vector3D::operator+=.vertices",vertices.size(),4*sizeof(Vector3D)))
+      {
+         normals.assign(vertices.size(),Vector3D());
+         for(std::size_t face=0;face<faces;face++)
+         {
+            std::uint32_t ia=indices[3*face],ib=indices[3*face+1],ic=indices[3*face+2];
+            Vector3D normal=(vertices[ib]-vertices[ia]).cross(vertices[ic]-vertices[ia]);
+            normals[ia]+=normal; normals[ib]+=normal; normals[ic]+=normal;
+         }
+         for(Vector3D &normal : normals) normal.setLength(1.0);
+         return normals[0];
+      };
+      BENCHMARK(workload("Vector3DMesh::vertexNormals",vertices.size(),4*sizeof(Vector3D))) { return Vector3DMesh::vertexNormals(array,indices,vertexNormals); };
+      BENCHMARK(workload("Vector3DMesh::vertexNormals.angle",vertices.size(),4*sizeof(Vector3D))) { return Vector3DMesh::vertexNormals(array,indices,vertexNormals,Vector3DMesh::Angle); };
+      BENCHMARK(workload("Vector3DMesh::vertexNormals.parallel",vertices.size(),4*sizeof(Vector3D))) { return Vector3DMesh::vertexNormals(Vector3DExecution::parallel(),array,indices,vertexNormals); };
+   }
+}
+
+TEST_CASE("Coordinate conversion","[coordinates]")
+{
+   for(std::size_t size : sizes())
+   {
+      std::vector<Vector3D> vectors=randomVectors(size,41),coordinates(size);
+      Vector3DArray array(vectors),spherical(size),back(size);
+      Vector3DBatch::toSpherical(array,spherical);
+
+      BENCHMARK(workload("Vector3D::length.atan2.acos",size,2*sizeof(Vector3D)))
+      {
+         for(std::size_t i=0;i<size;i++)
+         {
+            const Vector3D &vector=vectors[i];
+            double radius=vector.length();
+            coordinates[i]=Vector3D(radius,std::acos(vector.z()/radius),std::atan2(vector.y(),vector.x()));
+         }
+         return coordinates[0];
+      };
+      BENCHMARK(workload("Vector3DBatch::toSpherical",size,2*sizeof(Vector3D))) { return Vector3DBatch::toSpherical(array,spherical); };
+      BENCHMARK(workload("Vector3DBatch::toSpherical.parallel",size,2*sizeof(Vector3D))) { return Vector3DBatch::toSpherical(Vector3DExecution::parallel(),array,spherical); };
+      BENCHMARK(workload("std::sin.cos.spherical",size,2*sizeof(Vector3D)))
+      {
+         for(std::size_t i=0;i<size;i++)
+         {
+            Vector3D point=spherical[i];
+            double planar=point.x()*std::sin(point.y());
+            coordinates[i]=Vector3D(planar*std::cos(point.z()),planar*std::sin(point.z()),point.x()*std::cos(point.y()));
+         }
+         return coordinates[0];
+      };
+      BENCHMARK(workload("Vector3DBatch::fromSpherical",size,2*sizeof(Vector3D))) { return Vector3DBatch::fromSpherical(spherical,back); };
+      BENCHMARK(workload("Vector3DBatch::toCylindrical",size,2*sizeof(Vector3D))) { return Vector3DBatch::toCylindrical(array,back); };
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   Catch::Session session;
+   using namespace Catch::Clara;
+   auto cli=session.cli()
+      | Opt(jsonPath,"file")["--json"]("write ns/op, throughput and GB/s of every benchmark to this JSON file")
+      | Opt(maxSize,"vectors")["--max-size"]("largest input size in vectors (default 4194304)");
+   session.cli(cli);
+
+   int status=session.applyCommandLine(argc,argv);
+   if(status!=0) return status;
+   return session.run();
+}
@@ -0,0 +1,268 @@
+#ifndef QUATERNION_H
+#define QUATERNION_H
+
+#include "vector3d.h"
+#include "rotation3d.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/**
+ * @brief The Quaternion class is a rotation in the same convention as Vector3D::rotate() and Rotation3D.
+ * Products compose right to left like matrices, (q1*q2)*v rotates v by q2 first, so a chain of rotations
+ * costs one quaternion product each and is applied to a batch of vectors once through its Rotation3D.
+ */
+class Quaternion
+{
+   public:
+      Quaternion();
+      Quaternion(double w, double x, double y, double z);
+      Quaternion(const Vector3D &axis, double angle, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians);
+      explicit Quaternion(const Rotation3D &rotation);
+
+      Quaternion &operator*=(const Quaternion &quaternion);
+      friend const Quaternion operator*(const Quaternion &quaternion1, const Quaternion &quaternion2);
+      friend const Vector3D operator*(const Quaternion &quaternion, const Vector3D &vector);
+      friend bool operator==(const Quaternion &quaternion1, const Quaternion &quaternion2);
+      friend bool operator!=(const Quaternion &quaternion1, const Quaternion &quaternion2);
+
+      void apply(Vector3D &vector) const;
+      bool apply(Vector3DArrayView vectors) const;
+      bool apply(Vector3DArrayConstView vectors, Vector3DArrayView result) const;
+
+      double norm() const;
+      double dot(const Quaternion &quaternion) const;
+      bool normalize();
+      const Quaternion normalized() const;
+      const Quaternion conjugate() const;
+      const Quaternion inverse() const;
+      bool toAxisAngle(Vector3D &axis, double &angle, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians) const;
+      const Rotation3D toRotation() const;
+
+      static const Quaternion nlerp(const Quaternion &quaternion1, const Quaternion &quaternion2, double t);
+      static const Quaternion slerp(const Quaternion &quaternion1, const Quaternion &quaternion2, double t);
+
+      double w() const;
+      double x() const;
+      double y() const;
+      double z() const;
+
+   private:
+      double pW;
+      double pX;
+      double pY;
+      double pZ;
+};
+
+inline Quaternion::Quaternion() : pW(1.0), pX(0.0), pY(0.0), pZ(0.0)
+{
+}
+
+inline Quaternion::Quaternion(double w, double x, double y, double z) : pW(w), pX(x), pY(y), pZ(z)
+{
+}
+
+inline Quaternion::Quaternion(const Vector3D &axis, double angle, Vector3D::AngularUnits units) : Quaternion()
+{
+   if(units==Vector3D::AngularUnits::Degrees) angle*=Vector3D::Traits::deg2rad;
+   if(axis.isZero() || Vector3D::Traits::isZero(angle)) return;
+
+   // Same half angle sign as Vector3D::rotate(), so Rotation3D(Quaternion(axis,angle)) matches Rotation3D(axis,angle)
+   double x=axis.x(),y=axis.y(),z=axis.z();
+   double axisLength=std::sqrt(x*x+y*y+z*z); x/=axisLength; y/=axisLength; z/=axisLength;
+   double halfAngle=angle/-2.0,halfAngleSin=std::sin(halfAngle);
+   pX=x*halfAngleSin; pY=y*halfAngleSin; pZ=z*halfAngleSin; pW=std::cos(halfAngle);
+}
+
+inline Quaternion::Quaternion(const Rotation3D &rotation)
+{
+   const double *m=rotation.data();
+   double trace=m[0]+m[4]+m[8];
+   if(trace>0.0)
+   {
+      double s=std::sqrt(trace+1.0)*2.0;
+      pW=0.25*s; pX=(m[7]-m[5])/s; pY=(m[2]-m[6])/s; pZ=(m[3]-m[1])/s;
+   } else if(m[0]>m[4] && m[0]>m[8])
+   {
+      double s=std::sqrt(1.0+m[0]-m[4]-m[8])*2.0;
+      pW=(m[7]-m[5])/s; pX=0.25*s; pY=(m[1]+m[3])/s; pZ=(m[2]+m[6])/s;
+   } else if(m[4]>m[8])
+   {
+      double s=std::sqrt(1.0+m[4]-m[0]-m[8])*2.0;
+      pW=(m[2]-m[6])/s; pX=(m[1]+m[3])/s; pY=0.25*s; pZ=(m[5]+m[7])/s;
+   } else
+   {
+      double s=std::sqrt(1.0+m[8]-m[0]-m[4])*2.0;
+      pW=(m[3]-m[1])/s; pX=(m[2]+m[6])/s; pY=(m[5]+m[7])/s; pZ=0.25*s;
+   }
+}
+
+inline Rotation3D::Rotation3D(const Quaternion &quaternion) : Rotation3D()
+{
+   if(quaternion.x()==0.0 && quaternion.y()==0.0 && quaternion.z()==0.0) return;
+   // Drifted products expand into a scaled, sheared matrix, so rescale to unit length once here.
+   // Norms within rounding of one are left alone to keep the matrix of Rotation3D(axis,angle) bit for bit.
+   Quaternion unit=quaternion;
+   if(std::fabs(quaternion.dot(quaternion)-1.0)>8.0*std::numeric_limits<double>::epsilon()) unit.normalize();
+   setQuaternion(unit.x(),unit.y(),unit.z(),unit.w());
+}
+
+inline Quaternion &Quaternion::operator*=(const Quaternion &quaternion)
+{
+   *this=*this*quaternion;
+   return *this;
+}
+
+inline const Quaternion operator*(const Quaternion &quaternion1, const Quaternion &quaternion2)
+{
+   const Quaternion &a=quaternion1,&b=quaternion2;
+   return Quaternion(a.pW*b.pW-a.pX*b.pX-a.pY*b.pY-a.pZ*b.pZ,
+                     a.pW*b.pX+a.pX*b.pW+a.pY*b.pZ-a.pZ*b.pY,
+                     a.pW*b.pY-a.pX*b.pZ+a.pY*b.pW+a.pZ*b.pX,
+                     a.pW*b.pZ+a.pX*b.pY-a.pY*b.pX+a.pZ*b.pW);
+}
+
+inline const Vector3D operator*(const Quaternion &quaternion, const Vector3D &vector)
+{
+   Vector3D result(vector);
+   quaternion.apply(result);
+   return result;
+}
+
+inline bool operator==(const Quaternion &quaternion1, const Quaternion &quaternion2)
+{
+   return Vector3D::Traits::isEqual(quaternion1.pW,quaternion2.pW) && Vector3D::Traits::isEqual(quaternion1.pX,quaternion2.pX) && Vector3D::Traits::isEqual(quaternion1.pY,quaternion2.pY) && Vector3D::Traits::isEqual(quaternion1.pZ,quaternion2.pZ);
+}
+
+inline bool operator!=(const Quaternion &quaternion1, const Quaternion &quaternion2)
+{
+   return !(quaternion1==quaternion2);
+}
+
+inline void Quaternion::apply(Vector3D &vector) const
+{
+   Rotation3D(*this).apply(vector);
+}
+
+inline double Quaternion::norm() const
+{
+   return std::sqrt(dot(*this));
+}
+
+inline double Quaternion::dot(const Quaternion &quaternion) const
+{
+   return pW*quaternion.pW+pX*quaternion.pX+pY*quaternion.pY+pZ*quaternion.pZ;
+}
+
+inline bool Quaternion::normalize()
+{
+   // Only exact zero fails, norms whose square underflows are brought up by their largest component first
+   if(dot(*this)<std::numeric_limits<double>::min())
+   {
+      double scale=std::max(std::max(std::fabs(pW),std::fabs(pX)),std::max(std::fabs(pY),std::fabs(pZ)));
+      if(scale==0.0) return false;
+      pW/=scale; pX/=scale; pY/=scale; pZ/=scale;
+   }
+   double length=norm();
+   pW/=length; pX/=length; pY/=length; pZ/=length;
+   return true;
+}
+
+inline const Quaternion Quaternion::normalized() const
+{
+   Quaternion result(*this);
+   result.normalize();
+   return result;
+}
+
+inline const Quaternion Quaternion::conjugate() const
+{
+   return Quaternion(pW,-pX,-pY,-pZ);
+}
+
+inline const Quaternion Quaternion::inverse() const
+{
+   // Only exact zero has no inverse, squared norms that underflow are brought up by the largest component first
+   double normSquared=dot(*this);
+   if(normSquared<std::numeric_limits<double>::min())
+   {
+      double scale=std::max(std::max(std::fabs(pW),std::fabs(pX)),std::max(std::fabs(pY),std::fabs(pZ)));
+      if(scale==0.0) return Quaternion(std::numeric_limits<double>::quiet_NaN(),std::numeric_limits<double>::quiet_NaN(),std::numeric_limits<double>::quiet_NaN(),std::numeric_limits<double>::quiet_NaN());
+      Quaternion inverse=Quaternion(pW/scale,pX/scale,pY/scale,pZ/scale).inverse();
+      return Quaternion(inverse.pW/scale,inverse.pX/scale,inverse.pY/scale,inverse.pZ/scale);
+   }
+   return Quaternion(pW/normSquared,-pX/normSquared,-pY/normSquared,-pZ/normSquared);
+}
+
+inline bool Quaternion::toAxisAngle(Vector3D &axis, double &angle, Vector3D::AngularUnits units) const
+{
+   // Inverse of the axis-angle constructor: the vector part holds axis*sin(-angle/2), the angle comes back in [0,pi]
+   double sign=pW<0.0 ? -1.0 : 1.0;
+   double sinLength=std::sqrt(pX*pX+pY*pY+pZ*pZ);
+   if(Vector3D::Traits::isZero(sinLength))
+   {
+      axis=Vector3D(1.0,0.0,0.0); angle=0.0;
+      return false;
+   }
+   axis=Vector3D(-sign*pX/sinLength,-sign*pY/sinLength,-sign*pZ/sinLength);
+   angle=2.0*std::atan2(sinLength,sign*pW);
+   if(units==Vector3D::AngularUnits::Degrees) angle*=Vector3D::Traits::rad2deg;
+   return true;
+}
+
+inline const Rotation3D Quaternion::toRotation() const
+{
+   return Rotation3D(*this);
+}
+
+inline const Quaternion Quaternion::nlerp(const Quaternion &quaternion1, const Quaternion &quaternion2, double t)
+{
+   double sign=quaternion1.dot(quaternion2)<0.0 ? -1.0 : 1.0;
+   Quaternion result(quaternion1.pW+(sign*quaternion2.pW-quaternion1.pW)*t,
+                     quaternion1.pX+(sign*quaternion2.pX-quaternion1.pX)*t,
+                     quaternion1.pY+(sign*quaternion2.pY-quaternion1.pY)*t,
+                     quaternion1.pZ+(sign*quaternion2.pZ-quaternion1.pZ)*t);
+   result.normalize();
+   return result;
+}
+
+inline const Quaternion Quaternion::slerp(const Quaternion &quaternion1, const Quaternion &quaternion2, double t)
+{
+   // Takes the shorter arc, nearly parallel inputs fall back to nlerp where sin(theta) loses precision
+   double cosTheta=quaternion1.dot(quaternion2),sign=1.0;
+   if(cosTheta<0.0)
+   {
+      cosTheta=-cosTheta; sign=-1.0;
+   }
+   if(cosTheta>0.9995) return nlerp(quaternion1,quaternion2,t);
+
+   double theta=std::acos(cosTheta),sinTheta=std::sin(theta);
+   double factor1=std::sin((1.0-t)*theta)/sinTheta,factor2=sign*std::sin(t*theta)/sinTheta;
+   return Quaternion(factor1*quaternion1.pW+factor2*quaternion2.pW,
+                     factor1*quaternion1.pX+factor2*quaternion2.pX,
+                     factor1*quaternion1.pY+factor2*quaternion2.pY,
+                     factor1*quaternion1.pZ+factor2*quaternion2.pZ);
+}
+
+inline double Quaternion::w() const
+{
+   return pW;
+}
+
+inline double Quaternion::x() const
+{
+   return pX;
+}
+
+inline double Quaternion::y() const
+{
+   return pY;
+}
+
+inline double Quaternion::z() const
+{
+   return pZ;
+}
+
+#endif // QUATERNION_H
@@ -0,0 +1,174 @@
+#ifndef ROTATION3D_H
+#define ROTATION3D_H
+
+#include "vector3d.h"
+
+class Vector3DArrayView;
+class Vector3DArrayConstView;
+class Quaternion;
+
+/**
+ * @brief The Rotation3D class caches the rotation matrix of Vector3D::rotate() for one axis and angle,
+ * so applying it costs nine multiplications per vector instead of a full quaternion rotation.
+ * Rotations can be built in constant expressions, e.g. constexpr Rotation3D quarter(0.0,0.0,1.0,90.0,Vector3D::Degrees).
+ * At runtime they use libm. In constant evaluation sqrt, sin and cos come from long double Newton and Taylor
+ * iterations instead, which can differ from libm in the last bit.
+ * A Quaternion is normalized before it is expanded, so one that drifted from unit length still gives a rotation.
+ */
+class Rotation3D
+{
+   public:
+      constexpr Rotation3D();
+      constexpr Rotation3D(const Vector3D &axis, double angle, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians);
+      constexpr Rotation3D(double x, double y, double z, double angle, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians);
+      explicit Rotation3D(const Quaternion &quaternion);
+
+      friend constexpr const Rotation3D operator*(const Rotation3D &rotation1, const Rotation3D &rotation2);
+      friend constexpr const Vector3D operator*(const Rotation3D &rotation, const Vector3D &vector);
+
+      constexpr void apply(Vector3D &vector) const;
+      bool apply(Vector3DArrayView vectors) const;
+      bool apply(Vector3DArrayConstView vectors, Vector3DArrayView result) const;
+
+      constexpr const Rotation3D inverse() const;
+      constexpr bool isIdentity() const;
+      constexpr double element(int row, int column) const;
+      constexpr const double *data() const;
+
+   private:
+      double pMatrix[9];
+      bool pIdentity;
+
+      constexpr void setQuaternion(double qx, double qy, double qz, double qw);
+
+      static constexpr double squareRoot(double value);
+      static constexpr void sinCos(double angle, double &sine, double &cosine);
+};
+
+constexpr Rotation3D::Rotation3D() : pMatrix{1.0,0.0,0.0,0.0,1.0,0.0,0.0,0.0,1.0}, pIdentity(true)
+{
+}
+
+constexpr Rotation3D::Rotation3D(const Vector3D &axis, double angle, Vector3D::AngularUnits units) : Rotation3D(axis.x(),axis.y(),axis.z(),angle,units)
+{
+}
+
+constexpr Rotation3D::Rotation3D(double x, double y, double z, double angle, Vector3D::AngularUnits units) : Rotation3D()
+{
+   if(units==Vector3D::AngularUnits::Degrees) angle*=Vector3D::Traits::deg2rad;
+   if(Vector3D(x,y,z).isZero() || Vector3D::Traits::isZero(angle)) return;
+
+   // Same quaternion as Vector3D::rotate(), expanded once into its matrix
+   double axisLength=squareRoot(x*x+y*y+z*z); x/=axisLength; y/=axisLength; z/=axisLength;
+   double halfAngleSin=0.0,halfAngleCos=0.0;
+   sinCos(angle/-2.0,halfAngleSin,halfAngleCos);
+   setQuaternion(x*halfAngleSin,y*halfAngleSin,z*halfAngleSin,halfAngleCos);
+}
+
+constexpr double Rotation3D::squareRoot(double value)
+{
+   if(!std::is_constant_evaluated()) return std::sqrt(value);
+   if(!(value>0.0) || value==std::numeric_limits<double>::infinity()) return value==0.0 ? value : std::numeric_limits<double>::quiet_NaN();
+   // Newton's iterates decrease monotonically from any start above the root, until rounding stops them
+   long double target=value,root=target>1.0L ? target : 1.0L;
+   for(int i=0;i<4096;i++)
+   {
+      long double next=(root+target/root)/2.0L;
+      if(next>=root) break;
+      root=next;
+   }
+   return static_cast<double>(root);
+}
+
+constexpr void Rotation3D::sinCos(double angle, double &sine, double &cosine)
+{
+   if(!std::is_constant_evaluated())
+   {
+      sine=std::sin(angle);
+      cosine=std::cos(angle);
+      return;
+   }
+   // Reduction to [-pi/4,pi/4] by quarter turns, then Taylor series summed until the terms vanish
+   constexpr long double halfPi=1.570796326794896619231321691639751442L;
+   long double value=angle,turns=value/halfPi;
+   long long quadrant=static_cast<long long>(turns<0.0L ? turns-0.5L : turns+0.5L);
+   long double reduced=value-static_cast<long double>(quadrant)*halfPi,square=reduced*reduced;
+   long double reducedSin=reduced,reducedCos=1.0L,sinTerm=reduced,cosTerm=1.0L;
+   for(int n=1;n<64 && (sinTerm!=0.0L || cosTerm!=0.0L);n++)
+   {
+      sinTerm*=-square/static_cast<long double>((2*n)*(2*n+1));
+      cosTerm*=-square/static_cast<long double>((2*n-1)*(2*n));
+      reducedSin+=sinTerm;
+      reducedCos+=cosTerm;
+   }
+   switch(((quadrant%4)+4)%4)
+   {
+      case 0: sine=static_cast<double>(reducedSin); cosine=static_cast<double>(reducedCos); break;
+      case 1: sine=static_cast<double>(reducedCos); cosine=static_cast<double>(-reducedSin); break;
+      case 2: sine=static_cast<double>(-reducedSin); cosine=static_cast<double>(-reducedCos); break;
+      default: sine=static_cast<double>(-reducedCos); cosine=static_cast<double>(reducedSin); break;
+   }
+}
+
+constexpr void Rotation3D::setQuaternion(double qx, double qy, double qz, double qw)
+{
+   pMatrix[0]=1.0-2.0*(qy*qy+qz*qz); pMatrix[1]=2.0*(qx*qy-qw*qz);     pMatrix[2]=2.0*(qx*qz+qw*qy);
+   pMatrix[3]=2.0*(qx*qy+qw*qz);     pMatrix[4]=1.0-2.0*(qx*qx+qz*qz); pMatrix[5]=2.0*(qy*qz-qw*qx);
+   pMatrix[6]=2.0*(qx*qz-qw*qy);     pMatrix[7]=2.0*(qy*qz+qw*qx);     pMatrix[8]=1.0-2.0*(qx*qx+qy*qy);
+   pIdentity=false;
+}
+
+constexpr const Rotation3D operator*(const Rotation3D &rotation1, const Rotation3D &rotation2)
+{
+   if(rotation1.pIdentity) return rotation2;
+   if(rotation2.pIdentity) return rotation1;
+   Rotation3D result;
+   const double *a=rotation1.pMatrix,*b=rotation2.pMatrix;
+   for(int row=0;row<3;row++)
+   {
+      for(int column=0;column<3;column++) result.pMatrix[row*3+column]=a[row*3]*b[column]+a[row*3+1]*b[3+column]+a[row*3+2]*b[6+column];
+   }
+   result.pIdentity=false;
+   return result;
+}
+
+constexpr const Vector3D operator*(const Rotation3D &rotation, const Vector3D &vector)
+{
+   Vector3D result(vector);
+   rotation.apply(result);
+   return result;
+}
+
+constexpr void Rotation3D::apply(Vector3D &vector) const
+{
+   if(pIdentity) return;
+   const double *m=pMatrix;
+   double x=vector.x(),y=vector.y(),z=vector.z();
+   vector.set(m[0]*x+m[1]*y+m[2]*z,m[3]*x+m[4]*y+m[5]*z,m[6]*x+m[7]*y+m[8]*z);
+}
+
+constexpr const Rotation3D Rotation3D::inverse() const
+{
+   Rotation3D result(*this);
+   const double *m=pMatrix;
+   double *t=result.pMatrix;
+   t[1]=m[3]; t[2]=m[6]; t[3]=m[1]; t[5]=m[7]; t[6]=m[2]; t[7]=m[5];
+   return result;
+}
+
+constexpr bool Rotation3D::isIdentity() const
+{
+   return pIdentity;
+}
+
+constexpr double Rotation3D::element(int row, int column) const
+{
+   return pMatrix[row*3+column];
+}
+
+constexpr const double *Rotation3D::data() const
+{
+   return pMatrix;
+}
+
+#endif // ROTATION3D_H
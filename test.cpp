@@ -1,7 +1,32 @@
 #include <catch2/catch_all.hpp>
 #include <vector3d.h>
-
+#include <vector3darray.h>
+#include <rotation3d.h>
+#include <quaternion.h>
+#include <transform3d.h>
+#include <vector3dsort.h>
+#include <vector3dexpr.h>
+#include <vector3dindex.h>
+#include <vector3dexecution.h>
+#include <vector3dfile.h>
+#include <vector3dtext.h>
+#include <vector3dfastmath.h>
+#include <vector3dweld.h>
+#include <vector3dinstrumentation.h>
+#include <vector3dstream.h>
+#include <vector3dcurve.h>
+#include <vector3dmesh.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
 #include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
 
 double rx;
 double ry;
@@ -249,7 +274,12 @@ TEST_CASE("Length methods")
 
 TEST_CASE("Angle methods")
 {
+#ifdef VECTOR3D_FAST_MATH
+   // The default accuracy is then Fast, so angles are only as close as its acos approximation, in degrees too
+   double delta=1.0e-8+Vector3DFastMath::acosError*180.0/M_PI;
+#else
    double delta=1.0e-8;
+#endif
 
    SECTION("Radians simple instance")
    {
@@ -518,3 +548,2255 @@ TEST_CASE("Rotate methods")
       }
    }
 }
+
+std::vector<Vector3D> randomVectors(std::size_t count, unsigned seed)
+{
+   std::mt19937 generator(seed);
+   std::uniform_real_distribution<double> distribution(-50.0,50.0);
+   std::vector<Vector3D> vectors;
+   for(std::size_t i=0;i<count;i++) vectors.push_back(Vector3D(distribution(generator),distribution(generator),distribution(generator)));
+   if(count>3) vectors[3]=Vector3D();
+   if(count>5) vectors[5]=Vector3D(std::numeric_limits<double>::quiet_NaN(),1.0,2.0);
+   if(count>7) vectors[7]=Vector3D(1.0e-17,-1.0e-17,0.0);
+   return vectors;
+}
+
+bool isIdentical(const Vector3D &vector1, const Vector3D &vector2)
+{
+   return std::memcmp(&vector1,&vector2,sizeof(Vector3D))==0;
+}
+
+bool isIdentical(double value1, double value2)
+{
+   return std::memcmp(&value1,&value2,sizeof(double))==0;
+}
+
+std::vector<Vector3DBatch::InstructionSet> instructionSets()
+{
+   std::vector<Vector3DBatch::InstructionSet> sets;
+   for(Vector3DBatch::InstructionSet set : {Vector3DBatch::Scalar,Vector3DBatch::SSE2,Vector3DBatch::AVX2,Vector3DBatch::AVX512})
+   {
+      if(Vector3DBatch::isSupported(set)) sets.push_back(set);
+   }
+   return sets;
+}
+
+TEST_CASE("Batch methods")
+{
+   std::vector<Vector3D> vectors=randomVectors(1037,42),vectors2=randomVectors(1037,7);
+   Vector3D vector(12.338,-25.627,14.162);
+   Vector3DBatch::InstructionSet defaultSet=Vector3DBatch::instructionSet();
+
+   SECTION("Views")
+   {
+      Vector3DArray array(vectors);
+      REQUIRE(array.size()==vectors.size());
+      for(std::size_t i=0;i<vectors.size();i++) CHECK(isIdentical(array[i],vectors[i]));
+
+      std::vector<Vector3D> copy(vectors.size());
+      CHECK(array.copyTo(copy));
+      for(std::size_t i=0;i<vectors.size();i++) CHECK(isIdentical(copy[i],vectors[i]));
+
+      Vector3DArrayView view(copy);
+      view.set(1,Vector3D(1.0,2.0,3.0));
+      CHECK(copy[1]==Vector3D(1.0,2.0,3.0));
+      CHECK(view.subview(1,2)[0]==Vector3D(1.0,2.0,3.0));
+      CHECK_FALSE(Vector3DBatch::copy(array,view.subview(0,10)));
+   }
+
+   SECTION("Arithmetic")
+   {
+      for(Vector3DBatch::InstructionSet set : instructionSets())
+      {
+         CAPTURE(Vector3DBatch::instructionSetName(set));
+         Vector3DBatch::setInstructionSet(set);
+
+         Vector3DArray array(vectors),array2(vectors2);
+         Vector3DArray sum(array),difference(array),translated(array),scaled(array);
+         sum+=array2; difference-=array2; translated+=vector; scaled*=-3.42;
+         std::vector<Vector3D> aos=vectors;
+         CHECK(Vector3DBatch::add(aos,vectors2,aos));
+         for(std::size_t i=0;i<vectors.size();i++)
+         {
+            CHECK(isIdentical(sum[i],vectors[i]+vectors2[i]));
+            CHECK(isIdentical(aos[i],vectors[i]+vectors2[i]));
+            CHECK(isIdentical(difference[i],vectors[i]-vectors2[i]));
+            CHECK(isIdentical(translated[i],vectors[i]+vector));
+            CHECK(isIdentical(scaled[i],vectors[i]*-3.42));
+         }
+      }
+   }
+
+   SECTION("Measures")
+   {
+      for(Vector3DBatch::InstructionSet set : instructionSets())
+      {
+         CAPTURE(Vector3DBatch::instructionSetName(set));
+         Vector3DBatch::setInstructionSet(set);
+
+         Vector3DArray array(vectors);
+         std::vector<double> lengths(vectors.size()),distances(vectors.size()),radians(vectors.size()),degrees(vectors.size()),aosLengths(vectors.size());
+         CHECK(array.length(lengths));
+         CHECK(array.distance(vector,distances));
+         CHECK(array.angle(vector,radians));
+         CHECK(array.angle(vector,degrees,Vector3D::Degrees));
+         CHECK(Vector3DBatch::length(vectors,aosLengths));
+         CHECK_FALSE(array.length(std::span<double>(lengths).first(5)));
+         for(std::size_t i=0;i<vectors.size();i++)
+         {
+            CHECK(isIdentical(lengths[i],vectors[i].length()));
+            CHECK(isIdentical(aosLengths[i],vectors[i].length()));
+            CHECK(isIdentical(distances[i],vectors[i].distance(vector)));
+            CHECK(isIdentical(radians[i],vectors[i].angle(vector,Vector3D::Radians,Vector3D::Precise)));
+            CHECK(isIdentical(degrees[i],vectors[i].angle(vector,Vector3D::Degrees,Vector3D::Precise)));
+         }
+      }
+   }
+
+   SECTION("Set length")
+   {
+      for(Vector3DBatch::InstructionSet set : instructionSets())
+      {
+         CAPTURE(Vector3DBatch::instructionSetName(set));
+         Vector3DBatch::setInstructionSet(set);
+
+         Vector3DArray array(vectors),zeroLength(vectors.size());
+         std::vector<Vector3D> aos(vectors.size());
+         CHECK(Vector3DBatch::setLength(array,2.5,array));
+         CHECK(Vector3DBatch::setLength(vectors,-1.0,aos));
+         CHECK(Vector3DBatch::setLength(vectors,1.0e-17,zeroLength));
+         // NaN signs and payloads may differ with the optimization of the scalar method
+         auto same=[](const Vector3D &vector1, const Vector3D &vector2) { return vector2.isNaN() ? vector1.isNaN() : isIdentical(vector1,vector2); };
+         bool identical=true;
+         for(std::size_t i=0;i<vectors.size();i++)
+         {
+            Vector3D scaled=vectors[i],flipped=vectors[i],zero=vectors[i];
+            scaled.setLength(2.5,Vector3D::Precise);
+            flipped.setLength(-1.0,Vector3D::Precise);
+            zero.setLength(1.0e-17,Vector3D::Precise);
+            identical=identical && same(array[i],scaled) && same(aos[i],flipped) && same(zeroLength[i],zero);
+         }
+         CHECK(identical);
+         CHECK(isIdentical(array[7],vectors[7]));
+      }
+   }
+
+   SECTION("Predicates")
+   {
+      for(Vector3DBatch::InstructionSet set : instructionSets())
+      {
+         CAPTURE(Vector3DBatch::instructionSetName(set));
+         Vector3DBatch::setInstructionSet(set);
+
+         Vector3DArray array(vectors);
+         std::vector<std::uint8_t> zero(vectors.size()),nan(vectors.size());
+         CHECK(array.isZero(zero));
+         CHECK(Vector3DBatch::isNaN(vectors,nan));
+         for(std::size_t i=0;i<vectors.size();i++)
+         {
+            CHECK(static_cast<bool>(zero[i])==vectors[i].isZero());
+            CHECK(static_cast<bool>(nan[i])==vectors[i].isNaN());
+         }
+         CHECK(zero[3]==1);
+         CHECK(zero[7]==1);
+         CHECK(nan[5]==1);
+      }
+   }
+
+   Vector3DBatch::setInstructionSet(defaultSet);
+}
+
+TEST_CASE("Rotation object")
+{
+   std::vector<Vector3D> vectors=randomVectors(517,11);
+   Vector3D axis(48.561,23.648,36.697);
+   double delta=1.0e-12;
+   Vector3DBatch::InstructionSet defaultSet=Vector3DBatch::instructionSet();
+
+   SECTION("Matches rotate")
+   {
+      for(double angle : {0.0,1.57079633,-3.87112283,9.60243503})
+      {
+         Rotation3D rotation(axis,angle);
+         for(const Vector3D &vector : vectors)
+         {
+            if(vector.isNaN()) continue;
+            Vector3D check=vector,result=rotation*vector;
+            check.rotate(axis,angle,Vector3D::Radians,Vector3D::Precise);
+            CHECK_THAT(result.x(),Catch::Matchers::WithinAbs(check.x(),delta));
+            CHECK_THAT(result.y(),Catch::Matchers::WithinAbs(check.y(),delta));
+            CHECK_THAT(result.z(),Catch::Matchers::WithinAbs(check.z(),delta));
+         }
+      }
+
+      Vector3D vector(5.0,0.0,0.0);
+      Rotation3D(0.0,0.0,-1.0,90.0,Vector3D::Degrees).apply(vector);
+      CHECK_THAT(vector.x(),Catch::Matchers::WithinAbs(0.0,delta));
+      CHECK_THAT(vector.y(),Catch::Matchers::WithinAbs(5.0,delta));
+      CHECK_THAT(vector.z(),Catch::Matchers::WithinAbs(0.0,delta));
+
+      CHECK(Rotation3D(0.0,0.0,0.0,1.0).isIdentity());
+      CHECK(Rotation3D(axis,0.0).isIdentity());
+   }
+
+   SECTION("Composition and inverse")
+   {
+      Rotation3D rotation1(axis,0.7),rotation2(Vector3D(-6.250,-35.281,36.325),-2.1);
+      Vector3D vector(-10.927,-14.151,24.814),check=vector;
+      check.rotate(Vector3D(-6.250,-35.281,36.325),-2.1,Vector3D::Radians,Vector3D::Precise);
+      check.rotate(axis,0.7,Vector3D::Radians,Vector3D::Precise);
+      Vector3D result=(rotation1*rotation2)*vector;
+      CHECK_THAT(result.x(),Catch::Matchers::WithinAbs(check.x(),delta));
+      CHECK_THAT(result.y(),Catch::Matchers::WithinAbs(check.y(),delta));
+      CHECK_THAT(result.z(),Catch::Matchers::WithinAbs(check.z(),delta));
+
+      result=rotation1.inverse()*(rotation1*vector);
+      CHECK_THAT(result.x(),Catch::Matchers::WithinAbs(vector.x(),delta));
+      CHECK_THAT(result.y(),Catch::Matchers::WithinAbs(vector.y(),delta));
+      CHECK_THAT(result.z(),Catch::Matchers::WithinAbs(vector.z(),delta));
+   }
+
+   SECTION("Batch")
+   {
+      Rotation3D rotation(axis,191.205,Vector3D::Degrees);
+      for(Vector3DBatch::InstructionSet set : instructionSets())
+      {
+         CAPTURE(Vector3DBatch::instructionSetName(set));
+         Vector3DBatch::setInstructionSet(set);
+
+         Vector3DArray array(vectors);
+         std::vector<Vector3D> aos=vectors;
+         array.rotate(rotation);
+         CHECK(rotation.apply(aos));
+         for(std::size_t i=0;i<vectors.size();i++)
+         {
+            CHECK(isIdentical(array[i],rotation*vectors[i]));
+            CHECK(isIdentical(aos[i],rotation*vectors[i]));
+         }
+      }
+      Vector3DBatch::setInstructionSet(defaultSet);
+   }
+}
+
+TEST_CASE("Precision templates")
+{
+   STATIC_REQUIRE(std::is_same<decltype(Vector3DFloat().length()),float>::value);
+   STATIC_REQUIRE(std::is_same<decltype(Vector3DLongDouble().angle(Vector3DLongDouble(),Vector3D::Radians,Vector3D::Precise)),long double>::value);
+   STATIC_REQUIRE(Vector3DFloat::Traits::epsilon==std::numeric_limits<float>::epsilon());
+   STATIC_REQUIRE(Vector3D::Traits::deg2rad==M_DEG2RAD);
+   STATIC_REQUIRE(Vector3D::Traits::rad2deg==M_RAD2DEG);
+   STATIC_REQUIRE(sizeof(Vector3DFloat)==3*sizeof(float));
+
+   Vector3D vector(-11.872,48.280,-35.682),axis(-37.360,-30.796,-30.118);
+   Vector3DFloat vectorFloat(vector),axisFloat(axis);
+   Vector3DLongDouble vectorLong(vector),axisLong(axis);
+   double delta=1.0e-4;
+
+   SECTION("Conversion")
+   {
+      CHECK(vectorFloat.x()==static_cast<float>(vector.x()));
+      CHECK(Vector3D(vectorLong)==vector);
+      CHECK((2.0*vectorFloat)==Vector3DFloat(vectorFloat.x()*2.0f,vectorFloat.y()*2.0f,vectorFloat.z()*2.0f));
+   }
+
+   SECTION("Methods")
+   {
+      CHECK_THAT(vectorFloat.length(),Catch::Matchers::WithinAbs(vector.length(),delta));
+      CHECK_THAT(vectorFloat.distance(axisFloat),Catch::Matchers::WithinAbs(vector.distance(axis),delta));
+      CHECK_THAT(vectorFloat.angle(axisFloat,Vector3D::Degrees,Vector3D::Precise),Catch::Matchers::WithinAbs(vector.angle(axis,Vector3D::Degrees,Vector3D::Precise),1.0e-3));
+      CHECK_THAT(static_cast<double>(vectorLong.length()),Catch::Matchers::WithinAbs(vector.length(),1.0e-12));
+
+      vector.rotate(axis,-221.799,Vector3D::Degrees,Vector3D::Precise);
+      vectorFloat.rotate(axisFloat,-221.799f,Vector3DFloat::Degrees,Vector3DFloat::Precise);
+      vectorLong.rotate(axisLong,-221.799L,Vector3D::Degrees,Vector3D::Precise);
+      CHECK_THAT(vectorFloat.x(),Catch::Matchers::WithinAbs(-21.62114171,delta));
+      CHECK_THAT(vectorFloat.y(),Catch::Matchers::WithinAbs(-25.10782215,delta));
+      CHECK_THAT(vectorFloat.z(),Catch::Matchers::WithinAbs(51.45125271,delta));
+      CHECK_THAT(static_cast<double>(vectorLong.x()),Catch::Matchers::WithinAbs(vector.x(),1.0e-12));
+
+      CHECK(Vector3DFloat(1.0e-8f,0.0f,0.0f).isZero());
+      CHECK_FALSE(Vector3D(1.0e-8,0.0,0.0).isZero());
+      CHECK((vectorFloat/0.0f).isNaN());
+   }
+}
+
+TEST_CASE("Squared length and sorting")
+{
+   Vector3D vector(-11.872,48.280,-35.682),point(-37.360,-30.796,-30.118);
+
+   SECTION("Squared measures")
+   {
+      CHECK(vector.lengthSquared()==vector.x()*vector.x()+vector.y()*vector.y()+vector.z()*vector.z());
+      CHECK_THAT(std::sqrt(vector.distanceSquared(point)),Catch::Matchers::WithinAbs(vector.distance(point),1.0e-12));
+      CHECK(Vector3D::LengthLess()(point,vector)==(point.length()<vector.length()));
+      CHECK(Vector3D::LengthGreater()(point,vector)==(point.length()>vector.length()));
+      CHECK(Vector3D::DistanceLess(point)(point,vector));
+      CHECK_FALSE(Vector3D::DistanceLess(point)(vector,vector));
+   }
+
+   std::mt19937 generator(7);
+   std::uniform_real_distribution<double> distribution(-50.0,50.0);
+   std::vector<Vector3D> vectors(1000);
+   for(Vector3D &item : vectors) item=Vector3D(distribution(generator),distribution(generator),distribution(generator));
+   vectors[10]=vectors[20];
+   vectors[30].setX(std::numeric_limits<double>::quiet_NaN());
+   Vector3D nanVector=vectors[30];
+
+   auto isSame=[](const Vector3D &vector1, const Vector3D &vector2)
+   {
+      return std::memcmp(&vector1,&vector2,sizeof(Vector3D))==0;
+   };
+
+   SECTION("Sort by length")
+   {
+      std::vector<Vector3D> expected(vectors.begin(),vectors.end()),sorted(vectors);
+      expected.erase(expected.begin()+30);
+      std::stable_sort(expected.begin(),expected.end(),Vector3D::LengthLess());
+      expected.push_back(nanVector);
+      Vector3DSort::sortByLength(sorted.begin(),sorted.end());
+      CHECK(std::equal(sorted.begin(),sorted.end(),expected.begin(),isSame));
+
+      std::vector<std::size_t> order=Vector3DSort::orderByLength(vectors.begin(),vectors.end());
+      CHECK(order.back()==30);
+      for(std::size_t i=0;i<order.size();i++) CHECK(isSame(vectors[order[i]],sorted[i]));
+
+      std::vector<Vector3D> partial(vectors);
+      Vector3DSort::partialSortByLength(partial.begin(),partial.begin()+50,partial.end());
+      CHECK(std::equal(partial.begin(),partial.begin()+50,expected.begin(),isSame));
+
+      std::vector<Vector3D> nth(vectors);
+      Vector3DSort::nthElementByLength(nth.begin(),nth.begin()+500,nth.end());
+      CHECK(isSame(nth[500],expected[500]));
+      for(std::size_t i=0;i<500;i++) CHECK(nth[i].lengthSquared()<=nth[500].lengthSquared());
+   }
+
+   SECTION("Sort by distance")
+   {
+      std::vector<Vector3D> expected(vectors.begin(),vectors.end()),sorted(vectors);
+      expected.erase(expected.begin()+30);
+      std::stable_sort(expected.begin(),expected.end(),Vector3D::DistanceLess(point));
+      expected.push_back(nanVector);
+      Vector3DSort::sortByDistance(sorted.begin(),sorted.end(),point);
+      CHECK(std::equal(sorted.begin(),sorted.end(),expected.begin(),isSame));
+
+      std::vector<Vector3D> partial(vectors);
+      Vector3DSort::partialSortByDistance(partial.begin(),partial.begin()+10,partial.end(),point);
+      CHECK(std::equal(partial.begin(),partial.begin()+10,expected.begin(),isSame));
+
+      std::vector<Vector3D> nth(vectors);
+      Vector3DSort::nthElementByDistance(nth.begin(),nth.begin()+999,nth.end(),point);
+      CHECK(nth[999].isNaN());
+      CHECK(Vector3DSort::orderByDistance(vectors.begin(),vectors.end(),point).front()==static_cast<std::size_t>(std::min_element(vectors.begin(),vectors.end(),Vector3D::DistanceLess(point))-vectors.begin()));
+   }
+}
+
+TEST_CASE("Lazy expressions")
+{
+   using Vector3DExpr::lazy;
+
+   Vector3D vector1(-11.872,48.280,-35.682),vector2(-37.360,-30.796,-30.118),vector3(12.5,-0.25,7.0);
+   double factor1=1.75,factor2=-3.5;
+
+   auto isSame=[](const Vector3D &vector1, const Vector3D &vector2)
+   {
+      return std::memcmp(&vector1,&vector2,sizeof(Vector3D))==0;
+   };
+
+   SECTION("Single vectors")
+   {
+      Vector3D eager=vector1+vector2*factor1-vector3/factor2;
+      Vector3D fused=lazy(vector1)+lazy(vector2)*factor1-lazy(vector3)/factor2;
+      CHECK(isSame(fused,eager));
+      CHECK(isSame(Vector3DExpr::evaluate(factor1*(lazy(vector1)-vector2)+vector3),factor1*(vector1-vector2)+vector3));
+      CHECK(Vector3DExpr::evaluate(lazy(vector1)/0.0).isNaN());
+      Vector3DFloat fusedFloat=lazy(Vector3DFloat(vector1))*2.0f;
+      CHECK(fusedFloat==Vector3DFloat(vector1)*2.0f);
+   }
+
+   std::mt19937 generator(11);
+   std::uniform_real_distribution<double> distribution(-50.0,50.0);
+   std::size_t size=1003;
+   Vector3DArray array1(size),array2(size);
+   std::vector<Vector3D> vectors(size);
+   for(std::size_t i=0;i<size;i++)
+   {
+      array1.set(i,Vector3D(distribution(generator),distribution(generator),distribution(generator)));
+      array2.set(i,Vector3D(distribution(generator),distribution(generator),distribution(generator)));
+      vectors[i]=Vector3D(distribution(generator),distribution(generator),distribution(generator));
+   }
+
+   SECTION("Arrays")
+   {
+      Vector3DArray result(size);
+      REQUIRE(Vector3DExpr::assign(result,lazy(array1)+lazy(array2)*factor1-vector3/factor2+lazy(vectors)));
+      for(std::size_t i=0;i<size;i++) CHECK(isSame(result[i],array1[i]+array2[i]*factor1-vector3/factor2+vectors[i]));
+
+      std::vector<Vector3D> strided(size);
+      REQUIRE(Vector3DExpr::assign(strided,(lazy(vectors)-lazy(array1))*factor2));
+      for(std::size_t i=0;i<size;i++) CHECK(isSame(strided[i],(vectors[i]-array1[i])*factor2));
+
+      Vector3DArray copy(array1);
+      REQUIRE(Vector3DExpr::assign(array1,lazy(array1)+lazy(array2)));
+      for(std::size_t i=0;i<size;i++) CHECK(isSame(array1[i],copy[i]+array2[i]));
+
+      Vector3DArray shorter(size-1);
+      CHECK_FALSE(Vector3DExpr::assign(shorter,lazy(array1)+lazy(array2)));
+      CHECK_FALSE(Vector3DExpr::assign(result,lazy(array1)+lazy(shorter)));
+   }
+}
+
+TEST_CASE("Quaternion")
+{
+   std::vector<Vector3D> vectors=randomVectors(517,13);
+   Vector3D axis1(48.561,23.648,36.697),axis2(-6.250,-35.281,36.325),axis3(0.5,-1.0,2.0);
+   double delta=1.0e-12;
+
+   auto isNear=[delta](const Vector3D &vector1, const Vector3D &vector2)
+   {
+      return std::fabs(vector1.x()-vector2.x())<delta && std::fabs(vector1.y()-vector2.y())<delta && std::fabs(vector1.z()-vector2.z())<delta;
+   };
+   auto isNearQuaternion=[delta](const Quaternion &quaternion1, const Quaternion &quaternion2)
+   {
+      return std::fabs(quaternion1.w()-quaternion2.w())<delta && std::fabs(quaternion1.x()-quaternion2.x())<delta && std::fabs(quaternion1.y()-quaternion2.y())<delta && std::fabs(quaternion1.z()-quaternion2.z())<delta;
+   };
+
+   SECTION("Matches rotate")
+   {
+      Quaternion quaternion(axis1,-3.87112283);
+      Rotation3D rotation(axis1,-3.87112283);
+      CHECK(std::memcmp(Rotation3D(quaternion).data(),rotation.data(),sizeof(double)*9)==0);
+      Vector3D vector(-10.927,-14.151,24.814),check=vector;
+      check.rotate(axis1,-3.87112283,Vector3D::Radians,Vector3D::Precise);
+      CHECK(isNear(quaternion*vector,check));
+      CHECK(Rotation3D(Quaternion()).isIdentity());
+      CHECK(Quaternion(axis1,0.0)==Quaternion());
+
+      Quaternion drifted(quaternion.w()*1.25,quaternion.x()*1.25,quaternion.y()*1.25,quaternion.z()*1.25);
+      CHECK(isNear(Rotation3D(drifted)*vector,check));
+      for(int i=0;i<9;i++) CHECK_THAT(Rotation3D(drifted).data()[i],Catch::Matchers::WithinAbs(rotation.data()[i],delta));
+   }
+
+   SECTION("Composition")
+   {
+      Quaternion quaternion1(axis1,0.7),quaternion2(axis2,-2.1),quaternion3(axis3,191.205,Vector3D::Degrees);
+      Quaternion chain=quaternion1*quaternion2*quaternion3;
+      Vector3D vector(-10.927,-14.151,24.814),check=vector;
+      check.rotate(axis3,191.205,Vector3D::Degrees,Vector3D::Precise);
+      check.rotate(axis2,-2.1,Vector3D::Radians,Vector3D::Precise);
+      check.rotate(axis1,0.7,Vector3D::Radians,Vector3D::Precise);
+      CHECK(isNear(chain*vector,check));
+      CHECK_THAT(chain.norm(),Catch::Matchers::WithinAbs(1.0,delta));
+
+      Quaternion accumulated;
+      accumulated*=quaternion1; accumulated*=quaternion2; accumulated*=quaternion3;
+      CHECK(accumulated==chain);
+      CHECK(isNear(chain.inverse()*(chain*vector),vector));
+      CHECK(isNearQuaternion(chain.inverse(),chain.conjugate()));
+      CHECK(Quaternion(2.0,0.0,0.0,0.0).inverse()==Quaternion(0.5,0.0,0.0,0.0));
+      CHECK(Quaternion(0.0,0.0,0.0,0.0).inverse().w()!=Quaternion(0.0,0.0,0.0,0.0).inverse().w());
+
+      Quaternion scaled(2.0,-4.0,0.0,4.0);
+      CHECK(scaled.normalize());
+      CHECK(isNearQuaternion(scaled,Quaternion(1.0/3.0,-2.0/3.0,0.0,2.0/3.0)));
+      CHECK_FALSE(Quaternion(0.0,0.0,0.0,0.0).normalize());
+
+      // tiny quaternions are still invertible and normalizable
+      CHECK(Quaternion(1.0e-9,0.0,0.0,0.0).inverse()==Quaternion(1.0e9,0.0,0.0,0.0));
+      CHECK(Quaternion(0.0,2.0e-200,0.0,0.0).inverse()==Quaternion(0.0,-5.0e199,0.0,0.0));
+      Quaternion tiny(0.0,0.0,3.0e-170,4.0e-170);
+      CHECK(tiny.normalize());
+      CHECK(isNearQuaternion(tiny,Quaternion(0.0,0.0,0.6,0.8)));
+      Quaternion small(1.0e-20,0.0,0.0,0.0);
+      CHECK(small.normalize());
+      CHECK(small==Quaternion());
+   }
+
+   SECTION("Conversions")
+   {
+      for(double angle : {0.3,1.57079633,3.0,-2.5})
+      {
+         Quaternion quaternion(axis2,angle);
+         Vector3D axis;
+         double result;
+         REQUIRE(quaternion.toAxisAngle(axis,result));
+         CHECK(isNear(Quaternion(axis,result)*axis3,quaternion*axis3));
+         CHECK(result>=0.0);
+         CHECK(result<=Vector3D::Traits::pi);
+
+         Quaternion fromMatrix(Rotation3D(axis2,angle));
+         CHECK_THAT(std::fabs(fromMatrix.dot(quaternion)),Catch::Matchers::WithinAbs(1.0,delta));
+      }
+
+      Vector3D axis;
+      double angle;
+      REQUIRE(Quaternion(axis3,60.0,Vector3D::Degrees).toAxisAngle(axis,angle,Vector3D::Degrees));
+      CHECK_THAT(angle,Catch::Matchers::WithinAbs(60.0,1.0e-9));
+      CHECK(isNear(axis,axis3/axis3.length()));
+      CHECK_FALSE(Quaternion().toAxisAngle(axis,angle));
+      CHECK(angle==0.0);
+   }
+
+   SECTION("Interpolation")
+   {
+      Quaternion start(axis1,0.2),end(axis1,1.4);
+      CHECK(isNearQuaternion(Quaternion::slerp(start,end,0.0),start));
+      CHECK(isNearQuaternion(Quaternion::slerp(start,end,1.0),end));
+      CHECK(isNearQuaternion(Quaternion::slerp(start,end,0.5),Quaternion(axis1,0.8)));
+      CHECK(isNearQuaternion(Quaternion::slerp(start,end,0.25),Quaternion(axis1,0.5)));
+      Quaternion flipped(-end.w(),-end.x(),-end.y(),-end.z());
+      CHECK(isNearQuaternion(Quaternion::slerp(start,flipped,0.5),Quaternion(axis1,0.8)));
+
+      Quaternion halfway=Quaternion::nlerp(start,end,0.5);
+      CHECK_THAT(halfway.norm(),Catch::Matchers::WithinAbs(1.0,delta));
+      CHECK(isNearQuaternion(halfway,Quaternion(axis1,0.8)));
+      CHECK(isNearQuaternion(Quaternion::slerp(start,start,0.3),start));
+   }
+
+   SECTION("Batch")
+   {
+      Quaternion chain=Quaternion(axis1,0.7)*Quaternion(axis2,-2.1);
+      Rotation3D rotation(chain);
+      Vector3DArray array(vectors);
+      std::vector<Vector3D> aos=vectors;
+      CHECK(chain.apply(array));
+      CHECK(chain.apply(aos));
+      for(std::size_t i=0;i<vectors.size();i++)
+      {
+         CHECK(isIdentical(array[i],rotation*vectors[i]));
+         CHECK(isIdentical(aos[i],chain*vectors[i]));
+      }
+   }
+}
+
+TEST_CASE("Transform object")
+{
+   Vector3D axis(48.561,23.648,36.697),offset(-6.250,-35.281,36.325);
+   double factor=-2.75,delta=1.0e-12;
+   Vector3DBatch::InstructionSet defaultSet=Vector3DBatch::instructionSet();
+
+   auto isNear=[](const Vector3D &vector1, const Vector3D &vector2, double delta)
+   {
+      return std::fabs(vector1.x()-vector2.x())<delta && std::fabs(vector1.y()-vector2.y())<delta && std::fabs(vector1.z()-vector2.z())<delta;
+   };
+
+   SECTION("Matches the operation chain")
+   {
+      Transform3D transform;
+      CHECK(transform.isIdentity());
+      transform.rotate(axis,-3.87112283).scale(factor).translate(offset);
+      CHECK_FALSE(transform.isIdentity());
+      CHECK(Transform3D(Rotation3D(axis,-3.87112283),factor,offset).element(1,2)==transform.element(1,2));
+
+      Vector3D vector(-10.927,-14.151,24.814),check=vector;
+      check.rotate(axis,-3.87112283,Vector3D::Radians,Vector3D::Precise);
+      check*=factor;
+      check+=offset;
+      CHECK(isNear(transform*vector,check,1.0e-11));
+
+      Transform3D composed=Transform3D::translation(offset)*Transform3D::scaling(factor)*Transform3D(Rotation3D(axis,-3.87112283));
+      for(int row=0;row<3;row++)
+      {
+         for(int column=0;column<4;column++) CHECK_THAT(composed.element(row,column),Catch::Matchers::WithinAbs(transform.element(row,column),delta));
+      }
+      CHECK(Transform3D::scaling(1.0).isIdentity());
+      CHECK(Transform3D::translation(Vector3D()).isIdentity());
+   }
+
+   SECTION("Inverse")
+   {
+      Transform3D transform=Transform3D(Rotation3D(axis,0.7),factor,offset);
+      Vector3D vector(-10.927,-14.151,24.814);
+      CHECK(isNear(transform.inverse()*(transform*vector),vector,1.0e-11));
+      CHECK(isNear((transform*transform.inverse())*vector,vector,1.0e-11));
+      CHECK(Transform3D().inverse().isIdentity());
+      CHECK((Transform3D::scaling(0.0).inverse()*vector).isNaN());
+      CHECK_THAT(Transform3D::scaling(1.0e-6).inverse().element(0,0),Catch::Matchers::WithinRel(1.0e6,1.0e-12));
+      CHECK(isNear(Transform3D::scaling(1.0e-6).inverse()*(Transform3D::scaling(1.0e-6)*vector),vector,1.0e-11));
+      CHECK_FALSE((Transform3D::scaling(1.0e60).inverse()*vector).isNaN());
+   }
+
+   SECTION("Batch")
+   {
+      Transform3D transform=Transform3D(Rotation3D(axis,191.205,Vector3D::Degrees),factor,offset);
+      for(std::size_t size : {std::size_t(517),std::size_t(200003)})
+      {
+         std::vector<Vector3D> vectors=randomVectors(size,17);
+         for(Vector3DBatch::InstructionSet set : instructionSets())
+         {
+            CAPTURE(Vector3DBatch::instructionSetName(set),size);
+            Vector3DBatch::setInstructionSet(set);
+
+            Vector3DArray array(vectors),result(size);
+            std::vector<Vector3D> aos=vectors;
+            CHECK(transform.apply(array,result));
+            array.transform(transform);
+            CHECK(transform.apply(aos));
+            bool identical=true;
+            for(std::size_t i=0;i<size;i++)
+            {
+               Vector3D check=transform*vectors[i];
+               identical=identical && isIdentical(array[i],check) && isIdentical(result[i],check) && isIdentical(aos[i],check);
+            }
+            CHECK(identical);
+         }
+      }
+      Vector3DArray shorter(3);
+      CHECK_FALSE(Vector3DBatch::transform(Vector3DArray(4),transform,shorter));
+      Vector3DBatch::setInstructionSet(defaultSet);
+   }
+}
+
+TEST_CASE("Spatial index")
+{
+   std::vector<Vector3D> points=randomVectors(2000,19),queries=randomVectors(50,23);
+   points[100]=points[200];
+   queries[5]=Vector3D(60.0,-60.0,0.0);
+
+   auto bruteNearest=[](const std::vector<Vector3D> &points, const std::vector<std::uint8_t> &removed, const Vector3D &query, std::size_t count)
+   {
+      std::vector<Vector3DIndex::Neighbor> neighbors;
+      for(std::size_t id=0;id<points.size();id++)
+      {
+         if(!removed[id] && !points[id].isNaN()) neighbors.push_back({id,points[id].distanceSquared(query)});
+      }
+      std::sort(neighbors.begin(),neighbors.end(),[](const Vector3DIndex::Neighbor &neighbor1, const Vector3DIndex::Neighbor &neighbor2)
+      {
+         return neighbor1.distanceSquared<neighbor2.distanceSquared || (neighbor1.distanceSquared==neighbor2.distanceSquared && neighbor1.id<neighbor2.id);
+      });
+      if(neighbors.size()>count) neighbors.resize(count);
+      return neighbors;
+   };
+
+   auto isSame=[](const std::vector<Vector3DIndex::Neighbor> &neighbors1, const std::vector<Vector3DIndex::Neighbor> &neighbors2)
+   {
+      if(neighbors1.size()!=neighbors2.size()) return false;
+      for(std::size_t i=0;i<neighbors1.size();i++)
+      {
+         if(neighbors1[i].id!=neighbors2[i].id || neighbors1[i].distanceSquared!=neighbors2[i].distanceSquared) return false;
+      }
+      return true;
+   };
+
+   Vector3DIndex index(points);
+   std::vector<std::uint8_t> removed(points.size(),0);
+   REQUIRE(index.size()==points.size());
+
+   SECTION("Queries")
+   {
+      queries.push_back(points[100]);
+      for(const Vector3D &query : queries)
+      {
+         CHECK(isSame(index.nearest(query,7),bruteNearest(points,removed,query,7)));
+         CHECK(index.nearest(query).id==bruteNearest(points,removed,query,1).front().id);
+
+         std::vector<std::size_t> expected;
+         for(std::size_t id=0;id<points.size();id++)
+         {
+            if(points[id].distance(query)<=15.0) expected.push_back(id);
+         }
+         CHECK(index.radius(query,15.0)==expected);
+
+         Vector3D minimum(query.x()-10.0,query.y()-20.0,query.z()-5.0),maximum(query.x()+10.0,query.y()+20.0,query.z()+5.0);
+         expected.clear();
+         for(std::size_t id=0;id<points.size();id++)
+         {
+            const Vector3D &point=points[id];
+            if(point.x()>=minimum.x() && point.x()<=maximum.x() && point.y()>=minimum.y() && point.y()<=maximum.y() && point.z()>=minimum.z() && point.z()<=maximum.z()) expected.push_back(id);
+         }
+         CHECK(index.box(minimum,maximum)==expected);
+      }
+      CHECK(index.nearest(points[200]).id==100);
+      CHECK(index.nearest(points[5]).id!=5);
+      CHECK(index.nearest(Vector3D(std::numeric_limits<double>::quiet_NaN(),0.0,0.0)).id==Vector3DIndex::npos);
+      CHECK(Vector3DIndex().nearest(queries[0]).id==Vector3DIndex::npos);
+      CHECK(index.nearest(queries[0],3000).size()==points.size()-1);
+   }
+
+   SECTION("Batch queries")
+   {
+      std::vector<Vector3DIndex::Neighbor> neighbors(queries.size()*4);
+      REQUIRE(index.nearest(queries,4,neighbors));
+      for(std::size_t i=0;i<queries.size();i++)
+      {
+         CHECK(isSame(std::vector<Vector3DIndex::Neighbor>(neighbors.begin()+i*4,neighbors.begin()+i*4+4),index.nearest(queries[i],4)));
+      }
+      CHECK_FALSE(index.nearest(queries,3,neighbors));
+
+      std::vector<std::vector<std::size_t>> ids=index.radius(queries,12.0);
+      REQUIRE(ids.size()==queries.size());
+      for(std::size_t i=0;i<queries.size();i++) CHECK(ids[i]==index.radius(queries[i],12.0));
+
+      Vector3DIndex small(std::vector<Vector3D>{Vector3D(1.0,0.0,0.0),Vector3D(2.0,0.0,0.0)});
+      std::vector<Vector3DIndex::Neighbor> padded(3);
+      REQUIRE(small.nearest(std::vector<Vector3D>{Vector3D()},3,padded));
+      CHECK(padded[0].id==0);
+      CHECK(padded[2].id==Vector3DIndex::npos);
+
+      Vector3DThreadPool pool(4);
+      for(const Vector3DExecution &execution : {Vector3DExecution::sequential(),Vector3DExecution::parallel(pool,8)})
+      {
+         std::vector<Vector3DIndex::Neighbor> placed(queries.size()*4);
+         REQUIRE(index.nearest(execution,queries,4,placed));
+         for(std::size_t i=0;i<placed.size();i++) CHECK((placed[i].id==neighbors[i].id && placed[i].distanceSquared==neighbors[i].distanceSquared));
+         CHECK(index.radius(execution,queries,12.0)==ids);
+      }
+   }
+
+   SECTION("Parallel build")
+   {
+      Vector3DThreadPool pool(4);
+      Vector3DIndex sequential,parallel;
+      sequential.build(points,Vector3DExecution::sequential());
+      parallel.build(points,Vector3DExecution::parallel(pool,16));
+      for(const Vector3D &query : queries)
+      {
+         CHECK(isSame(parallel.nearest(query,7),bruteNearest(points,removed,query,7)));
+         CHECK(isSame(parallel.nearest(query,7),sequential.nearest(query,7)));
+         CHECK(parallel.radius(query,15.0)==sequential.radius(query,15.0));
+      }
+   }
+
+   SECTION("Insert and remove")
+   {
+      std::vector<Vector3D> inserted=randomVectors(1500,29);
+      for(std::size_t i=0;i<inserted.size();i++)
+      {
+         std::size_t id=index.insert(inserted[i]);
+         CHECK(id==points.size());
+         points.push_back(inserted[i]);
+         removed.push_back(0);
+         if(i%3==0)
+         {
+            CHECK(index.remove(i*2));
+            removed[i*2]=1;
+         }
+         if(i%97==0)
+         {
+            for(const Vector3D &query : queries) CHECK(isSame(index.nearest(query,5),bruteNearest(points,removed,query,5)));
+         }
+      }
+      CHECK_FALSE(index.remove(0));
+      CHECK_FALSE(index.remove(points.size()));
+      CHECK_FALSE(index.contains(0));
+      CHECK(index.contains(1));
+      CHECK(index.size()==points.size()-500);
+      for(const Vector3D &query : queries)
+      {
+         CHECK(isSame(index.nearest(query,9),bruteNearest(points,removed,query,9)));
+         std::vector<std::size_t> expected;
+         for(std::size_t id=0;id<points.size();id++)
+         {
+            if(!removed[id] && points[id].distance(query)<=10.0) expected.push_back(id);
+         }
+         CHECK(index.radius(query,10.0)==expected);
+      }
+
+      for(std::size_t id=0;id<points.size();id++) index.remove(id);
+      CHECK(index.isEmpty());
+      CHECK(index.nearest(queries[0]).id==Vector3DIndex::npos);
+   }
+}
+
+TEST_CASE("Execution policy")
+{
+   Vector3D axis(48.561,23.648,36.697),offset(-6.250,-35.281,36.325);
+   Rotation3D rotation(axis,-3.87112283);
+   Transform3D transform(rotation,-2.75,offset);
+   Vector3DThreadPool pool(4);
+   CHECK(pool.size()==4);
+   CHECK_FALSE(Vector3DExecution::sequential().isParallel());
+   CHECK(Vector3DExecution::parallel(pool,8).isParallel());
+
+   SECTION("Results do not depend on the policy")
+   {
+      std::size_t size=20011;
+      std::vector<Vector3D> vectors=randomVectors(size,23),others=randomVectors(size,29);
+      std::vector<Vector3DExecution> executions={Vector3DExecution::parallel(),Vector3DExecution::parallel(pool,8),Vector3DExecution::parallel(pool,1000)};
+
+      Vector3DArray array(vectors),other(others),sum(size),moved(size),turned(size),placed(size);
+      std::vector<double> lengths(size),distances(size),angles(size);
+      std::vector<std::uint8_t> zeros(size),nans(size);
+      Vector3DBatch::add(Vector3DExecution::sequential(),array,other,sum);
+      Vector3DBatch::subtract(Vector3DExecution::sequential(),array,offset,moved);
+      Vector3DBatch::rotate(Vector3DExecution::sequential(),array,rotation,turned);
+      Vector3DBatch::transform(Vector3DExecution::sequential(),array,transform,placed);
+      Vector3DBatch::length(Vector3DExecution::sequential(),array,lengths);
+      Vector3DBatch::distance(Vector3DExecution::sequential(),array,offset,distances);
+      Vector3DBatch::angle(Vector3DExecution::sequential(),array,axis,angles,Vector3D::Degrees);
+      Vector3DBatch::isZero(Vector3DExecution::sequential(),array,zeros);
+      Vector3DBatch::isNaN(Vector3DExecution::sequential(),array,nans);
+
+      for(std::size_t i=0;i<executions.size();i++)
+      {
+         CAPTURE(i);
+         const Vector3DExecution &execution=executions[i];
+         Vector3DArray result(size);
+         std::vector<Vector3D> aos(size);
+         std::vector<double> values(size);
+         std::vector<std::uint8_t> flags(size);
+
+         auto isSame=[&](const Vector3DArray &expected)
+         {
+            bool identical=true;
+            for(std::size_t j=0;j<size;j++) identical=identical && isIdentical(result[j],expected[j]) && isIdentical(aos[j],expected[j]);
+            return identical;
+         };
+
+         CHECK(Vector3DBatch::add(execution,array,other,result));
+         CHECK(Vector3DBatch::add(execution,vectors,others,aos));
+         CHECK(isSame(sum));
+         CHECK(Vector3DBatch::subtract(execution,array,offset,result));
+         CHECK(Vector3DBatch::subtract(execution,vectors,offset,aos));
+         CHECK(isSame(moved));
+         CHECK(Vector3DBatch::rotate(execution,array,rotation,result));
+         CHECK(Vector3DBatch::rotate(execution,vectors,rotation,aos));
+         CHECK(isSame(turned));
+         CHECK(Vector3DBatch::transform(execution,array,transform,result));
+         CHECK(Vector3DBatch::transform(execution,vectors,transform,aos));
+         CHECK(isSame(placed));
+         CHECK(Vector3DBatch::copy(execution,array,result));
+         CHECK(Vector3DBatch::copy(execution,vectors,aos));
+         CHECK(isSame(array));
+
+         CHECK(Vector3DBatch::length(execution,vectors,values));
+         CHECK(std::memcmp(values.data(),lengths.data(),size*sizeof(double))==0);
+         CHECK(Vector3DBatch::distance(execution,array,offset,values));
+         CHECK(std::memcmp(values.data(),distances.data(),size*sizeof(double))==0);
+         CHECK(Vector3DBatch::angle(execution,vectors,axis,values,Vector3D::Degrees));
+         CHECK(std::memcmp(values.data(),angles.data(),size*sizeof(double))==0);
+         CHECK(Vector3DBatch::isZero(execution,array,flags));
+         CHECK(flags==zeros);
+         CHECK(Vector3DBatch::isNaN(execution,vectors,flags));
+         CHECK(flags==nans);
+      }
+   }
+
+   SECTION("Thread pool")
+   {
+      for(std::size_t size : {std::size_t(0),std::size_t(1),std::size_t(100),std::size_t(100003)})
+      {
+         std::vector<std::atomic<int>> visits(size);
+         pool.parallelFor(size,64,[&](std::size_t offset, std::size_t count)
+         {
+            for(std::size_t i=offset;i<offset+count;i++) visits[i]++;
+         });
+         CHECK(std::all_of(visits.begin(),visits.end(),[](const std::atomic<int> &visit) { return visit==1; }));
+      }
+
+      std::atomic<std::size_t> total(0);
+      std::atomic<bool> nestedInline(true);
+      pool.parallelFor(64,1,[&](std::size_t, std::size_t)
+      {
+         std::thread::id outer=std::this_thread::get_id();
+         pool.parallelFor(256,16,[&](std::size_t, std::size_t count)
+         {
+            if(std::this_thread::get_id()!=outer) nestedInline=false;
+            total+=count;
+         });
+      });
+      CHECK(nestedInline);
+      CHECK(total==64*256);
+
+      // an exception on any thread reaches the caller and leaves the pool usable
+      for(std::size_t failing : {std::size_t(0),std::size_t(99968)})
+      {
+         CHECK_THROWS_AS(pool.parallelFor(100003,64,[&](std::size_t offset, std::size_t)
+         {
+            if(offset==failing) throw std::runtime_error("chunk failed");
+         }),std::runtime_error);
+      }
+      CHECK_THROWS_AS(pool.parallelFor(64,1,[&](std::size_t, std::size_t)
+      {
+         pool.parallelFor(256,16,[](std::size_t offset, std::size_t) { if(offset==128) throw std::runtime_error("nested chunk failed"); });
+      }),std::runtime_error);
+      std::vector<std::atomic<int>> visits(100003);
+      pool.parallelFor(visits.size(),64,[&](std::size_t offset, std::size_t count)
+      {
+         for(std::size_t i=offset;i<offset+count;i++) visits[i]++;
+      });
+      CHECK(std::all_of(visits.begin(),visits.end(),[](const std::atomic<int> &visit) { return visit==1; }));
+   }
+}
+
+TEST_CASE("Binary file")
+{
+   std::string path=(std::filesystem::temp_directory_path()/"vector3d_test.v3d").string();
+   std::vector<Vector3D> vectors=randomVectors(2500,31);
+
+   auto isSame=[](const Vector3DArray &array, const std::vector<Vector3D> &expected)
+   {
+      bool identical=array.size()==expected.size();
+      for(std::size_t i=0;identical && i<expected.size();i++) identical=isIdentical(array[i],expected[i]);
+      return identical;
+   };
+
+   SECTION("Float64 files are viewed in place")
+   {
+      REQUIRE(Vector3DFile::write(path,vectors,Vector3DFile::SoA,Vector3DFile::Float64,1000));
+      Vector3DFile file(path);
+      REQUIRE(file.isOpen());
+      CHECK(file.size()==vectors.size());
+      CHECK(file.layout()==Vector3DFile::SoA);
+      CHECK(file.chunkSize()==1008);
+      CHECK(file.chunkCount()==3);
+      CHECK(file.vectors().empty());
+      bool identical=true;
+      for(std::size_t index=0,offset=0;index<file.chunkCount();index++)
+      {
+         Vector3DArrayConstView chunk=file.chunk(index);
+         CHECK(reinterpret_cast<std::uintptr_t>(chunk.x())%4096==0);
+         for(std::size_t i=0;i<chunk.size();i++) identical=identical && isIdentical(chunk[i],vectors[offset+i]);
+         offset+=chunk.size();
+      }
+      CHECK(identical);
+      CHECK(file.chunk(3).size()==0);
+
+      Vector3DArray part(1500);
+      CHECK(file.read(500,part));
+      CHECK(isSame(part,std::vector<Vector3D>(vectors.begin()+500,vectors.begin()+2000)));
+      CHECK_FALSE(file.read(1001,part));
+
+      REQUIRE(Vector3DFile::write(path,vectors,Vector3DFile::AoS));
+      Vector3DFile aos(path);
+      REQUIRE(aos.isOpen());
+      std::span<const Vector3D> span=aos.vectors();
+      REQUIRE(span.size()==vectors.size());
+      CHECK(std::memcmp(span.data(),vectors.data(),vectors.size()*sizeof(Vector3D))==0);
+      Vector3DArray all(vectors.size());
+      CHECK(aos.read(0,all));
+      CHECK(isSame(all,vectors));
+
+      Vector3DFile moved=std::move(aos);
+      CHECK_FALSE(aos.isOpen());
+      CHECK(moved.vectors().data()==span.data());
+   }
+
+   SECTION("Float32 files are converted")
+   {
+      std::vector<Vector3DFloat> floats;
+      for(const Vector3D &vector : vectors) floats.push_back(Vector3DFloat(vector));
+      std::vector<Vector3D> rounded;
+      for(const Vector3DFloat &vector : floats) rounded.push_back(Vector3D(vector));
+      for(Vector3DFile::Layout layout : {Vector3DFile::AoS,Vector3DFile::SoA})
+      {
+         CAPTURE(layout);
+         REQUIRE(Vector3DFile::write(path,vectors,layout,Vector3DFile::Float32,64));
+         Vector3DFile file(path);
+         REQUIRE(file.isOpen());
+         CHECK(file.precision()==Vector3DFile::Float32);
+         CHECK(file.vectors().empty());
+         CHECK(file.chunk(0).size()==0);
+         Vector3DArray all(vectors.size());
+         CHECK(file.read(0,all));
+         CHECK(isSame(all,rounded));
+         std::vector<Vector3D> aos(100);
+         CHECK(file.read(1950,aos));
+         CHECK(std::equal(aos.begin(),aos.end(),rounded.begin()+1950,[](const Vector3D &vector1, const Vector3D &vector2) { return isIdentical(vector1,vector2); }));
+      }
+   }
+
+   SECTION("Streaming writer")
+   {
+      Vector3DFileWriter writer(path,Vector3DFile::SoA,Vector3DFile::Float64,256);
+      REQUIRE(writer.isOpen());
+      for(std::size_t offset=0;offset<vectors.size();offset+=333)
+      {
+         std::vector<Vector3D> part(vectors.begin()+offset,vectors.begin()+std::min(offset+333,vectors.size()));
+         CHECK(writer.append(part));
+      }
+      CHECK(writer.size()==2304);
+      CHECK(writer.close());
+      CHECK_FALSE(writer.isOpen());
+
+      Vector3DFile file(path);
+      REQUIRE(file.size()==vectors.size());
+      Vector3DArray all(vectors.size());
+      CHECK(file.read(0,all));
+      CHECK(isSame(all,vectors));
+
+      REQUIRE(writer.open(path));
+      CHECK(writer.close());
+      CHECK(Vector3DFile(path).size()==0);
+
+      // chunk sizes that wrap when rounded up or converted to bytes
+      for(std::size_t chunkSize : {std::numeric_limits<std::size_t>::max(),std::numeric_limits<std::size_t>::max()-14,std::numeric_limits<std::size_t>::max()/12})
+      {
+         CHECK_FALSE(writer.open(path,Vector3DFile::SoA,Vector3DFile::Float32,chunkSize));
+         CHECK_FALSE(writer.isOpen());
+         CHECK_FALSE(writer.append(std::vector<Vector3D>(vectors.begin(),vectors.begin()+10)));
+      }
+      CHECK_FALSE(Vector3DFile::write(path,vectors,Vector3DFile::AoS,Vector3DFile::Float64,std::numeric_limits<std::size_t>::max()/24));
+   }
+
+   SECTION("Invalid files")
+   {
+      Vector3DFile file;
+      CHECK_FALSE(file.open(path+".missing"));
+      {
+         std::ofstream out(path,std::ios::binary|std::ios::trunc);
+         out << "-10.927 -14.151 24.814\n";
+      }
+      CHECK_FALSE(file.open(path));
+      REQUIRE(Vector3DFile::write(path,vectors,Vector3DFile::SoA,Vector3DFile::Float64,1000));
+      std::filesystem::resize_file(path,std::filesystem::file_size(path)-8);
+      CHECK_FALSE(file.open(path));
+      CHECK_FALSE(file.isOpen());
+      Vector3DArray one(1);
+      CHECK_FALSE(file.read(0,one));
+
+      // Forged sizes whose byte counts wrap around 2^64
+      auto forge=[&path](std::uint64_t size, std::uint64_t chunkSize)
+      {
+         std::fstream out(path,std::ios::binary|std::ios::in|std::ios::out);
+         out.seekp(16);
+         out.write(reinterpret_cast<const char*>(&size),sizeof(size));
+         out.write(reinterpret_cast<const char*>(&chunkSize),sizeof(chunkSize));
+      };
+      for(Vector3DFile::Layout layout : {Vector3DFile::AoS,Vector3DFile::SoA})
+      {
+         CAPTURE(layout);
+         REQUIRE(Vector3DFile::write(path,std::vector<Vector3D>(vectors.begin(),vectors.begin()+10),layout,Vector3DFile::Float64,16));
+         forge(std::uint64_t(1)<<62,16);
+         CHECK_FALSE(file.open(path));
+         forge((std::uint64_t(1)<<62)+1,std::uint64_t(1)<<62);
+         CHECK_FALSE(file.open(path));
+         forge(11,16);
+         CHECK_FALSE(file.open(path));
+         forge(10,16);
+         CHECK(file.open(path));
+      }
+   }
+
+   std::filesystem::remove(path);
+}
+
+TEST_CASE("Text conversion")
+{
+   std::vector<Vector3D> vectors=randomVectors(3000,37);
+
+   SECTION("Single vectors")
+   {
+      Vector3D vector(45.969453,11.882488,-42.366982);
+      std::ostringstream oss;
+      oss << vector;
+      CHECK(Vector3DText::toString(vector,{6,true})==oss.str());
+      CHECK(Vector3DText::toString(vector)=="Vector3D(45.969453,11.882488,-42.366982)");
+      CHECK(Vector3DText::toString(Vector3D(1.0,-0.5,0.0),{2,false})=="Vector3D(1.00,-0.50,0.00)");
+      CHECK(Vector3DText::toString(Vector3DFloat(0.1f,2.0f,-3.5f))=="Vector3D(0.1,2,-3.5)");
+
+      char buffer[128];
+      bool identical=true;
+      for(const Vector3D &check : vectors)
+      {
+         std::to_chars_result written=Vector3DText::toChars(buffer,buffer+sizeof(buffer),check,{Vector3DText::shortest,true});
+         Vector3D parsed;
+         std::from_chars_result read=Vector3DText::fromChars(buffer,written.ptr,parsed);
+         identical=identical && written.ec==std::errc() && read.ec==std::errc() && read.ptr==written.ptr && (isIdentical(parsed,check) || (parsed.isNaN() && check.isNaN()));
+      }
+      CHECK(identical);
+      CHECK(Vector3DText::toChars(buffer,buffer+20,vector).ec==std::errc::value_too_large);
+
+      Vector3D parsed(1.0,2.0,3.0);
+      std::string text="Vector3D(1.5, +2,-3e2)tail";
+      std::from_chars_result result=Vector3DText::fromChars(text.data(),text.data()+text.size(),parsed);
+      CHECK(result.ec==std::errc());
+      CHECK(std::string(result.ptr)=="tail");
+      CHECK(parsed==Vector3D(1.5,2.0,-300.0));
+      for(std::string invalid : {"Vector3D(1,2)","Vector3D(1,2,x)","Vector(1,2,3)","Vector3D(1,2,3","Vector3D(1,+-2,3)","Vector3D(1,2,3, length=)"})
+      {
+         CAPTURE(invalid);
+         result=Vector3DText::fromChars(invalid.data(),invalid.data()+invalid.size(),parsed);
+         CHECK(result.ec!=std::errc());
+         CHECK(result.ptr==invalid.data());
+      }
+      CHECK(parsed==Vector3D(1.5,2.0,-300.0));
+   }
+
+   SECTION("XYZ and CSV files")
+   {
+      Vector3DArray array(vectors);
+      for(bool csv : {false,true})
+      {
+         CAPTURE(csv);
+         std::stringstream stream;
+         CHECK((csv ? Vector3DText::writeCSV(stream,array) : Vector3DText::writeXYZ(stream,vectors)));
+         Vector3DArray read;
+         CHECK((csv ? Vector3DText::readCSV(stream,read) : Vector3DText::readXYZ(stream,read)));
+         REQUIRE(read.size()==vectors.size());
+         bool identical=true;
+         for(std::size_t i=0;i<vectors.size();i++) identical=identical && (isIdentical(read[i],vectors[i]) || (read[i].isNaN() && vectors[i].isNaN()));
+         CHECK(identical);
+
+         std::stringstream fixed;
+         CHECK((csv ? Vector3DText::writeCSV(fixed,Vector3DArrayConstView(array).subview(0,2),3) : Vector3DText::writeXYZ(fixed,Vector3DArrayConstView(array).subview(0,2),3)));
+         char separator=csv ? ',' : ' ';
+         std::ostringstream expected;
+         expected << std::fixed << std::setprecision(3);
+         for(std::size_t i=0;i<2;i++) expected << vectors[i].x() << separator << vectors[i].y() << separator << vectors[i].z() << "\n";
+         CHECK(fixed.str()==expected.str());
+      }
+
+      Vector3DArray read;
+      std::istringstream xyz("# comment\n1 2 3\r\n\n  -4.5\t5 6e1 255 0 0\n+7 8 9");
+      CHECK(Vector3DText::readXYZ(xyz,read));
+      REQUIRE(read.size()==3);
+      CHECK(read[1]==Vector3D(-4.5,5.0,60.0));
+      CHECK(read[2]==Vector3D(7.0,8.0,9.0));
+
+      std::istringstream csv("x,y,z\n1, 2 ,3,extra\n4,5,6\n");
+      CHECK(Vector3DText::readCSV(csv,read));
+      REQUIRE(read.size()==5);
+      CHECK(read[3]==Vector3D(1.0,2.0,3.0));
+
+      for(std::string invalid : {"1 2\n","1 2 3x\n","1,2,3\n","1 2 3\nx y z\n"})
+      {
+         CAPTURE(invalid);
+         std::istringstream stream(invalid);
+         Vector3DArray partial;
+         CHECK_FALSE(Vector3DText::readXYZ(stream,partial));
+      }
+      std::istringstream headers("x,y,z\nx,y,z\n");
+      CHECK_FALSE(Vector3DText::readCSV(headers,read));
+   }
+}
+
+TEST_CASE("Fast math")
+{
+   std::mt19937 generator(41);
+   std::uniform_real_distribution<double> unit(-1.0,1.0),angles(-Vector3DFastMath::sinCosRange,Vector3DFastMath::sinCosRange);
+
+   SECTION("Approximations stay within their bounds")
+   {
+      double acosError=0.0,sinCosError=0.0;
+      for(int i=0;i<100000;i++)
+      {
+         double cosine=unit(generator),angle=i%2==0 ? angles(generator) : 4.0*unit(generator),sine,cosineOfAngle;
+         acosError=std::max(acosError,std::fabs(Vector3DFastMath::acos(cosine)-std::acos(cosine)));
+         Vector3DFastMath::sinCos(angle,sine,cosineOfAngle);
+         sinCosError=std::max({sinCosError,std::fabs(sine-std::sin(angle)),std::fabs(cosineOfAngle-std::cos(angle))});
+      }
+      CHECK(acosError<=Vector3DFastMath::acosError);
+      CHECK(sinCosError<=Vector3DFastMath::sinCosError);
+      CHECK(std::fabs(Vector3DFastMath::acos(-1.0)-M_PI)<=Vector3DFastMath::acosError);
+      CHECK(std::fabs(Vector3DFastMath::acos(1.0))<=Vector3DFastMath::acosError);
+      CHECK(std::isnan(Vector3DFastMath::acos(std::numeric_limits<double>::quiet_NaN())));
+
+      double sine,cosine;
+      Vector3DFastMath::sinCos(1.0e9,sine,cosine);
+      CHECK(sine==std::sin(1.0e9));
+      CHECK(cosine==std::cos(1.0e9));
+   }
+
+   SECTION("Fast methods match the precise ones")
+   {
+      std::vector<Vector3D> vectors=randomVectors(5000,43);
+      Vector3D axis(48.561,23.648,36.697);
+      double angleError=0.0,rotateError=0.0,lengthError=0.0;
+      for(const Vector3D &vector : vectors)
+      {
+         if(vector.isNaN()) continue;
+         angleError=std::max(angleError,std::fabs(vector.angle(axis,Vector3D::Radians,Vector3D::Fast)-vector.angle(axis,Vector3D::Radians,Vector3D::Precise)));
+
+         Vector3D fast=vector,precise=vector;
+         fast.rotate(axis,vector.x(),Vector3D::Radians,Vector3D::Fast);
+         precise.rotate(axis,vector.x(),Vector3D::Radians,Vector3D::Precise);
+         rotateError=std::max(rotateError,fast.distance(precise)/std::max(1.0,vector.length()));
+
+         fast=vector;
+         if(fast.setLength(2.5,Vector3D::Fast)) lengthError=std::max(lengthError,std::fabs(fast.length()-2.5));
+      }
+      CHECK(angleError<=Vector3DFastMath::acosError);
+      CHECK(rotateError<=4.0*Vector3DFastMath::sinCosError);
+      CHECK(lengthError<=8.0*std::numeric_limits<double>::epsilon());
+      CHECK_THAT(Vector3D(1.0,0.0,0.0).angle(Vector3D(0.0,1.0,0.0),Vector3D::Degrees,Vector3D::Fast),Catch::Matchers::WithinAbs(90.0,1.0e-5));
+      CHECK(Vector3D().angle(axis,Vector3D::Radians,Vector3D::Fast)==0.0);
+
+      Vector3DFloat vector(3.0f,-4.0f,12.0f);
+      CHECK(vector.setLength(1.0f,Vector3DFloat::Fast));
+      CHECK_THAT(vector.length(),Catch::Matchers::WithinAbs(1.0,1.0e-6));
+      Vector3DFloat precise=vector;
+      vector.rotate(Vector3DFloat(0.0f,0.0f,1.0f),90.0f,Vector3DFloat::Degrees,Vector3DFloat::Fast);
+      precise.rotate(Vector3DFloat(0.0f,0.0f,1.0f),90.0f,Vector3DFloat::Degrees,Vector3DFloat::Precise);
+      CHECK(vector.distance(precise)<1.0e-6f);
+   }
+
+   SECTION("Default arguments follow VECTOR3D_FAST_MATH")
+   {
+      Vector3D vector(39.216,-14.235,42.094),axis(46.412,47.500,-13.349);
+      CHECK(vector.angle(axis)==vector.angle(axis,Vector3D::Radians,Vector3D::VECTOR3D_DEFAULT_ACCURACY));
+      CHECK(vector.angle(axis.x(),axis.y(),axis.z())==vector.angle(axis,Vector3D::Radians,Vector3D::VECTOR3D_DEFAULT_ACCURACY));
+      Vector3D rotated=vector,check=vector;
+      rotated.rotate(axis,-3.87112283);
+      check.rotate(axis,-3.87112283,Vector3D::Radians,Vector3D::VECTOR3D_DEFAULT_ACCURACY);
+      CHECK(isIdentical(rotated,check));
+      rotated.rotate(axis.x(),axis.y(),axis.z(),1.25);
+      check.rotate(axis,1.25,Vector3D::Radians,Vector3D::VECTOR3D_DEFAULT_ACCURACY);
+      CHECK(isIdentical(rotated,check));
+      rotated.setLength(2.5);
+      check.setLength(2.5,Vector3D::VECTOR3D_DEFAULT_ACCURACY);
+      CHECK(isIdentical(rotated,check));
+   }
+}
+
+TEST_CASE("Reductions")
+{
+   std::size_t size=100003;
+   std::vector<Vector3D> vectors=randomVectors(size,47);
+   vectors[5]=Vector3D(1.0e8,-1.0e8,3.0);
+   Vector3DArray array(vectors);
+   Vector3DThreadPool pool(4);
+   Vector3DBatch::InstructionSet defaultSet=Vector3DBatch::instructionSet();
+
+   long double exact[3]={},center[3];
+   for(const Vector3D &vector : vectors)
+   {
+      exact[0]+=vector.x(); exact[1]+=vector.y(); exact[2]+=vector.z();
+   }
+   for(int i=0;i<3;i++) center[i]=exact[i]/size;
+
+   SECTION("Sums and centroid")
+   {
+      for(Vector3DBatch::Summation summation : {Vector3DBatch::Simple,Vector3DBatch::Compensated,Vector3DBatch::Pairwise})
+      {
+         CAPTURE(summation);
+         Vector3D sum=Vector3DBatch::sum(array,summation),centroid;
+         double tolerance=summation==Vector3DBatch::Compensated ? 1.0e-8 : 1.0e-5;
+         CHECK_THAT(sum.x(),Catch::Matchers::WithinAbs(static_cast<double>(exact[0]),tolerance));
+         CHECK_THAT(sum.y(),Catch::Matchers::WithinAbs(static_cast<double>(exact[1]),tolerance));
+         CHECK_THAT(sum.z(),Catch::Matchers::WithinAbs(static_cast<double>(exact[2]),tolerance));
+         CHECK(Vector3DBatch::centroid(array,centroid,summation));
+         CHECK_THAT(centroid.x(),Catch::Matchers::WithinAbs(static_cast<double>(center[0]),1.0e-10));
+
+         for(Vector3DBatch::InstructionSet set : instructionSets())
+         {
+            CAPTURE(Vector3DBatch::instructionSetName(set));
+            Vector3DBatch::setInstructionSet(set);
+            CHECK(isIdentical(Vector3DBatch::sum(vectors,summation),sum));
+            CHECK(isIdentical(Vector3DBatch::sum(Vector3DExecution::parallel(pool,8),array,summation),sum));
+            CHECK(isIdentical(Vector3DBatch::sum(Vector3DExecution::parallel(pool,5000),vectors,summation),sum));
+            CHECK(isIdentical(Vector3DBatch::sum(Vector3DExecution::parallel(pool,4096),array,summation),sum));
+         }
+         Vector3DBatch::setInstructionSet(defaultSet);
+      }
+
+      std::vector<Vector3D> cancelling={Vector3D(1.0e16,1.0,0.0)};
+      for(int i=0;i<1000;i++) cancelling.push_back(Vector3D(1.0,1.0e-16,0.0));
+      cancelling.push_back(Vector3D(-1.0e16,-1.0,0.0));
+      Vector3D compensated=Vector3DBatch::sum(cancelling,Vector3DBatch::Compensated);
+      CHECK(compensated.x()==1000.0);
+      CHECK_THAT(compensated.y(),Catch::Matchers::WithinAbs(1.0e-13,1.0e-27));
+
+      Vector3D centroid(1.0,2.0,3.0);
+      CHECK(Vector3DBatch::sum(Vector3DArray()).isZero());
+      CHECK_FALSE(Vector3DBatch::centroid(Vector3DArray(),centroid));
+      CHECK(centroid==Vector3D(1.0,2.0,3.0));
+   }
+
+   SECTION("Covariance")
+   {
+      long double expected[9]={};
+      for(const Vector3D &vector : vectors)
+      {
+         long double d[3]={vector.x()-center[0],vector.y()-center[1],vector.z()-center[2]};
+         for(int i=0;i<9;i++) expected[i]+=d[i/3]*d[i%3];
+      }
+      for(Vector3DBatch::Summation summation : {Vector3DBatch::Simple,Vector3DBatch::Compensated,Vector3DBatch::Pairwise})
+      {
+         CAPTURE(summation);
+         std::array<double,9> matrix,parallel;
+         CHECK(Vector3DBatch::covariance(array,matrix,summation));
+         for(int i=0;i<9;i++) CHECK_THAT(matrix[i],Catch::Matchers::WithinAbs(static_cast<double>(expected[i]/size),1.0e-6*std::fabs(static_cast<double>(expected[i]/size))));
+         CHECK(matrix[1]==matrix[3]);
+         CHECK(Vector3DBatch::covariance(Vector3DExecution::parallel(pool,8),vectors,parallel,summation));
+         CHECK(std::memcmp(matrix.data(),parallel.data(),sizeof(matrix))==0);
+      }
+      std::array<double,9> matrix;
+      CHECK_FALSE(Vector3DBatch::covariance(Vector3DArray(),matrix));
+   }
+
+   SECTION("Bounding box and length range")
+   {
+      vectors[11]=Vector3D(std::numeric_limits<double>::quiet_NaN(),-60.0,std::numeric_limits<double>::quiet_NaN());
+      array=Vector3DArray(vectors);
+      double infinity=std::numeric_limits<double>::infinity();
+      Vector3D low(infinity,infinity,infinity),high(-infinity,-infinity,-infinity);
+      double shortest=std::numeric_limits<double>::infinity(),longest=0.0;
+      for(const Vector3D &vector : vectors)
+      {
+         if(!std::isnan(vector.x())) low.setX(std::min(low.x(),vector.x())),high.setX(std::max(high.x(),vector.x()));
+         if(!std::isnan(vector.y())) low.setY(std::min(low.y(),vector.y())),high.setY(std::max(high.y(),vector.y()));
+         if(!std::isnan(vector.z())) low.setZ(std::min(low.z(),vector.z())),high.setZ(std::max(high.z(),vector.z()));
+         if(!vector.isNaN()) shortest=std::min(shortest,vector.length()),longest=std::max(longest,vector.length());
+      }
+      for(Vector3DBatch::InstructionSet set : instructionSets())
+      {
+         CAPTURE(Vector3DBatch::instructionSetName(set));
+         Vector3DBatch::setInstructionSet(set);
+         Vector3D minimum,maximum;
+         double minimumLength,maximumLength;
+         CHECK(Vector3DBatch::boundingBox(array,minimum,maximum));
+         CHECK((isIdentical(minimum,low) && isIdentical(maximum,high)));
+         CHECK(Vector3DBatch::boundingBox(Vector3DExecution::parallel(pool,8),vectors,minimum,maximum));
+         CHECK((isIdentical(minimum,low) && isIdentical(maximum,high)));
+         CHECK(Vector3DBatch::lengthRange(Vector3DExecution::parallel(pool,8),array,minimumLength,maximumLength));
+         CHECK(minimumLength==shortest);
+         CHECK(maximumLength==longest);
+      }
+      Vector3DBatch::setInstructionSet(defaultSet);
+
+      Vector3D minimum,maximum;
+      double minimumLength,maximumLength;
+      CHECK_FALSE(Vector3DBatch::boundingBox(Vector3DArray(),minimum,maximum));
+      CHECK_FALSE(Vector3DBatch::lengthRange(Vector3DArray(),minimumLength,maximumLength));
+      CHECK(Vector3DBatch::lengthRange(std::vector<Vector3D>{Vector3D(3.0,4.0,0.0)},minimumLength,maximumLength));
+      CHECK((minimumLength==5.0 && maximumLength==5.0));
+   }
+}
+
+TEST_CASE("Vertex welding")
+{
+   std::mt19937 generator(53);
+   std::uniform_real_distribution<double> jitter(-0.99,0.99);
+   std::uniform_int_distribution<std::size_t> pick(0,399);
+   double tolerance=0.01;
+   std::vector<Vector3D> vectors=randomVectors(400,51);
+   for(int i=0;i<2600;i++)
+   {
+      Vector3D vector=vectors[pick(generator)];
+      if(i%3==0) vector=Vector3D(vector.x()+jitter(generator)*tolerance,vector.y()+jitter(generator)*tolerance,vector.z()-jitter(generator)*tolerance);
+      if(i%7==0) vector=Vector3D(std::round(vector.x()/(2.0*tolerance))*2.0*tolerance+jitter(generator)*tolerance,vector.y(),vector.z());
+      vectors.push_back(vector);
+   }
+   std::size_t size=vectors.size();
+
+   std::vector<std::size_t> expected(size);
+   for(std::size_t i=0;i<size;i++)
+   {
+      expected[i]=i;
+      for(std::size_t j=0;j<i;j++)
+      {
+         Vector3D difference=vectors[i]-vectors[j];
+         if(expected[j]==j && std::fabs(difference.x())<tolerance && std::fabs(difference.y())<tolerance && std::fabs(difference.z())<tolerance)
+         {
+            expected[i]=j;
+            break;
+         }
+      }
+   }
+
+   SECTION("Representatives match a brute force scan")
+   {
+      Vector3DThreadPool pool(4);
+      std::vector<std::size_t> representatives(size);
+      CHECK(Vector3DWeld::representatives(vectors,representatives,tolerance));
+      CHECK(representatives==expected);
+      CHECK(representatives[5]==5);
+      for(std::size_t grain : {std::size_t(8),std::size_t(100)})
+      {
+         std::fill(representatives.begin(),representatives.end(),0);
+         CHECK(Vector3DWeld::representatives(Vector3DExecution::parallel(pool,grain),Vector3DArray(vectors),representatives,tolerance));
+         CHECK(representatives==expected);
+      }
+   }
+
+   SECTION("Weld")
+   {
+      std::vector<std::size_t> remap(size);
+      Vector3DArray unique;
+      CHECK(Vector3DWeld::weld(vectors,remap,unique,tolerance));
+      std::size_t count=0;
+      for(std::size_t i=0;i<size;i++)
+      {
+         if(expected[i]==i) CHECK(isIdentical(unique[count++],vectors[i]));
+         CHECK(isIdentical(unique[remap[i]],vectors[expected[i]]));
+      }
+      CHECK(unique.size()==count);
+
+      std::vector<Vector3D> exact={Vector3D(1.0e6,2.0,3.0),Vector3D(1.0e6,2.0,3.0),Vector3D(1.0e6+1.0e-9,2.0,3.0),Vector3D(-0.0,0.0,0.0),Vector3D(0.0,-0.0,0.0)};
+      remap.resize(exact.size());
+      CHECK(Vector3DWeld::weld(exact,remap,unique));
+      CHECK(remap==std::vector<std::size_t>({0,0,1,2,2}));
+      CHECK(unique.size()==3);
+
+      double infinity=std::numeric_limits<double>::infinity();
+      std::vector<Vector3D> special={Vector3D(infinity,0.0,0.0),Vector3D(infinity,0.0,0.0),Vector3D(1.0e308,0.0,0.0),Vector3D(1.0e308,0.0,0.0)};
+      remap.resize(special.size());
+      CHECK(Vector3DWeld::weld(special,remap,unique,1.0e-300));
+      CHECK(remap==std::vector<std::size_t>({0,1,2,2}));
+
+      std::vector<Vector3D> tiny={Vector3D(0.0,1.0,2.0),Vector3D(0.0,1.0,2.0),Vector3D(5.0e-321,1.0,2.0),Vector3D(2.0e-320,1.0,2.0)};
+      std::vector<std::size_t> representatives(tiny.size());
+      CHECK(Vector3DWeld::representatives(tiny,representatives,1.0e-320));
+      CHECK(representatives==std::vector<std::size_t>({0,0,0,3}));
+
+      CHECK_FALSE(Vector3DWeld::weld(vectors,remap,unique,tolerance));
+      CHECK_FALSE(Vector3DWeld::weld(special,remap,unique,0.0));
+      CHECK_FALSE(Vector3DWeld::weld(special,remap,unique,infinity));
+      CHECK_FALSE(Vector3DWeld::representatives(tiny,representatives,infinity));
+      CHECK(unique.size()==3);
+      remap.clear();
+      CHECK(Vector3DWeld::weld(std::vector<Vector3D>(),remap,unique));
+      CHECK(unique.isEmpty());
+   }
+}
+
+TEST_CASE("Instrumentation")
+{
+   Vector3DInstrumentation::reset();
+   Vector3D vector(1.0,2.0,3.0);
+   vector=vector/2.0+Vector3D(1.0,1.0,1.0);
+   vector/=0.0;
+   Vector3D zero;
+   CHECK_FALSE(zero.setLength(2.0,Vector3D::Precise));
+
+   Vector3DInstrumentation::Snapshot snapshot=Vector3DInstrumentation::snapshot();
+   std::ostringstream json;
+   CHECK(Vector3DInstrumentation::writeJSON(json,snapshot));
+   CHECK(json.str().find("\"divideAssign\":{\"calls\":")!=std::string::npos);
+
+#ifdef VECTOR3D_INSTRUMENTATION
+   SECTION("Operations are counted and the first NaN is traced")
+   {
+      CHECK(snapshot.operations[Vector3DInstrumentation::Divide].calls==1);
+      CHECK(snapshot.operations[Vector3DInstrumentation::Add].calls==1);
+      CHECK(snapshot.operations[Vector3DInstrumentation::DivideAssign].nearZero==1);
+      CHECK(snapshot.operations[Vector3DInstrumentation::DivideAssign].nans==1);
+      CHECK(snapshot.operations[Vector3DInstrumentation::SetLength].nearZero==1);
+      REQUIRE(snapshot.hasNaN);
+      CHECK(snapshot.firstNaN.operation==Vector3DInstrumentation::DivideAssign);
+      CHECK(snapshot.firstNaN.file==nullptr);
+
+      Vector3DInstrumentation::reset();
+      {
+         VECTOR3D_INSTRUMENT_SCOPE("loader");
+         Vector3D propagated=vector+Vector3D(1.0,1.0,1.0);
+         CHECK(propagated.isNaN());
+         CHECK_FALSE(Vector3DInstrumentation::snapshot().hasNaN);
+         double infinity=std::numeric_limits<double>::infinity();
+         CHECK((Vector3D(infinity,0.0,0.0)-Vector3D(infinity,0.0,0.0)).isNaN());
+      }
+      snapshot=Vector3DInstrumentation::snapshot();
+      CHECK(snapshot.operations[Vector3DInstrumentation::Add].calls==1);
+      CHECK(snapshot.operations[Vector3DInstrumentation::Add].nans==0);
+      CHECK(snapshot.operations[Vector3DInstrumentation::Subtract].nans==1);
+      REQUIRE(snapshot.hasNaN);
+      CHECK(snapshot.firstNaN.operation==Vector3DInstrumentation::Subtract);
+      CHECK(std::string(snapshot.firstNaN.label)=="loader");
+      CHECK(std::string(snapshot.firstNaN.file).find("test.cpp")!=std::string::npos);
+
+      json.str("");
+      CHECK(Vector3DInstrumentation::writeJSON(json,snapshot));
+      CHECK(json.str().find("\"firstNaN\":{\"operation\":\"subtract\",\"label\":\"loader\"")!=std::string::npos);
+   }
+
+   SECTION("Threads are merged and calls are sampled")
+   {
+      std::uint32_t period=Vector3DInstrumentation::samplingPeriod();
+      Vector3DInstrumentation::setSamplingPeriod(4);
+      Vector3DInstrumentation::reset();
+      std::vector<std::thread> threads;
+      for(int i=0;i<4;i++)
+      {
+         threads.emplace_back([]()
+         {
+            Vector3D sum;
+            for(int j=0;j<1000;j++) sum+=Vector3D(1.0,2.0,3.0);
+            CHECK(sum.length()>0.0);
+         });
+      }
+      for(std::thread &thread : threads) thread.join();
+      snapshot=Vector3DInstrumentation::snapshot();
+      Vector3DInstrumentation::setSamplingPeriod(period);
+      CHECK(snapshot.operations[Vector3DInstrumentation::AddAssign].calls==4000);
+      CHECK(snapshot.operations[Vector3DInstrumentation::Length].calls==4);
+      CHECK(snapshot.operations[Vector3DInstrumentation::AddAssign].samples==1000);
+      CHECK(snapshot.operations[Vector3DInstrumentation::AddAssign].estimatedNanoseconds()>0.0);
+      CHECK_FALSE(snapshot.hasNaN);
+   }
+#else
+   SECTION("Probes compile to nothing")
+   {
+      CHECK_FALSE(Vector3DInstrumentation::enabled);
+      CHECK(snapshot.operations[Vector3DInstrumentation::Divide].calls==0);
+      CHECK_FALSE(snapshot.hasNaN);
+      CHECK(json.str().find("\"enabled\":false")!=std::string::npos);
+   }
+#endif
+}
+
+TEST_CASE("All pairs")
+{
+   std::vector<Vector3D> vectors1=randomVectors(150,53),vectors2=randomVectors(300,59);
+   vectors2[11]=vectors1[20];
+   vectors2[12]=vectors1[20]*2.0;
+   Vector3DArray array1(vectors1),array2(vectors2);
+   Vector3DThreadPool pool(4);
+   Vector3DBatch::InstructionSet defaultSet=Vector3DBatch::instructionSet();
+   std::size_t rows=vectors1.size(),columns=vectors2.size();
+
+   SECTION("Matrices match the scalar methods")
+   {
+      for(Vector3DBatch::InstructionSet set : instructionSets())
+      {
+         CAPTURE(Vector3DBatch::instructionSetName(set));
+         Vector3DBatch::setInstructionSet(set);
+
+         std::vector<double> distances(rows*columns),radians(rows*columns),degrees(rows*columns),parallel(rows*columns);
+         CHECK(Vector3DBatch::distanceMatrix(array1,vectors2,distances));
+         CHECK(Vector3DBatch::angleMatrix(vectors1,array2,radians));
+         CHECK(Vector3DBatch::angleMatrix(array1,array2,degrees,Vector3D::Degrees));
+         for(std::size_t i=0;i<rows;i++)
+         {
+            for(std::size_t j=0;j<columns;j++)
+            {
+               CHECK(isIdentical(distances[i*columns+j],vectors1[i].distance(vectors2[j])));
+               CHECK(isIdentical(radians[i*columns+j],vectors1[i].angle(vectors2[j],Vector3D::Radians,Vector3D::Precise)));
+               CHECK(isIdentical(degrees[i*columns+j],vectors1[i].angle(vectors2[j],Vector3D::Degrees,Vector3D::Precise)));
+            }
+         }
+
+         CHECK(Vector3DBatch::distanceMatrix(Vector3DExecution::parallel(pool,1000),vectors1,array2,parallel));
+         CHECK(std::memcmp(parallel.data(),distances.data(),parallel.size()*sizeof(double))==0);
+         CHECK(Vector3DBatch::angleMatrix(Vector3DExecution::parallel(pool,1000),array1,vectors2,parallel));
+         CHECK(std::memcmp(parallel.data(),radians.data(),parallel.size()*sizeof(double))==0);
+      }
+      Vector3DBatch::setInstructionSet(defaultSet);
+
+      std::vector<double> matrix(rows*columns-1);
+      CHECK_FALSE(Vector3DBatch::distanceMatrix(vectors1,vectors2,matrix));
+      CHECK_FALSE(Vector3DBatch::angleMatrix(vectors1,vectors2,matrix));
+      CHECK(Vector3DBatch::distanceMatrix(std::vector<Vector3D>(),vectors2,std::span<double>()));
+   }
+
+   SECTION("Nearest pairs and pairs within a maximum")
+   {
+      std::vector<double> distances(rows*columns),degrees(rows*columns);
+      Vector3DBatch::distanceMatrix(vectors1,vectors2,distances);
+      Vector3DBatch::angleMatrix(vectors1,vectors2,degrees,Vector3D::Degrees);
+      std::vector<double> cosines(rows*columns);
+      for(std::size_t i=0;i<rows;i++)
+      {
+         for(std::size_t j=0;j<columns;j++) cosines[i*columns+j]=std::cos(degrees[i*columns+j]*Vector3D::Traits::deg2rad);
+      }
+
+      auto expectedNearest=[&](const std::vector<double> &values, bool descending, std::size_t row, std::size_t k)
+      {
+         std::vector<std::size_t> order(columns);
+         for(std::size_t j=0;j<columns;j++) order[j]=j;
+         std::stable_sort(order.begin(),order.end(),[&](std::size_t a, std::size_t b)
+         {
+            double valueA=values[row*columns+a],valueB=values[row*columns+b];
+            if(std::isnan(valueA) || std::isnan(valueB)) return !std::isnan(valueA) && std::isnan(valueB);
+            return descending ? valueA>valueB : valueA<valueB;
+         });
+         order.resize(k);
+         return order;
+      };
+
+      std::size_t k=5;
+      for(const Vector3DExecution &execution : {Vector3DExecution::sequential(),Vector3DExecution::parallel(pool,1000)})
+      {
+         std::vector<Vector3DBatch::Pair> nearest(rows*k),nearestAngles(rows*k);
+         CHECK(Vector3DBatch::nearestDistances(execution,vectors1,array2,k,nearest));
+         CHECK(Vector3DBatch::nearestAngles(execution,array1,vectors2,k,nearestAngles,Vector3D::Degrees));
+         for(std::size_t i=0;i<rows;i++)
+         {
+            CAPTURE(i);
+            std::vector<std::size_t> expected=expectedNearest(distances,false,i,k);
+            for(std::size_t n=0;n<k;n++)
+            {
+               const Vector3DBatch::Pair &pair=nearest[i*k+n];
+               CHECK(pair.first==i);
+               CHECK(pair.second==expected[n]);
+               CHECK(isIdentical(pair.value,distances[i*columns+pair.second]));
+               const Vector3DBatch::Pair &anglePair=nearestAngles[i*k+n];
+               CHECK(anglePair.first==i);
+               CHECK(isIdentical(anglePair.value,degrees[i*columns+anglePair.second]));
+               if(n>0 && !std::isnan(anglePair.value)) CHECK(nearestAngles[i*k+n-1].value<=anglePair.value);
+            }
+         }
+         CHECK(nearest[20*k].second==11);
+         std::vector<std::size_t> aligned;
+         for(std::size_t n=0;n<4;n++) aligned.push_back(nearestAngles[20*k+n].second);
+         std::sort(aligned.begin(),aligned.end());
+         CHECK(aligned==std::vector<std::size_t>({3,7,11,12}));
+
+         std::vector<Vector3DBatch::Pair> within,anglesWithin;
+         CHECK(Vector3DBatch::distancesWithin(execution,array1,vectors2,20.0,within));
+         CHECK(Vector3DBatch::anglesWithin(execution,vectors1,array2,15.0,anglesWithin,Vector3D::Degrees));
+         std::size_t position=0,anglePosition=0;
+         for(std::size_t i=0;i<rows;i++)
+         {
+            for(std::size_t j=0;j<columns;j++)
+            {
+               if(distances[i*columns+j]<=20.0)
+               {
+                  REQUIRE(position<within.size());
+                  CHECK(within[position].first==i);
+                  CHECK(within[position].second==j);
+                  CHECK(isIdentical(within[position++].value,distances[i*columns+j]));
+               }
+               if(degrees[i*columns+j]<=15.0)
+               {
+                  REQUIRE(anglePosition<anglesWithin.size());
+                  CHECK(anglesWithin[anglePosition].first==i);
+                  CHECK(anglesWithin[anglePosition++].second==j);
+               }
+            }
+         }
+         CHECK(position==within.size());
+         CHECK(anglePosition==anglesWithin.size());
+      }
+
+      std::vector<Vector3DBatch::Pair> pairs(rows*(columns+1)),within(1);
+      CHECK_FALSE(Vector3DBatch::nearestDistances(vectors1,vectors2,columns+1,pairs));
+      CHECK_FALSE(Vector3DBatch::nearestAngles(vectors1,vectors2,2,pairs));
+      CHECK(Vector3DBatch::distancesWithin(vectors1,vectors2,-1.0,within));
+      CHECK(within.empty());
+      CHECK(Vector3DBatch::anglesWithin(vectors1,vectors2,180.0,within,Vector3D::Degrees));
+      // the NaN vectors are at angle zero from the zero vectors, as with angle()
+      CHECK(within.size()==(rows-1)*(columns-1)+4);
+   }
+}
+
+TEST_CASE("Streaming pipeline")
+{
+   std::vector<Vector3D> vectors=randomVectors(2500,61);
+   Rotation3D rotation(Vector3D(1.0,2.0,3.0),0.7);
+   Vector3D offset(1.0,-2.0,0.5);
+   Vector3DThreadPool pool(4);
+
+   // the eager equivalent of dropNaN().dropZero().rotate().scale(2.0).translate(offset)
+   Vector3DArray expected;
+   for(const Vector3D &vector : vectors)
+   {
+      if(vector.isNaN() || vector.isZero()) continue;
+      Vector3DArray single(std::vector<Vector3D>{vector});
+      Vector3DBatch::rotate(single,rotation,single);
+      Vector3DBatch::scale(single,2.0,single);
+      Vector3DBatch::add(single,offset,single);
+      expected.append(single[0]);
+   }
+   auto isSame=[](const Vector3DArray &array1, const Vector3DArray &array2)
+   {
+      bool identical=array1.size()==array2.size();
+      for(std::size_t i=0;identical && i<array1.size();i++) identical=isIdentical(array1[i],array2[i]);
+      return identical;
+   };
+
+   SECTION("Stages match the batch methods")
+   {
+      for(std::size_t chunkSize : {1,7,1000,5000})
+      {
+         CAPTURE(chunkSize);
+         Vector3DArray result;
+         CHECK(Vector3DStream::fromView(vectors,chunkSize).dropNaN().dropZero().rotate(rotation).scale(2.0).translate(offset).collect(result));
+         CHECK(isSame(result,expected));
+
+         CHECK(Vector3DStream::fromView(vectors,chunkSize).dropNaN().dropZero().prefetch().rotate(rotation,Vector3DExecution::parallel(pool,100))
+               .scale(2.0,Vector3DExecution::parallel(pool,100)).prefetch().translate(offset).collect(result));
+         CHECK(isSame(result,expected));
+
+         Vector3DArray transformed;
+         CHECK(Vector3DStream::fromView(vectors,chunkSize).dropNaN().dropZero().transform(Transform3D(rotation,2.0,offset)).prefetch().collect(transformed));
+         CHECK(transformed.size()==expected.size());
+
+         std::size_t count=0;
+         CHECK(Vector3DStream::fromView(vectors,chunkSize).dropNaN().count(count));
+         CHECK(count==vectors.size()-1);
+      }
+
+      Vector3D sum;
+      CHECK(Vector3DStream::fromView(expected,expected.size()).sum(sum,Vector3DBatch::Compensated));
+      CHECK(isIdentical(sum,Vector3DBatch::sum(expected,Vector3DBatch::Compensated)));
+      CHECK(Vector3DStream::fromView(expected,100).prefetch().sum(sum));
+      Vector3D reference=Vector3DBatch::sum(expected);
+      CHECK_THAT(sum.x(),Catch::Matchers::WithinAbs(reference.x(),1e-9*expected.size()));
+      CHECK_THAT(sum.y(),Catch::Matchers::WithinAbs(reference.y(),1e-9*expected.size()));
+      CHECK_THAT(sum.z(),Catch::Matchers::WithinAbs(reference.z(),1e-9*expected.size()));
+
+      std::size_t calls=0;
+      Vector3DArray generated;
+      CHECK(Vector3DStream::generate([&calls](Vector3DArray &chunk)
+      {
+         chunk.resize(3);
+         for(std::size_t i=0;i<3;i++) chunk.set(i,Vector3D(calls,i,0.0));
+         return ++calls<=4;
+      }).prefetch().collect(generated));
+      CHECK(generated.size()==12);
+      CHECK(isIdentical(generated[11],Vector3D(3.0,2.0,0.0)));
+   }
+
+   SECTION("Files stream in and out chunk by chunk")
+   {
+      std::string in=(std::filesystem::temp_directory_path()/"vector3d_stream_in.v3d").string();
+      std::string out=(std::filesystem::temp_directory_path()/"vector3d_stream_out.v3d").string();
+      REQUIRE(Vector3DFile::write(in,vectors,Vector3DFile::AoS,Vector3DFile::Float64,512));
+      {
+         Vector3DFile file(in);
+         Vector3DFileWriter writer(out,Vector3DFile::SoA,Vector3DFile::Float64,300);
+         CHECK(Vector3DStream::fromFile(file).prefetch().dropNaN().dropZero().rotate(rotation).scale(2.0).translate(offset).write(writer));
+         CHECK(writer.close());
+      }
+      Vector3DFile file(out);
+      Vector3DArray result(file.size());
+      CHECK(file.read(0,result));
+      CHECK(isSame(result,expected));
+
+      std::ostringstream streamed,direct;
+      CHECK(Vector3DStream::fromFile(file).writeXYZ(streamed,6));
+      CHECK(Vector3DText::writeXYZ(direct,expected,6));
+      CHECK(streamed.str()==direct.str());
+      std::filesystem::remove(in);
+      std::filesystem::remove(out);
+
+      Vector3DFile missing;
+      std::size_t count=1;
+      CHECK_FALSE(Vector3DStream::fromFile(missing).prefetch().rotate(rotation).count(count));
+      CHECK(count==0);
+   }
+
+   SECTION("Failures and early exits")
+   {
+      Vector3DArray result;
+      CHECK_FALSE(Vector3DStream::fromView(vectors,0).collect(result));
+
+      std::size_t chunks=0;
+      CHECK_FALSE(Vector3DStream::fromView(vectors,100).apply([&chunks](Vector3DArray &) { return ++chunks<5; }).prefetch().collect(result));
+      CHECK(chunks==5);
+      CHECK(result.size()==400);
+
+      auto throwing=Vector3DStream::fromView(vectors,100).apply([](Vector3DArray &chunk) -> bool { if(chunk.size()==100) throw std::runtime_error("stage"); return true; });
+      CHECK_THROWS_AS(throwing.next(),std::runtime_error);
+      CHECK_FALSE(throwing.next());
+      CHECK(throwing.failed());
+      CHECK_THROWS_AS(Vector3DStream::fromView(vectors,100).apply([](Vector3DArray &) -> bool { throw std::runtime_error("stage"); }).prefetch().count(chunks),std::runtime_error);
+
+      // abandoned pipelines stop their prefetch threads and release their chunks
+      for(int i=0;i<20;i++)
+      {
+         Vector3DStream stream=Vector3DStream::fromView(vectors,10).prefetch().scale(2.0).prefetch();
+         REQUIRE(stream.next());
+         CHECK(stream.chunk().size()==10);
+      }
+      Vector3DStream empty;
+      CHECK_FALSE(empty.next());
+      CHECK_FALSE(empty.failed());
+   }
+}
+
+TEST_CASE("Compile-time geometry")
+{
+   constexpr Vector3D x(1.0,0.0,0.0),y(0.0,1.0,0.0),z(0.0,0.0,1.0);
+   static_assert(x.cross(y).x()==0.0 && x.cross(y).y()==0.0 && x.cross(y).z()==1.0);
+   static_assert(x.dot(y)==0.0 && (x+y).dot(x-y)==0.0);
+   static_assert((2.0*(x+y+z)-z).lengthSquared()==9.0);
+   static_assert((Vector3D(3.0,6.0,9.0)/3.0).distanceSquared(1.0,2.0,3.0)==0.0);
+   static_assert((x/0.0).isNaN() && !x.isNaN() && Vector3D().isZero() && !x.isZero());
+   static_assert(x==Vector3D(1.0,1e-17,0.0) && x!=y && x*2.0>y && x<=y);
+   static_assert(Vector3DFloat(Vector3D(0.5,0.25,0.125)).lengthSquared()==0.328125f);
+
+   constexpr Vector3D accumulated=[]
+   {
+      Vector3D vector(1.0,2.0,3.0);
+      vector*=2.0; vector+=Vector3D(1.0,1.0,1.0); vector-=Vector3D(0.0,1.0,2.0); vector/=3.0;
+      return vector;
+   }();
+   static_assert(accumulated==Vector3D(1.0,4.0/3.0,5.0/3.0));
+
+   constexpr Rotation3D quarter(z,90.0,Vector3D::Degrees);
+   static_assert(!quarter.isIdentity() && Rotation3D(z,0.0).isIdentity());
+   static_assert((quarter*x).distanceSquared(0.0,-1.0,0.0)<1e-30);
+   static_assert((quarter*quarter.inverse()*y).distanceSquared(y)<1e-30);
+
+   constexpr std::array<Rotation3D,6> rotations{Rotation3D(x,30.0,Vector3D::Degrees),Rotation3D(y,-135.0,Vector3D::Degrees),Rotation3D(1.0,2.0,3.0,0.7),
+                                                Rotation3D(-4.0,0.5,2.0,-5.0),Rotation3D(0.0,3.0,4.0,1e3),Rotation3D(1e-3,0.0,1e3,1.5)};
+   std::array<Rotation3D,6> runtime{Rotation3D(x,30.0,Vector3D::Degrees),Rotation3D(y,-135.0,Vector3D::Degrees),Rotation3D(1.0,2.0,3.0,0.7),
+                                    Rotation3D(-4.0,0.5,2.0,-5.0),Rotation3D(0.0,3.0,4.0,1e3),Rotation3D(1e-3,0.0,1e3,1.5)};
+   for(std::size_t i=0;i<rotations.size();i++)
+   {
+      CAPTURE(i);
+      for(int element=0;element<9;element++) CHECK_THAT(rotations[i].data()[element],Catch::Matchers::WithinAbs(runtime[i].data()[element],1e-15));
+   }
+}
+
+TEST_CASE("Space-filling curves")
+{
+   std::vector<Vector3D> vectors=randomVectors(5000,67);
+   Vector3DThreadPool pool(4);
+
+   SECTION("Keys")
+   {
+      Vector3D minimum(0.0,0.0,0.0),maximum(1<<21,1<<21,1<<21);
+      CHECK(Vector3DCurve::key(Vector3D(0.0,0.0,0.0),minimum,maximum)==0);
+      CHECK(Vector3DCurve::key(Vector3D(1.0,0.0,0.0),minimum,maximum)==4);
+      CHECK(Vector3DCurve::key(Vector3D(0.0,1.0,0.0),minimum,maximum)==2);
+      CHECK(Vector3DCurve::key(Vector3D(0.0,0.0,1.0),minimum,maximum)==1);
+      CHECK(Vector3DCurve::key(Vector3D(3.0,0.0,5.0),minimum,maximum)==0b001'100'101);
+      CHECK(Vector3DCurve::key(maximum,minimum,maximum)==(std::uint64_t(1)<<63)-1);
+      CHECK(Vector3DCurve::key(Vector3D(-5.0,1e300,0.0),minimum,maximum)==Vector3DCurve::key(Vector3D(0.0,(1<<21)-1,0.0),minimum,maximum));
+      CHECK(Vector3DCurve::key(Vector3D(0.0,std::nan(""),0.0),minimum,maximum,Vector3DCurve::Hilbert)==Vector3DCurve::nanKey);
+      CHECK(Vector3DCurve::key(Vector3D(7.0,7.0,7.0),minimum,minimum)==0);
+
+      // the corners of the 8x8x8 coarse cells follow the Hilbert curve one step at a time, and visit every cell once
+      std::vector<Vector3D> corners;
+      for(int i=0;i<512;i++) corners.emplace_back((i&7)<<18,((i>>3)&7)<<18,(i>>6)<<18);
+      std::vector<std::uint64_t> keys(corners.size());
+      CHECK(Vector3DCurve::keys(corners,minimum,maximum,keys,Vector3DCurve::Hilbert));
+      std::vector<std::size_t> byKey(corners.size());
+      for(std::size_t i=0;i<byKey.size();i++) byKey[i]=i;
+      std::sort(byKey.begin(),byKey.end(),[&keys](std::size_t index1, std::size_t index2) { return keys[index1]<keys[index2]; });
+      CHECK(keys[byKey[0]]==0);
+      bool adjacent=true;
+      for(std::size_t i=1;i<byKey.size();i++)
+      {
+         Vector3D step=corners[byKey[i]]-corners[byKey[i-1]];
+         adjacent=adjacent && std::fabs(step.x())+std::fabs(step.y())+std::fabs(step.z())==(1<<18) && keys[byKey[i]]>keys[byKey[i-1]];
+      }
+      CHECK(adjacent);
+
+      std::vector<std::uint64_t> parallel(corners.size());
+      CHECK(Vector3DCurve::keys(Vector3DExecution::parallel(pool,100),corners,minimum,maximum,parallel,Vector3DCurve::Hilbert));
+      CHECK(parallel==keys);
+      CHECK_FALSE(Vector3DCurve::keys(corners,minimum,maximum,std::span<std::uint64_t>(keys).first(10)));
+   }
+
+   SECTION("Ordering and sorting")
+   {
+      vectors[20]=vectors[10];
+      Vector3D minimum,maximum;
+      REQUIRE(Vector3DBatch::boundingBox(vectors,minimum,maximum));
+      for(Vector3DCurve::Curve curve : {Vector3DCurve::Morton,Vector3DCurve::Hilbert})
+      {
+         CAPTURE(curve);
+         std::vector<std::size_t> expected(vectors.size()),permutation(vectors.size()),parallel(vectors.size());
+         for(std::size_t i=0;i<expected.size();i++) expected[i]=i;
+         std::stable_sort(expected.begin(),expected.end(),[&](std::size_t index1, std::size_t index2)
+         {
+            return Vector3DCurve::key(vectors[index1],minimum,maximum,curve)<Vector3DCurve::key(vectors[index2],minimum,maximum,curve);
+         });
+         CHECK(Vector3DCurve::order(vectors,permutation,curve));
+         CHECK(permutation==expected);
+         CHECK(permutation.back()==5);
+         CHECK(Vector3DCurve::order(Vector3DExecution::parallel(pool,64),vectors,parallel,curve));
+         CHECK(parallel==expected);
+
+         Vector3DArray sorted(vectors);
+         std::vector<int> payload(vectors.size());
+         for(std::size_t i=0;i<payload.size();i++) payload[i]=static_cast<int>(i)*3;
+         CHECK(Vector3DCurve::sort(Vector3DExecution::parallel(pool,64),sorted,permutation,curve));
+         CHECK(permutation==expected);
+         CHECK(Vector3DCurve::permute(std::span<const std::size_t>(permutation),std::span<int>(payload)));
+         bool identical=true;
+         for(std::size_t i=0;i<vectors.size();i++) identical=identical && isIdentical(sorted[i],vectors[expected[i]]) && payload[i]==static_cast<int>(expected[i])*3;
+         CHECK(identical);
+      }
+
+      std::vector<std::size_t> permutation(10);
+      CHECK_FALSE(Vector3DCurve::order(vectors,permutation));
+      CHECK_FALSE(Vector3DCurve::permute(std::span<const std::size_t>(permutation),std::span<int>()));
+      CHECK(Vector3DCurve::order(std::vector<Vector3D>(),std::span<std::size_t>()));
+   }
+}
+
+TEST_CASE("Dot, cross and projection")
+{
+   std::vector<Vector3D> vectors=randomVectors(1037,71),vectors2=randomVectors(1037,72);
+   Vector3D axis(3.25,-1.5,0.75);
+   Vector3DThreadPool pool(4);
+   Vector3DBatch::InstructionSet defaultSet=Vector3DBatch::instructionSet();
+
+   SECTION("Members")
+   {
+      static_assert(Vector3D(1.0,2.0,3.0).dot(Vector3D(4.0,-5.0,6.0))==12.0);
+      static_assert(Vector3D(1.0,0.0,0.0).cross(Vector3D(0.0,1.0,0.0))==Vector3D(0.0,0.0,1.0));
+      static_assert(Vector3D(3.0,4.0,5.0).project(Vector3D(0.0,2.0,0.0))==Vector3D(0.0,4.0,0.0));
+      static_assert(Vector3D(3.0,4.0,5.0).reject(Vector3D(0.0,2.0,0.0))==Vector3D(3.0,0.0,5.0));
+      CHECK(Vector3D(1.0,2.0,3.0).project(Vector3D()).isNaN());
+      CHECK(Vector3D(1.0,2.0,3.0).reject(Vector3D()).isNaN());
+      Vector3D rejected=vectors[0].reject(axis);
+      CHECK_THAT(rejected.dot(axis),Catch::Matchers::WithinAbs(0.0,1e-12));
+      CHECK(vectors[0].project(axis)+rejected==vectors[0]);
+   }
+
+   SECTION("Batch")
+   {
+      for(Vector3DBatch::InstructionSet set : instructionSets())
+      {
+         CAPTURE(Vector3DBatch::instructionSetName(set));
+         Vector3DBatch::setInstructionSet(set);
+
+         Vector3DArray array(vectors),array2(vectors2),crossed(vectors.size()),projected(vectors.size());
+         std::vector<Vector3D> rejected(vectors.size());
+         std::vector<double> dots(vectors.size()),axisDots(vectors.size());
+         CHECK(Vector3DBatch::cross(array,vectors2,crossed));
+         CHECK(Vector3DBatch::project(array,axis,projected));
+         CHECK(Vector3DBatch::reject(vectors,axis,rejected));
+         CHECK(Vector3DBatch::dot(vectors,array2,dots));
+         CHECK(Vector3DBatch::dot(array,axis,axisDots));
+         bool identical=true;
+         for(std::size_t i=0;i<vectors.size();i++)
+         {
+            identical=identical && isIdentical(crossed[i],vectors[i].cross(vectors2[i])) && isIdentical(projected[i],vectors[i].project(axis));
+            identical=identical && isIdentical(rejected[i],vectors[i].reject(axis));
+            identical=identical && isIdentical(dots[i],vectors[i].dot(vectors2[i])) && isIdentical(axisDots[i],vectors[i].dot(axis));
+         }
+         CHECK(identical);
+
+         std::vector<double> parallel(vectors.size());
+         std::vector<Vector3D> parallelCrossed(vectors.size());
+         CHECK(Vector3DBatch::dot(Vector3DExecution::parallel(pool,100),array,array2,parallel));
+         CHECK(Vector3DBatch::cross(Vector3DExecution::parallel(pool,100),vectors,vectors2,parallelCrossed));
+         identical=true;
+         for(std::size_t i=0;i<vectors.size();i++) identical=identical && isIdentical(parallel[i],dots[i]) && isIdentical(parallelCrossed[i],crossed[i]);
+         CHECK(identical);
+      }
+      Vector3DBatch::setInstructionSet(defaultSet);
+
+      Vector3DArray array(vectors),result(vectors.size());
+      CHECK(Vector3DBatch::project(array,Vector3D(1e-17,0.0,0.0),result));
+      CHECK(result[0].isNaN());
+      CHECK(Vector3DBatch::reject(Vector3DExecution::parallel(pool,100),array,Vector3D(),result));
+      CHECK(result[vectors.size()-1].isNaN());
+      std::vector<double> dots(10);
+      CHECK_FALSE(Vector3DBatch::dot(array,array,dots));
+      CHECK_FALSE(Vector3DBatch::dot(array,axis,dots));
+      CHECK_FALSE(Vector3DBatch::cross(array,Vector3DArrayConstView(array).subview(0,10),result));
+      CHECK_FALSE(Vector3DBatch::project(array,axis,Vector3DArrayView(result).subview(0,10)));
+   }
+}
+
+TEST_CASE("Compaction")
+{
+   std::vector<Vector3D> vectors=randomVectors(5000,73);
+   for(std::size_t i=11;i<vectors.size();i+=37) vectors[i]=Vector3D(0.0,std::nan(""),0.0);
+   for(std::size_t i=13;i<vectors.size();i+=53) vectors[i]=Vector3D(1.0e-20,0.0,-1.0e-20);
+   for(std::size_t i=200;i<330;i++) vectors[i]=Vector3D();
+   for(std::size_t i=4000;i<4400;i+=1+i%3) vectors[i]=Vector3D();
+   for(std::size_t i=17;i<vectors.size();i+=29) vectors[i]=vectors[i]*1.0e-3;
+   Vector3DThreadPool pool(4);
+   Vector3DBatch::InstructionSet defaultSet=Vector3DBatch::instructionSet();
+   auto dropped=[](const Vector3D &vector, unsigned filters, double minimumLength)
+   {
+      return ((filters&Vector3DBatch::DropNaN)!=0 && vector.isNaN()) || ((filters&Vector3DBatch::DropZero)!=0 && vector.isZero()) ||
+             ((filters&Vector3DBatch::DropShort)!=0 && vector.lengthSquared()<minimumLength*minimumLength);
+   };
+
+   SECTION("Masks")
+   {
+      for(Vector3DBatch::InstructionSet set : instructionSets())
+      {
+         CAPTURE(Vector3DBatch::instructionSetName(set));
+         Vector3DBatch::setInstructionSet(set);
+
+         Vector3DArray array(vectors);
+         std::vector<std::uint64_t> zero(Vector3DBatch::maskWords(vectors.size())),nan(zero.size()),shortMask(zero.size()),parallel(zero.size());
+         CHECK(array.isZero(zero));
+         CHECK(Vector3DBatch::isNaN(vectors,nan));
+         CHECK(Vector3DBatch::filterMask(Vector3DArrayConstView(vectors).subview(0,vectors.size()),Vector3DBatch::DropShort,shortMask,0.1));
+         CHECK(Vector3DBatch::filterMask(Vector3DExecution::parallel(pool,100),array,Vector3DBatch::DropNaN|Vector3DBatch::DropZero,parallel));
+         bool identical=true;
+         for(std::size_t i=0;i<vectors.size();i++)
+         {
+            auto bit=[i](const std::vector<std::uint64_t> &mask) { return ((mask[i/64]>>(i%64))&1)!=0; };
+            identical=identical && bit(zero)==vectors[i].isZero() && bit(nan)==vectors[i].isNaN();
+            identical=identical && bit(shortMask)==(vectors[i].lengthSquared()<0.01) && bit(parallel)==(vectors[i].isZero() || vectors[i].isNaN());
+         }
+         CHECK(identical);
+         CHECK(zero.back()>>(vectors.size()%64)==0);
+      }
+      Vector3DBatch::setInstructionSet(defaultSet);
+
+      std::vector<std::uint64_t> mask(3);
+      CHECK_FALSE(Vector3DBatch::isZero(vectors,mask));
+      CHECK(Vector3DBatch::isNaN(std::vector<Vector3D>(),std::span<std::uint64_t>()));
+   }
+
+   SECTION("Compact")
+   {
+      for(Vector3DBatch::InstructionSet set : instructionSets())
+      {
+         CAPTURE(Vector3DBatch::instructionSetName(set));
+         Vector3DBatch::setInstructionSet(set);
+         for(int filters : {0,int(Vector3DBatch::DropNaN),Vector3DBatch::DropNaN|Vector3DBatch::DropZero,Vector3DBatch::DropNaN|Vector3DBatch::DropZero|Vector3DBatch::DropShort})
+         {
+            CAPTURE(filters);
+            std::vector<Vector3D> expected;
+            std::copy_if(vectors.begin(),vectors.end(),std::back_inserter(expected),[&](const Vector3D &vector) { return !dropped(vector,filters,0.5); });
+
+            std::vector<Vector3D> aos=vectors,parallelAos=vectors;
+            Vector3DArray array(vectors),parallelArray(vectors);
+            CHECK(Vector3DBatch::compact(aos,filters,0.5)==vectors.size()-expected.size());
+            CHECK(Vector3DBatch::compact(array,filters,0.5)==vectors.size()-expected.size());
+            CHECK(Vector3DBatch::compact(Vector3DExecution::parallel(pool,300),parallelAos,filters,0.5)==vectors.size()-expected.size());
+            CHECK(Vector3DBatch::compact(Vector3DExecution::parallel(pool,100),parallelArray,filters,0.5)==vectors.size()-expected.size());
+            REQUIRE(aos.size()==expected.size());
+            REQUIRE(array.size()==expected.size());
+            REQUIRE(parallelAos.size()==expected.size());
+            REQUIRE(parallelArray.size()==expected.size());
+            bool identical=true;
+            for(std::size_t i=0;i<expected.size();i++)
+            {
+               identical=identical && isIdentical(aos[i],expected[i]) && isIdentical(array[i],expected[i]);
+               identical=identical && isIdentical(parallelAos[i],expected[i]) && isIdentical(parallelArray[i],expected[i]);
+            }
+            CHECK(identical);
+         }
+
+         // a contiguous subview keeps its order and leaves the vectors around it alone
+         Vector3DArray part(vectors);
+         std::vector<Vector3D> kept;
+         std::copy_if(vectors.begin()+64,vectors.begin()+4203,std::back_inserter(kept),[](const Vector3D &vector) { return !vector.isZero(); });
+         CHECK(Vector3DBatch::compact(Vector3DArrayView(part).subview(64,4139),Vector3DBatch::DropZero)==4139-kept.size());
+         bool identical=isIdentical(part[63],vectors[63]) && isIdentical(part[4203],vectors[4203]);
+         for(std::size_t i=0;i<kept.size();i++) identical=identical && isIdentical(part[64+i],kept[i]);
+         CHECK(identical);
+      }
+      Vector3DBatch::setInstructionSet(defaultSet);
+
+      std::vector<Vector3D> copy=vectors;
+      std::size_t zeros=std::count_if(vectors.begin(),vectors.begin()+1000,[](const Vector3D &vector) { return vector.isZero(); });
+      CHECK(Vector3DBatch::compact(Vector3DArrayView(copy).subview(0,1000),Vector3DBatch::DropZero)==zeros);
+      CHECK(copy.size()==vectors.size());
+      CHECK(isIdentical(copy[1000],vectors[1000]));
+      std::vector<Vector3D> empty;
+      CHECK(Vector3DBatch::compact(Vector3DExecution::parallel(pool,1),empty,Vector3DBatch::DropNaN)==0);
+      std::vector<Vector3D> origins(500);
+      CHECK(Vector3DBatch::compact(Vector3DExecution::parallel(pool,64),origins,Vector3DBatch::DropZero)==500);
+      CHECK(origins.empty());
+   }
+}
+
+TEST_CASE("Mesh normals")
+{
+   // a 40x30 height field of two triangles per cell, plus a degenerate face and an unused vertex
+   std::size_t columns=40,rows=30;
+   std::vector<Vector3D> vertices;
+   for(std::size_t row=0;row<=rows;row++)
+   {
+      for(std::size_t column=0;column<=columns;column++) vertices.emplace_back(0.1*column,0.1*row,0.2*std::sin(0.3*column)*std::cos(0.2*row));
+   }
+   std::vector<std::uint32_t> indices;
+   for(std::uint32_t row=0;row<rows;row++)
+   {
+      for(std::uint32_t column=0;column<columns;column++)
+      {
+         std::uint32_t corner=row*static_cast<std::uint32_t>(columns+1)+column,above=corner+static_cast<std::uint32_t>(columns+1);
+         indices.insert(indices.end(),{corner,corner+1,above+1,corner,above+1,above});
+      }
+   }
+   indices.insert(indices.end(),{0,1,0});
+   vertices.emplace_back(5.0,5.0,5.0);
+   std::size_t faces=indices.size()/3;
+   Vector3DThreadPool pool(4);
+
+   SECTION("Face normals")
+   {
+      Vector3DArray normals(faces);
+      std::vector<Vector3D> parallel(faces);
+      CHECK(Vector3DMesh::faceNormals(vertices,indices,normals));
+      CHECK(Vector3DMesh::faceNormals(Vector3DExecution::parallel(pool,64),Vector3DArray(vertices),indices,parallel));
+      bool identical=true;
+      for(std::size_t face=0;face<faces;face++)
+      {
+         const Vector3D &a=vertices[indices[3*face]],&b=vertices[indices[3*face+1]],&c=vertices[indices[3*face+2]];
+         Vector3D expected=(b-a).cross(c-a);
+         expected.setLength(1.0,Vector3D::Precise);
+         identical=identical && isIdentical(normals[face],expected) && isIdentical(parallel[face],expected);
+      }
+      CHECK(identical);
+      CHECK(normals[0].z()>0.0);
+      CHECK(normals[faces-1].isZero());
+   }
+
+   SECTION("Vertex normals")
+   {
+      for(Vector3DMesh::Weighting weighting : {Vector3DMesh::Area,Vector3DMesh::Angle})
+      {
+         CAPTURE(weighting);
+         std::vector<Vector3D> expected(vertices.size());
+         for(std::size_t face=0;face<faces;face++)
+         {
+            std::uint32_t ia=indices[3*face],ib=indices[3*face+1],ic=indices[3*face+2];
+            const Vector3D &a=vertices[ia],&b=vertices[ib],&c=vertices[ic];
+            Vector3D normal=(b-a).cross(c-a);
+            if(weighting==Vector3DMesh::Area)
+            {
+               expected[ia]+=normal; expected[ib]+=normal; expected[ic]+=normal;
+            } else if(normal.setLength(1.0,Vector3D::Precise))
+            {
+               expected[ia]+=normal*(b-a).angle(c-a,Vector3D::Radians,Vector3D::Precise);
+               expected[ib]+=normal*(c-b).angle(a-b,Vector3D::Radians,Vector3D::Precise);
+               expected[ic]+=normal*(a-c).angle(b-c,Vector3D::Radians,Vector3D::Precise);
+            }
+         }
+         for(Vector3D &normal : expected) normal.setLength(1.0,Vector3D::Precise);
+
+         std::vector<Vector3D> normals(vertices.size());
+         Vector3DArray parallel(vertices.size());
+         CHECK(Vector3DMesh::vertexNormals(vertices,indices,normals,weighting));
+         CHECK(Vector3DMesh::vertexNormals(Vector3DExecution::parallel(pool,100),vertices,indices,parallel,weighting));
+         bool identical=true;
+         for(std::size_t vertex=0;vertex<vertices.size();vertex++) identical=identical && isIdentical(normals[vertex],expected[vertex]) && isIdentical(parallel[vertex],expected[vertex]);
+         CHECK(identical);
+         CHECK_THAT(normals[200].length(),Catch::Matchers::WithinAbs(1.0,1e-15));
+         CHECK(normals.back().isZero());
+      }
+
+      // the corner of a cube gets the diagonal with angle weights whatever the triangulation of its faces
+      std::vector<Vector3D> cube={Vector3D(0,0,0),Vector3D(1,0,0),Vector3D(1,1,0),Vector3D(0,1,0),Vector3D(0,0,1),Vector3D(1,0,1),Vector3D(1,1,1),Vector3D(0,1,1)};
+      std::vector<std::uint32_t> quads={0,3,2,1, 4,5,6,7, 0,1,5,4, 2,3,7,6, 1,2,6,5, 0,4,7,3},triangles;
+      for(std::size_t quad=0;quad<quads.size();quad+=4) triangles.insert(triangles.end(),{quads[quad],quads[quad+1],quads[quad+2],quads[quad],quads[quad+2],quads[quad+3]});
+      std::vector<Vector3D> normals(cube.size());
+      CHECK(Vector3DMesh::vertexNormals(cube,triangles,normals,Vector3DMesh::Angle));
+      double diagonal=1.0/std::sqrt(3.0);
+      for(std::size_t vertex=0;vertex<cube.size();vertex++)
+      {
+         Vector3D outward=cube[vertex]-Vector3D(0.5,0.5,0.5);
+         outward.setLength(1.0,Vector3D::Precise);
+         CHECK(normals[vertex].distance(outward)<1e-12);
+         CHECK_THAT(std::fabs(normals[vertex].x()),Catch::Matchers::WithinAbs(diagonal,1e-12));
+      }
+   }
+
+   SECTION("Small faces")
+   {
+      // cross products of nanometre faces are below the fuzzy zero of setLength() but still have a direction
+      std::vector<Vector3D> tiny={Vector3D(0.0,0.0,0.0),Vector3D(1.0e-9,0.0,0.0),Vector3D(0.0,1.0e-9,0.0)};
+      std::vector<Vector3D> normal(1);
+      CHECK(Vector3DMesh::faceNormals(tiny,std::vector<std::uint32_t>{0,1,2},normal));
+      CHECK(normal[0]==Vector3D(0.0,0.0,1.0));
+      for(Vector3D &vertex : tiny) vertex*=1.0e-151;
+      CHECK(Vector3DMesh::faceNormals(tiny,std::vector<std::uint32_t>{0,1,2},normal));
+      CHECK(normal[0]==Vector3D(0.0,0.0,1.0));
+
+      std::vector<Vector3D> scaled(vertices.size());
+      std::transform(vertices.begin(),vertices.end(),scaled.begin(),[](const Vector3D &vertex) { return vertex*1.0e-9; });
+      Vector3DArray normals(faces),expected(faces);
+      CHECK(Vector3DMesh::faceNormals(Vector3DExecution::parallel(pool,64),scaled,indices,normals));
+      CHECK(Vector3DMesh::faceNormals(vertices,indices,expected));
+      double error=0.0;
+      for(std::size_t face=0;face+1<faces;face++) error=std::max(error,normals[face].distance(expected[face]));
+      CHECK(error<1e-12);
+      CHECK(normals[faces-1].isZero());
+
+      for(Vector3DMesh::Weighting weighting : {Vector3DMesh::Area,Vector3DMesh::Angle})
+      {
+         CAPTURE(weighting);
+         std::vector<Vector3D> sequential(vertices.size()),unscaled(vertices.size());
+         Vector3DArray parallel(vertices.size());
+         CHECK(Vector3DMesh::vertexNormals(scaled,indices,sequential,weighting));
+         CHECK(Vector3DMesh::vertexNormals(Vector3DExecution::parallel(pool,100),scaled,indices,parallel,weighting));
+         CHECK(Vector3DMesh::vertexNormals(vertices,indices,unscaled,weighting));
+         bool identical=true;
+         error=0.0;
+         for(std::size_t vertex=0;vertex+1<vertices.size();vertex++)
+         {
+            identical=identical && isIdentical(sequential[vertex],parallel[vertex]);
+            error=std::max(error,sequential[vertex].distance(unscaled[vertex]));
+         }
+         CHECK(identical);
+         CHECK(error<1e-12);
+         CHECK(sequential.back().isZero());
+      }
+   }
+
+   SECTION("Invalid buffers")
+   {
+      std::vector<Vector3D> normals(vertices.size(),Vector3D(1.0,2.0,3.0));
+      std::vector<std::uint32_t> outside=indices;
+      outside[10]=static_cast<std::uint32_t>(vertices.size());
+      CHECK_FALSE(Vector3DMesh::vertexNormals(vertices,outside,normals));
+      CHECK_FALSE(Vector3DMesh::vertexNormals(vertices,std::span<const std::uint32_t>(indices).first(4),normals));
+      CHECK_FALSE(Vector3DMesh::vertexNormals(vertices,indices,Vector3DArrayView(normals).subview(0,10)));
+      CHECK_FALSE(Vector3DMesh::faceNormals(vertices,indices,normals));
+      CHECK(normals[0]==Vector3D(1.0,2.0,3.0));
+      CHECK(Vector3DMesh::faceNormals(vertices,std::span<const std::uint32_t>(),std::span<Vector3D>()));
+   }
+}
+
+TEST_CASE("Coordinate conversion")
+{
+   std::vector<Vector3D> vectors=randomVectors(1037,79);
+   vectors[5]=Vector3D(0.0,0.0,-2.0);
+   vectors[9]=Vector3D(-3.0,0.0,0.0);
+   vectors[10]=Vector3D(0.0,4.0,1.0);
+   Vector3DThreadPool pool(4);
+   Vector3DBatch::InstructionSet defaultSet=Vector3DBatch::instructionSet();
+
+   for(Vector3DBatch::InstructionSet set : instructionSets())
+   {
+      CAPTURE(Vector3DBatch::instructionSetName(set));
+      Vector3DBatch::setInstructionSet(set);
+
+      SECTION("Spherical")
+      {
+         Vector3DArray spherical(vectors.size()),degrees(vectors.size()),back(vectors.size());
+         CHECK(Vector3DBatch::toSpherical(vectors,spherical));
+         CHECK(Vector3DBatch::toSpherical(Vector3DExecution::parallel(pool,100),Vector3DArray(vectors),degrees,Vector3D::Degrees));
+         CHECK(Vector3DBatch::fromSpherical(degrees,back,Vector3D::Degrees));
+         double angleError=0.0,degreeError=0.0,error=0.0;
+         for(std::size_t i=0;i<vectors.size();i++)
+         {
+            const Vector3D &vector=vectors[i];
+            CHECK(isIdentical(spherical[i].x(),vector.length()));
+            angleError=std::max(angleError,std::fabs(spherical[i].y()-std::atan2(std::hypot(vector.x(),vector.y()),vector.z())));
+            angleError=std::max(angleError,std::fabs(spherical[i].z()-std::atan2(vector.y(),vector.x())));
+            degreeError=std::max(degreeError,std::fabs(degrees[i].y()-spherical[i].y()*Vector3D::Traits::rad2deg));
+            if(!vector.isZero()) error=std::max(error,(back[i]-vector).length()/vector.length());
+         }
+         CHECK(angleError<2.0*Vector3DBatch::coordinateAngleError);
+         CHECK(degreeError<1e-13);
+         CHECK(error<1e-14);
+         CHECK(spherical[3]==Vector3D());
+         CHECK(spherical[5]==Vector3D(2.0,Vector3D::Traits::pi,0.0));
+         CHECK(spherical[9]==Vector3D(3.0,Vector3D::Traits::pi/2.0,Vector3D::Traits::pi));
+         CHECK(degrees[10].z()==90.0);
+         CHECK(Vector3D(back[5]).distance(vectors[5])<1e-15);
+         CHECK(isIdentical(back[3],Vector3D()));
+      }
+
+      SECTION("Cylindrical")
+      {
+         Vector3DArray cylindrical(vectors.size()),back(vectors.size());
+         CHECK(Vector3DBatch::toCylindrical(vectors,cylindrical));
+         CHECK(Vector3DBatch::fromCylindrical(Vector3DExecution::parallel(pool,100),cylindrical,back));
+         double angleError=0.0,error=0.0;
+         for(std::size_t i=0;i<vectors.size();i++)
+         {
+            const Vector3D &vector=vectors[i];
+            CHECK(isIdentical(cylindrical[i].z(),vector.z()));
+            angleError=std::max(angleError,std::fabs(cylindrical[i].y()-std::atan2(vector.y(),vector.x())));
+            if(!vector.isZero()) error=std::max(error,(back[i]-vector).length()/vector.length());
+         }
+         CHECK(angleError<2.0*Vector3DBatch::coordinateAngleError);
+         CHECK(error<1e-14);
+         CHECK(cylindrical[10]==Vector3D(4.0,Vector3D::Traits::pi/2.0,1.0));
+      }
+
+      SECTION("Sines")
+      {
+         // one turn in quarter degree steps crosses every quadrant boundary, large angles use libm
+         std::vector<Vector3D> angles,points(1442);
+         for(int step=0;step<1440;step++) angles.emplace_back(2.0,step*0.25,0.0);
+         angles.emplace_back(1.0,3.0e5,0.0);
+         angles.emplace_back(1.0,std::nan(""),0.0);
+         CHECK(Vector3DBatch::fromCylindrical(angles,points,Vector3D::Degrees));
+         bool accurate=true;
+         for(std::size_t i=0;i<1441;i++)
+         {
+            double radians=angles[i].y()*Vector3D::Traits::deg2rad;
+            accurate=accurate && std::fabs(points[i].x()-angles[i].x()*std::cos(radians))<2e-15 && std::fabs(points[i].y()-angles[i].x()*std::sin(radians))<2e-15;
+         }
+         CHECK(accurate);
+         CHECK(std::fabs(points[360].x())<1e-15);
+         CHECK(points[360].y()==2.0);
+         CHECK(points[1441].isNaN());
+      }
+   }
+   Vector3DBatch::setInstructionSet(defaultSet);
+
+   Vector3DArray result(10);
+   CHECK_FALSE(Vector3DBatch::toSpherical(vectors,result));
+   CHECK_FALSE(Vector3DBatch::fromCylindrical(vectors,result));
+}
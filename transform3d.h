@@ -0,0 +1,180 @@
+#ifndef TRANSFORM3D_H
+#define TRANSFORM3D_H
+
+#include "vector3d.h"
+#include "rotation3d.h"
+
+#include <cmath>
+#include <limits>
+
+class Vector3DArrayView;
+class Vector3DArrayConstView;
+
+/**
+ * @brief The Transform3D class is an affine transform stored as a row-major 3x4 matrix, a linear part
+ * followed by a translation column. A chain of rotate(), scale() and translate() calls folds into
+ * one matrix, so transforming a batch of vectors is a single pass of twelve operations per vector.
+ */
+class Transform3D
+{
+   public:
+      Transform3D();
+      explicit Transform3D(const Rotation3D &rotation);
+      Transform3D(const Rotation3D &rotation, double factor, const Vector3D &translation);
+
+      friend const Transform3D operator*(const Transform3D &transform1, const Transform3D &transform2);
+      friend const Vector3D operator*(const Transform3D &transform, const Vector3D &vector);
+
+      Transform3D &rotate(const Rotation3D &rotation);
+      Transform3D &rotate(const Vector3D &axis, double angle, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians);
+      Transform3D &scale(double factor);
+      Transform3D &translate(const Vector3D &translation);
+
+      void apply(Vector3D &vector) const;
+      bool apply(Vector3DArrayView vectors) const;
+      bool apply(Vector3DArrayConstView vectors, Vector3DArrayView result) const;
+
+      const Transform3D inverse() const;
+      bool isIdentity() const;
+      double element(int row, int column) const;
+      const double *data() const;
+
+      static const Transform3D scaling(double factor);
+      static const Transform3D translation(const Vector3D &translation);
+
+   private:
+      double pMatrix[12];
+      bool pIdentity;
+};
+
+inline Transform3D::Transform3D() : pMatrix{1.0,0.0,0.0,0.0,0.0,1.0,0.0,0.0,0.0,0.0,1.0,0.0}, pIdentity(true)
+{
+}
+
+inline Transform3D::Transform3D(const Rotation3D &rotation) : Transform3D()
+{
+   if(rotation.isIdentity()) return;
+   const double *m=rotation.data();
+   for(int row=0;row<3;row++)
+   {
+      for(int column=0;column<3;column++) pMatrix[row*4+column]=m[row*3+column];
+   }
+   pIdentity=false;
+}
+
+inline Transform3D::Transform3D(const Rotation3D &rotation, double factor, const Vector3D &translation) : Transform3D(rotation)
+{
+   scale(factor).translate(translation);
+}
+
+inline const Transform3D operator*(const Transform3D &transform1, const Transform3D &transform2)
+{
+   if(transform1.pIdentity) return transform2;
+   if(transform2.pIdentity) return transform1;
+   Transform3D result;
+   const double *a=transform1.pMatrix,*b=transform2.pMatrix;
+   for(int row=0;row<3;row++)
+   {
+      for(int column=0;column<4;column++) result.pMatrix[row*4+column]=a[row*4]*b[column]+a[row*4+1]*b[4+column]+a[row*4+2]*b[8+column];
+      result.pMatrix[row*4+3]+=a[row*4+3];
+   }
+   result.pIdentity=false;
+   return result;
+}
+
+inline const Vector3D operator*(const Transform3D &transform, const Vector3D &vector)
+{
+   Vector3D result(vector);
+   transform.apply(result);
+   return result;
+}
+
+inline Transform3D &Transform3D::rotate(const Rotation3D &rotation)
+{
+   *this=Transform3D(rotation)**this;
+   return *this;
+}
+
+inline Transform3D &Transform3D::rotate(const Vector3D &axis, double angle, Vector3D::AngularUnits units)
+{
+   return rotate(Rotation3D(axis,angle,units));
+}
+
+inline Transform3D &Transform3D::scale(double factor)
+{
+   if(factor==1.0) return *this;
+   for(double &element : pMatrix) element*=factor;
+   pIdentity=false;
+   return *this;
+}
+
+inline Transform3D &Transform3D::translate(const Vector3D &translation)
+{
+   if(translation.x()==0.0 && translation.y()==0.0 && translation.z()==0.0) return *this;
+   pMatrix[3]+=translation.x(); pMatrix[7]+=translation.y(); pMatrix[11]+=translation.z();
+   pIdentity=false;
+   return *this;
+}
+
+inline void Transform3D::apply(Vector3D &vector) const
+{
+   if(pIdentity) return;
+   const double *m=pMatrix;
+   double x=vector.x(),y=vector.y(),z=vector.z();
+   vector.set(m[0]*x+m[1]*y+m[2]*z+m[3],m[4]*x+m[5]*y+m[6]*z+m[7],m[8]*x+m[9]*y+m[10]*z+m[11]);
+}
+
+inline const Transform3D Transform3D::inverse() const
+{
+   if(pIdentity) return *this;
+   const double *m=pMatrix;
+   double c00=m[5]*m[10]-m[6]*m[9],c01=m[2]*m[9]-m[1]*m[10],c02=m[1]*m[6]-m[2]*m[5];
+   double c10=m[6]*m[8]-m[4]*m[10],c11=m[0]*m[10]-m[2]*m[8],c12=m[2]*m[4]-m[0]*m[6];
+   double c20=m[4]*m[9]-m[5]*m[8],c21=m[1]*m[8]-m[0]*m[9],c22=m[0]*m[5]-m[1]*m[4];
+   double determinant=m[0]*c00+m[1]*c10+m[2]*c20;
+
+   Transform3D result;
+   result.pIdentity=false;
+   double *t=result.pMatrix;
+   // Singular relative to the row norms, which bound the determinant, so uniformly tiny transforms still invert
+   double rowNorms=std::hypot(m[0],m[1],m[2])*std::hypot(m[4],m[5],m[6])*std::hypot(m[8],m[9],m[10]);
+   if(determinant==0.0 || std::fabs(determinant)<=std::numeric_limits<double>::epsilon()*rowNorms)
+   {
+      for(double &element : result.pMatrix) element=std::numeric_limits<double>::quiet_NaN();
+      return result;
+   }
+   t[0]=c00/determinant; t[1]=c01/determinant; t[2]=c02/determinant;
+   t[4]=c10/determinant; t[5]=c11/determinant; t[6]=c12/determinant;
+   t[8]=c20/determinant; t[9]=c21/determinant; t[10]=c22/determinant;
+   t[3]=-(t[0]*m[3]+t[1]*m[7]+t[2]*m[11]);
+   t[7]=-(t[4]*m[3]+t[5]*m[7]+t[6]*m[11]);
+   t[11]=-(t[8]*m[3]+t[9]*m[7]+t[10]*m[11]);
+   return result;
+}
+
+inline bool Transform3D::isIdentity() const
+{
+   return pIdentity;
+}
+
+inline double Transform3D::element(int row, int column) const
+{
+   return pMatrix[row*4+column];
+}
+
+inline const double *Transform3D::data() const
+{
+   return pMatrix;
+}
+
+inline const Transform3D Transform3D::scaling(double factor)
+{
+   return Transform3D().scale(factor);
+}
+
+inline const Transform3D Transform3D::translation(const Vector3D &translation)
+{
+   return Transform3D().translate(translation);
+}
+
+#endif // TRANSFORM3D_H
@@ -5,6 +5,9 @@
 #include <cmath>
 #include <ostream>
 #include <limits>
+#include <type_traits>
+
+#include "vector3dinstrumentation.h"
 
 #ifndef M_RAD2DEG
    #define M_RAD2DEG (180.0/M_PI)
@@ -14,120 +17,550 @@
    #define M_DEG2RAD (M_PI/180.0)
 #endif
 
+// Define VECTOR3D_HEADER_ONLY to get every method inline from this header,
+// otherwise the out-of-line methods are compiled once into vector3d.cpp
+#ifdef VECTOR3D_HEADER_ONLY
+   #define VECTOR3D_INLINE inline
+#else
+   #define VECTOR3D_INLINE
+#endif
+
+// Define VECTOR3D_FAST_MATH to make Fast the default accuracy of setLength(), angle() and rotate().
+// It changes default arguments, so it must be defined the same way for every translation unit.
+// The Vector3DBatch kernels stay Precise, so they then no longer match the default scalar results bit for bit.
+#ifdef VECTOR3D_FAST_MATH
+   #define VECTOR3D_DEFAULT_ACCURACY Fast
+#else
+   #define VECTOR3D_DEFAULT_ACCURACY Precise
+#endif
+
+// Define VECTOR3D_INSTRUMENTATION to count, trace and time the scalar operations, see vector3dinstrumentation.h.
+// Without it the probes compile to nothing.
+
+/**
+ * @brief The Vector3DTraits struct holds the per-type epsilon, angle conversions and fuzzy comparisons,
+ * so float vectors never get promoted to double math
+ */
+template<class T>
+struct Vector3DTraits
+{
+   static constexpr T epsilon=std::numeric_limits<T>::epsilon();
+   static constexpr T epsilonNeg=std::numeric_limits<T>::epsilon()*static_cast<T>(-1);
+   static constexpr T pi=static_cast<T>(3.141592653589793238462643383279502884L);
+   static constexpr T deg2rad=pi/static_cast<T>(180);
+   static constexpr T rad2deg=static_cast<T>(180)/pi;
+
+   static constexpr bool isEqual(T value1, T value2);
+   static constexpr bool isNotEqual(T value1, T value2);
+   static constexpr bool isZero(T value);
+   static constexpr bool isNotZero(T value);
+   static constexpr bool isNaN(T value);
+};
+
 /**
- * @brief The Vector3D class represents a vector or vertex in 3D space
+ * @brief Non-template base holding the angular units, shared by every BasicVector3D precision
  */
-class Vector3D
+struct Vector3DBase
+{
+   enum AngularUnits {Radians,Degrees};
+   /**
+    * @brief Precise uses libm. Fast uses the Vector3DFastMath acos and sin/cos approximations, with their
+    * error bounds, and multiplies by reciprocals instead of dividing, which costs up to two ulps
+    */
+   enum Accuracy {Precise,Fast};
+};
+
+template<class T> class BasicVector3D;
+
+template<class T> constexpr BasicVector3D<T> operator*(typename BasicVector3D<T>::ValueType factor, const BasicVector3D<T> &vector);
+template<class T> constexpr BasicVector3D<T> operator*(const BasicVector3D<T> &vector, typename BasicVector3D<T>::ValueType factor);
+template<class T> constexpr BasicVector3D<T> operator/(const BasicVector3D<T> &vector, typename BasicVector3D<T>::ValueType factor);
+template<class T> constexpr BasicVector3D<T> operator+(const BasicVector3D<T> &vector1, const BasicVector3D<T> &vector2);
+template<class T> constexpr BasicVector3D<T> operator-(const BasicVector3D<T> &vector1, const BasicVector3D<T> &vector2);
+template<class T> constexpr bool operator==(const BasicVector3D<T> &vector1, const BasicVector3D<T> &vector2);
+template<class T> constexpr bool operator!=(const BasicVector3D<T> &vector1, const BasicVector3D<T> &vector2);
+template<class T> constexpr bool operator>(const BasicVector3D<T> &vector1, const BasicVector3D<T> &vector2);
+template<class T> constexpr bool operator>=(const BasicVector3D<T> &vector1, const BasicVector3D<T> &vector2);
+template<class T> constexpr bool operator<(const BasicVector3D<T> &vector1, const BasicVector3D<T> &vector2);
+template<class T> constexpr bool operator<=(const BasicVector3D<T> &vector1, const BasicVector3D<T> &vector2);
+template<class T> std::ostream& operator<<(std::ostream& out, const BasicVector3D<T> &vector);
+
+/**
+ * @brief The BasicVector3D class represents a vector or vertex in 3D space with T precision components
+ */
+template<class T>
+class BasicVector3D : public Vector3DBase
 {
    public:
-      enum AngularUnits {Radians,Degrees};
-
-      Vector3D();
-      Vector3D(double x, double y, double z);
-      Vector3D(const Vector3D &vector);
-      Vector3D &operator=(const Vector3D &vector);
-      Vector3D &operator*=(double factor);
-      Vector3D &operator/=(double factor);
-      Vector3D &operator+=(const Vector3D &vector);
-      Vector3D &operator-=(const Vector3D &vector);
-
-      friend const Vector3D operator*(double factor, const Vector3D &vector);
-      friend const Vector3D operator*(const Vector3D &vector, double factor);
-      friend const Vector3D operator/(const Vector3D &vector, double factor);
-      friend const Vector3D operator+(const Vector3D &vector1, const Vector3D &vector2);
-      friend const Vector3D operator-(const Vector3D &vector1, const Vector3D &vector2);
-      friend bool operator==(const Vector3D &vector1, const Vector3D &vector2);
-      friend bool operator!=(const Vector3D &vector1, const Vector3D &vector2);
-      friend bool operator>(const Vector3D &vector1, const Vector3D &vector2);
-      friend bool operator>=(const Vector3D &vector1, const Vector3D &vector2);
-      friend bool operator<(const Vector3D &vector1, const Vector3D &vector2);
-      friend bool operator<=(const Vector3D &vector1, const Vector3D &vector2);
-      friend std::ostream& operator<<(std::ostream& out, const Vector3D &vector);
-
-      double x() const;
-      double y() const;
-      double z() const;
-
-      void setX(double x);
-      void setY(double y);
-      void setZ(double z);
-
-      void set(const Vector3D &vector);
-      void set(double x, double y, double z);
-
-      double length() const;
-      bool setLength(double length);
-
-      double distance(const Vector3D &vector) const;
-      double distance(double x, double y, double z) const;
-
-      double angle(const Vector3D &vector, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians) const;
-      double angle(double x, double y, double z, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians) const;
-
-      void rotate(const Vector3D &vector, double angle, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians);
-      void rotate(double x, double y, double z, double angle, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians);
-
-      bool isZero() const;
-      bool isNaN() const;
+      using ValueType=T;
+      using Traits=Vector3DTraits<T>;
+
+      struct LengthLess;
+      struct LengthGreater;
+      struct DistanceLess;
+
+      constexpr BasicVector3D();
+      constexpr BasicVector3D(T x, T y, T z);
+      constexpr BasicVector3D(const BasicVector3D &vector);
+      template<class U> constexpr explicit BasicVector3D(const BasicVector3D<U> &vector);
+      constexpr BasicVector3D &operator=(const BasicVector3D &vector);
+      constexpr BasicVector3D &operator*=(T factor);
+      constexpr BasicVector3D &operator/=(T factor);
+      constexpr BasicVector3D &operator+=(const BasicVector3D &vector);
+      constexpr BasicVector3D &operator-=(const BasicVector3D &vector);
+
+      friend constexpr BasicVector3D operator*<>(T factor, const BasicVector3D &vector);
+      friend constexpr BasicVector3D operator*<>(const BasicVector3D &vector, T factor);
+      friend constexpr BasicVector3D operator/<>(const BasicVector3D &vector, T factor);
+      friend constexpr BasicVector3D operator+<>(const BasicVector3D &vector1, const BasicVector3D &vector2);
+      friend constexpr BasicVector3D operator-<>(const BasicVector3D &vector1, const BasicVector3D &vector2);
+      friend constexpr bool operator==<>(const BasicVector3D &vector1, const BasicVector3D &vector2);
+      friend constexpr bool operator!=<>(const BasicVector3D &vector1, const BasicVector3D &vector2);
+      friend constexpr bool operator><>(const BasicVector3D &vector1, const BasicVector3D &vector2);
+      friend constexpr bool operator>=<>(const BasicVector3D &vector1, const BasicVector3D &vector2);
+      friend constexpr bool operator< <>(const BasicVector3D &vector1, const BasicVector3D &vector2);
+      friend constexpr bool operator<=<>(const BasicVector3D &vector1, const BasicVector3D &vector2);
+      friend std::ostream& operator<< <>(std::ostream& out, const BasicVector3D &vector);
+
+      constexpr T x() const;
+      constexpr T y() const;
+      constexpr T z() const;
+
+      constexpr void setX(T x);
+      constexpr void setY(T y);
+      constexpr void setZ(T z);
+
+      constexpr void set(const BasicVector3D &vector);
+      constexpr void set(T x, T y, T z);
+
+      T length() const;
+      constexpr T lengthSquared() const;
+      bool setLength(T length, Accuracy accuracy=VECTOR3D_DEFAULT_ACCURACY);
+
+      T distance(const BasicVector3D &vector) const;
+      T distance(T x, T y, T z) const;
+      constexpr T distanceSquared(const BasicVector3D &vector) const;
+      constexpr T distanceSquared(T x, T y, T z) const;
+
+      constexpr T dot(const BasicVector3D &vector) const;
+      constexpr BasicVector3D cross(const BasicVector3D &vector) const;
+      /**
+       * @brief Component of the vector along axis, and the remainder perpendicular to it. A zero axis gives NaN, as a division by zero does.
+       */
+      constexpr BasicVector3D project(const BasicVector3D &axis) const;
+      constexpr BasicVector3D reject(const BasicVector3D &axis) const;
+
+      T angle(const BasicVector3D &vector, AngularUnits units=AngularUnits::Radians, Accuracy accuracy=VECTOR3D_DEFAULT_ACCURACY) const;
+      T angle(T x, T y, T z, AngularUnits units=AngularUnits::Radians, Accuracy accuracy=VECTOR3D_DEFAULT_ACCURACY) const;
+
+      void rotate(const BasicVector3D &vector, T angle, AngularUnits units=AngularUnits::Radians, Accuracy accuracy=VECTOR3D_DEFAULT_ACCURACY);
+      void rotate(T x, T y, T z, T angle, AngularUnits units=AngularUnits::Radians, Accuracy accuracy=VECTOR3D_DEFAULT_ACCURACY);
+
+      constexpr bool isZero() const;
+      constexpr bool isNaN() const;
 
    private:
-      struct Quaternion { double x,y,z,w; };
-      double pX;
-      double pY;
-      double pZ;
+      struct Quaternion { T x,y,z,w; };
+      T pX;
+      T pY;
+      T pZ;
 
    protected:
-      static inline bool isEqual(double value1, double value2);
-      static inline bool isNotEqual(double value1, double value2);
-      static inline bool isZero(double value);
-      static inline bool isNotZero(double value);
+      static constexpr bool isEqual(T value1, T value2);
+      static constexpr bool isNotEqual(T value1, T value2);
+      static constexpr bool isZero(T value);
+      static constexpr bool isNotZero(T value);
 
-      static constexpr double pEpsilon=std::numeric_limits<double>::epsilon();
-      static constexpr double pEpsilonNeg=std::numeric_limits<double>::epsilon()*-1.0;
+      static constexpr T pEpsilon=Traits::epsilon;
+      static constexpr T pEpsilonNeg=Traits::epsilonNeg;
 };
 
-bool inline Vector3D::isEqual(double value1, double value2)
+/**
+ * @brief Orders vectors by length, comparing squared lengths so no square root is taken
+ */
+template<class T>
+struct BasicVector3D<T>::LengthLess
+{
+   bool operator()(const BasicVector3D &vector1, const BasicVector3D &vector2) const { return vector1.lengthSquared()<vector2.lengthSquared(); }
+};
+
+template<class T>
+struct BasicVector3D<T>::LengthGreater
+{
+   bool operator()(const BasicVector3D &vector1, const BasicVector3D &vector2) const { return vector1.lengthSquared()>vector2.lengthSquared(); }
+};
+
+/**
+ * @brief Orders vectors by their distance to a point, comparing squared distances
+ */
+template<class T>
+struct BasicVector3D<T>::DistanceLess
+{
+   BasicVector3D point;
+
+   explicit DistanceLess(const BasicVector3D &point) : point(point) {}
+   bool operator()(const BasicVector3D &vector1, const BasicVector3D &vector2) const { return vector1.distanceSquared(point)<vector2.distanceSquared(point); }
+};
+
+using Vector3D=BasicVector3D<double>;
+using Vector3DFloat=BasicVector3D<float>;
+using Vector3DLongDouble=BasicVector3D<long double>;
+
+template<class T>
+constexpr bool Vector3DTraits<T>::isEqual(T value1, T value2)
 {
    if(value1>=value2)
    {
-      if((value1-value2)<pEpsilon) return true; else return false;
+      if((value1-value2)<epsilon) return true; else return false;
    } else
    {
-      if((value2-value1)<pEpsilon) return true; else return false;
+      if((value2-value1)<epsilon) return true; else return false;
    }
 }
 
-bool inline Vector3D::isNotEqual(double value1, double value2)
+template<class T>
+constexpr bool Vector3DTraits<T>::isNotEqual(T value1, T value2)
 {
    if(value1>=value2)
    {
-      if((value1-value2)<pEpsilon) return false; else return true;
+      if((value1-value2)<epsilon) return false; else return true;
    } else
    {
-      if((value2-value1)<pEpsilon) return false; else return true;
+      if((value2-value1)<epsilon) return false; else return true;
    }
 }
 
-bool inline Vector3D::isZero(double value)
+template<class T>
+constexpr bool Vector3DTraits<T>::isZero(T value)
 {
-   if(value>=0.0)
+   if(value>=static_cast<T>(0))
    {
-      if(value<pEpsilon) return true; else return false;
+      if(value<epsilon) return true; else return false;
    } else
    {
-      if(value>pEpsilonNeg) return true; else return false;
+      if(value>epsilonNeg) return true; else return false;
    }
 }
 
-bool inline Vector3D::isNotZero(double value)
+template<class T>
+constexpr bool Vector3DTraits<T>::isNotZero(T value)
 {
-   if(value>=0.0)
+   if(value>=static_cast<T>(0))
    {
-      if(value<pEpsilon) return false; else return true;
+      if(value<epsilon) return false; else return true;
    } else
    {
-      if(value>pEpsilonNeg) return false; else return true;
+      if(value>epsilonNeg) return false; else return true;
+   }
+}
+
+/**
+ * @brief std::isnan is not constexpr before C++23, a NaN is the only value unequal to itself
+ */
+template<class T>
+constexpr bool Vector3DTraits<T>::isNaN(T value)
+{
+   if(std::is_constant_evaluated()) return value!=value;
+   return std::isnan(value);
+}
+
+template<class T>
+constexpr bool BasicVector3D<T>::isEqual(T value1, T value2)
+{
+   return Traits::isEqual(value1,value2);
+}
+
+template<class T>
+constexpr bool BasicVector3D<T>::isNotEqual(T value1, T value2)
+{
+   return Traits::isNotEqual(value1,value2);
+}
+
+template<class T>
+constexpr bool BasicVector3D<T>::isZero(T value)
+{
+   return Traits::isZero(value);
+}
+
+template<class T>
+constexpr bool BasicVector3D<T>::isNotZero(T value)
+{
+   return Traits::isNotZero(value);
+}
+
+template<class T>
+constexpr BasicVector3D<T>::BasicVector3D() : pX(0), pY(0), pZ(0)
+{
+}
+
+template<class T>
+constexpr BasicVector3D<T>::BasicVector3D(T x, T y, T z) : pX(x), pY(y), pZ(z)
+{
+}
+
+template<class T>
+constexpr BasicVector3D<T>::BasicVector3D(const BasicVector3D &vector) : pX(vector.pX), pY(vector.pY), pZ(vector.pZ)
+{
+}
+
+template<class T>
+template<class U>
+constexpr BasicVector3D<T>::BasicVector3D(const BasicVector3D<U> &vector) : pX(static_cast<T>(vector.x())), pY(static_cast<T>(vector.y())), pZ(static_cast<T>(vector.z()))
+{
+}
+
+template<class T>
+constexpr BasicVector3D<T> &BasicVector3D<T>::operator=(const BasicVector3D &vector)
+{
+   pX=vector.pX; pY=vector.pY; pZ=vector.pZ;
+   return *this;
+}
+
+template<class T>
+constexpr BasicVector3D<T> &BasicVector3D<T>::operator*=(T factor)
+{
+   VECTOR3D_PROBE(MultiplyAssign,isNaN() || Traits::isNaN(factor));
+   pX*=factor; pY*=factor; pZ*=factor;
+   VECTOR3D_PROBE_RESULT(isNaN());
+   return *this;
+}
+
+template<class T>
+constexpr BasicVector3D<T> &BasicVector3D<T>::operator/=(T factor)
+{
+   VECTOR3D_PROBE(DivideAssign,isNaN() || Traits::isNaN(factor));
+   if(BasicVector3D::isNotZero(factor))
+   {
+      pX/=factor; pY/=factor; pZ/=factor;
+   } else
+   {
+      VECTOR3D_PROBE_NEAR_ZERO();
+      pZ=pY=pX=std::numeric_limits<T>::quiet_NaN();
+   }
+   VECTOR3D_PROBE_RESULT(isNaN());
+   return *this;
+}
+
+template<class T>
+constexpr BasicVector3D<T> &BasicVector3D<T>::operator+=(const BasicVector3D &vector)
+{
+   VECTOR3D_PROBE(AddAssign,isNaN() || vector.isNaN());
+   pX+=vector.pX; pY+=vector.pY; pZ+=vector.pZ;
+   VECTOR3D_PROBE_RESULT(isNaN());
+   return *this;
+}
+
+template<class T>
+constexpr BasicVector3D<T> &BasicVector3D<T>::operator-=(const BasicVector3D &vector)
+{
+   VECTOR3D_PROBE(SubtractAssign,isNaN() || vector.isNaN());
+   pX-=vector.pX; pY-=vector.pY; pZ-=vector.pZ;
+   VECTOR3D_PROBE_RESULT(isNaN());
+   return *this;
+}
+
+template<class T>
+constexpr BasicVector3D<T> operator*(typename BasicVector3D<T>::ValueType factor, const BasicVector3D<T> &vector)
+{
+   VECTOR3D_PROBE(Multiply,vector.isNaN() || BasicVector3D<T>::Traits::isNaN(factor));
+   BasicVector3D<T> result(vector.pX*factor,vector.pY*factor,vector.pZ*factor);
+   VECTOR3D_PROBE_RESULT(result.isNaN());
+   return result;
+}
+
+template<class T>
+constexpr BasicVector3D<T> operator*(const BasicVector3D<T> &vector, typename BasicVector3D<T>::ValueType factor)
+{
+   VECTOR3D_PROBE(Multiply,vector.isNaN() || BasicVector3D<T>::Traits::isNaN(factor));
+   BasicVector3D<T> result(vector.pX*factor,vector.pY*factor,vector.pZ*factor);
+   VECTOR3D_PROBE_RESULT(result.isNaN());
+   return result;
+}
+
+template<class T>
+constexpr BasicVector3D<T> operator/(const BasicVector3D<T> &vector, typename BasicVector3D<T>::ValueType factor)
+{
+   VECTOR3D_PROBE(Divide,vector.isNaN() || BasicVector3D<T>::Traits::isNaN(factor));
+   if(BasicVector3D<T>::Traits::isZero(factor))
+   {
+      VECTOR3D_PROBE_NEAR_ZERO();
+      VECTOR3D_PROBE_RESULT(true);
+      return BasicVector3D<T>(std::numeric_limits<T>::quiet_NaN(),std::numeric_limits<T>::quiet_NaN(),std::numeric_limits<T>::quiet_NaN());
    }
+   BasicVector3D<T> result(vector.pX/factor,vector.pY/factor,vector.pZ/factor);
+   VECTOR3D_PROBE_RESULT(result.isNaN());
+   return result;
+}
+
+template<class T>
+constexpr BasicVector3D<T> operator+(const BasicVector3D<T> &vector1, const BasicVector3D<T> &vector2)
+{
+   VECTOR3D_PROBE(Add,vector1.isNaN() || vector2.isNaN());
+   BasicVector3D<T> result(vector1.pX+vector2.pX,vector1.pY+vector2.pY,vector1.pZ+vector2.pZ);
+   VECTOR3D_PROBE_RESULT(result.isNaN());
+   return result;
+}
+
+template<class T>
+constexpr BasicVector3D<T> operator-(const BasicVector3D<T> &vector1, const BasicVector3D<T> &vector2)
+{
+   VECTOR3D_PROBE(Subtract,vector1.isNaN() || vector2.isNaN());
+   BasicVector3D<T> result(vector1.pX-vector2.pX,vector1.pY-vector2.pY,vector1.pZ-vector2.pZ);
+   VECTOR3D_PROBE_RESULT(result.isNaN());
+   return result;
+}
+
+template<class T>
+constexpr bool operator==(const BasicVector3D<T> &vector1, const BasicVector3D<T> &vector2)
+{
+   if(BasicVector3D<T>::Traits::isNotEqual(vector1.pX,vector2.pX) || BasicVector3D<T>::Traits::isNotEqual(vector1.pY,vector2.pY) || BasicVector3D<T>::Traits::isNotEqual(vector1.pZ,vector2.pZ)) return false; else return true;
 }
 
+template<class T>
+constexpr bool operator!=(const BasicVector3D<T> &vector1, const BasicVector3D<T> &vector2)
+{
+   if(BasicVector3D<T>::Traits::isNotEqual(vector1.pX,vector2.pX) || BasicVector3D<T>::Traits::isNotEqual(vector1.pY,vector2.pY) || BasicVector3D<T>::Traits::isNotEqual(vector1.pZ,vector2.pZ)) return true; else return false;
+}
+
+template<class T>
+constexpr bool operator>(const BasicVector3D<T> &vector1, const BasicVector3D<T> &vector2)
+{
+   return vector1.lengthSquared()>vector2.lengthSquared();
+}
+
+template<class T>
+constexpr bool operator>=(const BasicVector3D<T> &vector1, const BasicVector3D<T> &vector2)
+{
+   return vector1.lengthSquared()>=vector2.lengthSquared();
+}
+
+template<class T>
+constexpr bool operator<(const BasicVector3D<T> &vector1, const BasicVector3D<T> &vector2)
+{
+   return vector1.lengthSquared()<vector2.lengthSquared();
+}
+
+template<class T>
+constexpr bool operator<=(const BasicVector3D<T> &vector1, const BasicVector3D<T> &vector2)
+{
+   return vector1.lengthSquared()<=vector2.lengthSquared();
+}
+
+template<class T>
+constexpr T BasicVector3D<T>::x() const
+{
+   return pX;
+}
+
+template<class T>
+constexpr T BasicVector3D<T>::y() const
+{
+   return pY;
+}
+
+template<class T>
+constexpr T BasicVector3D<T>::z() const
+{
+   return pZ;
+}
+
+template<class T>
+constexpr void BasicVector3D<T>::setX(T x)
+{
+   pX=x;
+}
+
+template<class T>
+constexpr void BasicVector3D<T>::setY(T y)
+{
+   pY=y;
+}
+
+template<class T>
+constexpr void BasicVector3D<T>::setZ(T z)
+{
+   pZ=z;
+}
+
+template<class T>
+constexpr void BasicVector3D<T>::set(const BasicVector3D &vector)
+{
+   pX=vector.pX; pY=vector.pY; pZ=vector.pZ;
+}
+
+template<class T>
+constexpr void BasicVector3D<T>::set(T x, T y, T z)
+{
+   pX=x; pY=y; pZ=z;
+}
+
+template<class T>
+constexpr T BasicVector3D<T>::lengthSquared() const
+{
+   return pX*pX+pY*pY+pZ*pZ;
+}
+
+template<class T>
+constexpr T BasicVector3D<T>::distanceSquared(const BasicVector3D &vector) const
+{
+   return distanceSquared(vector.pX,vector.pY,vector.pZ);
+}
+
+template<class T>
+constexpr T BasicVector3D<T>::distanceSquared(T x, T y, T z) const
+{
+   T dx=x-pX,dy=y-pY,dz=z-pZ;
+   return dx*dx+dy*dy+dz*dz;
+}
+
+template<class T>
+constexpr T BasicVector3D<T>::dot(const BasicVector3D &vector) const
+{
+   return pX*vector.pX+pY*vector.pY+pZ*vector.pZ;
+}
+
+template<class T>
+constexpr BasicVector3D<T> BasicVector3D<T>::cross(const BasicVector3D &vector) const
+{
+   return BasicVector3D(pY*vector.pZ-pZ*vector.pY,pZ*vector.pX-pX*vector.pZ,pX*vector.pY-pY*vector.pX);
+}
+
+template<class T>
+constexpr BasicVector3D<T> BasicVector3D<T>::project(const BasicVector3D &axis) const
+{
+   if(axis.isZero()) return BasicVector3D(std::numeric_limits<T>::quiet_NaN(),std::numeric_limits<T>::quiet_NaN(),std::numeric_limits<T>::quiet_NaN());
+   T scale=dot(axis)/axis.lengthSquared();
+   return BasicVector3D(axis.pX*scale,axis.pY*scale,axis.pZ*scale);
+}
+
+template<class T>
+constexpr BasicVector3D<T> BasicVector3D<T>::reject(const BasicVector3D &axis) const
+{
+   BasicVector3D projection=project(axis);
+   return BasicVector3D(pX-projection.pX,pY-projection.pY,pZ-projection.pZ);
+}
+
+template<class T>
+constexpr bool BasicVector3D<T>::isZero() const
+{
+   if(BasicVector3D::isNotZero(pX) || BasicVector3D::isNotZero(pY) || BasicVector3D::isNotZero(pZ)) return false; else return true;
+}
+
+template<class T>
+constexpr bool BasicVector3D<T>::isNaN() const
+{
+   if(Traits::isNaN(pX) || Traits::isNaN(pY) || Traits::isNaN(pZ)) return true; else return false;
+}
+
+#ifdef VECTOR3D_HEADER_ONLY
+   #include "vector3d_inl.h"
+#else
+   extern template class BasicVector3D<float>;
+   extern template class BasicVector3D<double>;
+   extern template class BasicVector3D<long double>;
+   extern template std::ostream& operator<<(std::ostream& out, const BasicVector3D<float> &vector);
+   extern template std::ostream& operator<<(std::ostream& out, const BasicVector3D<double> &vector);
+   extern template std::ostream& operator<<(std::ostream& out, const BasicVector3D<long double> &vector);
+#endif
+
 #endif // VECTOR3D_H
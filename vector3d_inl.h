@@ -0,0 +1,132 @@
+#ifndef VECTOR3D_INL_H
+#define VECTOR3D_INL_H
+
+#include "vector3d.h"
+#include "vector3dfastmath.h"
+
+#include <charconv>
+
+template<class T>
+VECTOR3D_INLINE std::ostream& operator<<(std::ostream& out, const BasicVector3D<T> &vector)
+{
+   auto write=[&out](T value)
+   {
+      char buffer[std::numeric_limits<T>::max_exponent10+32];
+      std::to_chars_result result=std::to_chars(buffer,buffer+sizeof(buffer),value,std::chars_format::fixed,6);
+      out.write(buffer,result.ptr-buffer);
+   };
+   out.write("Vector3D(",9);
+   write(vector.pX); out.put(','); write(vector.pY); out.put(','); write(vector.pZ);
+   out.write(", length=",9);
+   write(vector.length());
+   out.put(')');
+   return out;
+}
+
+template<class T>
+VECTOR3D_INLINE T BasicVector3D<T>::length() const
+{
+   VECTOR3D_PROBE(Length,isNaN());
+   T result=std::sqrt(lengthSquared());
+   VECTOR3D_PROBE_RESULT(std::isnan(result));
+   return result;
+}
+
+template<class T>
+VECTOR3D_INLINE bool BasicVector3D<T>::setLength(T length, Accuracy accuracy)
+{
+   VECTOR3D_PROBE(SetLength,isNaN() || std::isnan(length));
+   if(isNotZero(length))
+   {
+      if(BasicVector3D::isZero(pX) && BasicVector3D::isZero(pY) && BasicVector3D::isZero(pZ))
+      {
+         VECTOR3D_PROBE_NEAR_ZERO();
+         return false;
+      }
+      if(accuracy==Fast)
+      {
+         T factor=length/std::sqrt(lengthSquared());
+         pX*=factor; pY*=factor; pZ*=factor;
+         VECTOR3D_PROBE_RESULT(isNaN());
+         return true;
+      }
+      T factor=std::sqrt(lengthSquared())/length;
+      pX=pX/factor; pY=pY/factor; pZ=pZ/factor;
+   } else pZ=pY=pX=static_cast<T>(0);
+   VECTOR3D_PROBE_RESULT(isNaN());
+   return true;
+}
+
+template<class T>
+VECTOR3D_INLINE T BasicVector3D<T>::distance(const BasicVector3D &vector) const
+{
+   return distance(vector.pX,vector.pY,vector.pZ);
+}
+
+template<class T>
+VECTOR3D_INLINE T BasicVector3D<T>::distance(T x, T y, T z) const
+{
+   VECTOR3D_PROBE(Distance,isNaN() || std::isnan(x) || std::isnan(y) || std::isnan(z));
+   T result=std::sqrt(distanceSquared(x,y,z));
+   VECTOR3D_PROBE_RESULT(std::isnan(result));
+   return result;
+}
+
+template<class T>
+VECTOR3D_INLINE T BasicVector3D<T>::angle(const BasicVector3D &vector, AngularUnits units, Accuracy accuracy) const
+{
+   return angle(vector.pX,vector.pY,vector.pZ,units,accuracy);
+}
+
+template<class T>
+VECTOR3D_INLINE T BasicVector3D<T>::angle(T x, T y, T z, AngularUnits units, Accuracy accuracy) const
+{
+   VECTOR3D_PROBE(Angle,isNaN() || std::isnan(x) || std::isnan(y) || std::isnan(z));
+   if((BasicVector3D::isNotZero(x) || BasicVector3D::isNotZero(y) || BasicVector3D::isNotZero(z)) && (BasicVector3D::isNotZero(pX) || BasicVector3D::isNotZero(pY) || BasicVector3D::isNotZero(pZ)))
+   {
+      T arccos=(x*pX+y*pY+z*pZ)/(std::sqrt(x*x+y*y+z*z)*std::sqrt(lengthSquared()));
+      if(arccos>static_cast<T>(1)) arccos=static_cast<T>(1);
+      if(arccos<static_cast<T>(-1)) arccos=static_cast<T>(-1);
+      T result=accuracy==Fast ? Vector3DFastMath::acos(arccos) : std::acos(arccos);
+      VECTOR3D_PROBE_RESULT(std::isnan(result));
+      if(units==AngularUnits::Degrees) return result*Traits::rad2deg; else return result;
+   } else
+   {
+      VECTOR3D_PROBE_NEAR_ZERO();
+      return static_cast<T>(0);
+   }
+}
+
+template<class T>
+VECTOR3D_INLINE void BasicVector3D<T>::rotate(const BasicVector3D& vector, T angle, AngularUnits units, Accuracy accuracy)
+{
+   rotate(vector.pX,vector.pY,vector.pZ,angle,units,accuracy);
+}
+
+template<class T>
+VECTOR3D_INLINE void BasicVector3D<T>::rotate(T x, T y, T z, T angle, AngularUnits units, Accuracy accuracy)
+{
+   VECTOR3D_PROBE(Rotate,isNaN() || std::isnan(x) || std::isnan(y) || std::isnan(z) || std::isnan(angle));
+   if(units==AngularUnits::Degrees) angle*=Traits::deg2rad;
+
+   if((BasicVector3D::isNotZero(x) || BasicVector3D::isNotZero(y) || BasicVector3D::isNotZero(z)) && (BasicVector3D::isNotZero(pX) || BasicVector3D::isNotZero(pY) || BasicVector3D::isNotZero(pZ)) && BasicVector3D::isNotZero(angle))
+   {
+      T halfAngle=angle/static_cast<T>(-2),halfAngleSin,halfAngleCos;
+      if(accuracy==Fast)
+      {
+         T axisFactor=static_cast<T>(1)/std::sqrt(x*x+y*y+z*z); x*=axisFactor; y*=axisFactor; z*=axisFactor;
+         Vector3DFastMath::sinCos(halfAngle,halfAngleSin,halfAngleCos);
+      } else
+      {
+         T axisLength=std::sqrt(x*x+y*y+z*z); x/=axisLength; y/=axisLength; z/=axisLength;
+         halfAngleSin=std::sin(halfAngle); halfAngleCos=std::cos(halfAngle);
+      }
+      Quaternion t,r={.x=x*halfAngleSin,.y=y*halfAngleSin,.z=z*halfAngleSin,.w=halfAngleCos};
+      t.w=static_cast<T>(0)-r.x*pX-r.y*pY-r.z*pZ; t.x=r.w*pX+r.y*pZ-r.z*pY; t.y=r.w*pY-r.x*pZ+r.z*pX; t.z=r.w*pZ+r.x*pY-r.y*pX;
+      r.x*=static_cast<T>(-1); r.y*=static_cast<T>(-1); r.z*=static_cast<T>(-1);
+      pX=t.w*r.x+t.x*r.w+t.y*r.z-t.z*r.y; pY=t.w*r.y-t.x*r.z+t.y*r.w+t.z*r.x; pZ=t.w*r.z+t.x*r.y-t.y*r.x+t.z*r.w;
+      VECTOR3D_PROBE_RESULT(isNaN());
+   }
+}
+
+#endif // VECTOR3D_INL_H
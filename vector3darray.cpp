@@ -0,0 +1,1446 @@
+#include "vector3darray.h"
+#include "vector3dkernels.h"
+#include "quaternion.h"
+#include "vector3dradixsort.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <mutex>
+
+const Vector3DKernels::Table Vector3DKernels::tableScalar=Vector3DKernels::makeTable<Vector3DSimd::Scalar>("scalar");
+
+namespace
+{
+   constexpr std::size_t blockSize=256;
+
+   const Vector3DKernels::Table *kernelTable(Vector3DBatch::InstructionSet set)
+   {
+      switch(set)
+      {
+#ifdef VECTOR3D_HAVE_AVX512
+         case Vector3DBatch::AVX512: return __builtin_cpu_supports("avx512f") ? &Vector3DKernels::tableAVX512 : nullptr;
+#endif
+#ifdef VECTOR3D_HAVE_AVX2
+         case Vector3DBatch::AVX2: return __builtin_cpu_supports("avx2") ? &Vector3DKernels::tableAVX2 : nullptr;
+#endif
+#ifdef VECTOR3D_HAVE_SSE2
+         case Vector3DBatch::SSE2: return __builtin_cpu_supports("sse2") ? &Vector3DKernels::tableSSE2 : nullptr;
+#endif
+         case Vector3DBatch::Scalar: return &Vector3DKernels::tableScalar;
+         default: return nullptr;
+      }
+   }
+
+   Vector3DBatch::InstructionSet bestInstructionSet()
+   {
+      for(Vector3DBatch::InstructionSet set : {Vector3DBatch::AVX512,Vector3DBatch::AVX2,Vector3DBatch::SSE2})
+      {
+         if(kernelTable(set)!=nullptr) return set;
+      }
+      return Vector3DBatch::Scalar;
+   }
+
+   std::atomic<Vector3DBatch::InstructionSet> &activeSet()
+   {
+      static std::atomic<Vector3DBatch::InstructionSet> set(bestInstructionSet());
+      return set;
+   }
+
+   const Vector3DKernels::Table &kernels()
+   {
+      return *kernelTable(activeSet().load(std::memory_order_relaxed));
+   }
+
+   /**
+    * @brief Hands out contiguous component pointers for a block, gathering strided views into a buffer
+    */
+   class BlockReader
+   {
+      public:
+         explicit BlockReader(const Vector3DArrayConstView &view) : pView(view) {}
+
+         void read(std::size_t offset, std::size_t count, const double *&x, const double *&y, const double *&z)
+         {
+            if(pView.stride()==1)
+            {
+               x=pView.x()+offset; y=pView.y()+offset; z=pView.z()+offset;
+               return;
+            }
+            std::size_t stride=pView.stride(),index=offset*stride;
+            for(std::size_t i=0;i<count;i++,index+=stride)
+            {
+               pBufferX[i]=pView.x()[index]; pBufferY[i]=pView.y()[index]; pBufferZ[i]=pView.z()[index];
+            }
+            x=pBufferX; y=pBufferY; z=pBufferZ;
+         }
+
+      private:
+         const Vector3DArrayConstView &pView;
+         double pBufferX[blockSize];
+         double pBufferY[blockSize];
+         double pBufferZ[blockSize];
+   };
+
+   /**
+    * @brief Hands out contiguous component pointers for a block, scattering them back into strided views on flush
+    */
+   class BlockWriter
+   {
+      public:
+         explicit BlockWriter(const Vector3DArrayView &view) : pView(view) {}
+
+         void target(std::size_t offset, double *&x, double *&y, double *&z)
+         {
+            if(pView.stride()==1)
+            {
+               x=pView.x()+offset; y=pView.y()+offset; z=pView.z()+offset;
+            } else
+            {
+               x=pBufferX; y=pBufferY; z=pBufferZ;
+            }
+         }
+
+         void flush(std::size_t offset, std::size_t count)
+         {
+            if(pView.stride()==1) return;
+            std::size_t stride=pView.stride(),index=offset*stride;
+            for(std::size_t i=0;i<count;i++,index+=stride)
+            {
+               pView.x()[index]=pBufferX[i]; pView.y()[index]=pBufferY[i]; pView.z()[index]=pBufferZ[i];
+            }
+         }
+
+      private:
+         const Vector3DArrayView &pView;
+         double pBufferX[blockSize];
+         double pBufferY[blockSize];
+         double pBufferZ[blockSize];
+   };
+
+   std::size_t stepSize(std::size_t size, std::initializer_list<std::size_t> strides)
+   {
+      for(std::size_t stride : strides)
+      {
+         if(stride!=1) return blockSize;
+      }
+      return size>0 ? size : 1;
+   }
+
+   template<class Kernel>
+   void forEachBlock(const Vector3DArrayConstView &vectors, Kernel kernel)
+   {
+      BlockReader reader(vectors);
+      std::size_t size=vectors.size(),step=stepSize(size,{vectors.stride()});
+      for(std::size_t offset=0;offset<size;offset+=step)
+      {
+         std::size_t count=size-offset<step ? size-offset : step;
+         const double *x,*y,*z;
+         reader.read(offset,count,x,y,z);
+         kernel(x,y,z,offset,count);
+      }
+   }
+
+   template<class Kernel>
+   void forEachBlock(const Vector3DArrayConstView &vectors, const Vector3DArrayView &result, Kernel kernel)
+   {
+      BlockReader reader(vectors);
+      BlockWriter writer(result);
+      std::size_t size=vectors.size(),step=stepSize(size,{vectors.stride(),result.stride()});
+      for(std::size_t offset=0;offset<size;offset+=step)
+      {
+         std::size_t count=size-offset<step ? size-offset : step;
+         const double *ax,*ay,*az;
+         double *x,*y,*z;
+         reader.read(offset,count,ax,ay,az);
+         writer.target(offset,x,y,z);
+         kernel(ax,ay,az,x,y,z,count);
+         writer.flush(offset,count);
+      }
+   }
+
+   template<class Kernel>
+   void forEachBlock(const Vector3DArrayConstView &vectors1, const Vector3DArrayConstView &vectors2, const Vector3DArrayView &result, Kernel kernel)
+   {
+      BlockReader reader1(vectors1),reader2(vectors2);
+      BlockWriter writer(result);
+      std::size_t size=vectors1.size(),step=stepSize(size,{vectors1.stride(),vectors2.stride(),result.stride()});
+      for(std::size_t offset=0;offset<size;offset+=step)
+      {
+         std::size_t count=size-offset<step ? size-offset : step;
+         const double *ax,*ay,*az,*bx,*by,*bz;
+         double *x,*y,*z;
+         reader1.read(offset,count,ax,ay,az);
+         reader2.read(offset,count,bx,by,bz);
+         writer.target(offset,x,y,z);
+         kernel(ax,ay,az,bx,by,bz,x,y,z,count);
+         writer.flush(offset,count);
+      }
+   }
+
+   template<class Kernel>
+   void forEachBlock(const Vector3DArrayConstView &vectors1, const Vector3DArrayConstView &vectors2, Kernel kernel)
+   {
+      BlockReader reader1(vectors1),reader2(vectors2);
+      std::size_t size=vectors1.size(),step=stepSize(size,{vectors1.stride(),vectors2.stride()});
+      for(std::size_t offset=0;offset<size;offset+=step)
+      {
+         std::size_t count=size-offset<step ? size-offset : step;
+         const double *ax,*ay,*az,*bx,*by,*bz;
+         reader1.read(offset,count,ax,ay,az);
+         reader2.read(offset,count,bx,by,bz);
+         kernel(ax,ay,az,bx,by,bz,offset,count);
+      }
+   }
+
+   template<class Kernel>
+   void forEachBlock(const Vector3DExecution &execution, const Vector3DArrayConstView &vectors, Kernel kernel)
+   {
+      execution.forEachRange(vectors.size(),[&](std::size_t offset, std::size_t count)
+      {
+         forEachBlock(vectors.subview(offset,count),[&](const double *x, const double *y, const double *z, std::size_t blockOffset, std::size_t blockCount)
+         {
+            kernel(x,y,z,offset+blockOffset,blockCount);
+         });
+      });
+   }
+
+   template<class Kernel>
+   void forEachBlock(const Vector3DExecution &execution, const Vector3DArrayConstView &vectors1, const Vector3DArrayConstView &vectors2, Kernel kernel)
+   {
+      execution.forEachRange(vectors1.size(),[&](std::size_t offset, std::size_t count)
+      {
+         forEachBlock(vectors1.subview(offset,count),vectors2.subview(offset,count),[&](const double *ax, const double *ay, const double *az, const double *bx, const double *by, const double *bz, std::size_t blockOffset, std::size_t blockCount)
+         {
+            kernel(ax,ay,az,bx,by,bz,offset+blockOffset,blockCount);
+         });
+      });
+   }
+
+   template<class Kernel>
+   void forEachBlock(const Vector3DExecution &execution, const Vector3DArrayConstView &vectors, const Vector3DArrayView &result, Kernel kernel)
+   {
+      execution.forEachRange(vectors.size(),[&](std::size_t offset, std::size_t count)
+      {
+         forEachBlock(vectors.subview(offset,count),result.subview(offset,count),kernel);
+      });
+   }
+
+   template<class Kernel>
+   void forEachBlock(const Vector3DExecution &execution, const Vector3DArrayConstView &vectors1, const Vector3DArrayConstView &vectors2, const Vector3DArrayView &result, Kernel kernel)
+   {
+      execution.forEachRange(vectors1.size(),[&](std::size_t offset, std::size_t count)
+      {
+         forEachBlock(vectors1.subview(offset,count),vectors2.subview(offset,count),result.subview(offset,count),kernel);
+      });
+   }
+
+   /**
+    * @brief The axis of a projection, NaN when it is zero so the kernels match Vector3D::project()
+    */
+   Vector3D nanAxis(const Vector3D &axis)
+   {
+      double nan=std::numeric_limits<double>::quiet_NaN();
+      return axis.isZero() ? Vector3D(nan,nan,nan) : axis;
+   }
+
+   /**
+    * @brief Runs kernel(x,y,z,word,count) over blocks starting on multiples of 64 vectors, word being the mask word
+    * of the first vector, so no two threads share a mask word
+    */
+   template<class Kernel>
+   void forEachMaskBlock(const Vector3DExecution &execution, const Vector3DArrayConstView &vectors, Kernel kernel)
+   {
+      std::size_t size=vectors.size();
+      Vector3DExecution words=execution.isParallel() ? Vector3DExecution::parallel(*execution.pool(),(execution.grain()+63)/64) : execution;
+      words.forEachRange(Vector3DBatch::maskWords(size),[&](std::size_t offset, std::size_t count)
+      {
+         std::size_t first=offset*64;
+         forEachBlock(vectors.subview(first,std::min(count*64,size-first)),[&](const double *x, const double *y, const double *z, std::size_t blockOffset, std::size_t blockCount)
+         {
+            kernel(x,y,z,(first+blockOffset)/64,blockCount);
+         });
+      });
+   }
+
+   /**
+    * @brief Moves the vectors of [first,last) whose mask bit is clear to the front of the range and returns their
+    * count, first being a multiple of 64. Contiguous components go through the compact kernel, strided ones are
+    * copied one vector at a time without a branch on its bit. Words with nothing to move are skipped.
+    */
+   std::size_t keepUnmasked(const Vector3DArrayView &vectors, const std::uint64_t *mask, std::size_t first, std::size_t last)
+   {
+      double *x=vectors.x(),*y=vectors.y(),*z=vectors.z();
+      std::size_t stride=vectors.stride(),kept=first;
+      if(stride==1) return kernels().compact(x+first,y+first,z+first,last-first,mask+first/64);
+      for(std::size_t start=first;start<last;start+=64)
+      {
+         std::uint64_t bits=mask[start/64];
+         std::size_t count=std::min<std::size_t>(64,last-start);
+         if(bits==0 && kept==start)
+         {
+            kept+=count;
+            continue;
+         }
+         if(~bits==0) continue;
+         for(std::size_t i=start;i<start+count;i++,bits>>=1)
+         {
+            x[kept*stride]=x[i*stride];
+            y[kept*stride]=y[i*stride];
+            z[kept*stride]=z[i*stride];
+            kept+=1-(bits&1);
+         }
+      }
+      return kept-first;
+   }
+
+   /**
+    * @brief Copies count vectors from index from down to index to, to<=from
+    */
+   void moveDown(const Vector3DArrayView &vectors, std::size_t from, std::size_t to, std::size_t count)
+   {
+      if(from==to) return;
+      if(vectors.stride()==1)
+      {
+         std::copy(vectors.x()+from,vectors.x()+from+count,vectors.x()+to);
+         std::copy(vectors.y()+from,vectors.y()+from+count,vectors.y()+to);
+         std::copy(vectors.z()+from,vectors.z()+from+count,vectors.z()+to);
+         return;
+      }
+      for(std::size_t i=0;i<count;i++) vectors.set(to+i,vectors[from+i]);
+   }
+
+   constexpr std::size_t reductionGroup=16*blockSize;
+   constexpr std::size_t lanes=Vector3DKernels::reductionLanes;
+   constexpr std::size_t maxChannels=6;
+
+   /**
+    * @brief Fills width values of partials per group of reductionGroup vectors through group(view,partial).
+    * Groups start at multiples of reductionGroup whatever the policy, each one runs in the chunk holding its start.
+    */
+   template<class Group>
+   std::vector<double> forEachGroup(const Vector3DExecution &execution, const Vector3DArrayConstView &vectors, std::size_t width, Group group)
+   {
+      std::size_t size=vectors.size(),groups=(size+reductionGroup-1)/reductionGroup;
+      std::vector<double> partials(groups*width);
+      execution.forEachRange(size,[&](std::size_t offset, std::size_t count)
+      {
+         for(std::size_t index=(offset+reductionGroup-1)/reductionGroup;index*reductionGroup<offset+count;index++)
+         {
+            std::size_t start=index*reductionGroup;
+            group(vectors.subview(start,std::min(reductionGroup,size-start)),partials.data()+index*width);
+         }
+      });
+      return partials;
+   }
+
+   /**
+    * @brief Adds count rows of width values into the first one along a balanced tree
+    */
+   void pairwiseAdd(double *rows, std::size_t count, std::size_t width)
+   {
+      for(std::size_t step=1;step<count;step*=2)
+      {
+         for(std::size_t i=0;i+step<count;i+=2*step)
+         {
+            double *row=rows+i*width,*other=rows+(i+step)*width;
+            for(std::size_t j=0;j<width;j++) row[j]+=other[j];
+         }
+      }
+   }
+
+   void compensatedAdd(double &sum, double &compensation, double value)
+   {
+      double total=sum+value;
+      compensation+=std::fabs(sum)>=std::fabs(value) ? (sum-total)+value : (value-total)+sum;
+      sum=total;
+   }
+
+   /**
+    * @brief Sums channels values per vector with kernel(x,y,z,count,lanes) for Simple and Pairwise summation
+    * and compensated(x,y,z,count,lanes) for Compensated summation
+    */
+   template<class Kernel, class CompensatedKernel>
+   void sumChannels(const Vector3DExecution &execution, const Vector3DArrayConstView &vectors, Vector3DBatch::Summation summation, std::size_t channels, Kernel kernel, CompensatedKernel compensated, double *totals)
+   {
+      std::size_t width=channels*lanes;
+      if(summation==Vector3DBatch::Compensated)
+      {
+         std::vector<double> partials=forEachGroup(execution,vectors,2*width,[&](const Vector3DArrayConstView &group, double *partial)
+         {
+            std::fill(partial,partial+2*width,0.0);
+            forEachBlock(group,[&](const double *x, const double *y, const double *z, std::size_t, std::size_t count) { compensated(x,y,z,count,partial); });
+         });
+         std::vector<double> sums(width,0.0),compensations(width,0.0);
+         for(std::size_t offset=0;offset<partials.size();offset+=2*width)
+         {
+            for(std::size_t j=0;j<width;j++)
+            {
+               compensatedAdd(sums[j],compensations[j],partials[offset+j]);
+               compensations[j]+=partials[offset+width+j];
+            }
+         }
+         for(std::size_t c=0;c<channels;c++)
+         {
+            double sum=0.0,compensation=0.0;
+            for(std::size_t l=0;l<lanes;l++)
+            {
+               compensatedAdd(sum,compensation,sums[c*lanes+l]);
+               compensation+=compensations[c*lanes+l];
+            }
+            totals[c]=sum+compensation;
+         }
+         return;
+      }
+
+      std::vector<double> partials=forEachGroup(execution,vectors,width,[&](const Vector3DArrayConstView &group, double *partial)
+      {
+         if(summation==Vector3DBatch::Pairwise)
+         {
+            double leaves[reductionGroup/blockSize*maxChannels*lanes];
+            std::size_t count=(group.size()+blockSize-1)/blockSize;
+            std::fill(leaves,leaves+count*width,0.0);
+            for(std::size_t leaf=0;leaf<count;leaf++)
+            {
+               std::size_t offset=leaf*blockSize;
+               forEachBlock(group.subview(offset,std::min(blockSize,group.size()-offset)),[&](const double *x, const double *y, const double *z, std::size_t, std::size_t blockCount)
+               {
+                  kernel(x,y,z,blockCount,leaves+leaf*width);
+               });
+            }
+            pairwiseAdd(leaves,count,width);
+            std::copy(leaves,leaves+width,partial);
+            return;
+         }
+         std::fill(partial,partial+width,0.0);
+         forEachBlock(group,[&](const double *x, const double *y, const double *z, std::size_t, std::size_t count) { kernel(x,y,z,count,partial); });
+      });
+      std::vector<double> sums(width,0.0);
+      if(summation==Vector3DBatch::Pairwise)
+      {
+         pairwiseAdd(partials.data(),partials.size()/width,width);
+         if(!partials.empty()) std::copy(partials.begin(),partials.begin()+width,sums.begin());
+      } else
+      {
+         for(std::size_t offset=0;offset<partials.size();offset+=width)
+         {
+            for(std::size_t j=0;j<width;j++) sums[j]+=partials[offset+j];
+         }
+      }
+      for(std::size_t c=0;c<channels;c++)
+      {
+         pairwiseAdd(sums.data()+c*lanes,lanes,1);
+         totals[c]=sums[c*lanes];
+      }
+   }
+
+   /**
+    * @brief Folds channels lanes of minimums followed by channels lanes of maximums per group with kernel(x,y,z,count,lanes)
+    */
+   template<class Kernel>
+   void boundChannels(const Vector3DExecution &execution, const Vector3DArrayConstView &vectors, std::size_t channels, Kernel kernel, double *minimums, double *maximums)
+   {
+      std::size_t width=2*channels*lanes;
+      auto fold=[width](double *limits, const double *other)
+      {
+         for(std::size_t j=0;j<width/2;j++) limits[j]=other[j]<limits[j] ? other[j] : limits[j];
+         for(std::size_t j=width/2;j<width;j++) limits[j]=other[j]>limits[j] ? other[j] : limits[j];
+      };
+      std::vector<double> initial(width,std::numeric_limits<double>::infinity());
+      std::fill(initial.begin()+width/2,initial.end(),-std::numeric_limits<double>::infinity());
+
+      std::vector<double> partials=forEachGroup(execution,vectors,width,[&](const Vector3DArrayConstView &group, double *partial)
+      {
+         std::copy(initial.begin(),initial.end(),partial);
+         forEachBlock(group,[&](const double *x, const double *y, const double *z, std::size_t, std::size_t count) { kernel(x,y,z,count,partial); });
+      });
+      std::vector<double> limits=initial;
+      for(std::size_t offset=0;offset<partials.size();offset+=width) fold(limits.data(),partials.data()+offset);
+      for(std::size_t c=0;c<channels;c++)
+      {
+         const double *low=limits.data()+c*lanes,*high=limits.data()+(channels+c)*lanes;
+         minimums[c]=low[0]; maximums[c]=high[0];
+         for(std::size_t l=1;l<lanes;l++)
+         {
+            minimums[c]=low[l]<minimums[c] ? low[l] : minimums[c];
+            maximums[c]=high[l]>maximums[c] ? high[l] : maximums[c];
+         }
+      }
+   }
+
+   constexpr std::size_t pairRows=64;
+
+   /**
+    * @brief Splits rows into chunks of about grain pairs, the unit of work of the all-pairs functions
+    */
+   template<class Function>
+   void forEachRowRange(const Vector3DExecution &execution, std::size_t rows, std::size_t columns, Function function)
+   {
+      if(rows==0) return;
+      std::size_t chunk=std::max<std::size_t>(1,execution.grain()/std::max<std::size_t>(columns,1));
+      if(!execution.isParallel() || rows<=chunk)
+      {
+         function(std::size_t(0),rows);
+         return;
+      }
+      execution.pool()->parallelFor(rows,chunk,function);
+   }
+
+   /**
+    * @brief Computes the distances, or with columnLengths the angle cosines, of rows first to first+count against every
+    * column, pairRows rows at a time against blocks of blockSize columns. target(row,column) returns where the values
+    * of a block go, nullptr for a scratch buffer, then consume(row,column,values,count) gets them.
+    */
+   template<class Target, class Consume>
+   void forEachPairBlock(const Vector3DArrayConstView &rows, const Vector3DArrayConstView &columns, const double *columnLengths, std::size_t first, std::size_t count, Target target, Consume consume)
+   {
+      const Vector3DKernels::Table &table=kernels();
+      BlockReader reader(columns);
+      double buffer[blockSize];
+      Vector3D tile[pairRows];
+      double tileLengths[pairRows];
+      for(std::size_t tileFirst=first;tileFirst<first+count;tileFirst+=pairRows)
+      {
+         std::size_t tileSize=std::min(pairRows,first+count-tileFirst);
+         for(std::size_t r=0;r<tileSize;r++)
+         {
+            tile[r]=rows[tileFirst+r];
+            tileLengths[r]=std::sqrt(tile[r].lengthSquared());
+         }
+         for(std::size_t column=0;column<columns.size();column+=blockSize)
+         {
+            std::size_t columnCount=std::min(blockSize,columns.size()-column);
+            const double *x,*y,*z;
+            reader.read(column,columnCount,x,y,z);
+            for(std::size_t r=0;r<tileSize;r++)
+            {
+               double *values=target(tileFirst+r,column);
+               if(values==nullptr) values=buffer;
+               const Vector3D &vector=tile[r];
+               if(columnLengths) table.angleCosines(x,y,z,columnLengths+column,vector.x(),vector.y(),vector.z(),tileLengths[r],values,columnCount);
+               else table.distance(x,y,z,vector.x(),vector.y(),vector.z(),values,columnCount);
+               consume(tileFirst+r,column,values,columnCount);
+            }
+         }
+      }
+   }
+
+   double angleValue(double cosine, Vector3D::AngularUnits units)
+   {
+      return units==Vector3D::AngularUnits::Degrees ? std::acos(cosine)*Vector3D::Traits::rad2deg : std::acos(cosine);
+   }
+
+   /**
+    * @brief Ranks by value then by second index, NaN last
+    */
+   bool isCloser(const Vector3DBatch::Pair &pair1, const Vector3DBatch::Pair &pair2)
+   {
+      bool nan1=std::isnan(pair1.value),nan2=std::isnan(pair2.value);
+      if(nan1!=nan2) return nan2;
+      if(!nan1 && pair1.value!=pair2.value) return pair1.value<pair2.value;
+      return pair1.second<pair2.second;
+   }
+
+   /**
+    * @brief Whether any value, negated when negate is set, is below limit. Branch free, so whole blocks are skipped cheaply.
+    */
+   bool anyBelow(const double *values, std::size_t count, bool negate, double limit)
+   {
+      std::size_t below=0;
+      if(negate)
+      {
+         for(std::size_t i=0;i<count;i++) below+=values[i]>-limit;
+      } else
+      {
+         for(std::size_t i=0;i<count;i++) below+=values[i]<limit;
+      }
+      return below>0;
+   }
+
+   /**
+    * @brief Keeps the k closest pairs of every row in its slice of pairs, as a heap with the farthest on top.
+    * Cosines are negated so the closest angle has the lowest value.
+    */
+   bool nearest(const Vector3DExecution &execution, const Vector3DArrayConstView &vectors1, const Vector3DArrayConstView &vectors2, std::size_t k, std::span<Vector3DBatch::Pair> pairs, bool angles, Vector3D::AngularUnits units)
+   {
+      if(k>vectors2.size() || pairs.size()!=vectors1.size()*k) return false;
+      if(k==0) return true;
+      std::vector<double> lengths;
+      if(angles)
+      {
+         lengths.resize(vectors2.size());
+         Vector3DBatch::length(execution,vectors2,lengths);
+      }
+      std::size_t columns=vectors2.size();
+      forEachRowRange(execution,vectors1.size(),columns,[&](std::size_t first, std::size_t count)
+      {
+         forEachPairBlock(vectors1,vectors2,angles ? lengths.data() : nullptr,first,count,[](std::size_t, std::size_t) { return static_cast<double*>(nullptr); },
+                          [&](std::size_t row, std::size_t column, const double *values, std::size_t valueCount)
+         {
+            Vector3DBatch::Pair *heap=pairs.data()+row*k;
+            std::size_t size=std::min(column,k);
+            double farthest=size==k ? heap[0].value : 0.0;
+            // Columns arrive in index order, so a full heap only takes strictly closer values
+            bool open=size<k || std::isnan(farthest) || anyBelow(values,valueCount,angles,farthest);
+            for(std::size_t j=0;open && j<valueCount;j++)
+            {
+               double value=angles ? -values[j] : values[j];
+               if(size==k && !(value<farthest || (std::isnan(farthest) && !std::isnan(value)))) continue;
+               Vector3DBatch::Pair pair={row,column+j,value};
+               if(size<k)
+               {
+                  heap[size++]=pair;
+                  std::push_heap(heap,heap+size,isCloser);
+               } else
+               {
+                  std::pop_heap(heap,heap+k,isCloser);
+                  heap[k-1]=pair;
+                  std::push_heap(heap,heap+k,isCloser);
+               }
+               farthest=heap[0].value;
+            }
+            if(column+valueCount<columns) return;
+            std::sort_heap(heap,heap+k,isCloser);
+            if(angles)
+            {
+               for(std::size_t j=0;j<k;j++) heap[j].value=angleValue(-heap[j].value,units);
+            }
+         });
+      });
+      return true;
+   }
+
+   /**
+    * @brief Collects the pairs of every row range, then joins them in row order. Angles are preselected
+    * by cosine with a margin of a few ulps, then compared as the angle() values.
+    */
+   bool within(const Vector3DExecution &execution, const Vector3DArrayConstView &vectors1, const Vector3DArrayConstView &vectors2, double maximum, std::vector<Vector3DBatch::Pair> &pairs, bool angles, Vector3D::AngularUnits units)
+   {
+      pairs.clear();
+      if(!(maximum>=0.0)) return true;
+      std::vector<double> lengths;
+      double minimumCosine=-std::numeric_limits<double>::infinity();
+      if(angles)
+      {
+         lengths.resize(vectors2.size());
+         Vector3DBatch::length(execution,vectors2,lengths);
+         double radians=units==Vector3D::AngularUnits::Degrees ? maximum*Vector3D::Traits::deg2rad : maximum;
+         if(radians<Vector3D::Traits::pi) minimumCosine=std::cos(radians)-4.0*std::numeric_limits<double>::epsilon();
+      }
+      std::mutex mutex;
+      std::vector<std::pair<std::size_t,std::vector<Vector3DBatch::Pair>>> ranges;
+      forEachRowRange(execution,vectors1.size(),vectors2.size(),[&](std::size_t first, std::size_t count)
+      {
+         std::vector<Vector3DBatch::Pair> found;
+         forEachPairBlock(vectors1,vectors2,angles ? lengths.data() : nullptr,first,count,[](std::size_t, std::size_t) { return static_cast<double*>(nullptr); },
+                          [&](std::size_t row, std::size_t column, const double *values, std::size_t valueCount)
+         {
+            for(std::size_t j=0;j<valueCount;j++)
+            {
+               if(!angles)
+               {
+                  if(values[j]<=maximum) found.push_back({row,column+j,values[j]});
+               } else if(values[j]>=minimumCosine)
+               {
+                  double angle=angleValue(values[j],units);
+                  if(angle<=maximum) found.push_back({row,column+j,angle});
+               }
+            }
+         });
+         std::sort(found.begin(),found.end(),[](const Vector3DBatch::Pair &pair1, const Vector3DBatch::Pair &pair2) { return pair1.first<pair2.first || (pair1.first==pair2.first && pair1.second<pair2.second); });
+         std::lock_guard<std::mutex> lock(mutex);
+         ranges.emplace_back(first,std::move(found));
+      });
+      std::sort(ranges.begin(),ranges.end(),[](const auto &range1, const auto &range2) { return range1.first<range2.first; });
+      for(const auto &range : ranges) pairs.insert(pairs.end(),range.second.begin(),range.second.end());
+      return true;
+   }
+}
+
+Vector3DBatch::InstructionSet Vector3DBatch::instructionSet()
+{
+   return activeSet().load(std::memory_order_relaxed);
+}
+
+bool Vector3DBatch::setInstructionSet(InstructionSet set)
+{
+   if(kernelTable(set)==nullptr) return false;
+   activeSet().store(set,std::memory_order_relaxed);
+   return true;
+}
+
+bool Vector3DBatch::isSupported(InstructionSet set)
+{
+   return kernelTable(set)!=nullptr;
+}
+
+const char *Vector3DBatch::instructionSetName(InstructionSet set)
+{
+   switch(set)
+   {
+      case Vector3DBatch::SSE2: return "sse2";
+      case Vector3DBatch::AVX2: return "avx2";
+      case Vector3DBatch::AVX512: return "avx512";
+      default: return "scalar";
+   }
+}
+
+bool Vector3DBatch::copy(Vector3DArrayConstView vectors, Vector3DArrayView result)
+{
+   return copy(Vector3DExecution::sequential(),vectors,result);
+}
+
+bool Vector3DBatch::copy(const Vector3DExecution &execution, Vector3DArrayConstView vectors, Vector3DArrayView result)
+{
+   if(vectors.size()!=result.size()) return false;
+   if(vectors.stride()==1 && result.stride()==1)
+   {
+      execution.forEachRange(vectors.size(),[&](std::size_t offset, std::size_t count)
+      {
+         std::size_t bytes=count*sizeof(double);
+         std::memmove(result.x()+offset,vectors.x()+offset,bytes); std::memmove(result.y()+offset,vectors.y()+offset,bytes); std::memmove(result.z()+offset,vectors.z()+offset,bytes);
+      });
+      return true;
+   }
+   forEachBlock(execution,vectors,result,[](const double *ax, const double *ay, const double *az, double *x, double *y, double *z, std::size_t count)
+   {
+      std::memmove(x,ax,count*sizeof(double)); std::memmove(y,ay,count*sizeof(double)); std::memmove(z,az,count*sizeof(double));
+   });
+   return true;
+}
+
+bool Vector3DBatch::add(Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, Vector3DArrayView result)
+{
+   return add(Vector3DExecution::sequential(),vectors1,vectors2,result);
+}
+
+bool Vector3DBatch::add(const Vector3DExecution &execution, Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, Vector3DArrayView result)
+{
+   if(vectors1.size()!=vectors2.size() || vectors1.size()!=result.size()) return false;
+   forEachBlock(execution,vectors1,vectors2,result,kernels().add);
+   return true;
+}
+
+bool Vector3DBatch::add(Vector3DArrayConstView vectors, const Vector3D &vector, Vector3DArrayView result)
+{
+   return add(Vector3DExecution::sequential(),vectors,vector,result);
+}
+
+bool Vector3DBatch::add(const Vector3DExecution &execution, Vector3DArrayConstView vectors, const Vector3D &vector, Vector3DArrayView result)
+{
+   if(vectors.size()!=result.size()) return false;
+   const Vector3DKernels::Table &table=kernels();
+   forEachBlock(execution,vectors,result,[&](const double *ax, const double *ay, const double *az, double *x, double *y, double *z, std::size_t count)
+   {
+      table.translate(ax,ay,az,vector.x(),vector.y(),vector.z(),x,y,z,count);
+   });
+   return true;
+}
+
+bool Vector3DBatch::subtract(Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, Vector3DArrayView result)
+{
+   return subtract(Vector3DExecution::sequential(),vectors1,vectors2,result);
+}
+
+bool Vector3DBatch::subtract(const Vector3DExecution &execution, Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, Vector3DArrayView result)
+{
+   if(vectors1.size()!=vectors2.size() || vectors1.size()!=result.size()) return false;
+   forEachBlock(execution,vectors1,vectors2,result,kernels().subtract);
+   return true;
+}
+
+bool Vector3DBatch::subtract(Vector3DArrayConstView vectors, const Vector3D &vector, Vector3DArrayView result)
+{
+   return subtract(Vector3DExecution::sequential(),vectors,vector,result);
+}
+
+bool Vector3DBatch::subtract(const Vector3DExecution &execution, Vector3DArrayConstView vectors, const Vector3D &vector, Vector3DArrayView result)
+{
+   return add(execution,vectors,Vector3D(-vector.x(),-vector.y(),-vector.z()),result);
+}
+
+bool Vector3DBatch::scale(Vector3DArrayConstView vectors, double factor, Vector3DArrayView result)
+{
+   return scale(Vector3DExecution::sequential(),vectors,factor,result);
+}
+
+bool Vector3DBatch::scale(const Vector3DExecution &execution, Vector3DArrayConstView vectors, double factor, Vector3DArrayView result)
+{
+   if(vectors.size()!=result.size()) return false;
+   const Vector3DKernels::Table &table=kernels();
+   forEachBlock(execution,vectors,result,[&](const double *ax, const double *ay, const double *az, double *x, double *y, double *z, std::size_t count)
+   {
+      table.scale(ax,ay,az,factor,x,y,z,count);
+   });
+   return true;
+}
+
+bool Vector3DBatch::rotate(Vector3DArrayConstView vectors, const Rotation3D &rotation, Vector3DArrayView result)
+{
+   return rotate(Vector3DExecution::sequential(),vectors,rotation,result);
+}
+
+bool Vector3DBatch::rotate(const Vector3DExecution &execution, Vector3DArrayConstView vectors, const Rotation3D &rotation, Vector3DArrayView result)
+{
+   if(vectors.size()!=result.size()) return false;
+   if(rotation.isIdentity()) return copy(execution,vectors,result);
+   const Vector3DKernels::Table &table=kernels();
+   forEachBlock(execution,vectors,result,[&](const double *ax, const double *ay, const double *az, double *x, double *y, double *z, std::size_t count)
+   {
+      table.rotate(ax,ay,az,rotation.data(),x,y,z,count);
+   });
+   return true;
+}
+
+bool Vector3DBatch::rotate(Vector3DArrayConstView vectors, const Vector3D &axis, double angle, Vector3DArrayView result, Vector3D::AngularUnits units)
+{
+   return rotate(Vector3DExecution::sequential(),vectors,Rotation3D(axis,angle,units),result);
+}
+
+bool Vector3DBatch::rotate(const Vector3DExecution &execution, Vector3DArrayConstView vectors, const Vector3D &axis, double angle, Vector3DArrayView result, Vector3D::AngularUnits units)
+{
+   return rotate(execution,vectors,Rotation3D(axis,angle,units),result);
+}
+
+bool Vector3DBatch::transform(Vector3DArrayConstView vectors, const Transform3D &transform, Vector3DArrayView result)
+{
+   return Vector3DBatch::transform(Vector3DExecution::sequential(),vectors,transform,result);
+}
+
+bool Vector3DBatch::transform(const Vector3DExecution &execution, Vector3DArrayConstView vectors, const Transform3D &transform, Vector3DArrayView result)
+{
+   if(vectors.size()!=result.size()) return false;
+   if(transform.isIdentity()) return copy(execution,vectors,result);
+   const Vector3DKernels::Table &table=kernels();
+   forEachBlock(execution,vectors,result,[&](const double *ax, const double *ay, const double *az, double *x, double *y, double *z, std::size_t count)
+   {
+      table.transform(ax,ay,az,transform.data(),x,y,z,count);
+   });
+   return true;
+}
+
+bool Vector3DBatch::cross(Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, Vector3DArrayView result)
+{
+   return cross(Vector3DExecution::sequential(),vectors1,vectors2,result);
+}
+
+bool Vector3DBatch::cross(const Vector3DExecution &execution, Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, Vector3DArrayView result)
+{
+   if(vectors1.size()!=vectors2.size() || vectors1.size()!=result.size()) return false;
+   forEachBlock(execution,vectors1,vectors2,result,kernels().cross);
+   return true;
+}
+
+bool Vector3DBatch::project(Vector3DArrayConstView vectors, const Vector3D &axis, Vector3DArrayView result)
+{
+   return project(Vector3DExecution::sequential(),vectors,axis,result);
+}
+
+bool Vector3DBatch::project(const Vector3DExecution &execution, Vector3DArrayConstView vectors, const Vector3D &axis, Vector3DArrayView result)
+{
+   if(vectors.size()!=result.size()) return false;
+   const Vector3DKernels::Table &table=kernels();
+   Vector3D direction=nanAxis(axis);
+   double squared=direction.lengthSquared();
+   forEachBlock(execution,vectors,result,[&](const double *ax, const double *ay, const double *az, double *x, double *y, double *z, std::size_t count)
+   {
+      table.project(ax,ay,az,direction.x(),direction.y(),direction.z(),squared,x,y,z,count);
+   });
+   return true;
+}
+
+bool Vector3DBatch::reject(Vector3DArrayConstView vectors, const Vector3D &axis, Vector3DArrayView result)
+{
+   return reject(Vector3DExecution::sequential(),vectors,axis,result);
+}
+
+bool Vector3DBatch::reject(const Vector3DExecution &execution, Vector3DArrayConstView vectors, const Vector3D &axis, Vector3DArrayView result)
+{
+   if(vectors.size()!=result.size()) return false;
+   const Vector3DKernels::Table &table=kernels();
+   Vector3D direction=nanAxis(axis);
+   double squared=direction.lengthSquared();
+   forEachBlock(execution,vectors,result,[&](const double *ax, const double *ay, const double *az, double *x, double *y, double *z, std::size_t count)
+   {
+      table.reject(ax,ay,az,direction.x(),direction.y(),direction.z(),squared,x,y,z,count);
+   });
+   return true;
+}
+
+bool Vector3DBatch::setLength(Vector3DArrayConstView vectors, double length, Vector3DArrayView result)
+{
+   return setLength(Vector3DExecution::sequential(),vectors,length,result);
+}
+
+bool Vector3DBatch::setLength(const Vector3DExecution &execution, Vector3DArrayConstView vectors, double length, Vector3DArrayView result)
+{
+   if(vectors.size()!=result.size()) return false;
+   if(Vector3D::Traits::isZero(length))
+   {
+      forEachBlock(execution,vectors,result,[](const double *, const double *, const double *, double *x, double *y, double *z, std::size_t count)
+      {
+         std::fill(x,x+count,0.0); std::fill(y,y+count,0.0); std::fill(z,z+count,0.0);
+      });
+      return true;
+   }
+   const Vector3DKernels::Table &table=kernels();
+   forEachBlock(execution,vectors,result,[&](const double *ax, const double *ay, const double *az, double *x, double *y, double *z, std::size_t count)
+   {
+      table.setLength(ax,ay,az,length,x,y,z,count);
+   });
+   return true;
+}
+
+bool Vector3DBatch::dot(Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, std::span<double> dots)
+{
+   return dot(Vector3DExecution::sequential(),vectors1,vectors2,dots);
+}
+
+bool Vector3DBatch::dot(const Vector3DExecution &execution, Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, std::span<double> dots)
+{
+   if(vectors1.size()!=vectors2.size() || vectors1.size()!=dots.size()) return false;
+   const Vector3DKernels::Table &table=kernels();
+   forEachBlock(execution,vectors1,vectors2,[&](const double *ax, const double *ay, const double *az, const double *bx, const double *by, const double *bz, std::size_t offset, std::size_t count)
+   {
+      table.dot(ax,ay,az,bx,by,bz,dots.data()+offset,count);
+   });
+   return true;
+}
+
+bool Vector3DBatch::dot(Vector3DArrayConstView vectors, const Vector3D &vector, std::span<double> dots)
+{
+   return dot(Vector3DExecution::sequential(),vectors,vector,dots);
+}
+
+bool Vector3DBatch::dot(const Vector3DExecution &execution, Vector3DArrayConstView vectors, const Vector3D &vector, std::span<double> dots)
+{
+   if(vectors.size()!=dots.size()) return false;
+   const Vector3DKernels::Table &table=kernels();
+   forEachBlock(execution,vectors,[&](const double *x, const double *y, const double *z, std::size_t offset, std::size_t count)
+   {
+      table.dotVector(x,y,z,vector.x(),vector.y(),vector.z(),dots.data()+offset,count);
+   });
+   return true;
+}
+
+bool Vector3DBatch::length(Vector3DArrayConstView vectors, std::span<double> lengths)
+{
+   return length(Vector3DExecution::sequential(),vectors,lengths);
+}
+
+bool Vector3DBatch::length(const Vector3DExecution &execution, Vector3DArrayConstView vectors, std::span<double> lengths)
+{
+   if(vectors.size()!=lengths.size()) return false;
+   const Vector3DKernels::Table &table=kernels();
+   forEachBlock(execution,vectors,[&](const double *x, const double *y, const double *z, std::size_t offset, std::size_t count)
+   {
+      table.length(x,y,z,lengths.data()+offset,count);
+   });
+   return true;
+}
+
+bool Vector3DBatch::distance(Vector3DArrayConstView vectors, const Vector3D &vector, std::span<double> distances)
+{
+   return distance(Vector3DExecution::sequential(),vectors,vector,distances);
+}
+
+bool Vector3DBatch::distance(const Vector3DExecution &execution, Vector3DArrayConstView vectors, const Vector3D &vector, std::span<double> distances)
+{
+   if(vectors.size()!=distances.size()) return false;
+   const Vector3DKernels::Table &table=kernels();
+   forEachBlock(execution,vectors,[&](const double *x, const double *y, const double *z, std::size_t offset, std::size_t count)
+   {
+      table.distance(x,y,z,vector.x(),vector.y(),vector.z(),distances.data()+offset,count);
+   });
+   return true;
+}
+
+bool Vector3DBatch::angle(Vector3DArrayConstView vectors, const Vector3D &vector, std::span<double> angles, Vector3D::AngularUnits units)
+{
+   return angle(Vector3DExecution::sequential(),vectors,vector,angles,units);
+}
+
+bool Vector3DBatch::angle(const Vector3DExecution &execution, Vector3DArrayConstView vectors, const Vector3D &vector, std::span<double> angles, Vector3D::AngularUnits units)
+{
+   if(vectors.size()!=angles.size()) return false;
+   const Vector3DKernels::Table &table=kernels();
+   forEachBlock(execution,vectors,[&](const double *x, const double *y, const double *z, std::size_t offset, std::size_t count)
+   {
+      double *cosines=angles.data()+offset;
+      table.angleCosine(x,y,z,vector.x(),vector.y(),vector.z(),cosines,count);
+      if(units==Vector3D::AngularUnits::Degrees)
+      {
+         for(std::size_t i=0;i<count;i++) cosines[i]=std::acos(cosines[i])*Vector3D::Traits::rad2deg;
+      } else
+      {
+         for(std::size_t i=0;i<count;i++) cosines[i]=std::acos(cosines[i]);
+      }
+   });
+   return true;
+}
+
+bool Vector3DBatch::isZero(Vector3DArrayConstView vectors, std::span<std::uint8_t> flags)
+{
+   return isZero(Vector3DExecution::sequential(),vectors,flags);
+}
+
+bool Vector3DBatch::isZero(const Vector3DExecution &execution, Vector3DArrayConstView vectors, std::span<std::uint8_t> flags)
+{
+   if(vectors.size()!=flags.size()) return false;
+   const Vector3DKernels::Table &table=kernels();
+   forEachBlock(execution,vectors,[&](const double *x, const double *y, const double *z, std::size_t offset, std::size_t count)
+   {
+      table.isZero(x,y,z,flags.data()+offset,count);
+   });
+   return true;
+}
+
+bool Vector3DBatch::isNaN(Vector3DArrayConstView vectors, std::span<std::uint8_t> flags)
+{
+   return isNaN(Vector3DExecution::sequential(),vectors,flags);
+}
+
+bool Vector3DBatch::isNaN(const Vector3DExecution &execution, Vector3DArrayConstView vectors, std::span<std::uint8_t> flags)
+{
+   if(vectors.size()!=flags.size()) return false;
+   const Vector3DKernels::Table &table=kernels();
+   forEachBlock(execution,vectors,[&](const double *x, const double *y, const double *z, std::size_t offset, std::size_t count)
+   {
+      table.isNaN(x,y,z,flags.data()+offset,count);
+   });
+   return true;
+}
+
+bool Vector3DBatch::isZero(Vector3DArrayConstView vectors, std::span<std::uint64_t> mask)
+{
+   return filterMask(Vector3DExecution::sequential(),vectors,DropZero,mask);
+}
+
+bool Vector3DBatch::isZero(const Vector3DExecution &execution, Vector3DArrayConstView vectors, std::span<std::uint64_t> mask)
+{
+   return filterMask(execution,vectors,DropZero,mask);
+}
+
+bool Vector3DBatch::isNaN(Vector3DArrayConstView vectors, std::span<std::uint64_t> mask)
+{
+   return filterMask(Vector3DExecution::sequential(),vectors,DropNaN,mask);
+}
+
+bool Vector3DBatch::isNaN(const Vector3DExecution &execution, Vector3DArrayConstView vectors, std::span<std::uint64_t> mask)
+{
+   return filterMask(execution,vectors,DropNaN,mask);
+}
+
+bool Vector3DBatch::filterMask(Vector3DArrayConstView vectors, unsigned filters, std::span<std::uint64_t> mask, double minimumLength)
+{
+   return filterMask(Vector3DExecution::sequential(),vectors,filters,mask,minimumLength);
+}
+
+bool Vector3DBatch::filterMask(const Vector3DExecution &execution, Vector3DArrayConstView vectors, unsigned filters, std::span<std::uint64_t> mask, double minimumLength)
+{
+   if(mask.size()!=maskWords(vectors.size())) return false;
+   const Vector3DKernels::Table &table=kernels();
+   bool nan=(filters&DropNaN)!=0,zero=(filters&DropZero)!=0;
+   double squaredLength=(filters&DropShort)!=0 ? minimumLength*minimumLength : 0.0;
+   forEachMaskBlock(execution,vectors,[&](const double *x, const double *y, const double *z, std::size_t word, std::size_t count)
+   {
+      table.filterMask(x,y,z,count,nan,zero,squaredLength,mask.data()+word);
+   });
+   return true;
+}
+
+std::size_t Vector3DBatch::compact(Vector3DArrayView vectors, unsigned filters, double minimumLength)
+{
+   return compact(Vector3DExecution::sequential(),vectors,filters,minimumLength);
+}
+
+std::size_t Vector3DBatch::compact(const Vector3DExecution &execution, Vector3DArrayView vectors, unsigned filters, double minimumLength)
+{
+   std::size_t size=vectors.size(),words=maskWords(size),parts=1;
+   std::vector<std::uint64_t> mask(words);
+   filterMask(execution,vectors,filters,mask,minimumLength);
+   if(execution.isParallel()) parts=std::clamp<std::size_t>(size/execution.grain(),1,4*execution.pool()->size());
+   auto start=[&](std::size_t part) { return std::min(words*part/parts*64,size); };
+   std::vector<std::size_t> kept(parts);
+   Vector3DRadixSort::forEachPart(execution,parts,[&](std::size_t part)
+   {
+      kept[part]=keepUnmasked(vectors,mask.data(),start(part),start(part+1));
+   });
+   std::size_t offset=kept[0];
+   for(std::size_t part=1;part<parts;part++)
+   {
+      moveDown(vectors,start(part),offset,kept[part]);
+      offset+=kept[part];
+   }
+   return size-offset;
+}
+
+std::size_t Vector3DBatch::compact(Vector3DArray &vectors, unsigned filters, double minimumLength)
+{
+   return compact(Vector3DExecution::sequential(),vectors,filters,minimumLength);
+}
+
+std::size_t Vector3DBatch::compact(const Vector3DExecution &execution, Vector3DArray &vectors, unsigned filters, double minimumLength)
+{
+   std::size_t dropped=compact(execution,Vector3DArrayView(vectors),filters,minimumLength);
+   vectors.resize(vectors.size()-dropped);
+   return dropped;
+}
+
+std::size_t Vector3DBatch::compact(std::vector<Vector3D> &vectors, unsigned filters, double minimumLength)
+{
+   return compact(Vector3DExecution::sequential(),vectors,filters,minimumLength);
+}
+
+std::size_t Vector3DBatch::compact(const Vector3DExecution &execution, std::vector<Vector3D> &vectors, unsigned filters, double minimumLength)
+{
+   std::size_t dropped=compact(execution,Vector3DArrayView(vectors),filters,minimumLength);
+   vectors.resize(vectors.size()-dropped);
+   return dropped;
+}
+
+bool Vector3DBatch::toSpherical(Vector3DArrayConstView vectors, Vector3DArrayView coordinates, Vector3D::AngularUnits units)
+{
+   return toSpherical(Vector3DExecution::sequential(),vectors,coordinates,units);
+}
+
+bool Vector3DBatch::toSpherical(const Vector3DExecution &execution, Vector3DArrayConstView vectors, Vector3DArrayView coordinates, Vector3D::AngularUnits units)
+{
+   if(vectors.size()!=coordinates.size()) return false;
+   const Vector3DKernels::Table &table=kernels();
+   double scale=units==Vector3D::AngularUnits::Degrees ? Vector3D::Traits::rad2deg : 1.0;
+   forEachBlock(execution,vectors,coordinates,[&](const double *ax, const double *ay, const double *az, double *x, double *y, double *z, std::size_t count)
+   {
+      table.toSpherical(ax,ay,az,scale,x,y,z,count);
+   });
+   return true;
+}
+
+bool Vector3DBatch::fromSpherical(Vector3DArrayConstView coordinates, Vector3DArrayView vectors, Vector3D::AngularUnits units)
+{
+   return fromSpherical(Vector3DExecution::sequential(),coordinates,vectors,units);
+}
+
+bool Vector3DBatch::fromSpherical(const Vector3DExecution &execution, Vector3DArrayConstView coordinates, Vector3DArrayView vectors, Vector3D::AngularUnits units)
+{
+   if(coordinates.size()!=vectors.size()) return false;
+   const Vector3DKernels::Table &table=kernels();
+   double scale=units==Vector3D::AngularUnits::Degrees ? Vector3D::Traits::deg2rad : 1.0;
+   forEachBlock(execution,coordinates,vectors,[&](const double *ax, const double *ay, const double *az, double *x, double *y, double *z, std::size_t count)
+   {
+      table.fromSpherical(ax,ay,az,scale,x,y,z,count);
+   });
+   return true;
+}
+
+bool Vector3DBatch::toCylindrical(Vector3DArrayConstView vectors, Vector3DArrayView coordinates, Vector3D::AngularUnits units)
+{
+   return toCylindrical(Vector3DExecution::sequential(),vectors,coordinates,units);
+}
+
+bool Vector3DBatch::toCylindrical(const Vector3DExecution &execution, Vector3DArrayConstView vectors, Vector3DArrayView coordinates, Vector3D::AngularUnits units)
+{
+   if(vectors.size()!=coordinates.size()) return false;
+   const Vector3DKernels::Table &table=kernels();
+   double scale=units==Vector3D::AngularUnits::Degrees ? Vector3D::Traits::rad2deg : 1.0;
+   forEachBlock(execution,vectors,coordinates,[&](const double *ax, const double *ay, const double *az, double *x, double *y, double *z, std::size_t count)
+   {
+      table.toCylindrical(ax,ay,az,scale,x,y,z,count);
+   });
+   return true;
+}
+
+bool Vector3DBatch::fromCylindrical(Vector3DArrayConstView coordinates, Vector3DArrayView vectors, Vector3D::AngularUnits units)
+{
+   return fromCylindrical(Vector3DExecution::sequential(),coordinates,vectors,units);
+}
+
+bool Vector3DBatch::fromCylindrical(const Vector3DExecution &execution, Vector3DArrayConstView coordinates, Vector3DArrayView vectors, Vector3D::AngularUnits units)
+{
+   if(coordinates.size()!=vectors.size()) return false;
+   const Vector3DKernels::Table &table=kernels();
+   double scale=units==Vector3D::AngularUnits::Degrees ? Vector3D::Traits::deg2rad : 1.0;
+   forEachBlock(execution,coordinates,vectors,[&](const double *ax, const double *ay, const double *az, double *x, double *y, double *z, std::size_t count)
+   {
+      table.fromCylindrical(ax,ay,az,scale,x,y,z,count);
+   });
+   return true;
+}
+
+Vector3D Vector3DBatch::sum(Vector3DArrayConstView vectors, Summation summation)
+{
+   return sum(Vector3DExecution::sequential(),vectors,summation);
+}
+
+Vector3D Vector3DBatch::sum(const Vector3DExecution &execution, Vector3DArrayConstView vectors, Summation summation)
+{
+   const Vector3DKernels::Table &table=kernels();
+   double totals[3];
+   sumChannels(execution,vectors,summation,3,table.sum,table.compensatedSum,totals);
+   return Vector3D(totals[0],totals[1],totals[2]);
+}
+
+bool Vector3DBatch::centroid(Vector3DArrayConstView vectors, Vector3D &centroid, Summation summation)
+{
+   return Vector3DBatch::centroid(Vector3DExecution::sequential(),vectors,centroid,summation);
+}
+
+bool Vector3DBatch::centroid(const Vector3DExecution &execution, Vector3DArrayConstView vectors, Vector3D &centroid, Summation summation)
+{
+   if(vectors.size()==0) return false;
+   Vector3D total=sum(execution,vectors,summation);
+   double size=static_cast<double>(vectors.size());
+   centroid=Vector3D(total.x()/size,total.y()/size,total.z()/size);
+   return true;
+}
+
+bool Vector3DBatch::covariance(Vector3DArrayConstView vectors, std::span<double,9> matrix, Summation summation)
+{
+   return covariance(Vector3DExecution::sequential(),vectors,matrix,summation);
+}
+
+bool Vector3DBatch::covariance(const Vector3DExecution &execution, Vector3DArrayConstView vectors, std::span<double,9> matrix, Summation summation)
+{
+   Vector3D center;
+   if(!centroid(execution,vectors,center,summation)) return false;
+   const Vector3DKernels::Table &table=kernels();
+   double totals[6];
+   sumChannels(execution,vectors,summation,6,[&](const double *x, const double *y, const double *z, std::size_t count, double *partial)
+   {
+      table.moments(x,y,z,count,center.x(),center.y(),center.z(),partial);
+   },[&](const double *x, const double *y, const double *z, std::size_t count, double *partial)
+   {
+      table.compensatedMoments(x,y,z,count,center.x(),center.y(),center.z(),partial);
+   },totals);
+   double size=static_cast<double>(vectors.size());
+   matrix[0]=totals[0]/size; matrix[1]=totals[1]/size; matrix[2]=totals[2]/size;
+   matrix[3]=matrix[1]; matrix[4]=totals[3]/size; matrix[5]=totals[4]/size;
+   matrix[6]=matrix[2]; matrix[7]=matrix[5]; matrix[8]=totals[5]/size;
+   return true;
+}
+
+bool Vector3DBatch::boundingBox(Vector3DArrayConstView vectors, Vector3D &minimum, Vector3D &maximum)
+{
+   return boundingBox(Vector3DExecution::sequential(),vectors,minimum,maximum);
+}
+
+bool Vector3DBatch::boundingBox(const Vector3DExecution &execution, Vector3DArrayConstView vectors, Vector3D &minimum, Vector3D &maximum)
+{
+   if(vectors.size()==0) return false;
+   double minimums[3],maximums[3];
+   boundChannels(execution,vectors,3,kernels().bounds,minimums,maximums);
+   minimum=Vector3D(minimums[0],minimums[1],minimums[2]);
+   maximum=Vector3D(maximums[0],maximums[1],maximums[2]);
+   return true;
+}
+
+bool Vector3DBatch::lengthRange(Vector3DArrayConstView vectors, double &minimum, double &maximum)
+{
+   return lengthRange(Vector3DExecution::sequential(),vectors,minimum,maximum);
+}
+
+bool Vector3DBatch::lengthRange(const Vector3DExecution &execution, Vector3DArrayConstView vectors, double &minimum, double &maximum)
+{
+   if(vectors.size()==0) return false;
+   double minimums[1],maximums[1];
+   boundChannels(execution,vectors,1,kernels().squaredLengthBounds,minimums,maximums);
+   minimum=std::sqrt(minimums[0]);
+   maximum=std::sqrt(maximums[0]);
+   return true;
+}
+
+bool Vector3DBatch::distanceMatrix(Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, std::span<double> matrix)
+{
+   return distanceMatrix(Vector3DExecution::sequential(),vectors1,vectors2,matrix);
+}
+
+bool Vector3DBatch::distanceMatrix(const Vector3DExecution &execution, Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, std::span<double> matrix)
+{
+   if(matrix.size()!=vectors1.size()*vectors2.size()) return false;
+   std::size_t columns=vectors2.size();
+   forEachRowRange(execution,vectors1.size(),columns,[&](std::size_t first, std::size_t count)
+   {
+      forEachPairBlock(vectors1,vectors2,nullptr,first,count,[&](std::size_t row, std::size_t column) { return matrix.data()+row*columns+column; },
+                       [](std::size_t, std::size_t, const double*, std::size_t) {});
+   });
+   return true;
+}
+
+bool Vector3DBatch::angleMatrix(Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, std::span<double> matrix, Vector3D::AngularUnits units)
+{
+   return angleMatrix(Vector3DExecution::sequential(),vectors1,vectors2,matrix,units);
+}
+
+bool Vector3DBatch::angleMatrix(const Vector3DExecution &execution, Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, std::span<double> matrix, Vector3D::AngularUnits units)
+{
+   if(matrix.size()!=vectors1.size()*vectors2.size()) return false;
+   std::vector<double> lengths(vectors2.size());
+   length(execution,vectors2,lengths);
+   std::size_t columns=vectors2.size();
+   forEachRowRange(execution,vectors1.size(),columns,[&](std::size_t first, std::size_t count)
+   {
+      forEachPairBlock(vectors1,vectors2,lengths.data(),first,count,[&](std::size_t row, std::size_t column) { return matrix.data()+row*columns+column; },
+                       [&](std::size_t, std::size_t, double *values, std::size_t valueCount)
+      {
+         for(std::size_t j=0;j<valueCount;j++) values[j]=angleValue(values[j],units);
+      });
+   });
+   return true;
+}
+
+bool Vector3DBatch::nearestDistances(Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, std::size_t k, std::span<Pair> pairs)
+{
+   return nearest(Vector3DExecution::sequential(),vectors1,vectors2,k,pairs,false,Vector3D::AngularUnits::Radians);
+}
+
+bool Vector3DBatch::nearestDistances(const Vector3DExecution &execution, Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, std::size_t k, std::span<Pair> pairs)
+{
+   return nearest(execution,vectors1,vectors2,k,pairs,false,Vector3D::AngularUnits::Radians);
+}
+
+bool Vector3DBatch::nearestAngles(Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, std::size_t k, std::span<Pair> pairs, Vector3D::AngularUnits units)
+{
+   return nearest(Vector3DExecution::sequential(),vectors1,vectors2,k,pairs,true,units);
+}
+
+bool Vector3DBatch::nearestAngles(const Vector3DExecution &execution, Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, std::size_t k, std::span<Pair> pairs, Vector3D::AngularUnits units)
+{
+   return nearest(execution,vectors1,vectors2,k,pairs,true,units);
+}
+
+bool Vector3DBatch::distancesWithin(Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, double maximum, std::vector<Pair> &pairs)
+{
+   return within(Vector3DExecution::sequential(),vectors1,vectors2,maximum,pairs,false,Vector3D::AngularUnits::Radians);
+}
+
+bool Vector3DBatch::distancesWithin(const Vector3DExecution &execution, Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, double maximum, std::vector<Pair> &pairs)
+{
+   return within(execution,vectors1,vectors2,maximum,pairs,false,Vector3D::AngularUnits::Radians);
+}
+
+bool Vector3DBatch::anglesWithin(Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, double maximum, std::vector<Pair> &pairs, Vector3D::AngularUnits units)
+{
+   return within(Vector3DExecution::sequential(),vectors1,vectors2,maximum,pairs,true,units);
+}
+
+bool Vector3DBatch::anglesWithin(const Vector3DExecution &execution, Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, double maximum, std::vector<Pair> &pairs, Vector3D::AngularUnits units)
+{
+   return within(execution,vectors1,vectors2,maximum,pairs,true,units);
+}
+
+Vector3DArray &Vector3DArray::operator+=(const Vector3DArray &array)
+{
+   Vector3DBatch::add(*this,array,*this);
+   return *this;
+}
+
+Vector3DArray &Vector3DArray::operator-=(const Vector3DArray &array)
+{
+   Vector3DBatch::subtract(*this,array,*this);
+   return *this;
+}
+
+Vector3DArray &Vector3DArray::operator+=(const Vector3D &vector)
+{
+   Vector3DBatch::add(*this,vector,*this);
+   return *this;
+}
+
+Vector3DArray &Vector3DArray::operator-=(const Vector3D &vector)
+{
+   Vector3DBatch::subtract(*this,vector,*this);
+   return *this;
+}
+
+Vector3DArray &Vector3DArray::operator*=(double factor)
+{
+   Vector3DBatch::scale(*this,factor,*this);
+   return *this;
+}
+
+void Vector3DArray::rotate(const Rotation3D &rotation)
+{
+   Vector3DBatch::rotate(*this,rotation,*this);
+}
+
+void Vector3DArray::rotate(const Vector3D &axis, double angle, Vector3D::AngularUnits units)
+{
+   Vector3DBatch::rotate(*this,Rotation3D(axis,angle,units),*this);
+}
+
+void Vector3DArray::transform(const Transform3D &transform)
+{
+   Vector3DBatch::transform(*this,transform,*this);
+}
+
+bool Vector3DArray::copyTo(std::span<Vector3D> vectors) const
+{
+   return Vector3DBatch::copy(*this,vectors);
+}
+
+bool Vector3DArray::length(std::span<double> lengths) const
+{
+   return Vector3DBatch::length(*this,lengths);
+}
+
+bool Vector3DArray::distance(const Vector3D &vector, std::span<double> distances) const
+{
+   return Vector3DBatch::distance(*this,vector,distances);
+}
+
+bool Vector3DArray::angle(const Vector3D &vector, std::span<double> angles, Vector3D::AngularUnits units) const
+{
+   return Vector3DBatch::angle(*this,vector,angles,units);
+}
+
+bool Vector3DArray::isZero(std::span<std::uint8_t> flags) const
+{
+   return Vector3DBatch::isZero(*this,flags);
+}
+
+bool Vector3DArray::isNaN(std::span<std::uint8_t> flags) const
+{
+   return Vector3DBatch::isNaN(*this,flags);
+}
+
+bool Vector3DArray::isZero(std::span<std::uint64_t> mask) const
+{
+   return Vector3DBatch::isZero(*this,mask);
+}
+
+bool Vector3DArray::isNaN(std::span<std::uint64_t> mask) const
+{
+   return Vector3DBatch::isNaN(*this,mask);
+}
+
+bool Rotation3D::apply(Vector3DArrayView vectors) const
+{
+   return Vector3DBatch::rotate(vectors,*this,vectors);
+}
+
+bool Rotation3D::apply(Vector3DArrayConstView vectors, Vector3DArrayView result) const
+{
+   return Vector3DBatch::rotate(vectors,*this,result);
+}
+
+bool Quaternion::apply(Vector3DArrayView vectors) const
+{
+   return Vector3DBatch::rotate(vectors,Rotation3D(*this),vectors);
+}
+
+bool Quaternion::apply(Vector3DArrayConstView vectors, Vector3DArrayView result) const
+{
+   return Vector3DBatch::rotate(vectors,Rotation3D(*this),result);
+}
+
+bool Transform3D::apply(Vector3DArrayView vectors) const
+{
+   return Vector3DBatch::transform(vectors,*this,vectors);
+}
+
+bool Transform3D::apply(Vector3DArrayConstView vectors, Vector3DArrayView result) const
+{
+   return Vector3DBatch::transform(vectors,*this,result);
+}
@@ -0,0 +1,545 @@
+#ifndef VECTOR3DARRAY_H
+#define VECTOR3DARRAY_H
+
+#include "vector3d.h"
+#include "rotation3d.h"
+#include "transform3d.h"
+#include "vector3dexecution.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <span>
+#include <vector>
+
+static_assert(sizeof(Vector3D)==3*sizeof(double),"Vector3D must be three packed doubles to be viewed in place");
+
+/**
+ * @brief Allocator handing out cache line aligned storage for the Vector3DArray components
+ */
+template<class T>
+struct Vector3DAlignedAllocator
+{
+   using value_type=T;
+   static constexpr std::size_t alignment=64;
+
+   Vector3DAlignedAllocator()=default;
+   template<class U> Vector3DAlignedAllocator(const Vector3DAlignedAllocator<U> &) {}
+
+   T *allocate(std::size_t count) { return static_cast<T*>(::operator new(count*sizeof(T),std::align_val_t(alignment))); }
+   void deallocate(T *data, std::size_t) { ::operator delete(data,std::align_val_t(alignment)); }
+
+   template<class U> bool operator==(const Vector3DAlignedAllocator<U> &) const { return true; }
+   template<class U> bool operator!=(const Vector3DAlignedAllocator<U> &) const { return false; }
+};
+
+class Vector3DArray;
+
+/**
+ * @brief The Vector3DArrayView class is a non-owning, strided view of x/y/z components.
+ * It views a Vector3DArray (stride 1) or Vector3D objects in place (stride 3) without copying.
+ */
+class Vector3DArrayView
+{
+   public:
+      Vector3DArrayView(double *x, double *y, double *z, std::size_t size, std::size_t stride=1);
+      Vector3DArrayView(Vector3DArray &array);
+      Vector3DArrayView(std::span<Vector3D> vectors);
+      Vector3DArrayView(std::vector<Vector3D> &vectors);
+
+      Vector3D operator[](std::size_t index) const;
+      void set(std::size_t index, const Vector3D &vector) const;
+
+      double *x() const;
+      double *y() const;
+      double *z() const;
+      std::size_t size() const;
+      std::size_t stride() const;
+      Vector3DArrayView subview(std::size_t offset, std::size_t size) const;
+
+   private:
+      double *pX;
+      double *pY;
+      double *pZ;
+      std::size_t pSize;
+      std::size_t pStride;
+};
+
+/**
+ * @brief The Vector3DArrayConstView class is the read-only counterpart of Vector3DArrayView
+ */
+class Vector3DArrayConstView
+{
+   public:
+      Vector3DArrayConstView(const double *x, const double *y, const double *z, std::size_t size, std::size_t stride=1);
+      Vector3DArrayConstView(const Vector3DArray &array);
+      Vector3DArrayConstView(std::span<const Vector3D> vectors);
+      Vector3DArrayConstView(const std::vector<Vector3D> &vectors);
+      Vector3DArrayConstView(const Vector3DArrayView &view);
+
+      Vector3D operator[](std::size_t index) const;
+
+      const double *x() const;
+      const double *y() const;
+      const double *z() const;
+      std::size_t size() const;
+      std::size_t stride() const;
+      Vector3DArrayConstView subview(std::size_t offset, std::size_t size) const;
+
+   private:
+      const double *pX;
+      const double *pY;
+      const double *pZ;
+      std::size_t pSize;
+      std::size_t pStride;
+};
+
+/**
+ * @brief The Vector3DArray class stores vectors as three aligned component arrays (structure of arrays)
+ */
+class Vector3DArray
+{
+   public:
+      using Storage=std::vector<double,Vector3DAlignedAllocator<double>>;
+
+      Vector3DArray();
+      explicit Vector3DArray(std::size_t size);
+      explicit Vector3DArray(Vector3DArrayConstView vectors);
+
+      Vector3DArray &operator+=(const Vector3DArray &array);
+      Vector3DArray &operator-=(const Vector3DArray &array);
+      Vector3DArray &operator+=(const Vector3D &vector);
+      Vector3DArray &operator-=(const Vector3D &vector);
+      Vector3DArray &operator*=(double factor);
+
+      void rotate(const Rotation3D &rotation);
+      void rotate(const Vector3D &axis, double angle, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians);
+      void transform(const Transform3D &transform);
+
+      Vector3D operator[](std::size_t index) const;
+      void set(std::size_t index, const Vector3D &vector);
+      void append(const Vector3D &vector);
+
+      std::size_t size() const;
+      bool isEmpty() const;
+      void resize(std::size_t size);
+      void reserve(std::size_t size);
+      void clear();
+
+      double *x();
+      double *y();
+      double *z();
+      const double *x() const;
+      const double *y() const;
+      const double *z() const;
+
+      bool copyTo(std::span<Vector3D> vectors) const;
+
+      bool length(std::span<double> lengths) const;
+      bool distance(const Vector3D &vector, std::span<double> distances) const;
+      bool angle(const Vector3D &vector, std::span<double> angles, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians) const;
+      bool isZero(std::span<std::uint8_t> flags) const;
+      bool isNaN(std::span<std::uint8_t> flags) const;
+      bool isZero(std::span<std::uint64_t> mask) const;
+      bool isNaN(std::span<std::uint64_t> mask) const;
+
+   private:
+      Storage pX;
+      Storage pY;
+      Storage pZ;
+};
+
+/**
+ * @brief Batch counterparts of the Vector3D operations over whole views.
+ * Kernels are vectorized for SSE2, AVX2 and AVX-512, the widest one supported by the CPU is picked
+ * at runtime. Results are bit-identical to the scalar Vector3D methods at Precise accuracy, which is their
+ * default unless VECTOR3D_FAST_MATH is defined. The batch kernels always compute the Precise results, so with
+ * VECTOR3D_FAST_MATH they differ from a default setLength(), angle() or rotate(). Outputs may alias inputs.
+ * Each function has an overload taking a Vector3DExecution policy first, the plain overloads run sequentially.
+ * Results do not depend on the policy.
+ * Every function returns false, without touching the output, when the sizes do not match.
+ */
+namespace Vector3DBatch
+{
+   enum InstructionSet {Scalar,SSE2,AVX2,AVX512};
+
+   /**
+    * @brief Summation of the reductions: Simple adds in order, Compensated carries the rounding error of every
+    * addition (Kahan-Babuska), Pairwise adds along a balanced tree. Reductions split the vectors into fixed blocks
+    * aligned to the start of the view and combine them in a fixed order, so their results do not depend on the
+    * policy, the instruction set or the view stride.
+    */
+   enum Summation {Simple,Compensated,Pairwise};
+
+   /**
+    * @brief Vectors dropped by compact(): NaN ones, zero ones as Vector3D::isZero() sees them, and ones shorter than
+    * a minimum length. Combine them with |.
+    */
+   enum Filter {DropNaN=1,DropZero=2,DropShort=4};
+
+   /**
+    * @brief Number of 64 bit words of a mask over size vectors, vector i being bit i%64 of word i/64
+    */
+   constexpr std::size_t maskWords(std::size_t size) { return (size+63)/64; }
+
+   InstructionSet instructionSet();
+   bool setInstructionSet(InstructionSet set);
+   bool isSupported(InstructionSet set);
+   const char *instructionSetName(InstructionSet set);
+
+   bool copy(Vector3DArrayConstView vectors, Vector3DArrayView result);
+   bool copy(const Vector3DExecution &execution, Vector3DArrayConstView vectors, Vector3DArrayView result);
+   bool add(Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, Vector3DArrayView result);
+   bool add(const Vector3DExecution &execution, Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, Vector3DArrayView result);
+   bool add(Vector3DArrayConstView vectors, const Vector3D &vector, Vector3DArrayView result);
+   bool add(const Vector3DExecution &execution, Vector3DArrayConstView vectors, const Vector3D &vector, Vector3DArrayView result);
+   bool subtract(Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, Vector3DArrayView result);
+   bool subtract(const Vector3DExecution &execution, Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, Vector3DArrayView result);
+   bool subtract(Vector3DArrayConstView vectors, const Vector3D &vector, Vector3DArrayView result);
+   bool subtract(const Vector3DExecution &execution, Vector3DArrayConstView vectors, const Vector3D &vector, Vector3DArrayView result);
+   bool scale(Vector3DArrayConstView vectors, double factor, Vector3DArrayView result);
+   bool scale(const Vector3DExecution &execution, Vector3DArrayConstView vectors, double factor, Vector3DArrayView result);
+   bool rotate(Vector3DArrayConstView vectors, const Rotation3D &rotation, Vector3DArrayView result);
+   bool rotate(const Vector3DExecution &execution, Vector3DArrayConstView vectors, const Rotation3D &rotation, Vector3DArrayView result);
+   bool rotate(Vector3DArrayConstView vectors, const Vector3D &axis, double angle, Vector3DArrayView result, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians);
+   bool rotate(const Vector3DExecution &execution, Vector3DArrayConstView vectors, const Vector3D &axis, double angle, Vector3DArrayView result, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians);
+   bool transform(Vector3DArrayConstView vectors, const Transform3D &transform, Vector3DArrayView result);
+   bool transform(const Vector3DExecution &execution, Vector3DArrayConstView vectors, const Transform3D &transform, Vector3DArrayView result);
+   bool cross(Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, Vector3DArrayView result);
+   bool cross(const Vector3DExecution &execution, Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, Vector3DArrayView result);
+   bool project(Vector3DArrayConstView vectors, const Vector3D &axis, Vector3DArrayView result);
+   bool project(const Vector3DExecution &execution, Vector3DArrayConstView vectors, const Vector3D &axis, Vector3DArrayView result);
+   bool reject(Vector3DArrayConstView vectors, const Vector3D &axis, Vector3DArrayView result);
+   bool reject(const Vector3DExecution &execution, Vector3DArrayConstView vectors, const Vector3D &axis, Vector3DArrayView result);
+   /**
+    * @brief Vector3D::setLength() with Precise accuracy, zero vectors keep their value
+    */
+   bool setLength(Vector3DArrayConstView vectors, double length, Vector3DArrayView result);
+   bool setLength(const Vector3DExecution &execution, Vector3DArrayConstView vectors, double length, Vector3DArrayView result);
+
+   bool dot(Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, std::span<double> dots);
+   bool dot(const Vector3DExecution &execution, Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, std::span<double> dots);
+   bool dot(Vector3DArrayConstView vectors, const Vector3D &vector, std::span<double> dots);
+   bool dot(const Vector3DExecution &execution, Vector3DArrayConstView vectors, const Vector3D &vector, std::span<double> dots);
+   bool length(Vector3DArrayConstView vectors, std::span<double> lengths);
+   bool length(const Vector3DExecution &execution, Vector3DArrayConstView vectors, std::span<double> lengths);
+   bool distance(Vector3DArrayConstView vectors, const Vector3D &vector, std::span<double> distances);
+   bool distance(const Vector3DExecution &execution, Vector3DArrayConstView vectors, const Vector3D &vector, std::span<double> distances);
+   bool angle(Vector3DArrayConstView vectors, const Vector3D &vector, std::span<double> angles, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians);
+   bool angle(const Vector3DExecution &execution, Vector3DArrayConstView vectors, const Vector3D &vector, std::span<double> angles, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians);
+
+   bool isZero(Vector3DArrayConstView vectors, std::span<std::uint8_t> flags);
+   bool isZero(const Vector3DExecution &execution, Vector3DArrayConstView vectors, std::span<std::uint8_t> flags);
+   bool isNaN(Vector3DArrayConstView vectors, std::span<std::uint8_t> flags);
+   bool isNaN(const Vector3DExecution &execution, Vector3DArrayConstView vectors, std::span<std::uint8_t> flags);
+   bool isZero(Vector3DArrayConstView vectors, std::span<std::uint64_t> mask);
+   bool isZero(const Vector3DExecution &execution, Vector3DArrayConstView vectors, std::span<std::uint64_t> mask);
+   bool isNaN(Vector3DArrayConstView vectors, std::span<std::uint64_t> mask);
+   bool isNaN(const Vector3DExecution &execution, Vector3DArrayConstView vectors, std::span<std::uint64_t> mask);
+   /**
+    * @brief Mask of the vectors matching any of filters, a combination of Filter values
+    */
+   bool filterMask(Vector3DArrayConstView vectors, unsigned filters, std::span<std::uint64_t> mask, double minimumLength=0.0);
+   bool filterMask(const Vector3DExecution &execution, Vector3DArrayConstView vectors, unsigned filters, std::span<std::uint64_t> mask, double minimumLength=0.0);
+
+   /**
+    * @brief Drops the vectors matching any of filters in place and returns how many were dropped. The others keep
+    * their order at the front of the view, the container overloads shrink to them. Parallel policies compact
+    * their parts side by side and move them together along a prefix sum of the part sizes.
+    */
+   std::size_t compact(Vector3DArrayView vectors, unsigned filters, double minimumLength=0.0);
+   std::size_t compact(const Vector3DExecution &execution, Vector3DArrayView vectors, unsigned filters, double minimumLength=0.0);
+   std::size_t compact(Vector3DArray &vectors, unsigned filters, double minimumLength=0.0);
+   std::size_t compact(const Vector3DExecution &execution, Vector3DArray &vectors, unsigned filters, double minimumLength=0.0);
+   std::size_t compact(std::vector<Vector3D> &vectors, unsigned filters, double minimumLength=0.0);
+   std::size_t compact(const Vector3DExecution &execution, std::vector<Vector3D> &vectors, unsigned filters, double minimumLength=0.0);
+
+   /**
+    * @brief Conversions between Cartesian vectors and spherical (r,theta,phi) or cylindrical (rho,phi,z) coordinates
+    * held in the x, y and z components. theta is the polar angle from +z in [0,pi], phi the azimuth from +x towards +y
+    * in [-pi,pi], both in units. The trigonometry is vectorized rather than taken from libm, so unlike the other
+    * functions the results are not bit-identical to scalar code: angles are within coordinateAngleError radians and
+    * Cartesian components within coordinateError times the radius, for angles up to 1e5 radians and as long as the
+    * squared components neither overflow nor underflow. Radii are bit-identical to Vector3D::length(). theta is
+    * taken as atan2(rho,z) rather than acos(z/r), which keeps its accuracy near the poles. The azimuth of a vector on
+    * the z axis is 0, NaN components give NaN coordinates.
+    */
+   constexpr double coordinateAngleError=1.0e-15;
+   constexpr double coordinateError=1.0e-15;
+
+   bool toSpherical(Vector3DArrayConstView vectors, Vector3DArrayView coordinates, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians);
+   bool toSpherical(const Vector3DExecution &execution, Vector3DArrayConstView vectors, Vector3DArrayView coordinates, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians);
+   bool fromSpherical(Vector3DArrayConstView coordinates, Vector3DArrayView vectors, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians);
+   bool fromSpherical(const Vector3DExecution &execution, Vector3DArrayConstView coordinates, Vector3DArrayView vectors, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians);
+   bool toCylindrical(Vector3DArrayConstView vectors, Vector3DArrayView coordinates, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians);
+   bool toCylindrical(const Vector3DExecution &execution, Vector3DArrayConstView vectors, Vector3DArrayView coordinates, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians);
+   bool fromCylindrical(Vector3DArrayConstView coordinates, Vector3DArrayView vectors, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians);
+   bool fromCylindrical(const Vector3DExecution &execution, Vector3DArrayConstView coordinates, Vector3DArrayView vectors, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians);
+
+   Vector3D sum(Vector3DArrayConstView vectors, Summation summation=Simple);
+   Vector3D sum(const Vector3DExecution &execution, Vector3DArrayConstView vectors, Summation summation=Simple);
+
+   /**
+    * @brief The reductions below return false, without touching the output, when vectors is empty
+    */
+   bool centroid(Vector3DArrayConstView vectors, Vector3D &centroid, Summation summation=Simple);
+   bool centroid(const Vector3DExecution &execution, Vector3DArrayConstView vectors, Vector3D &centroid, Summation summation=Simple);
+
+   /**
+    * @brief Row-major population covariance matrix, accumulated about the centroid
+    */
+   bool covariance(Vector3DArrayConstView vectors, std::span<double,9> matrix, Summation summation=Simple);
+   bool covariance(const Vector3DExecution &execution, Vector3DArrayConstView vectors, std::span<double,9> matrix, Summation summation=Simple);
+
+   /**
+    * @brief Axis-aligned bounding box and length range, ignoring NaN components and NaN lengths
+    */
+   bool boundingBox(Vector3DArrayConstView vectors, Vector3D &minimum, Vector3D &maximum);
+   bool boundingBox(const Vector3DExecution &execution, Vector3DArrayConstView vectors, Vector3D &minimum, Vector3D &maximum);
+   bool lengthRange(Vector3DArrayConstView vectors, double &minimum, double &maximum);
+   bool lengthRange(const Vector3DExecution &execution, Vector3DArrayConstView vectors, double &minimum, double &maximum);
+
+   /**
+    * @brief Index of a vector of vectors1 and of a vector of vectors2, with their distance or angle
+    */
+   struct Pair
+   {
+      std::size_t first;
+      std::size_t second;
+      double value;
+   };
+
+   /**
+    * @brief All-pairs functions compare every vector of vectors1 with every vector of vectors2 in tiles of rows against
+    * blocks of vectors2 held in L1, with the lengths computed once per vector. Values are bit for bit those of
+    * vectors1[i].distance(vectors2[j]) and vectors1[i].angle(vectors2[j],Vector3D::Radians,Vector3D::Precise). The matrices are row-major, vectors1.size()
+    * rows of vectors2.size() values, and return false when the sizes do not match.
+    */
+   bool distanceMatrix(Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, std::span<double> matrix);
+   bool distanceMatrix(const Vector3DExecution &execution, Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, std::span<double> matrix);
+   bool angleMatrix(Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, std::span<double> matrix, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians);
+   bool angleMatrix(const Vector3DExecution &execution, Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, std::span<double> matrix, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians);
+
+   /**
+    * @brief Stores in pairs[i*k] to pairs[i*k+k-1] the k vectors of vectors2 closest to vectors1[i], closest first, ties by index
+    * and NaN last. Angles are ranked by their cosines. Returns false when k exceeds vectors2.size() or pairs does not hold
+    * vectors1.size()*k pairs.
+    */
+   bool nearestDistances(Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, std::size_t k, std::span<Pair> pairs);
+   bool nearestDistances(const Vector3DExecution &execution, Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, std::size_t k, std::span<Pair> pairs);
+   bool nearestAngles(Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, std::size_t k, std::span<Pair> pairs, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians);
+   bool nearestAngles(const Vector3DExecution &execution, Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, std::size_t k, std::span<Pair> pairs, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians);
+
+   /**
+    * @brief Replaces pairs with every pair whose distance or angle is at most maximum, ordered by first then second index
+    */
+   bool distancesWithin(Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, double maximum, std::vector<Pair> &pairs);
+   bool distancesWithin(const Vector3DExecution &execution, Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, double maximum, std::vector<Pair> &pairs);
+   bool anglesWithin(Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, double maximum, std::vector<Pair> &pairs, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians);
+   bool anglesWithin(const Vector3DExecution &execution, Vector3DArrayConstView vectors1, Vector3DArrayConstView vectors2, double maximum, std::vector<Pair> &pairs, Vector3D::AngularUnits units=Vector3D::AngularUnits::Radians);
+}
+
+inline Vector3DArrayView::Vector3DArrayView(double *x, double *y, double *z, std::size_t size, std::size_t stride) : pX(x), pY(y), pZ(z), pSize(size), pStride(stride)
+{
+}
+
+inline Vector3DArrayView::Vector3DArrayView(std::span<Vector3D> vectors)
+{
+   double *data=reinterpret_cast<double*>(vectors.data());
+   pX=data; pY=data+1; pZ=data+2; pSize=vectors.size(); pStride=3;
+}
+
+inline Vector3DArrayView::Vector3DArrayView(std::vector<Vector3D> &vectors) : Vector3DArrayView(std::span<Vector3D>(vectors))
+{
+}
+
+inline Vector3D Vector3DArrayView::operator[](std::size_t index) const
+{
+   std::size_t offset=index*pStride;
+   return Vector3D(pX[offset],pY[offset],pZ[offset]);
+}
+
+inline void Vector3DArrayView::set(std::size_t index, const Vector3D &vector) const
+{
+   std::size_t offset=index*pStride;
+   pX[offset]=vector.x(); pY[offset]=vector.y(); pZ[offset]=vector.z();
+}
+
+inline double *Vector3DArrayView::x() const
+{
+   return pX;
+}
+
+inline double *Vector3DArrayView::y() const
+{
+   return pY;
+}
+
+inline double *Vector3DArrayView::z() const
+{
+   return pZ;
+}
+
+inline std::size_t Vector3DArrayView::size() const
+{
+   return pSize;
+}
+
+inline std::size_t Vector3DArrayView::stride() const
+{
+   return pStride;
+}
+
+inline Vector3DArrayView Vector3DArrayView::subview(std::size_t offset, std::size_t size) const
+{
+   std::size_t start=offset*pStride;
+   return Vector3DArrayView(pX+start,pY+start,pZ+start,size,pStride);
+}
+
+inline Vector3DArrayConstView::Vector3DArrayConstView(const double *x, const double *y, const double *z, std::size_t size, std::size_t stride) : pX(x), pY(y), pZ(z), pSize(size), pStride(stride)
+{
+}
+
+inline Vector3DArrayConstView::Vector3DArrayConstView(std::span<const Vector3D> vectors)
+{
+   const double *data=reinterpret_cast<const double*>(vectors.data());
+   pX=data; pY=data+1; pZ=data+2; pSize=vectors.size(); pStride=3;
+}
+
+inline Vector3DArrayConstView::Vector3DArrayConstView(const std::vector<Vector3D> &vectors) : Vector3DArrayConstView(std::span<const Vector3D>(vectors))
+{
+}
+
+inline Vector3DArrayConstView::Vector3DArrayConstView(const Vector3DArrayView &view) : pX(view.x()), pY(view.y()), pZ(view.z()), pSize(view.size()), pStride(view.stride())
+{
+}
+
+inline Vector3D Vector3DArrayConstView::operator[](std::size_t index) const
+{
+   std::size_t offset=index*pStride;
+   return Vector3D(pX[offset],pY[offset],pZ[offset]);
+}
+
+inline const double *Vector3DArrayConstView::x() const
+{
+   return pX;
+}
+
+inline const double *Vector3DArrayConstView::y() const
+{
+   return pY;
+}
+
+inline const double *Vector3DArrayConstView::z() const
+{
+   return pZ;
+}
+
+inline std::size_t Vector3DArrayConstView::size() const
+{
+   return pSize;
+}
+
+inline std::size_t Vector3DArrayConstView::stride() const
+{
+   return pStride;
+}
+
+inline Vector3DArrayConstView Vector3DArrayConstView::subview(std::size_t offset, std::size_t size) const
+{
+   std::size_t start=offset*pStride;
+   return Vector3DArrayConstView(pX+start,pY+start,pZ+start,size,pStride);
+}
+
+inline Vector3DArray::Vector3DArray()
+{
+}
+
+inline Vector3DArray::Vector3DArray(std::size_t size) : pX(size,0.0), pY(size,0.0), pZ(size,0.0)
+{
+}
+
+inline Vector3DArray::Vector3DArray(Vector3DArrayConstView vectors) : pX(vectors.size()), pY(vectors.size()), pZ(vectors.size())
+{
+   Vector3DBatch::copy(vectors,*this);
+}
+
+inline Vector3D Vector3DArray::operator[](std::size_t index) const
+{
+   return Vector3D(pX[index],pY[index],pZ[index]);
+}
+
+inline void Vector3DArray::set(std::size_t index, const Vector3D &vector)
+{
+   pX[index]=vector.x(); pY[index]=vector.y(); pZ[index]=vector.z();
+}
+
+inline void Vector3DArray::append(const Vector3D &vector)
+{
+   pX.push_back(vector.x()); pY.push_back(vector.y()); pZ.push_back(vector.z());
+}
+
+inline std::size_t Vector3DArray::size() const
+{
+   return pX.size();
+}
+
+inline bool Vector3DArray::isEmpty() const
+{
+   return pX.empty();
+}
+
+inline void Vector3DArray::resize(std::size_t size)
+{
+   pX.resize(size,0.0); pY.resize(size,0.0); pZ.resize(size,0.0);
+}
+
+inline void Vector3DArray::reserve(std::size_t size)
+{
+   pX.reserve(size); pY.reserve(size); pZ.reserve(size);
+}
+
+inline void Vector3DArray::clear()
+{
+   pX.clear(); pY.clear(); pZ.clear();
+}
+
+inline double *Vector3DArray::x()
+{
+   return pX.data();
+}
+
+inline double *Vector3DArray::y()
+{
+   return pY.data();
+}
+
+inline double *Vector3DArray::z()
+{
+   return pZ.data();
+}
+
+inline const double *Vector3DArray::x() const
+{
+   return pX.data();
+}
+
+inline const double *Vector3DArray::y() const
+{
+   return pY.data();
+}
+
+inline const double *Vector3DArray::z() const
+{
+   return pZ.data();
+}
+
+inline Vector3DArrayView::Vector3DArrayView(Vector3DArray &array) : Vector3DArrayView(array.x(),array.y(),array.z(),array.size())
+{
+}
+
+inline Vector3DArrayConstView::Vector3DArrayConstView(const Vector3DArray &array) : Vector3DArrayConstView(array.x(),array.y(),array.z(),array.size())
+{
+}
+
+#endif // VECTOR3DARRAY_H
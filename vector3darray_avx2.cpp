@@ -0,0 +1,5 @@
+#include "vector3dkernels.h"
+
+#ifdef __AVX2__
+const Vector3DKernels::Table Vector3DKernels::tableAVX2=Vector3DKernels::makeTable<Vector3DSimd::AVX2>("avx2");
+#endif
@@ -0,0 +1,5 @@
+#include "vector3dkernels.h"
+
+#ifdef __AVX512F__
+const Vector3DKernels::Table Vector3DKernels::tableAVX512=Vector3DKernels::makeTable<Vector3DSimd::AVX512>("avx512");
+#endif
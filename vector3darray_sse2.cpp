@@ -0,0 +1,5 @@
+#include "vector3dkernels.h"
+
+#ifdef __SSE2__
+const Vector3DKernels::Table Vector3DKernels::tableSSE2=Vector3DKernels::makeTable<Vector3DSimd::SSE2>("sse2");
+#endif
@@ -0,0 +1,155 @@
+#include "vector3dcurve.h"
+#include "vector3dradixsort.h"
+
+#include <limits>
+#include <vector>
+
+namespace
+{
+   constexpr std::uint32_t cells=std::uint32_t(1)<<Vector3DCurve::bitsPerAxis;
+
+   /**
+    * @brief Cell scale and origin of one axis. A box with no extent, or an infinite one, puts every vector in cell zero.
+    */
+   struct Axis
+   {
+      double minimum;
+      double scale;
+
+      Axis(double minimum, double maximum) : minimum(minimum), scale(0.0)
+      {
+         double extent=maximum-minimum;
+         if(extent>0.0 && extent<std::numeric_limits<double>::infinity()) scale=cells/extent;
+      }
+
+      std::uint32_t cell(double value) const
+      {
+         double position=(value-minimum)*scale;
+         if(!(position>0.0)) return 0;
+         if(position>=cells) return cells-1;
+         return static_cast<std::uint32_t>(position);
+      }
+   };
+
+   /**
+    * @brief Spreads the 21 low bits of value three bits apart
+    */
+   std::uint64_t spread(std::uint32_t value)
+   {
+      std::uint64_t bits=value&(cells-1);
+      bits=(bits|bits<<32)&0x001f00000000ffffull;
+      bits=(bits|bits<<16)&0x001f0000ff0000ffull;
+      bits=(bits|bits<<8)&0x100f00f00f00f00full;
+      bits=(bits|bits<<4)&0x10c30c30c30c30c3ull;
+      bits=(bits|bits<<2)&0x1249249249249249ull;
+      return bits;
+   }
+
+   std::uint64_t interleave(std::uint32_t x, std::uint32_t y, std::uint32_t z)
+   {
+      return spread(x)<<2|spread(y)<<1|spread(z);
+   }
+
+   /**
+    * @brief Skilling's transform of cell coordinates into the transposed Hilbert index, whose interleaved bits are the key
+    * (J. Skilling, Programming the Hilbert curve, AIP Conference Proceedings 707, 2004)
+    */
+   std::uint64_t hilbert(std::uint32_t x, std::uint32_t y, std::uint32_t z)
+   {
+      // Branch-free: a set bit inverts the low bits of the first axis, a clear one exchanges them with this axis
+      std::uint32_t axes[3]={x,y,z};
+      for(unsigned bit=Vector3DCurve::bitsPerAxis-1;bit>0;bit--)
+      {
+         std::uint32_t lower=(std::uint32_t(1)<<bit)-1;
+         for(int i=0;i<3;i++)
+         {
+            std::uint32_t set=0u-((axes[i]>>bit)&1u);
+            std::uint32_t swap=(axes[0]^axes[i])&lower&~set;
+            axes[0]^=(lower&set)|swap;
+            axes[i]^=swap;
+         }
+      }
+      axes[1]^=axes[0];
+      axes[2]^=axes[1];
+      std::uint32_t flip=0;
+      for(unsigned bit=Vector3DCurve::bitsPerAxis-1;bit>0;bit--) flip^=((std::uint32_t(1)<<bit)-1)&(0u-((axes[2]>>bit)&1u));
+      return interleave(axes[0]^flip,axes[1]^flip,axes[2]^flip);
+   }
+
+   std::uint64_t curveKey(const Vector3D &vector, const Axis *axes, Vector3DCurve::Curve curve)
+   {
+      if(vector.isNaN()) return Vector3DCurve::nanKey;
+      std::uint32_t x=axes[0].cell(vector.x()),y=axes[1].cell(vector.y()),z=axes[2].cell(vector.z());
+      return curve==Vector3DCurve::Hilbert ? hilbert(x,y,z) : interleave(x,y,z);
+   }
+
+   struct Entry
+   {
+      std::uint64_t key;
+      std::size_t index;
+   };
+}
+
+std::uint64_t Vector3DCurve::key(const Vector3D &vector, const Vector3D &minimum, const Vector3D &maximum, Curve curve)
+{
+   const Axis axes[3]={Axis(minimum.x(),maximum.x()),Axis(minimum.y(),maximum.y()),Axis(minimum.z(),maximum.z())};
+   return curveKey(vector,axes,curve);
+}
+
+bool Vector3DCurve::keys(Vector3DArrayConstView vectors, const Vector3D &minimum, const Vector3D &maximum, std::span<std::uint64_t> keys, Curve curve)
+{
+   return Vector3DCurve::keys(Vector3DExecution::sequential(),vectors,minimum,maximum,keys,curve);
+}
+
+bool Vector3DCurve::keys(const Vector3DExecution &execution, Vector3DArrayConstView vectors, const Vector3D &minimum, const Vector3D &maximum, std::span<std::uint64_t> keys, Curve curve)
+{
+   if(vectors.size()!=keys.size()) return false;
+   const Axis axes[3]={Axis(minimum.x(),maximum.x()),Axis(minimum.y(),maximum.y()),Axis(minimum.z(),maximum.z())};
+   execution.forEachRange(vectors.size(),[&](std::size_t offset, std::size_t count)
+   {
+      for(std::size_t i=offset;i<offset+count;i++) keys[i]=curveKey(vectors[i],axes,curve);
+   });
+   return true;
+}
+
+bool Vector3DCurve::order(Vector3DArrayConstView vectors, std::span<std::size_t> permutation, Curve curve)
+{
+   return order(Vector3DExecution::sequential(),vectors,permutation,curve);
+}
+
+bool Vector3DCurve::order(const Vector3DExecution &execution, Vector3DArrayConstView vectors, std::span<std::size_t> permutation, Curve curve)
+{
+   if(vectors.size()!=permutation.size()) return false;
+   std::size_t size=vectors.size();
+   if(size==0) return true;
+   Vector3D minimum,maximum;
+   Vector3DBatch::boundingBox(execution,vectors,minimum,maximum);
+   const Axis axes[3]={Axis(minimum.x(),maximum.x()),Axis(minimum.y(),maximum.y()),Axis(minimum.z(),maximum.z())};
+   std::vector<Entry> entries(size);
+   execution.forEachRange(size,[&](std::size_t offset, std::size_t count)
+   {
+      for(std::size_t i=offset;i<offset+count;i++) entries[i]={curveKey(vectors[i],axes,curve),i};
+   });
+   Vector3DRadixSort::sort(execution,entries,&Entry::key,64);
+   execution.forEachRange(size,[&](std::size_t offset, std::size_t count)
+   {
+      for(std::size_t i=offset;i<offset+count;i++) permutation[i]=entries[i].index;
+   });
+   return true;
+}
+
+bool Vector3DCurve::sort(Vector3DArrayView vectors, std::span<std::size_t> permutation, Curve curve)
+{
+   return sort(Vector3DExecution::sequential(),vectors,permutation,curve);
+}
+
+bool Vector3DCurve::sort(const Vector3DExecution &execution, Vector3DArrayView vectors, std::span<std::size_t> permutation, Curve curve)
+{
+   if(!order(execution,vectors,permutation,curve)) return false;
+   Vector3DArray original(vectors);
+   execution.forEachRange(vectors.size(),[&](std::size_t offset, std::size_t count)
+   {
+      for(std::size_t i=offset;i<offset+count;i++) vectors.set(i,original[permutation[i]]);
+   });
+   return true;
+}
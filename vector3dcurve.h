@@ -0,0 +1,62 @@
+#ifndef VECTOR3DCURVE_H
+#define VECTOR3DCURVE_H
+
+#include "vector3d.h"
+#include "vector3darray.h"
+#include "vector3dexecution.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Space-filling curve keys and spatial ordering. A box is split into 2^21 cells per axis and every cell
+ * gets a 63-bit key, its position along a Morton (Z-order) or Hilbert curve, so vectors sorted by key sit close
+ * in memory when they are close in space. Hilbert keys cost more but never jump between distant cells.
+ * Components outside the box are clamped to it, vectors with a NaN component get nanKey and sort last.
+ * Sorting is a stable radix sort, so equal keys keep their index order and results do not depend on the policy.
+ * Functions return false, without touching the output, when the sizes do not match.
+ */
+namespace Vector3DCurve
+{
+   enum Curve {Morton,Hilbert};
+
+   constexpr unsigned bitsPerAxis=21;
+   constexpr std::uint64_t nanKey=std::uint64_t(1)<<63;
+
+   std::uint64_t key(const Vector3D &vector, const Vector3D &minimum, const Vector3D &maximum, Curve curve=Morton);
+   bool keys(Vector3DArrayConstView vectors, const Vector3D &minimum, const Vector3D &maximum, std::span<std::uint64_t> keys, Curve curve=Morton);
+   bool keys(const Vector3DExecution &execution, Vector3DArrayConstView vectors, const Vector3D &minimum, const Vector3D &maximum, std::span<std::uint64_t> keys, Curve curve=Morton);
+
+   /**
+    * @brief Stores in permutation[i] the index of the vector at position i along the curve through the bounding box of vectors
+    */
+   bool order(Vector3DArrayConstView vectors, std::span<std::size_t> permutation, Curve curve=Morton);
+   bool order(const Vector3DExecution &execution, Vector3DArrayConstView vectors, std::span<std::size_t> permutation, Curve curve=Morton);
+
+   /**
+    * @brief Reorders vectors along the curve in place, with the permutation of order() to carry attached data along
+    */
+   bool sort(Vector3DArrayView vectors, std::span<std::size_t> permutation, Curve curve=Morton);
+   bool sort(const Vector3DExecution &execution, Vector3DArrayView vectors, std::span<std::size_t> permutation, Curve curve=Morton);
+
+   /**
+    * @brief Moves payload[permutation[i]] to position i, the reordering sort() applied to the vectors
+    */
+   template<class T>
+   bool permute(std::span<const std::size_t> permutation, std::span<T> payload);
+}
+
+template<class T>
+bool Vector3DCurve::permute(std::span<const std::size_t> permutation, std::span<T> payload)
+{
+   if(permutation.size()!=payload.size()) return false;
+   std::vector<T> original(std::make_move_iterator(payload.begin()),std::make_move_iterator(payload.end()));
+   for(std::size_t i=0;i<permutation.size();i++) payload[i]=std::move(original[permutation[i]]);
+   return true;
+}
+
+#endif // VECTOR3DCURVE_H
@@ -0,0 +1,197 @@
+#include "vector3dexecution.h"
+
+#include <algorithm>
+
+namespace
+{
+   thread_local const Vector3DThreadPool *currentPool=nullptr;
+
+   /**
+    * @brief Marks the calling thread as running a loop of the pool until the end of the scope
+    */
+   class CurrentPoolScope
+   {
+      public:
+         explicit CurrentPoolScope(const Vector3DThreadPool *pool) : pPrevious(currentPool) { currentPool=pool; }
+         ~CurrentPoolScope() { currentPool=pPrevious; }
+
+         CurrentPoolScope(const CurrentPoolScope &)=delete;
+         CurrentPoolScope &operator=(const CurrentPoolScope &)=delete;
+
+      private:
+         const Vector3DThreadPool *pPrevious;
+   };
+
+   constexpr std::uint64_t pack(std::size_t begin, std::size_t end)
+   {
+      return (static_cast<std::uint64_t>(begin)<<32)|static_cast<std::uint64_t>(end);
+   }
+}
+
+Vector3DThreadPool::Vector3DThreadPool(std::size_t threads) : pDone(0), pFailed(false), pGeneration(0), pActive(0), pAccepting(false), pStop(false), pTrampoline(nullptr), pContext(nullptr), pSize(0), pChunk(1), pChunks(0)
+{
+   if(threads==0) threads=std::max(1u,std::thread::hardware_concurrency());
+   pRanges.reset(new std::atomic<std::uint64_t>[threads]);
+   for(std::size_t i=0;i<threads;i++) pRanges[i].store(0,std::memory_order_relaxed);
+   pWorkers.reserve(threads-1);
+   for(std::size_t i=1;i<threads;i++) pWorkers.emplace_back(&Vector3DThreadPool::workerLoop,this,i);
+}
+
+Vector3DThreadPool::~Vector3DThreadPool()
+{
+   {
+      std::lock_guard<std::mutex> lock(pMutex);
+      pStop=true;
+   }
+   pStart.notify_all();
+   for(std::thread &worker : pWorkers) worker.join();
+}
+
+std::size_t Vector3DThreadPool::size() const
+{
+   return pWorkers.size()+1;
+}
+
+Vector3DThreadPool &Vector3DThreadPool::defaultPool()
+{
+   static Vector3DThreadPool pool;
+   return pool;
+}
+
+void Vector3DThreadPool::run(std::size_t total, std::size_t chunk, Trampoline trampoline, void *context)
+{
+   if(total==0) return;
+   chunk=std::max<std::size_t>(chunk,1);
+   std::size_t chunks=(total+chunk-1)/chunk;
+   if(pWorkers.empty() || chunks<=1 || currentPool==this || chunks>=(std::size_t(1)<<32))
+   {
+      for(std::size_t offset=0;offset<total;offset+=chunk) trampoline(context,offset,std::min(chunk,total-offset));
+      return;
+   }
+
+   std::lock_guard<std::mutex> runLock(pRunMutex);
+   {
+      std::lock_guard<std::mutex> lock(pMutex);
+      std::size_t workers=size();
+      for(std::size_t i=0;i<workers;i++) pRanges[i].store(pack(i*chunks/workers,(i+1)*chunks/workers),std::memory_order_relaxed);
+      pTrampoline=trampoline; pContext=context; pSize=total; pChunk=chunk; pChunks=chunks;
+      pDone.store(0,std::memory_order_relaxed);
+      pFailed.store(false,std::memory_order_relaxed);
+      pException=nullptr;
+      pAccepting=true;
+      pGeneration++;
+   }
+   pStart.notify_all();
+
+   {
+      CurrentPoolScope scope(this);
+      work(0);
+   }
+
+   std::unique_lock<std::mutex> lock(pMutex);
+   pFinished.wait(lock,[this] { return pDone.load(std::memory_order_acquire)==pChunks; });
+   pAccepting=false;
+   pFinished.wait(lock,[this] { return pActive==0; });
+   if(pException)
+   {
+      std::exception_ptr exception=pException;
+      pException=nullptr;
+      lock.unlock();
+      std::rethrow_exception(exception);
+   }
+}
+
+void Vector3DThreadPool::work(std::size_t worker)
+{
+   std::size_t workers=size(),chunk,completed=0;
+   while(take(worker,chunk))
+   {
+      execute(chunk);
+      completed++;
+   }
+   for(std::size_t i=1;i<workers;i++)
+   {
+      std::size_t victim=(worker+i)%workers;
+      while(steal(victim,chunk))
+      {
+         execute(chunk);
+         completed++;
+      }
+   }
+   if(completed>0 && pDone.fetch_add(completed,std::memory_order_acq_rel)+completed==pChunks)
+   {
+      std::lock_guard<std::mutex> lock(pMutex);
+      pFinished.notify_all();
+   }
+}
+
+void Vector3DThreadPool::execute(std::size_t chunk)
+{
+   // After a failure the remaining chunks are still taken and counted, so the loop drains without running them
+   if(pFailed.load(std::memory_order_relaxed)) return;
+   try
+   {
+      std::size_t offset=chunk*pChunk;
+      pTrampoline(pContext,offset,std::min(pChunk,pSize-offset));
+   }
+   catch(...)
+   {
+      std::lock_guard<std::mutex> lock(pMutex);
+      if(!pException) pException=std::current_exception();
+      pFailed.store(true,std::memory_order_relaxed);
+   }
+}
+
+void Vector3DThreadPool::workerLoop(std::size_t worker)
+{
+   std::uint64_t generation=0;
+   currentPool=this;
+   while(true)
+   {
+      {
+         std::unique_lock<std::mutex> lock(pMutex);
+         pStart.wait(lock,[&] { return pStop || (pGeneration!=generation && pAccepting); });
+         if(pStop) return;
+         generation=pGeneration;
+         pActive++;
+      }
+      work(worker);
+      {
+         std::lock_guard<std::mutex> lock(pMutex);
+         pActive--;
+      }
+      pFinished.notify_all();
+   }
+}
+
+bool Vector3DThreadPool::take(std::size_t worker, std::size_t &chunk)
+{
+   std::atomic<std::uint64_t> &range=pRanges[worker];
+   std::uint64_t value=range.load(std::memory_order_acquire);
+   while(true)
+   {
+      std::size_t begin=static_cast<std::size_t>(value>>32),end=static_cast<std::size_t>(value&0xffffffffu);
+      if(begin>=end) return false;
+      if(range.compare_exchange_weak(value,pack(begin+1,end),std::memory_order_acq_rel))
+      {
+         chunk=begin;
+         return true;
+      }
+   }
+}
+
+bool Vector3DThreadPool::steal(std::size_t victim, std::size_t &chunk)
+{
+   std::atomic<std::uint64_t> &range=pRanges[victim];
+   std::uint64_t value=range.load(std::memory_order_acquire);
+   while(true)
+   {
+      std::size_t begin=static_cast<std::size_t>(value>>32),end=static_cast<std::size_t>(value&0xffffffffu);
+      if(begin>=end) return false;
+      if(range.compare_exchange_weak(value,pack(begin,end-1),std::memory_order_acq_rel))
+      {
+         chunk=end-1;
+         return true;
+      }
+   }
+}
@@ -0,0 +1,151 @@
+#ifndef VECTOR3DEXECUTION_H
+#define VECTOR3DEXECUTION_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief The Vector3DThreadPool class runs parallel loops on a fixed set of workers with range stealing.
+ * Every worker owns a contiguous slice of the chunks of a loop, always the same slice for the same size,
+ * so repeated sweeps over the same data mostly revisit the same elements from the same thread.
+ * Idle workers steal single chunks from the far end of other slices. The calling thread takes part as
+ * worker zero, loops started from inside a worker run inline, and one loop runs at a time per pool,
+ * so the host application can share the pool with the library. When the loop body throws, the chunks not
+ * yet started are skipped and parallelFor() rethrows the first exception on the calling thread.
+ */
+class Vector3DThreadPool
+{
+   public:
+      explicit Vector3DThreadPool(std::size_t threads=0);
+      ~Vector3DThreadPool();
+
+      Vector3DThreadPool(const Vector3DThreadPool &)=delete;
+      Vector3DThreadPool &operator=(const Vector3DThreadPool &)=delete;
+
+      std::size_t size() const;
+
+      template<class Function>
+      void parallelFor(std::size_t size, std::size_t chunk, Function function);
+
+      static Vector3DThreadPool &defaultPool();
+
+   private:
+      using Trampoline=void (*)(void *context, std::size_t offset, std::size_t count);
+
+      std::vector<std::thread> pWorkers;
+      std::unique_ptr<std::atomic<std::uint64_t>[]> pRanges;
+      std::mutex pRunMutex;
+      std::mutex pMutex;
+      std::condition_variable pStart;
+      std::condition_variable pFinished;
+      std::atomic<std::size_t> pDone;
+      std::atomic<bool> pFailed;
+      std::exception_ptr pException;
+      std::uint64_t pGeneration;
+      std::size_t pActive;
+      bool pAccepting;
+      bool pStop;
+      Trampoline pTrampoline;
+      void *pContext;
+      std::size_t pSize;
+      std::size_t pChunk;
+      std::size_t pChunks;
+
+      void run(std::size_t total, std::size_t chunk, Trampoline trampoline, void *context);
+      void work(std::size_t worker);
+      void execute(std::size_t chunk);
+      void workerLoop(std::size_t worker);
+      bool take(std::size_t worker, std::size_t &chunk);
+      bool steal(std::size_t victim, std::size_t &chunk);
+};
+
+/**
+ * @brief The Vector3DExecution class selects how a batch operation runs: sequentially on the calling thread,
+ * or split into chunks of grain vectors on a thread pool. Chunk sizes are rounded up to a multiple of 8 vectors,
+ * 512 for grains of at least 512, so the chunks of a whole Vector3DArray start on cache-line boundaries and
+ * workers do not write to shared cache lines. Element-wise results do not depend on the policy.
+ */
+class Vector3DExecution
+{
+   public:
+      static constexpr std::size_t defaultGrain=1<<15;
+
+      static const Vector3DExecution sequential();
+      static const Vector3DExecution parallel(std::size_t grain=defaultGrain);
+      static const Vector3DExecution parallel(Vector3DThreadPool &pool, std::size_t grain=defaultGrain);
+
+      bool isParallel() const;
+      Vector3DThreadPool *pool() const;
+      std::size_t grain() const;
+
+      template<class Function>
+      void forEachRange(std::size_t size, Function function) const;
+
+   private:
+      Vector3DExecution(Vector3DThreadPool *pool, std::size_t grain);
+
+      Vector3DThreadPool *pPool;
+      std::size_t pGrain;
+};
+
+template<class Function>
+void Vector3DThreadPool::parallelFor(std::size_t size, std::size_t chunk, Function function)
+{
+   run(size,chunk,[](void *context, std::size_t offset, std::size_t count) { (*static_cast<Function*>(context))(offset,count); },&function);
+}
+
+inline Vector3DExecution::Vector3DExecution(Vector3DThreadPool *pool, std::size_t grain) : pPool(pool), pGrain(grain>0 ? grain : 1)
+{
+}
+
+inline const Vector3DExecution Vector3DExecution::sequential()
+{
+   return Vector3DExecution(nullptr,defaultGrain);
+}
+
+inline const Vector3DExecution Vector3DExecution::parallel(std::size_t grain)
+{
+   return Vector3DExecution(&Vector3DThreadPool::defaultPool(),grain);
+}
+
+inline const Vector3DExecution Vector3DExecution::parallel(Vector3DThreadPool &pool, std::size_t grain)
+{
+   return Vector3DExecution(&pool,grain);
+}
+
+inline bool Vector3DExecution::isParallel() const
+{
+   return pPool!=nullptr && pPool->size()>1;
+}
+
+inline Vector3DThreadPool *Vector3DExecution::pool() const
+{
+   return pPool;
+}
+
+inline std::size_t Vector3DExecution::grain() const
+{
+   return pGrain;
+}
+
+template<class Function>
+void Vector3DExecution::forEachRange(std::size_t size, Function function) const
+{
+   if(!isParallel() || size<=pGrain)
+   {
+      if(size>0) function(std::size_t(0),size);
+      return;
+   }
+   std::size_t alignment=pGrain>=512 ? 512 : 8;
+   std::size_t chunk=(pGrain+alignment-1)/alignment*alignment;
+   pPool->parallelFor(size,chunk,function);
+}
+
+#endif // VECTOR3DEXECUTION_H
@@ -0,0 +1,271 @@
+#ifndef VECTOR3DEXPR_H
+#define VECTOR3DEXPR_H
+
+#include "vector3d.h"
+#include "vector3darray.h"
+
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Opt-in expression templates over Vector3D and Vector3DArray.
+ * Wrapping operands with lazy() makes +, -, * and / build a small expression tree instead of
+ * temporaries, the whole formula is then evaluated in one pass per element when it is converted to a
+ * vector or assigned to a view. Operations run in the same order as the eager operators, division by
+ * a zero factor gives NaN components, so results match the eager code for the same formula.
+ */
+namespace Vector3DExpr
+{
+   /**
+    * @brief CRTP base of every expression node. Each node provides ValueType, isArray,
+    * x/y/z<Contiguous>(index), size() (0 for a single vector broadcast to every element),
+    * isContiguous() and matches(size).
+    */
+   template<class E>
+   struct Expression
+   {
+      const E &self() const { return static_cast<const E&>(*this); }
+
+      template<class T>
+      operator BasicVector3D<T>() const requires (!E::isArray)
+      {
+         return BasicVector3D<T>(self().template x<false>(0),self().template y<false>(0),self().template z<false>(0));
+      }
+   };
+
+   template<class T>
+   class Vector : public Expression<Vector<T>>
+   {
+      public:
+         using ValueType=T;
+         static constexpr bool isArray=false;
+
+         explicit Vector(const BasicVector3D<T> &vector) : pVector(vector) {}
+
+         template<bool Contiguous> T x(std::size_t) const { return pVector.x(); }
+         template<bool Contiguous> T y(std::size_t) const { return pVector.y(); }
+         template<bool Contiguous> T z(std::size_t) const { return pVector.z(); }
+         std::size_t size() const { return 0; }
+         bool isContiguous() const { return true; }
+         bool matches(std::size_t) const { return true; }
+
+      private:
+         BasicVector3D<T> pVector;
+   };
+
+   class Array : public Expression<Array>
+   {
+      public:
+         using ValueType=double;
+         static constexpr bool isArray=true;
+
+         explicit Array(Vector3DArrayConstView view) : pX(view.x()), pY(view.y()), pZ(view.z()), pSize(view.size()), pStride(view.stride()) {}
+
+         template<bool Contiguous> double x(std::size_t index) const { return pX[Contiguous ? index : index*pStride]; }
+         template<bool Contiguous> double y(std::size_t index) const { return pY[Contiguous ? index : index*pStride]; }
+         template<bool Contiguous> double z(std::size_t index) const { return pZ[Contiguous ? index : index*pStride]; }
+         std::size_t size() const { return pSize; }
+         bool isContiguous() const { return pStride==1; }
+         bool matches(std::size_t size) const { return pSize==size; }
+
+      private:
+         const double *pX;
+         const double *pY;
+         const double *pZ;
+         std::size_t pSize;
+         std::size_t pStride;
+   };
+
+   struct Plus { template<class T> static T apply(T value1, T value2) { return value1+value2; } };
+   struct Minus { template<class T> static T apply(T value1, T value2) { return value1-value2; } };
+
+   template<class L, class R, class Op>
+   class Binary : public Expression<Binary<L,R,Op>>
+   {
+      public:
+         using ValueType=std::common_type_t<typename L::ValueType,typename R::ValueType>;
+         static constexpr bool isArray=L::isArray || R::isArray;
+
+         Binary(const L &left, const R &right) : pLeft(left), pRight(right) {}
+
+         template<bool Contiguous> ValueType x(std::size_t index) const { return Op::apply(static_cast<ValueType>(pLeft.template x<Contiguous>(index)),static_cast<ValueType>(pRight.template x<Contiguous>(index))); }
+         template<bool Contiguous> ValueType y(std::size_t index) const { return Op::apply(static_cast<ValueType>(pLeft.template y<Contiguous>(index)),static_cast<ValueType>(pRight.template y<Contiguous>(index))); }
+         template<bool Contiguous> ValueType z(std::size_t index) const { return Op::apply(static_cast<ValueType>(pLeft.template z<Contiguous>(index)),static_cast<ValueType>(pRight.template z<Contiguous>(index))); }
+         std::size_t size() const { return pLeft.size()!=0 ? pLeft.size() : pRight.size(); }
+         bool isContiguous() const { return pLeft.isContiguous() && pRight.isContiguous(); }
+         bool matches(std::size_t size) const { return pLeft.matches(size) && pRight.matches(size); }
+
+      private:
+         L pLeft;
+         R pRight;
+   };
+
+   template<class E>
+   class Scale : public Expression<Scale<E>>
+   {
+      public:
+         using ValueType=typename E::ValueType;
+         static constexpr bool isArray=E::isArray;
+
+         Scale(const E &expression, ValueType factor) : pExpression(expression), pFactor(factor) {}
+
+         template<bool Contiguous> ValueType x(std::size_t index) const { return pExpression.template x<Contiguous>(index)*pFactor; }
+         template<bool Contiguous> ValueType y(std::size_t index) const { return pExpression.template y<Contiguous>(index)*pFactor; }
+         template<bool Contiguous> ValueType z(std::size_t index) const { return pExpression.template z<Contiguous>(index)*pFactor; }
+         std::size_t size() const { return pExpression.size(); }
+         bool isContiguous() const { return pExpression.isContiguous(); }
+         bool matches(std::size_t size) const { return pExpression.matches(size); }
+
+      private:
+         E pExpression;
+         ValueType pFactor;
+   };
+
+   template<class E>
+   class Divide : public Expression<Divide<E>>
+   {
+      public:
+         using ValueType=typename E::ValueType;
+         static constexpr bool isArray=E::isArray;
+
+         Divide(const E &expression, ValueType factor) : pExpression(expression), pFactor(factor), pIsNaN(Vector3DTraits<ValueType>::isZero(factor)) {}
+
+         template<bool Contiguous> ValueType x(std::size_t index) const { return pIsNaN ? std::numeric_limits<ValueType>::quiet_NaN() : pExpression.template x<Contiguous>(index)/pFactor; }
+         template<bool Contiguous> ValueType y(std::size_t index) const { return pIsNaN ? std::numeric_limits<ValueType>::quiet_NaN() : pExpression.template y<Contiguous>(index)/pFactor; }
+         template<bool Contiguous> ValueType z(std::size_t index) const { return pIsNaN ? std::numeric_limits<ValueType>::quiet_NaN() : pExpression.template z<Contiguous>(index)/pFactor; }
+         std::size_t size() const { return pExpression.size(); }
+         bool isContiguous() const { return pExpression.isContiguous(); }
+         bool matches(std::size_t size) const { return pExpression.matches(size); }
+
+      private:
+         E pExpression;
+         ValueType pFactor;
+         bool pIsNaN;
+   };
+
+   template<class T>
+   inline Vector<T> lazy(const BasicVector3D<T> &vector)
+   {
+      return Vector<T>(vector);
+   }
+
+   inline Array lazy(Vector3DArrayConstView vectors)
+   {
+      return Array(vectors);
+   }
+
+   inline Array lazy(const Vector3DArray &array)
+   {
+      return Array(Vector3DArrayConstView(array));
+   }
+
+   inline Array lazy(std::span<const Vector3D> vectors)
+   {
+      return Array(Vector3DArrayConstView(vectors));
+   }
+
+   inline Array lazy(const std::vector<Vector3D> &vectors)
+   {
+      return Array(Vector3DArrayConstView(vectors));
+   }
+
+   template<class L, class R>
+   inline Binary<L,R,Plus> operator+(const Expression<L> &left, const Expression<R> &right)
+   {
+      return Binary<L,R,Plus>(left.self(),right.self());
+   }
+
+   template<class L, class T>
+   inline Binary<L,Vector<T>,Plus> operator+(const Expression<L> &left, const BasicVector3D<T> &right)
+   {
+      return Binary<L,Vector<T>,Plus>(left.self(),Vector<T>(right));
+   }
+
+   template<class T, class R>
+   inline Binary<Vector<T>,R,Plus> operator+(const BasicVector3D<T> &left, const Expression<R> &right)
+   {
+      return Binary<Vector<T>,R,Plus>(Vector<T>(left),right.self());
+   }
+
+   template<class L, class R>
+   inline Binary<L,R,Minus> operator-(const Expression<L> &left, const Expression<R> &right)
+   {
+      return Binary<L,R,Minus>(left.self(),right.self());
+   }
+
+   template<class L, class T>
+   inline Binary<L,Vector<T>,Minus> operator-(const Expression<L> &left, const BasicVector3D<T> &right)
+   {
+      return Binary<L,Vector<T>,Minus>(left.self(),Vector<T>(right));
+   }
+
+   template<class T, class R>
+   inline Binary<Vector<T>,R,Minus> operator-(const BasicVector3D<T> &left, const Expression<R> &right)
+   {
+      return Binary<Vector<T>,R,Minus>(Vector<T>(left),right.self());
+   }
+
+   template<class E>
+   inline Scale<E> operator*(const Expression<E> &expression, typename E::ValueType factor)
+   {
+      return Scale<E>(expression.self(),factor);
+   }
+
+   template<class E>
+   inline Scale<E> operator*(typename E::ValueType factor, const Expression<E> &expression)
+   {
+      return Scale<E>(expression.self(),factor);
+   }
+
+   template<class E>
+   inline Divide<E> operator/(const Expression<E> &expression, typename E::ValueType factor)
+   {
+      return Divide<E>(expression.self(),factor);
+   }
+
+   /**
+    * @brief Evaluates a single vector expression
+    */
+   template<class E>
+   inline BasicVector3D<typename E::ValueType> evaluate(const Expression<E> &expression) requires (!E::isArray)
+   {
+      return expression;
+   }
+
+   /**
+    * @brief Evaluates an expression into every element of the result in a single pass.
+    * Single vectors are broadcast, every array operand must have the size of the result, otherwise
+    * false is returned without touching it. The result may alias the operands.
+    */
+   template<class E>
+   inline bool assign(Vector3DArrayView result, const Expression<E> &expression)
+   {
+      const E &tree=expression.self();
+      std::size_t size=result.size();
+      if(!tree.matches(size)) return false;
+
+      double *x=result.x(),*y=result.y(),*z=result.z();
+      if(result.stride()==1 && tree.isContiguous())
+      {
+         for(std::size_t i=0;i<size;i++)
+         {
+            double valueX=tree.template x<true>(i),valueY=tree.template y<true>(i),valueZ=tree.template z<true>(i);
+            x[i]=valueX; y[i]=valueY; z[i]=valueZ;
+         }
+      } else
+      {
+         std::size_t stride=result.stride();
+         for(std::size_t i=0;i<size;i++)
+         {
+            double valueX=tree.template x<false>(i),valueY=tree.template y<false>(i),valueZ=tree.template z<false>(i);
+            x[i*stride]=valueX; y[i*stride]=valueY; z[i*stride]=valueZ;
+         }
+      }
+      return true;
+   }
+}
+
+#endif // VECTOR3DEXPR_H
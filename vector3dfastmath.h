@@ -0,0 +1,90 @@
+#ifndef VECTOR3DFASTMATH_H
+#define VECTOR3DFASTMATH_H
+
+#include <cmath>
+
+/**
+ * @brief Approximations behind the Vector3D Fast accuracy. The bounds hold for double and long double,
+ * float results are additionally limited by float rounding. NaN and arguments outside the approximated
+ * range fall back to the libm functions. Square roots are not approximated: the hardware instruction
+ * is already faster than a reciprocal square root estimate refined to a few ulps.
+ */
+namespace Vector3DFastMath
+{
+   /**
+    * @brief Maximum absolute error of acos(), in radians
+    */
+   constexpr double acosError=3.0e-8;
+   /**
+    * @brief Maximum absolute error of sinCos() for |angle|<=sinCosRange
+    */
+   constexpr double sinCosError=1.0e-13;
+   constexpr double sinCosRange=1.0e5;
+
+   /**
+    * @brief Abramowitz and Stegun 4.4.46: acos(x)=sqrt(1-x)*P(x) on [0,1], mirrored for negative x
+    */
+   template<class T>
+   inline T acos(T value)
+   {
+      if(!(value>=static_cast<T>(-1) && value<=static_cast<T>(1))) return std::acos(value);
+      T x=std::fabs(value);
+      T polynomial=static_cast<T>(-0.0012624911);
+      polynomial=polynomial*x+static_cast<T>(0.0066700901);
+      polynomial=polynomial*x+static_cast<T>(-0.0170881256);
+      polynomial=polynomial*x+static_cast<T>(0.0308918810);
+      polynomial=polynomial*x+static_cast<T>(-0.0501743046);
+      polynomial=polynomial*x+static_cast<T>(0.0889789874);
+      polynomial=polynomial*x+static_cast<T>(-0.2145988016);
+      polynomial=polynomial*x+static_cast<T>(1.5707963050);
+      T result=std::sqrt(static_cast<T>(1)-x)*polynomial;
+      return value<static_cast<T>(0) ? static_cast<T>(3.14159265358979323846264338327950288L)-result : result;
+   }
+
+   /**
+    * @brief Sine and cosine from one reduction to [-pi/4,pi/4] and Taylor polynomials of degree 13 and 14
+    */
+   template<class T>
+   inline void sinCos(T angle, T &sine, T &cosine)
+   {
+      if(!(std::fabs(angle)<=static_cast<T>(sinCosRange)))
+      {
+         sine=std::sin(angle);
+         cosine=std::cos(angle);
+         return;
+      }
+      constexpr T twoOverPi=static_cast<T>(0.636619772367581343075535053490057448L);
+      constexpr T halfPiHigh=static_cast<T>(1.57079632673412561417e+00);
+      constexpr T halfPiLow=static_cast<T>(6.07710050650619224932e-11L);
+      long long quadrant=static_cast<long long>(angle*twoOverPi+(angle>=static_cast<T>(0) ? static_cast<T>(0.5) : static_cast<T>(-0.5)));
+      T k=static_cast<T>(quadrant);
+      T r=(angle-k*halfPiHigh)-k*halfPiLow,r2=r*r;
+
+      T s=static_cast<T>(1.0/6227020800.0);
+      s=s*r2-static_cast<T>(1.0/39916800.0);
+      s=s*r2+static_cast<T>(1.0/362880.0);
+      s=s*r2-static_cast<T>(1.0/5040.0);
+      s=s*r2+static_cast<T>(1.0/120.0);
+      s=s*r2-static_cast<T>(1.0/6.0);
+      s=r+r*r2*s;
+
+      T c=static_cast<T>(-1.0/87178291200.0);
+      c=c*r2+static_cast<T>(1.0/479001600.0);
+      c=c*r2-static_cast<T>(1.0/3628800.0);
+      c=c*r2+static_cast<T>(1.0/40320.0);
+      c=c*r2-static_cast<T>(1.0/720.0);
+      c=c*r2+static_cast<T>(1.0/24.0);
+      c=c*r2-static_cast<T>(0.5);
+      c=static_cast<T>(1)+r2*c;
+
+      switch(quadrant&3)
+      {
+         case 0: sine=s; cosine=c; break;
+         case 1: sine=c; cosine=-s; break;
+         case 2: sine=-s; cosine=-c; break;
+         default: sine=-c; cosine=s; break;
+      }
+   }
+}
+
+#endif // VECTOR3DFASTMATH_H
@@ -0,0 +1,389 @@
+#include "vector3dfile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+   constexpr char magic[8]={'V','E','C','3','D','P','C','\0'};
+   constexpr std::uint32_t version=1;
+   constexpr std::uint32_t byteOrder=0x01020304;
+   constexpr std::size_t pageSize=4096;
+
+   static_assert(sizeof(Vector3D)==3*sizeof(double),"Vector3D must be three packed doubles to be viewed in place");
+
+   /**
+    * @brief Fixed part of the header page, padded with zeros up to pageSize
+    */
+   struct Header
+   {
+      char magic[8];
+      std::uint32_t version;
+      std::uint32_t byteOrder;
+      std::uint64_t size;
+      std::uint64_t chunkSize;
+      std::uint8_t layout;
+      std::uint8_t precision;
+   };
+
+   std::size_t scalarSize(Vector3DFile::Precision precision)
+   {
+      return precision==Vector3DFile::Float64 ? sizeof(double) : sizeof(float);
+   }
+
+   std::size_t roundChunkSize(std::size_t chunkSize)
+   {
+      return (std::max<std::size_t>(chunkSize,1)+15)/16*16;
+   }
+
+   /**
+    * @brief Whether a requested chunk size still fits size_t once rounded up and padded to whole pages
+    */
+   bool isChunkSizeValid(std::size_t chunkSize, Vector3DFile::Precision precision)
+   {
+      std::size_t limit=(std::numeric_limits<std::size_t>::max()-pageSize)/(3*scalarSize(precision));
+      return chunkSize<=limit/16*16;
+   }
+
+   std::size_t chunkBytes(std::size_t chunkSize, Vector3DFile::Precision precision)
+   {
+      return (3*chunkSize*scalarSize(precision)+pageSize-1)/pageSize*pageSize;
+   }
+
+   void unmap(const unsigned char *data, std::size_t bytes, void *mapping)
+   {
+#ifdef _WIN32
+      (void)bytes;
+      UnmapViewOfFile(data);
+      CloseHandle(static_cast<HANDLE>(mapping));
+#else
+      (void)mapping;
+      munmap(const_cast<unsigned char*>(data),bytes);
+#endif
+   }
+
+   const unsigned char *map(const std::string &path, std::size_t &bytes, void *&mapping)
+   {
+#ifdef _WIN32
+      HANDLE file=CreateFileA(path.c_str(),GENERIC_READ,FILE_SHARE_READ,nullptr,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,nullptr);
+      if(file==INVALID_HANDLE_VALUE) return nullptr;
+      LARGE_INTEGER fileSize;
+      HANDLE handle=nullptr;
+      if(GetFileSizeEx(file,&fileSize) && fileSize.QuadPart>0) handle=CreateFileMappingA(file,nullptr,PAGE_READONLY,0,0,nullptr);
+      CloseHandle(file);
+      if(handle==nullptr) return nullptr;
+      void *data=MapViewOfFile(handle,FILE_MAP_READ,0,0,0);
+      if(data==nullptr)
+      {
+         CloseHandle(handle);
+         return nullptr;
+      }
+      bytes=static_cast<std::size_t>(fileSize.QuadPart);
+      mapping=handle;
+      return static_cast<const unsigned char*>(data);
+#else
+      int file=::open(path.c_str(),O_RDONLY);
+      if(file<0) return nullptr;
+      struct stat status;
+      void *data=MAP_FAILED;
+      if(fstat(file,&status)==0 && status.st_size>0) data=mmap(nullptr,static_cast<std::size_t>(status.st_size),PROT_READ,MAP_SHARED,file,0);
+      ::close(file);
+      if(data==MAP_FAILED) return nullptr;
+      bytes=static_cast<std::size_t>(status.st_size);
+      mapping=nullptr;
+      return static_cast<const unsigned char*>(data);
+#endif
+   }
+
+   void toDouble(const float *values, std::size_t count, std::size_t stride, double *result, std::size_t resultStride)
+   {
+      for(std::size_t i=0;i<count;i++) result[i*resultStride]=static_cast<double>(values[i*stride]);
+   }
+}
+
+Vector3DFile::Vector3DFile() : pData(nullptr), pBytes(0), pMapping(nullptr), pSize(0), pChunkSize(0), pLayout(SoA), pPrecision(Float64)
+{
+}
+
+Vector3DFile::Vector3DFile(const std::string &path) : Vector3DFile()
+{
+   open(path);
+}
+
+Vector3DFile::Vector3DFile(Vector3DFile &&file) noexcept : pData(file.pData), pBytes(file.pBytes), pMapping(file.pMapping), pSize(file.pSize), pChunkSize(file.pChunkSize), pLayout(file.pLayout), pPrecision(file.pPrecision)
+{
+   file.pData=nullptr; file.pBytes=0; file.pMapping=nullptr; file.pSize=0; file.pChunkSize=0;
+}
+
+Vector3DFile &Vector3DFile::operator=(Vector3DFile &&file) noexcept
+{
+   if(this!=&file)
+   {
+      close();
+      pData=file.pData; pBytes=file.pBytes; pMapping=file.pMapping; pSize=file.pSize; pChunkSize=file.pChunkSize; pLayout=file.pLayout; pPrecision=file.pPrecision;
+      file.pData=nullptr; file.pBytes=0; file.pMapping=nullptr; file.pSize=0; file.pChunkSize=0;
+   }
+   return *this;
+}
+
+Vector3DFile::~Vector3DFile()
+{
+   close();
+}
+
+bool Vector3DFile::open(const std::string &path)
+{
+   close();
+   std::size_t bytes=0;
+   void *mapping=nullptr;
+   const unsigned char *data=map(path,bytes,mapping);
+   if(data==nullptr) return false;
+
+   Header header;
+   bool valid=bytes>=pageSize;
+   if(valid)
+   {
+      std::memcpy(&header,data,sizeof(header));
+      valid=std::memcmp(header.magic,magic,sizeof(magic))==0 && header.version==version && header.byteOrder==byteOrder &&
+            header.layout<=SoA && header.precision<=Float32 && header.chunkSize>0 && header.chunkSize%16==0;
+   }
+   if(valid)
+   {
+      // Bounded by division, so forged sizes cannot wrap the byte count around to something that fits
+      Precision precision=static_cast<Precision>(header.precision);
+      std::size_t size=static_cast<std::size_t>(header.size),chunkSize=static_cast<std::size_t>(header.chunkSize);
+      std::size_t available=bytes-pageSize,vectorBytes=3*scalarSize(precision),capacity=available/vectorBytes;
+      if(header.layout==AoS) valid=size<=capacity;
+      else if(size>0)
+      {
+         std::size_t fullChunks=(size-1)/chunkSize,tail=(size-1)%chunkSize+1;
+         valid=tail<=capacity && (fullChunks==0 || (chunkSize<=capacity && fullChunks<=(available-tail*vectorBytes)/chunkBytes(chunkSize,precision)));
+      }
+   }
+   if(!valid)
+   {
+      unmap(data,bytes,mapping);
+      return false;
+   }
+
+   pData=data; pBytes=bytes; pMapping=mapping;
+   pSize=static_cast<std::size_t>(header.size);
+   pChunkSize=static_cast<std::size_t>(header.chunkSize);
+   pLayout=static_cast<Layout>(header.layout);
+   pPrecision=static_cast<Precision>(header.precision);
+   return true;
+}
+
+void Vector3DFile::close()
+{
+   if(pData!=nullptr) unmap(pData,pBytes,pMapping);
+   pData=nullptr; pBytes=0; pMapping=nullptr; pSize=0; pChunkSize=0;
+}
+
+bool Vector3DFile::isOpen() const
+{
+   return pData!=nullptr;
+}
+
+std::size_t Vector3DFile::size() const
+{
+   return pSize;
+}
+
+Vector3DFile::Layout Vector3DFile::layout() const
+{
+   return pLayout;
+}
+
+Vector3DFile::Precision Vector3DFile::precision() const
+{
+   return pPrecision;
+}
+
+std::size_t Vector3DFile::chunkSize() const
+{
+   return pChunkSize;
+}
+
+std::size_t Vector3DFile::chunkCount() const
+{
+   return pChunkSize>0 ? (pSize+pChunkSize-1)/pChunkSize : 0;
+}
+
+std::span<const Vector3D> Vector3DFile::vectors() const
+{
+   if(pData==nullptr || pLayout!=AoS || pPrecision!=Float64) return {};
+   return std::span<const Vector3D>(reinterpret_cast<const Vector3D*>(pData+pageSize),pSize);
+}
+
+Vector3DArrayConstView Vector3DFile::chunk(std::size_t index) const
+{
+   std::size_t count=0;
+   const unsigned char *data=pPrecision==Float64 ? chunkData(index,count) : nullptr;
+   if(data==nullptr) return Vector3DArrayConstView(nullptr,nullptr,nullptr,0);
+   const double *values=reinterpret_cast<const double*>(data);
+   if(pLayout==AoS) return Vector3DArrayConstView(values,values+1,values+2,count,3);
+   return Vector3DArrayConstView(values,values+count,values+2*count,count);
+}
+
+bool Vector3DFile::read(std::size_t offset, Vector3DArrayView result) const
+{
+   if(pData==nullptr || offset>pSize || result.size()>pSize-offset) return false;
+   std::size_t done=0;
+   while(done<result.size())
+   {
+      std::size_t position=offset+done,index=position/pChunkSize,begin=position%pChunkSize,count=0;
+      const unsigned char *data=chunkData(index,count);
+      count=std::min(count-begin,result.size()-done);
+      Vector3DArrayView target=result.subview(done,count);
+      if(pPrecision==Float64)
+      {
+         Vector3DBatch::copy(chunk(index).subview(begin,count),target);
+      } else
+      {
+         const float *values=reinterpret_cast<const float*>(data);
+         std::size_t chunkCount=pLayout==AoS ? 0 : std::min(pChunkSize,pSize-index*pChunkSize);
+         std::size_t stride=pLayout==AoS ? 3 : 1;
+         const float *x=pLayout==AoS ? values+3*begin : values+begin;
+         const float *y=pLayout==AoS ? x+1 : x+chunkCount;
+         const float *z=pLayout==AoS ? x+2 : x+2*chunkCount;
+         toDouble(x,count,stride,target.x(),target.stride());
+         toDouble(y,count,stride,target.y(),target.stride());
+         toDouble(z,count,stride,target.z(),target.stride());
+      }
+      done+=count;
+   }
+   return true;
+}
+
+bool Vector3DFile::write(const std::string &path, Vector3DArrayConstView vectors, Layout layout, Precision precision, std::size_t chunkSize)
+{
+   Vector3DFileWriter writer;
+   return writer.open(path,layout,precision,chunkSize) && writer.append(vectors) && writer.close();
+}
+
+const unsigned char *Vector3DFile::chunkData(std::size_t index, std::size_t &count) const
+{
+   if(pData==nullptr || index>=chunkCount()) return nullptr;
+   count=std::min(pChunkSize,pSize-index*pChunkSize);
+   if(pLayout==AoS) return pData+pageSize+3*index*pChunkSize*scalarSize(pPrecision);
+   return pData+pageSize+index*chunkBytes(pChunkSize,pPrecision);
+}
+
+Vector3DFileWriter::Vector3DFileWriter() : pBuffered(0), pSize(0), pChunkSize(0), pLayout(Vector3DFile::SoA), pPrecision(Vector3DFile::Float64)
+{
+}
+
+Vector3DFileWriter::Vector3DFileWriter(const std::string &path, Vector3DFile::Layout layout, Vector3DFile::Precision precision, std::size_t chunkSize) : Vector3DFileWriter()
+{
+   open(path,layout,precision,chunkSize);
+}
+
+Vector3DFileWriter::~Vector3DFileWriter()
+{
+   close();
+}
+
+bool Vector3DFileWriter::open(const std::string &path, Vector3DFile::Layout layout, Vector3DFile::Precision precision, std::size_t chunkSize)
+{
+   close();
+   if(!isChunkSizeValid(chunkSize,precision)) return false;
+   pStream.open(path,std::ios::binary|std::ios::trunc);
+   if(!pStream) return false;
+   pLayout=layout;
+   pPrecision=precision;
+   pChunkSize=roundChunkSize(chunkSize);
+   pBuffered=0;
+   pSize=0;
+   pBuffer.resize(pChunkSize);
+   std::vector<char> header(pageSize,0);
+   pStream.write(header.data(),static_cast<std::streamsize>(header.size()));
+   return static_cast<bool>(pStream);
+}
+
+bool Vector3DFileWriter::append(Vector3DArrayConstView vectors)
+{
+   if(!pStream.is_open()) return false;
+   std::size_t done=0;
+   while(done<vectors.size())
+   {
+      std::size_t count=std::min(pChunkSize-pBuffered,vectors.size()-done);
+      Vector3DBatch::copy(vectors.subview(done,count),Vector3DArrayView(pBuffer.x()+pBuffered,pBuffer.y()+pBuffered,pBuffer.z()+pBuffered,count));
+      pBuffered+=count;
+      done+=count;
+      if(pBuffered==pChunkSize && !flush()) return false;
+   }
+   return true;
+}
+
+bool Vector3DFileWriter::close()
+{
+   if(!pStream.is_open()) return false;
+   bool written=flush();
+   Header header={};
+   std::memcpy(header.magic,magic,sizeof(magic));
+   header.version=version;
+   header.byteOrder=byteOrder;
+   header.size=pSize;
+   header.chunkSize=pChunkSize;
+   header.layout=pLayout;
+   header.precision=pPrecision;
+   pStream.seekp(0);
+   pStream.write(reinterpret_cast<const char*>(&header),sizeof(header));
+   written=written && static_cast<bool>(pStream);
+   pStream.close();
+   pBuffer.clear();
+   pScratch=std::vector<unsigned char>();
+   return written && !pStream.fail();
+}
+
+bool Vector3DFileWriter::isOpen() const
+{
+   return pStream.is_open();
+}
+
+std::size_t Vector3DFileWriter::size() const
+{
+   return pSize;
+}
+
+bool Vector3DFileWriter::flush()
+{
+   if(pBuffered==0) return static_cast<bool>(pStream);
+   std::size_t scalar=scalarSize(pPrecision),bytes=3*pBuffered*scalar;
+   if(pLayout==Vector3DFile::SoA && pBuffered==pChunkSize) bytes=chunkBytes(pChunkSize,pPrecision);
+   pScratch.assign(bytes,0);
+
+   const double *components[3]={pBuffer.x(),pBuffer.y(),pBuffer.z()};
+   std::size_t stride=pLayout==Vector3DFile::AoS ? 3 : 1;
+   for(std::size_t component=0;component<3;component++)
+   {
+      std::size_t start=pLayout==Vector3DFile::AoS ? component : component*pBuffered;
+      if(pPrecision==Vector3DFile::Float64)
+      {
+         double *target=reinterpret_cast<double*>(pScratch.data())+start;
+         for(std::size_t i=0;i<pBuffered;i++) target[i*stride]=components[component][i];
+      } else
+      {
+         float *target=reinterpret_cast<float*>(pScratch.data())+start;
+         for(std::size_t i=0;i<pBuffered;i++) target[i*stride]=static_cast<float>(components[component][i]);
+      }
+   }
+   pStream.write(reinterpret_cast<const char*>(pScratch.data()),static_cast<std::streamsize>(bytes));
+   pSize+=pBuffered;
+   pBuffered=0;
+   return static_cast<bool>(pStream);
+}
@@ -0,0 +1,100 @@
+#ifndef VECTOR3DFILE_H
+#define VECTOR3DFILE_H
+
+#include "vector3darray.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The Vector3DFile class memory-maps a binary point-cloud file and exposes it without parsing.
+ * A file is a 4 KiB header page followed by the vectors, in native byte order, either interleaved (AoS)
+ * or as chunks of chunkSize x components, then y, then z (SoA), each chunk starting on a page boundary.
+ * Float64 files are viewed in place through vectors() or chunk(), read() converts any file into a view.
+ * Every function returns false, an empty span or an empty view when the file does not hold what was asked.
+ */
+class Vector3DFile
+{
+   public:
+      enum Layout : std::uint8_t {AoS,SoA};
+      enum Precision : std::uint8_t {Float64,Float32};
+
+      static constexpr std::size_t defaultChunkSize=1<<16;
+
+      Vector3DFile();
+      explicit Vector3DFile(const std::string &path);
+      Vector3DFile(Vector3DFile &&file) noexcept;
+      Vector3DFile &operator=(Vector3DFile &&file) noexcept;
+      ~Vector3DFile();
+
+      Vector3DFile(const Vector3DFile &)=delete;
+      Vector3DFile &operator=(const Vector3DFile &)=delete;
+
+      bool open(const std::string &path);
+      void close();
+
+      bool isOpen() const;
+      std::size_t size() const;
+      Layout layout() const;
+      Precision precision() const;
+      std::size_t chunkSize() const;
+      std::size_t chunkCount() const;
+
+      std::span<const Vector3D> vectors() const;
+      Vector3DArrayConstView chunk(std::size_t index) const;
+      bool read(std::size_t offset, Vector3DArrayView result) const;
+
+      static bool write(const std::string &path, Vector3DArrayConstView vectors, Layout layout=SoA, Precision precision=Float64, std::size_t chunkSize=defaultChunkSize);
+
+   private:
+      const unsigned char *pData;
+      std::size_t pBytes;
+      void *pMapping;
+      std::size_t pSize;
+      std::size_t pChunkSize;
+      Layout pLayout;
+      Precision pPrecision;
+
+      const unsigned char *chunkData(std::size_t index, std::size_t &count) const;
+};
+
+/**
+ * @brief The Vector3DFileWriter class streams vectors into a Vector3DFile, holding at most one chunk in memory,
+ * so files larger than RAM can be written in pieces. The header is completed by close(). open() fails, without
+ * touching the file, for chunk sizes whose byte count does not fit size_t.
+ */
+class Vector3DFileWriter
+{
+   public:
+      Vector3DFileWriter();
+      explicit Vector3DFileWriter(const std::string &path, Vector3DFile::Layout layout=Vector3DFile::SoA, Vector3DFile::Precision precision=Vector3DFile::Float64, std::size_t chunkSize=Vector3DFile::defaultChunkSize);
+      ~Vector3DFileWriter();
+
+      Vector3DFileWriter(const Vector3DFileWriter &)=delete;
+      Vector3DFileWriter &operator=(const Vector3DFileWriter &)=delete;
+
+      bool open(const std::string &path, Vector3DFile::Layout layout=Vector3DFile::SoA, Vector3DFile::Precision precision=Vector3DFile::Float64, std::size_t chunkSize=Vector3DFile::defaultChunkSize);
+      bool append(Vector3DArrayConstView vectors);
+      bool close();
+
+      bool isOpen() const;
+      std::size_t size() const;
+
+   private:
+      std::ofstream pStream;
+      Vector3DArray pBuffer;
+      std::vector<unsigned char> pScratch;
+      std::size_t pBuffered;
+      std::size_t pSize;
+      std::size_t pChunkSize;
+      Vector3DFile::Layout pLayout;
+      Vector3DFile::Precision pPrecision;
+
+      bool flush();
+};
+
+#endif // VECTOR3DFILE_H
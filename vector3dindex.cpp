@@ -0,0 +1,352 @@
+#include "vector3dindex.h"
+#include "vector3dexecution.h"
+
+#include <algorithm>
+
+namespace
+{
+   constexpr std::size_t leafSize=16;
+   constexpr std::size_t minimumPending=64;
+   constexpr std::size_t parallelBuildGrain=1<<14;
+   constexpr std::size_t parallelQueryGrain=64;
+
+   /**
+    * @brief Orders neighbors by squared distance, then by id, so every query has a unique answer
+    */
+   bool isCloser(const Vector3DIndex::Neighbor &neighbor1, const Vector3DIndex::Neighbor &neighbor2)
+   {
+      if(neighbor1.distanceSquared!=neighbor2.distanceSquared) return neighbor1.distanceSquared<neighbor2.distanceSquared;
+      return neighbor1.id<neighbor2.id;
+   }
+
+   void offer(std::vector<Vector3DIndex::Neighbor> &heap, std::size_t count, const Vector3DIndex::Neighbor &neighbor)
+   {
+      if(heap.size()<count)
+      {
+         heap.push_back(neighbor);
+         std::push_heap(heap.begin(),heap.end(),isCloser);
+      } else if(isCloser(neighbor,heap.front()))
+      {
+         std::pop_heap(heap.begin(),heap.end(),isCloser);
+         heap.back()=neighbor;
+         std::push_heap(heap.begin(),heap.end(),isCloser);
+      }
+   }
+
+   double component(const Vector3D &vector, std::size_t axis)
+   {
+      return axis==0 ? vector.x() : (axis==1 ? vector.y() : vector.z());
+   }
+}
+
+Vector3DIndex::Vector3DIndex() : pDepth(0), pLive(0), pRemovedIndexed(0)
+{
+}
+
+Vector3DIndex::Vector3DIndex(std::span<const Vector3D> points) : Vector3DIndex()
+{
+   build(points);
+}
+
+void Vector3DIndex::build(std::span<const Vector3D> points)
+{
+   build(points,Vector3DExecution::parallel(parallelBuildGrain));
+}
+
+void Vector3DIndex::build(std::span<const Vector3D> points, const Vector3DExecution &execution)
+{
+   pPoints.assign(points.begin(),points.end());
+   pState.assign(pPoints.size(),Indexed);
+   pLive=pPoints.size();
+   rebuild(execution);
+}
+
+std::size_t Vector3DIndex::insert(const Vector3D &point)
+{
+   std::size_t id=pPoints.size();
+   pPoints.push_back(point);
+   pLive++;
+   if(point.isNaN())
+   {
+      pState.push_back(Skipped);
+      return id;
+   }
+   pState.push_back(Pending);
+   pPending.push_back(id);
+   if(pPending.size()>std::max(minimumPending,pOrder.size()/4)) rebuild(Vector3DExecution::parallel(parallelBuildGrain));
+   return id;
+}
+
+bool Vector3DIndex::remove(std::size_t id)
+{
+   if(!contains(id)) return false;
+   State state=pState[id];
+   pState[id]=Removed;
+   pLive--;
+   if(state==Pending) pPending.erase(std::find(pPending.begin(),pPending.end(),id));
+   if(state==Indexed && ++pRemovedIndexed*2>pOrder.size()) rebuild(Vector3DExecution::parallel(parallelBuildGrain));
+   return true;
+}
+
+std::size_t Vector3DIndex::size() const
+{
+   return pLive;
+}
+
+bool Vector3DIndex::isEmpty() const
+{
+   return pLive==0;
+}
+
+bool Vector3DIndex::contains(std::size_t id) const
+{
+   return id<pPoints.size() && pState[id]!=Removed;
+}
+
+const Vector3D &Vector3DIndex::point(std::size_t id) const
+{
+   return pPoints[id];
+}
+
+Vector3DIndex::Neighbor Vector3DIndex::nearest(const Vector3D &point) const
+{
+   std::vector<Neighbor> heap;
+   searchNearest(point,1,heap);
+   return heap.empty() ? Neighbor{npos,std::numeric_limits<double>::infinity()} : heap.front();
+}
+
+std::vector<Vector3DIndex::Neighbor> Vector3DIndex::nearest(const Vector3D &point, std::size_t count) const
+{
+   std::vector<Neighbor> heap;
+   searchNearest(point,count,heap);
+   std::sort_heap(heap.begin(),heap.end(),isCloser);
+   return heap;
+}
+
+std::vector<std::size_t> Vector3DIndex::radius(const Vector3D &point, double radius) const
+{
+   std::vector<std::size_t> ids;
+   if(point.isNaN() || !(radius>=0.0)) return ids;
+   double radiusSquared=radius*radius,coordinates[3]={point.x(),point.y(),point.z()};
+   if(!pNodes.empty()) searchRadius(0,0,coordinates,radiusSquared,ids);
+   for(std::size_t id : pPending)
+   {
+      if(pPoints[id].distanceSquared(point)<=radiusSquared) ids.push_back(id);
+   }
+   std::sort(ids.begin(),ids.end());
+   return ids;
+}
+
+std::vector<std::size_t> Vector3DIndex::box(const Vector3D &minimum, const Vector3D &maximum) const
+{
+   std::vector<std::size_t> ids;
+   double lower[3]={minimum.x(),minimum.y(),minimum.z()},upper[3]={maximum.x(),maximum.y(),maximum.z()};
+   if(!pNodes.empty()) searchBox(0,0,lower,upper,ids);
+   for(std::size_t id : pPending)
+   {
+      const Vector3D &vector=pPoints[id];
+      if(vector.x()>=lower[0] && vector.x()<=upper[0] && vector.y()>=lower[1] && vector.y()<=upper[1] && vector.z()>=lower[2] && vector.z()<=upper[2]) ids.push_back(id);
+   }
+   std::sort(ids.begin(),ids.end());
+   return ids;
+}
+
+bool Vector3DIndex::nearest(std::span<const Vector3D> points, std::size_t count, std::span<Neighbor> neighbors) const
+{
+   return nearest(Vector3DExecution::parallel(parallelQueryGrain),points,count,neighbors);
+}
+
+bool Vector3DIndex::nearest(const Vector3DExecution &execution, std::span<const Vector3D> points, std::size_t count, std::span<Neighbor> neighbors) const
+{
+   if(neighbors.size()!=points.size()*count) return false;
+   execution.forEachRange(points.size(),[&](std::size_t offset, std::size_t size)
+   {
+      std::vector<Neighbor> heap;
+      for(std::size_t i=offset;i<offset+size;i++)
+      {
+         heap.clear();
+         searchNearest(points[i],count,heap);
+         std::sort_heap(heap.begin(),heap.end(),isCloser);
+         heap.resize(count,Neighbor{npos,std::numeric_limits<double>::infinity()});
+         std::copy(heap.begin(),heap.end(),neighbors.begin()+static_cast<std::ptrdiff_t>(i*count));
+      }
+   });
+   return true;
+}
+
+std::vector<std::vector<std::size_t>> Vector3DIndex::radius(std::span<const Vector3D> points, double radius) const
+{
+   return this->radius(Vector3DExecution::parallel(parallelQueryGrain),points,radius);
+}
+
+std::vector<std::vector<std::size_t>> Vector3DIndex::radius(const Vector3DExecution &execution, std::span<const Vector3D> points, double radius) const
+{
+   std::vector<std::vector<std::size_t>> ids(points.size());
+   execution.forEachRange(points.size(),[&](std::size_t offset, std::size_t size)
+   {
+      for(std::size_t i=offset;i<offset+size;i++) ids[i]=this->radius(points[i],radius);
+   });
+   return ids;
+}
+
+void Vector3DIndex::rebuild(const Vector3DExecution &execution)
+{
+   pOrder.clear();
+   pPending.clear();
+   pRemovedIndexed=0;
+   for(std::size_t id=0;id<pPoints.size();id++)
+   {
+      if(pState[id]==Removed) continue;
+      if(pPoints[id].isNaN())
+      {
+         pState[id]=Skipped;
+         continue;
+      }
+      pState[id]=Indexed;
+      pOrder.push_back(id);
+   }
+
+   // Median splits keep every leaf at the same depth, so the tree is an implicit heap: node i has children 2i+1 and 2i+2
+   std::size_t size=pOrder.size();
+   pDepth=0;
+   while((size+(std::size_t(1)<<pDepth)-1)>>pDepth>leafSize) pDepth++;
+   pNodes.assign(size>0 ? (std::size_t(2)<<pDepth)-1 : 0,Node{0.0,0,0,0});
+
+   // The pool runs one loop at a time, so the top levels are split breadth first, one loop per level,
+   // until there is a subtree per worker, then every subtree is finished sequentially by one task
+   std::size_t parallelDepth=0;
+   if(execution.isParallel())
+   {
+      while(parallelDepth<pDepth && (std::size_t(1)<<parallelDepth)<execution.pool()->size() && (size>>parallelDepth)>=execution.grain()) parallelDepth++;
+   }
+   if(size>0)
+   {
+      pNodes[0].end=size;
+      for(std::size_t depth=0;depth<parallelDepth;depth++)
+      {
+         std::size_t first=(std::size_t(1)<<depth)-1;
+         execution.pool()->parallelFor(std::size_t(1)<<depth,1,[this,first](std::size_t offset, std::size_t count)
+         {
+            for(std::size_t i=offset;i<offset+count;i++) splitNode(first+i);
+         });
+      }
+      if(parallelDepth==0) buildNode(0,0);
+      else
+      {
+         std::size_t first=(std::size_t(1)<<parallelDepth)-1;
+         execution.pool()->parallelFor(std::size_t(1)<<parallelDepth,1,[this,first,parallelDepth](std::size_t offset, std::size_t count)
+         {
+            for(std::size_t i=offset;i<offset+count;i++) buildNode(first+i,parallelDepth);
+         });
+      }
+   }
+
+   pOrderedX.resize(size); pOrderedY.resize(size); pOrderedZ.resize(size);
+   for(std::size_t i=0;i<size;i++)
+   {
+      const Vector3D &vector=pPoints[pOrder[i]];
+      pOrderedX[i]=vector.x(); pOrderedY[i]=vector.y(); pOrderedZ[i]=vector.z();
+   }
+}
+
+void Vector3DIndex::splitNode(std::size_t node)
+{
+   // Split the widest extent at the median, ties broken by id so the tree does not depend on the input order
+   Node &current=pNodes[node];
+   std::size_t begin=current.begin,end=current.end;
+   Vector3D minimum=pPoints[pOrder[begin]],maximum=minimum;
+   for(std::size_t i=begin+1;i<end;i++)
+   {
+      const Vector3D &vector=pPoints[pOrder[i]];
+      minimum.set(std::min(minimum.x(),vector.x()),std::min(minimum.y(),vector.y()),std::min(minimum.z(),vector.z()));
+      maximum.set(std::max(maximum.x(),vector.x()),std::max(maximum.y(),vector.y()),std::max(maximum.z(),vector.z()));
+   }
+   Vector3D extent=maximum-minimum;
+   std::size_t axis=extent.x()>=extent.y() ? (extent.x()>=extent.z() ? 0 : 2) : (extent.y()>=extent.z() ? 1 : 2);
+   std::size_t middle=begin+(end-begin)/2;
+   std::nth_element(pOrder.begin()+static_cast<std::ptrdiff_t>(begin),pOrder.begin()+static_cast<std::ptrdiff_t>(middle),pOrder.begin()+static_cast<std::ptrdiff_t>(end),[this,axis](std::size_t id1, std::size_t id2)
+   {
+      double value1=component(pPoints[id1],axis),value2=component(pPoints[id2],axis);
+      return value1<value2 || (value1==value2 && id1<id2);
+   });
+   current.axis=static_cast<std::uint8_t>(axis);
+   current.split=component(pPoints[pOrder[middle]],axis);
+   pNodes[2*node+1].begin=begin; pNodes[2*node+1].end=middle;
+   pNodes[2*node+2].begin=middle; pNodes[2*node+2].end=end;
+}
+
+void Vector3DIndex::buildNode(std::size_t node, std::size_t depth)
+{
+   if(depth==pDepth) return;
+   splitNode(node);
+   buildNode(2*node+1,depth+1);
+   buildNode(2*node+2,depth+1);
+}
+
+void Vector3DIndex::searchNearest(const Vector3D &point, std::size_t count, std::vector<Neighbor> &heap) const
+{
+   if(count==0 || point.isNaN()) return;
+   double coordinates[3]={point.x(),point.y(),point.z()};
+   if(!pNodes.empty()) searchNearest(0,0,coordinates,count,heap);
+   for(std::size_t id : pPending) offer(heap,count,Neighbor{id,pPoints[id].distanceSquared(point)});
+}
+
+void Vector3DIndex::searchNearest(std::size_t node, std::size_t depth, const double *point, std::size_t count, std::vector<Neighbor> &heap) const
+{
+   const Node &current=pNodes[node];
+   if(depth==pDepth)
+   {
+      for(std::size_t i=current.begin;i<current.end;i++)
+      {
+         std::size_t id=pOrder[i];
+         if(pState[id]!=Indexed) continue;
+         double dx=point[0]-pOrderedX[i],dy=point[1]-pOrderedY[i],dz=point[2]-pOrderedZ[i];
+         offer(heap,count,Neighbor{id,dx*dx+dy*dy+dz*dz});
+      }
+      return;
+   }
+
+   double difference=point[current.axis]-current.split;
+   std::size_t nearChild=difference<0.0 ? 2*node+1 : 2*node+2,farChild=difference<0.0 ? 2*node+2 : 2*node+1;
+   searchNearest(nearChild,depth+1,point,count,heap);
+   if(heap.size()<count || difference*difference<=heap.front().distanceSquared) searchNearest(farChild,depth+1,point,count,heap);
+}
+
+void Vector3DIndex::searchRadius(std::size_t node, std::size_t depth, const double *point, double radiusSquared, std::vector<std::size_t> &ids) const
+{
+   const Node &current=pNodes[node];
+   if(depth==pDepth)
+   {
+      for(std::size_t i=current.begin;i<current.end;i++)
+      {
+         std::size_t id=pOrder[i];
+         if(pState[id]!=Indexed) continue;
+         double dx=point[0]-pOrderedX[i],dy=point[1]-pOrderedY[i],dz=point[2]-pOrderedZ[i];
+         if(dx*dx+dy*dy+dz*dz<=radiusSquared) ids.push_back(id);
+      }
+      return;
+   }
+
+   double difference=point[current.axis]-current.split;
+   bool farNeeded=difference*difference<=radiusSquared;
+   if(difference<0.0 || farNeeded) searchRadius(2*node+1,depth+1,point,radiusSquared,ids);
+   if(difference>=0.0 || farNeeded) searchRadius(2*node+2,depth+1,point,radiusSquared,ids);
+}
+
+void Vector3DIndex::searchBox(std::size_t node, std::size_t depth, const double *minimum, const double *maximum, std::vector<std::size_t> &ids) const
+{
+   const Node &current=pNodes[node];
+   if(depth==pDepth)
+   {
+      for(std::size_t i=current.begin;i<current.end;i++)
+      {
+         std::size_t id=pOrder[i];
+         if(pState[id]!=Indexed) continue;
+         if(pOrderedX[i]>=minimum[0] && pOrderedX[i]<=maximum[0] && pOrderedY[i]>=minimum[1] && pOrderedY[i]<=maximum[1] && pOrderedZ[i]>=minimum[2] && pOrderedZ[i]<=maximum[2]) ids.push_back(id);
+      }
+      return;
+   }
+
+   if(minimum[current.axis]<=current.split) searchBox(2*node+1,depth+1,minimum,maximum,ids);
+   if(maximum[current.axis]>=current.split) searchBox(2*node+2,depth+1,minimum,maximum,ids);
+}
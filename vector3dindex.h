@@ -0,0 +1,89 @@
+#ifndef VECTOR3DINDEX_H
+#define VECTOR3DINDEX_H
+
+#include "vector3d.h"
+#include "vector3dexecution.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+/**
+ * @brief The Vector3DIndex class is a KD-tree over Vector3D points answering nearest neighbor, radius and box
+ * queries with squared distances. Points are identified by their insertion order, ids stay stable across
+ * insert(), remove() and rebuilds. NaN points are stored but never returned.
+ * Const queries may run concurrently from any number of threads, build(), insert() and remove() need
+ * exclusive access. Inserted points are scanned linearly until enough of them pile up to trigger a rebuild,
+ * removed points are skipped until they make up half of the tree. build() splits the top levels of the tree
+ * on the pool of its execution policy, by default the shared one, and gives the same tree under every policy.
+ * The batch nearest() and radius() queries split their points the same way and return the same answers under every policy.
+ */
+class Vector3DIndex
+{
+   public:
+      static constexpr std::size_t npos=std::numeric_limits<std::size_t>::max();
+
+      struct Neighbor
+      {
+         std::size_t id;
+         double distanceSquared;
+      };
+
+      Vector3DIndex();
+      explicit Vector3DIndex(std::span<const Vector3D> points);
+
+      void build(std::span<const Vector3D> points);
+      void build(std::span<const Vector3D> points, const Vector3DExecution &execution);
+      std::size_t insert(const Vector3D &point);
+      bool remove(std::size_t id);
+
+      std::size_t size() const;
+      bool isEmpty() const;
+      bool contains(std::size_t id) const;
+      const Vector3D &point(std::size_t id) const;
+
+      Neighbor nearest(const Vector3D &point) const;
+      std::vector<Neighbor> nearest(const Vector3D &point, std::size_t count) const;
+      std::vector<std::size_t> radius(const Vector3D &point, double radius) const;
+      std::vector<std::size_t> box(const Vector3D &minimum, const Vector3D &maximum) const;
+
+      bool nearest(std::span<const Vector3D> points, std::size_t count, std::span<Neighbor> neighbors) const;
+      bool nearest(const Vector3DExecution &execution, std::span<const Vector3D> points, std::size_t count, std::span<Neighbor> neighbors) const;
+      std::vector<std::vector<std::size_t>> radius(std::span<const Vector3D> points, double radius) const;
+      std::vector<std::vector<std::size_t>> radius(const Vector3DExecution &execution, std::span<const Vector3D> points, double radius) const;
+
+   private:
+      enum State : std::uint8_t {Indexed,Pending,Skipped,Removed};
+
+      struct Node
+      {
+         double split;
+         std::size_t begin;
+         std::size_t end;
+         std::uint8_t axis;
+      };
+
+      std::vector<Vector3D> pPoints;
+      std::vector<State> pState;
+      std::vector<std::size_t> pOrder;
+      std::vector<double> pOrderedX;
+      std::vector<double> pOrderedY;
+      std::vector<double> pOrderedZ;
+      std::vector<Node> pNodes;
+      std::vector<std::size_t> pPending;
+      std::size_t pDepth;
+      std::size_t pLive;
+      std::size_t pRemovedIndexed;
+
+      void rebuild(const Vector3DExecution &execution);
+      void splitNode(std::size_t node);
+      void buildNode(std::size_t node, std::size_t depth);
+      void searchNearest(const Vector3D &point, std::size_t count, std::vector<Neighbor> &heap) const;
+      void searchNearest(std::size_t node, std::size_t depth, const double *point, std::size_t count, std::vector<Neighbor> &heap) const;
+      void searchRadius(std::size_t node, std::size_t depth, const double *point, double radiusSquared, std::vector<std::size_t> &ids) const;
+      void searchBox(std::size_t node, std::size_t depth, const double *minimum, const double *maximum, std::vector<std::size_t> &ids) const;
+};
+
+#endif // VECTOR3DINDEX_H
@@ -0,0 +1,433 @@
+#ifndef VECTOR3DINSTRUMENTATION_H
+#define VECTOR3DINSTRUMENTATION_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#ifdef VECTOR3D_INSTRUMENTATION
+   #include <atomic>
+   #include <chrono>
+   #include <mutex>
+   #include <source_location>
+   #include <type_traits>
+#endif
+
+/**
+ * @brief Opt-in instrumentation of the scalar Vector3D operations, compiled in by defining VECTOR3D_INSTRUMENTATION.
+ * Every operation counts its calls, the near-zero divisors it met and the NaN results it produced from finite
+ * or infinite operands, and one call in samplingPeriod() per thread is timed. Counters are thread-local and written
+ * without locks, snapshot() merges them. Without VECTOR3D_INSTRUMENTATION the probes expand to nothing and snapshot()
+ * is empty. It changes class layouts, so it must be defined the same way for every translation unit.
+ */
+namespace Vector3DInstrumentation
+{
+#ifdef VECTOR3D_INSTRUMENTATION
+   constexpr bool enabled=true;
+#else
+   constexpr bool enabled=false;
+#endif
+
+   enum Operation {Multiply,MultiplyAssign,Divide,DivideAssign,Add,AddAssign,Subtract,SubtractAssign,Length,SetLength,Distance,Angle,Rotate,OperationCount};
+
+   inline const char *name(Operation operation)
+   {
+      static constexpr const char *names[OperationCount]={"multiply","multiplyAssign","divide","divideAssign","add","addAssign","subtract","subtractAssign","length","setLength","distance","angle","rotate"};
+      return operation>=0 && operation<OperationCount ? names[operation] : "";
+   }
+
+   struct OperationCounters
+   {
+      std::uint64_t calls=0;
+      std::uint64_t nearZero=0;
+      std::uint64_t nans=0;
+      std::uint64_t samples=0;
+      std::uint64_t sampledNanoseconds=0;
+
+      /**
+       * @brief Total time extrapolated from the timed calls, 0 when none was timed
+       */
+      double estimatedNanoseconds() const { return samples ? static_cast<double>(sampledNanoseconds)*static_cast<double>(calls)/static_cast<double>(samples) : 0.0; }
+   };
+
+   /**
+    * @brief Where the first NaN came from: the operation, and the innermost Scope active on its thread, if any
+    */
+   struct NaNOrigin
+   {
+      Operation operation=OperationCount;
+      const char *label=nullptr;
+      const char *file=nullptr;
+      const char *function=nullptr;
+      std::uint_least32_t line=0;
+      std::uint64_t thread=0;
+   };
+
+   struct Snapshot
+   {
+      std::array<OperationCounters,OperationCount> operations{};
+      bool hasNaN=false;
+      NaNOrigin firstNaN{};
+   };
+
+   /**
+    * @brief Writes the snapshot as one JSON object, with the operations keyed by name()
+    */
+   inline bool writeJSON(std::ostream &out, const Snapshot &snapshot);
+
+#ifdef VECTOR3D_INSTRUMENTATION
+   /**
+    * @brief Marks the enclosing block as the call site reported by NaNOrigin. Operators cannot take a
+    * std::source_location, so callers mark their own functions, usually with VECTOR3D_INSTRUMENT_SCOPE().
+    */
+   class Scope
+   {
+      public:
+         explicit Scope(const char *label=nullptr, std::source_location location=std::source_location::current());
+         ~Scope();
+         Scope(const Scope&)=delete;
+         Scope &operator=(const Scope&)=delete;
+
+         const char *label() const;
+         const std::source_location &location() const;
+
+         static const Scope *current();
+
+      private:
+         const char *pLabel;
+         std::source_location pLocation;
+         const Scope *pPrevious;
+   };
+
+   namespace Detail
+   {
+      enum Field {Calls,NearZero,NaNs,Samples,SampledNanoseconds,FieldCount};
+
+      /**
+       * @brief Counters of one thread. Only the owner writes them, so increments are a relaxed load and store.
+       * Blocks are never freed: a block released by an exiting thread keeps its counts and is reused by the next one.
+       */
+      struct Block
+      {
+         std::array<std::array<std::atomic<std::uint64_t>,FieldCount>,OperationCount> counters{};
+         std::atomic<bool> owned{true};
+         Block *next=nullptr;
+         std::uint64_t thread=0;
+
+         void add(Operation operation, Field field, std::uint64_t value)
+         {
+            std::atomic<std::uint64_t> &counter=counters[operation][field];
+            counter.store(counter.load(std::memory_order_relaxed)+value,std::memory_order_relaxed);
+         }
+      };
+
+      /**
+       * @brief nanState is 0 while no NaN is recorded, 1 while a thread writes nan and 2 once it is published
+       */
+      struct Registry
+      {
+         std::atomic<Block*> head{nullptr};
+         std::atomic<std::uint64_t> threads{0};
+         std::atomic<std::uint32_t> samplingPeriod{1024};
+         std::atomic<int> nanState{0};
+         NaNOrigin nan;
+         std::mutex mutex;
+         std::array<OperationCounters,OperationCount> baseline{};
+      };
+
+      inline Registry &registry()
+      {
+         static Registry *registry=new Registry;
+         return *registry;
+      }
+
+      struct ThreadState
+      {
+         Block *block;
+         std::uint32_t countdown=1;
+         const Scope *scope=nullptr;
+
+         ThreadState()
+         {
+            Registry &shared=registry();
+            for(block=shared.head.load(std::memory_order_acquire);block;block=block->next)
+            {
+               bool expected=false;
+               if(block->owned.compare_exchange_strong(expected,true,std::memory_order_acquire)) return;
+            }
+            block=new Block;
+            block->thread=shared.threads.fetch_add(1,std::memory_order_relaxed);
+            block->next=shared.head.load(std::memory_order_relaxed);
+            while(!shared.head.compare_exchange_weak(block->next,block,std::memory_order_release,std::memory_order_relaxed));
+         }
+         ~ThreadState() { block->owned.store(false,std::memory_order_release); }
+      };
+
+      inline ThreadState &threadState()
+      {
+         thread_local ThreadState state;
+         return state;
+      }
+
+      inline std::array<OperationCounters,OperationCount> totals()
+      {
+         std::array<OperationCounters,OperationCount> result{};
+         for(Block *block=registry().head.load(std::memory_order_acquire);block;block=block->next)
+         {
+            for(int i=0;i<OperationCount;i++)
+            {
+               auto value=[block,i](Field field) { return block->counters[i][field].load(std::memory_order_relaxed); };
+               result[i].calls+=value(Calls);
+               result[i].nearZero+=value(NearZero);
+               result[i].nans+=value(NaNs);
+               result[i].samples+=value(Samples);
+               result[i].sampledNanoseconds+=value(SampledNanoseconds);
+            }
+         }
+         return result;
+      }
+   }
+
+   /**
+    * @brief Counts one call of an operation, placed by VECTOR3D_PROBE() at the top of the operation
+    */
+   class Probe
+   {
+      public:
+         constexpr Probe(Operation operation, bool inputNaN);
+         constexpr ~Probe();
+         Probe(const Probe&)=delete;
+         Probe &operator=(const Probe&)=delete;
+
+         constexpr void nearZero();
+         constexpr void result(bool nan);
+
+      private:
+         void start();
+         void finish();
+         void recordNaN();
+
+         Detail::Block *pBlock=nullptr;
+         Operation pOperation;
+         bool pInputNaN;
+         bool pTimed=false;
+         std::chrono::steady_clock::time_point pStart;
+   };
+
+   /**
+    * @brief Merges the counters of every thread, minus the counts at the last reset()
+    */
+   inline Snapshot snapshot();
+   /**
+    * @brief Restarts the counts from zero and forgets the recorded NaN origin
+    */
+   inline void reset();
+   /**
+    * @brief Times one call in period per thread, 0 stops timing. Applies from each thread's next timed call.
+    */
+   inline void setSamplingPeriod(std::uint32_t period);
+   inline std::uint32_t samplingPeriod();
+
+   #define VECTOR3D_INSTRUMENT_SCOPE_NAME2(line) vector3dInstrumentScope##line
+   #define VECTOR3D_INSTRUMENT_SCOPE_NAME(line) VECTOR3D_INSTRUMENT_SCOPE_NAME2(line)
+   #define VECTOR3D_INSTRUMENT_SCOPE(...) const Vector3DInstrumentation::Scope VECTOR3D_INSTRUMENT_SCOPE_NAME(__LINE__)(__VA_ARGS__)
+   #define VECTOR3D_PROBE(operation,inputNaN) Vector3DInstrumentation::Probe vector3dProbe(Vector3DInstrumentation::operation,inputNaN)
+   #define VECTOR3D_PROBE_NEAR_ZERO() vector3dProbe.nearZero()
+   #define VECTOR3D_PROBE_RESULT(nan) vector3dProbe.result(nan)
+#else
+   inline Snapshot snapshot() { return Snapshot(); }
+   inline void reset() {}
+   inline void setSamplingPeriod(std::uint32_t) {}
+   inline std::uint32_t samplingPeriod() { return 0; }
+
+   #define VECTOR3D_INSTRUMENT_SCOPE(...) static_cast<void>(0)
+   #define VECTOR3D_PROBE(operation,inputNaN) static_cast<void>(0)
+   #define VECTOR3D_PROBE_NEAR_ZERO() static_cast<void>(0)
+   #define VECTOR3D_PROBE_RESULT(nan) static_cast<void>(0)
+#endif
+}
+
+#ifdef VECTOR3D_INSTRUMENTATION
+inline Vector3DInstrumentation::Scope::Scope(const char *label, std::source_location location) : pLabel(label), pLocation(location)
+{
+   Detail::ThreadState &state=Detail::threadState();
+   pPrevious=state.scope;
+   state.scope=this;
+}
+
+inline Vector3DInstrumentation::Scope::~Scope()
+{
+   Detail::threadState().scope=pPrevious;
+}
+
+inline const char *Vector3DInstrumentation::Scope::label() const
+{
+   return pLabel;
+}
+
+inline const std::source_location &Vector3DInstrumentation::Scope::location() const
+{
+   return pLocation;
+}
+
+inline const Vector3DInstrumentation::Scope *Vector3DInstrumentation::Scope::current()
+{
+   return Detail::threadState().scope;
+}
+
+/**
+ * @brief Probes do nothing in constant evaluation, so the constexpr operators stay constexpr when instrumented
+ */
+constexpr Vector3DInstrumentation::Probe::Probe(Operation operation, bool inputNaN) : pOperation(operation), pInputNaN(inputNaN)
+{
+   if(!std::is_constant_evaluated()) start();
+}
+
+constexpr Vector3DInstrumentation::Probe::~Probe()
+{
+   if(pTimed) finish();
+}
+
+constexpr void Vector3DInstrumentation::Probe::nearZero()
+{
+   if(pBlock) pBlock->add(pOperation,Detail::NearZero,1);
+}
+
+constexpr void Vector3DInstrumentation::Probe::result(bool nan)
+{
+   if(nan && !pInputNaN && pBlock) recordNaN();
+}
+
+inline void Vector3DInstrumentation::Probe::start()
+{
+   Detail::ThreadState &state=Detail::threadState();
+   pBlock=state.block;
+   pBlock->add(pOperation,Detail::Calls,1);
+   if(--state.countdown==0)
+   {
+      std::uint32_t period=Detail::registry().samplingPeriod.load(std::memory_order_relaxed);
+      state.countdown=period ? period : 1u<<16;
+      if(period)
+      {
+         pTimed=true;
+         pStart=std::chrono::steady_clock::now();
+      }
+   }
+}
+
+inline void Vector3DInstrumentation::Probe::finish()
+{
+   auto elapsed=std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-pStart).count();
+   pBlock->add(pOperation,Detail::Samples,1);
+   pBlock->add(pOperation,Detail::SampledNanoseconds,static_cast<std::uint64_t>(elapsed));
+}
+
+inline void Vector3DInstrumentation::Probe::recordNaN()
+{
+   pBlock->add(pOperation,Detail::NaNs,1);
+   Detail::Registry &shared=Detail::registry();
+   int expected=0;
+   if(shared.nanState.load(std::memory_order_relaxed)!=0 || !shared.nanState.compare_exchange_strong(expected,1,std::memory_order_acquire)) return;
+   NaNOrigin origin;
+   origin.operation=pOperation;
+   origin.thread=pBlock->thread;
+   if(const Scope *scope=Scope::current())
+   {
+      origin.label=scope->label();
+      origin.file=scope->location().file_name();
+      origin.function=scope->location().function_name();
+      origin.line=scope->location().line();
+   }
+   shared.nan=origin;
+   shared.nanState.store(2,std::memory_order_release);
+}
+
+inline Vector3DInstrumentation::Snapshot Vector3DInstrumentation::snapshot()
+{
+   Detail::Registry &shared=Detail::registry();
+   std::lock_guard<std::mutex> lock(shared.mutex);
+   Snapshot result;
+   result.operations=Detail::totals();
+   for(int i=0;i<OperationCount;i++)
+   {
+      result.operations[i].calls-=shared.baseline[i].calls;
+      result.operations[i].nearZero-=shared.baseline[i].nearZero;
+      result.operations[i].nans-=shared.baseline[i].nans;
+      result.operations[i].samples-=shared.baseline[i].samples;
+      result.operations[i].sampledNanoseconds-=shared.baseline[i].sampledNanoseconds;
+   }
+   if(shared.nanState.load(std::memory_order_acquire)==2)
+   {
+      result.hasNaN=true;
+      result.firstNaN=shared.nan;
+   }
+   return result;
+}
+
+inline void Vector3DInstrumentation::reset()
+{
+   Detail::Registry &shared=Detail::registry();
+   std::lock_guard<std::mutex> lock(shared.mutex);
+   shared.baseline=Detail::totals();
+   int expected=2;
+   shared.nanState.compare_exchange_strong(expected,0,std::memory_order_relaxed);
+}
+
+inline void Vector3DInstrumentation::setSamplingPeriod(std::uint32_t period)
+{
+   Detail::registry().samplingPeriod.store(period,std::memory_order_relaxed);
+}
+
+inline std::uint32_t Vector3DInstrumentation::samplingPeriod()
+{
+   return Detail::registry().samplingPeriod.load(std::memory_order_relaxed);
+}
+#endif
+
+inline bool Vector3DInstrumentation::writeJSON(std::ostream &out, const Snapshot &snapshot)
+{
+   auto string=[&out](const char *value)
+   {
+      if(value==nullptr)
+      {
+         out<<"null";
+         return;
+      }
+      static constexpr char hex[]="0123456789abcdef";
+      out.put('"');
+      for(;*value;value++)
+      {
+         unsigned char c=static_cast<unsigned char>(*value);
+         if(c=='"' || c=='\\') { out.put('\\'); out.put(static_cast<char>(c)); }
+         else if(c<0x20) { out<<"\\u00"; out.put(hex[c>>4]); out.put(hex[c&15]); }
+         else out.put(static_cast<char>(c));
+      }
+      out.put('"');
+   };
+
+   out<<"{\"enabled\":"<<(enabled ? "true" : "false")<<",\"operations\":{";
+   for(int i=0;i<OperationCount;i++)
+   {
+      const OperationCounters &counters=snapshot.operations[i];
+      if(i) out.put(',');
+      string(name(static_cast<Operation>(i)));
+      out<<":{\"calls\":"<<counters.calls<<",\"nearZero\":"<<counters.nearZero<<",\"nans\":"<<counters.nans
+         <<",\"samples\":"<<counters.samples<<",\"sampledNanoseconds\":"<<counters.sampledNanoseconds
+         <<",\"estimatedNanoseconds\":"<<static_cast<std::uint64_t>(counters.estimatedNanoseconds())<<'}';
+   }
+   out<<"},\"firstNaN\":";
+   if(snapshot.hasNaN)
+   {
+      const NaNOrigin &origin=snapshot.firstNaN;
+      out<<"{\"operation\":"; string(name(origin.operation));
+      out<<",\"label\":"; string(origin.label);
+      out<<",\"file\":"; string(origin.file);
+      out<<",\"function\":"; string(origin.function);
+      out<<",\"line\":"<<origin.line<<",\"thread\":"<<origin.thread<<'}';
+   } else out<<"null";
+   out<<'}';
+   return static_cast<bool>(out);
+}
+
+#endif // VECTOR3DINSTRUMENTATION_H
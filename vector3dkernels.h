@@ -0,0 +1,832 @@
+#ifndef VECTOR3DKERNELS_H
+#define VECTOR3DKERNELS_H
+
+#include "vector3dsimd.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+/**
+ * @brief Batch kernels over structure-of-arrays data, written once against a Vector3DSimd wrapper.
+ * Every instruction set translation unit instantiates Table with its own wrapper, so nothing in
+ * here may call shared non-template inline code that could be emitted with the wrong instruction set.
+ */
+namespace Vector3DKernels
+{
+   struct Table
+   {
+      const char *name;
+      void (*add)(const double *ax, const double *ay, const double *az, const double *bx, const double *by, const double *bz, double *x, double *y, double *z, std::size_t size);
+      void (*subtract)(const double *ax, const double *ay, const double *az, const double *bx, const double *by, const double *bz, double *x, double *y, double *z, std::size_t size);
+      void (*translate)(const double *ax, const double *ay, const double *az, double vx, double vy, double vz, double *x, double *y, double *z, std::size_t size);
+      void (*scale)(const double *ax, const double *ay, const double *az, double factor, double *x, double *y, double *z, std::size_t size);
+      void (*rotate)(const double *ax, const double *ay, const double *az, const double *matrix, double *x, double *y, double *z, std::size_t size);
+      void (*transform)(const double *ax, const double *ay, const double *az, const double *matrix, double *x, double *y, double *z, std::size_t size);
+      void (*length)(const double *x, const double *y, const double *z, double *lengths, std::size_t size);
+      void (*distance)(const double *x, const double *y, const double *z, double px, double py, double pz, double *distances, std::size_t size);
+      void (*angleCosine)(const double *x, const double *y, const double *z, double vx, double vy, double vz, double *cosines, std::size_t size);
+      void (*angleCosines)(const double *x, const double *y, const double *z, const double *lengths, double vx, double vy, double vz, double vectorLength, double *cosines, std::size_t size);
+      void (*dot)(const double *ax, const double *ay, const double *az, const double *bx, const double *by, const double *bz, double *dots, std::size_t size);
+      void (*dotVector)(const double *x, const double *y, const double *z, double vx, double vy, double vz, double *dots, std::size_t size);
+      void (*cross)(const double *ax, const double *ay, const double *az, const double *bx, const double *by, const double *bz, double *x, double *y, double *z, std::size_t size);
+      void (*project)(const double *ax, const double *ay, const double *az, double vx, double vy, double vz, double axisSquared, double *x, double *y, double *z, std::size_t size);
+      void (*reject)(const double *ax, const double *ay, const double *az, double vx, double vy, double vz, double axisSquared, double *x, double *y, double *z, std::size_t size);
+      void (*setLength)(const double *ax, const double *ay, const double *az, double length, double *x, double *y, double *z, std::size_t size);
+      void (*isZero)(const double *x, const double *y, const double *z, std::uint8_t *flags, std::size_t size);
+      void (*isNaN)(const double *x, const double *y, const double *z, std::uint8_t *flags, std::size_t size);
+      void (*toSpherical)(const double *ax, const double *ay, const double *az, double scale, double *x, double *y, double *z, std::size_t size);
+      void (*fromSpherical)(const double *ax, const double *ay, const double *az, double scale, double *x, double *y, double *z, std::size_t size);
+      void (*toCylindrical)(const double *ax, const double *ay, const double *az, double scale, double *x, double *y, double *z, std::size_t size);
+      void (*fromCylindrical)(const double *ax, const double *ay, const double *az, double scale, double *x, double *y, double *z, std::size_t size);
+      void (*filterMask)(const double *x, const double *y, const double *z, std::size_t size, bool nan, bool zero, double squaredLength, std::uint64_t *mask);
+      std::size_t (*compact)(double *x, double *y, double *z, std::size_t size, const std::uint64_t *mask);
+      void (*sum)(const double *x, const double *y, const double *z, std::size_t size, double *lanes);
+      void (*compensatedSum)(const double *x, const double *y, const double *z, std::size_t size, double *lanes);
+      void (*moments)(const double *x, const double *y, const double *z, std::size_t size, double cx, double cy, double cz, double *lanes);
+      void (*compensatedMoments)(const double *x, const double *y, const double *z, std::size_t size, double cx, double cy, double cz, double *lanes);
+      void (*bounds)(const double *x, const double *y, const double *z, std::size_t size, double *lanes);
+      void (*squaredLengthBounds)(const double *x, const double *y, const double *z, std::size_t size, double *lanes);
+   };
+
+   /**
+    * @brief Reduction kernels accumulate element i into lane i%reductionLanes of every channel, whatever the
+    * register width, so all instruction sets produce the same lanes. lanes holds reductionLanes values per channel.
+    */
+   constexpr std::size_t reductionLanes=8;
+
+   extern const Table tableScalar;
+   extern const Table tableSSE2;
+   extern const Table tableAVX2;
+   extern const Table tableAVX512;
+
+   /**
+    * @brief Zero padded copy of a partial block, so the tail runs through the same vector code
+    */
+   template<class S>
+   struct Tail
+   {
+      double data[S::width];
+
+      Tail() : data() {}
+      Tail(const double *source, std::size_t count) : data() { for(std::size_t i=0;i<count;i++) data[i]=source[i]; }
+      void copyTo(double *target, std::size_t count) const { for(std::size_t i=0;i<count;i++) target[i]=data[i]; }
+   };
+
+   template<class S>
+   inline void writeFlags(unsigned bits, std::uint8_t *flags, std::size_t count)
+   {
+      for(std::size_t i=0;i<count;i++) flags[i]=static_cast<std::uint8_t>((bits>>i)&1u);
+   }
+
+   template<class S, class Lanes>
+   inline void forEachBinary(const double *ax, const double *ay, const double *az, const double *bx, const double *by, const double *bz, double *x, double *y, double *z, std::size_t size, Lanes lanes)
+   {
+      std::size_t i=0;
+      for(;i+S::width<=size;i+=S::width) lanes(ax+i,ay+i,az+i,bx+i,by+i,bz+i,x+i,y+i,z+i);
+      if(i<size)
+      {
+         std::size_t count=size-i;
+         Tail<S> tax(ax+i,count),tay(ay+i,count),taz(az+i,count),tbx(bx+i,count),tby(by+i,count),tbz(bz+i,count),tx,ty,tz;
+         lanes(tax.data,tay.data,taz.data,tbx.data,tby.data,tbz.data,tx.data,ty.data,tz.data);
+         tx.copyTo(x+i,count); ty.copyTo(y+i,count); tz.copyTo(z+i,count);
+      }
+   }
+
+   template<class S, class Lanes>
+   inline void forEachUnary(const double *ax, const double *ay, const double *az, double *x, double *y, double *z, std::size_t size, Lanes lanes)
+   {
+      std::size_t i=0;
+      for(;i+S::width<=size;i+=S::width) lanes(ax+i,ay+i,az+i,x+i,y+i,z+i);
+      if(i<size)
+      {
+         std::size_t count=size-i;
+         Tail<S> tax(ax+i,count),tay(ay+i,count),taz(az+i,count),tx,ty,tz;
+         lanes(tax.data,tay.data,taz.data,tx.data,ty.data,tz.data);
+         tx.copyTo(x+i,count); ty.copyTo(y+i,count); tz.copyTo(z+i,count);
+      }
+   }
+
+   template<class S, class Lanes>
+   inline void forEachReduce(const double *x, const double *y, const double *z, double *values, std::size_t size, Lanes lanes)
+   {
+      std::size_t i=0;
+      for(;i+S::width<=size;i+=S::width) S::store(values+i,lanes(S::load(x+i),S::load(y+i),S::load(z+i)));
+      if(i<size)
+      {
+         std::size_t count=size-i;
+         Tail<S> tx(x+i,count),ty(y+i,count),tz(z+i,count),tv;
+         S::store(tv.data,lanes(S::load(tx.data),S::load(ty.data),S::load(tz.data)));
+         tv.copyTo(values+i,count);
+      }
+   }
+
+   template<class S, class Lanes>
+   inline void forEachFlag(const double *x, const double *y, const double *z, std::uint8_t *flags, std::size_t size, Lanes lanes)
+   {
+      std::size_t i=0;
+      for(;i+S::width<=size;i+=S::width) writeFlags<S>(S::bits(lanes(S::load(x+i),S::load(y+i),S::load(z+i))),flags+i,S::width);
+      if(i<size)
+      {
+         std::size_t count=size-i;
+         Tail<S> tx(x+i,count),ty(y+i,count),tz(z+i,count);
+         writeFlags<S>(S::bits(lanes(S::load(tx.data),S::load(ty.data),S::load(tz.data))),flags+i,count);
+      }
+   }
+
+   /**
+    * @brief Hands lanes(r,x,y,z) register r of every group of reductionLanes elements, the last group padded with (px,py,pz)
+    */
+   template<class S, class Lanes>
+   inline void forEachLaneGroup(const double *x, const double *y, const double *z, std::size_t size, double px, double py, double pz, Lanes lanes)
+   {
+      constexpr std::size_t registers=reductionLanes/S::width;
+      std::size_t i=0;
+      for(;i+reductionLanes<=size;i+=reductionLanes)
+      {
+         for(std::size_t r=0;r<registers;r++) lanes(r,S::load(x+i+r*S::width),S::load(y+i+r*S::width),S::load(z+i+r*S::width));
+      }
+      if(i<size)
+      {
+         double tx[reductionLanes],ty[reductionLanes],tz[reductionLanes];
+         for(std::size_t j=0;j<reductionLanes;j++)
+         {
+            bool inside=i+j<size;
+            tx[j]=inside ? x[i+j] : px; ty[j]=inside ? y[i+j] : py; tz[j]=inside ? z[i+j] : pz;
+         }
+         for(std::size_t r=0;r<registers;r++) lanes(r,S::load(tx+r*S::width),S::load(ty+r*S::width),S::load(tz+r*S::width));
+      }
+   }
+
+   /**
+    * @brief Channels x reductionLanes accumulators held in registers between a load and a store of the lanes
+    */
+   template<class S, std::size_t Channels>
+   struct Accumulator
+   {
+      static constexpr std::size_t registers=reductionLanes/S::width;
+      typename S::Type value[Channels][registers];
+
+      explicit Accumulator(const double *lanes)
+      {
+         for(std::size_t c=0;c<Channels;c++) for(std::size_t r=0;r<registers;r++) value[c][r]=S::load(lanes+c*reductionLanes+r*S::width);
+      }
+
+      void store(double *lanes) const
+      {
+         for(std::size_t c=0;c<Channels;c++) for(std::size_t r=0;r<registers;r++) S::store(lanes+c*reductionLanes+r*S::width,value[c][r]);
+      }
+   };
+
+   /**
+    * @brief Kahan-Babuska (Neumaier) step: the rounding error of sum+value goes to compensation
+    */
+   template<class S>
+   inline void compensatedAdd(typename S::Type &sum, typename S::Type &compensation, typename S::Type value)
+   {
+      typename S::Type total=S::add(sum,value);
+      typename S::Mask sumLarger=S::notLess(S::abs(sum),S::abs(value));
+      typename S::Type large=S::select(sumLarger,sum,value),small=S::select(sumLarger,value,sum);
+      compensation=S::add(compensation,S::add(S::sub(large,total),small));
+      sum=total;
+   }
+
+   template<class S>
+   inline typename S::Type squared(typename S::Type x, typename S::Type y, typename S::Type z)
+   {
+      return S::add(S::add(S::mul(x,x),S::mul(y,y)),S::mul(z,z));
+   }
+
+   template<class S>
+   inline typename S::Mask notZero(typename S::Type x, typename S::Type y, typename S::Type z)
+   {
+      typename S::Type epsilon=S::set(std::numeric_limits<double>::epsilon());
+      return S::maskOr(S::maskOr(S::notLess(S::abs(x),epsilon),S::notLess(S::abs(y),epsilon)),S::notLess(S::abs(z),epsilon));
+   }
+
+   template<class S>
+   void add(const double *ax, const double *ay, const double *az, const double *bx, const double *by, const double *bz, double *x, double *y, double *z, std::size_t size)
+   {
+      forEachBinary<S>(ax,ay,az,bx,by,bz,x,y,z,size,[](const double *ax, const double *ay, const double *az, const double *bx, const double *by, const double *bz, double *x, double *y, double *z)
+      {
+         S::store(x,S::add(S::load(ax),S::load(bx)));
+         S::store(y,S::add(S::load(ay),S::load(by)));
+         S::store(z,S::add(S::load(az),S::load(bz)));
+      });
+   }
+
+   template<class S>
+   void subtract(const double *ax, const double *ay, const double *az, const double *bx, const double *by, const double *bz, double *x, double *y, double *z, std::size_t size)
+   {
+      forEachBinary<S>(ax,ay,az,bx,by,bz,x,y,z,size,[](const double *ax, const double *ay, const double *az, const double *bx, const double *by, const double *bz, double *x, double *y, double *z)
+      {
+         S::store(x,S::sub(S::load(ax),S::load(bx)));
+         S::store(y,S::sub(S::load(ay),S::load(by)));
+         S::store(z,S::sub(S::load(az),S::load(bz)));
+      });
+   }
+
+   template<class S>
+   void translate(const double *ax, const double *ay, const double *az, double vx, double vy, double vz, double *x, double *y, double *z, std::size_t size)
+   {
+      typename S::Type tx=S::set(vx),ty=S::set(vy),tz=S::set(vz);
+      forEachUnary<S>(ax,ay,az,x,y,z,size,[tx,ty,tz](const double *ax, const double *ay, const double *az, double *x, double *y, double *z)
+      {
+         S::store(x,S::add(S::load(ax),tx));
+         S::store(y,S::add(S::load(ay),ty));
+         S::store(z,S::add(S::load(az),tz));
+      });
+   }
+
+   template<class S>
+   void scale(const double *ax, const double *ay, const double *az, double factor, double *x, double *y, double *z, std::size_t size)
+   {
+      typename S::Type f=S::set(factor);
+      forEachUnary<S>(ax,ay,az,x,y,z,size,[f](const double *ax, const double *ay, const double *az, double *x, double *y, double *z)
+      {
+         S::store(x,S::mul(S::load(ax),f));
+         S::store(y,S::mul(S::load(ay),f));
+         S::store(z,S::mul(S::load(az),f));
+      });
+   }
+
+   /**
+    * @brief Multiplies by a row-major 3x3 matrix, in the same operation order as Rotation3D::apply()
+    */
+   template<class S>
+   void rotate(const double *ax, const double *ay, const double *az, const double *matrix, double *x, double *y, double *z, std::size_t size)
+   {
+      typename S::Type m[9];
+      for(int i=0;i<9;i++) m[i]=S::set(matrix[i]);
+      forEachUnary<S>(ax,ay,az,x,y,z,size,[&m](const double *ax, const double *ay, const double *az, double *x, double *y, double *z)
+      {
+         typename S::Type vx=S::load(ax),vy=S::load(ay),vz=S::load(az);
+         S::store(x,S::add(S::add(S::mul(m[0],vx),S::mul(m[1],vy)),S::mul(m[2],vz)));
+         S::store(y,S::add(S::add(S::mul(m[3],vx),S::mul(m[4],vy)),S::mul(m[5],vz)));
+         S::store(z,S::add(S::add(S::mul(m[6],vx),S::mul(m[7],vy)),S::mul(m[8],vz)));
+      });
+   }
+
+   /**
+    * @brief Applies a row-major 3x4 affine matrix, in the same operation order as Transform3D::apply()
+    */
+   template<class S>
+   void transform(const double *ax, const double *ay, const double *az, const double *matrix, double *x, double *y, double *z, std::size_t size)
+   {
+      typename S::Type m[12];
+      for(int i=0;i<12;i++) m[i]=S::set(matrix[i]);
+      forEachUnary<S>(ax,ay,az,x,y,z,size,[&m](const double *ax, const double *ay, const double *az, double *x, double *y, double *z)
+      {
+         typename S::Type vx=S::load(ax),vy=S::load(ay),vz=S::load(az);
+         S::store(x,S::add(S::add(S::add(S::mul(m[0],vx),S::mul(m[1],vy)),S::mul(m[2],vz)),m[3]));
+         S::store(y,S::add(S::add(S::add(S::mul(m[4],vx),S::mul(m[5],vy)),S::mul(m[6],vz)),m[7]));
+         S::store(z,S::add(S::add(S::add(S::mul(m[8],vx),S::mul(m[9],vy)),S::mul(m[10],vz)),m[11]));
+      });
+   }
+
+   template<class S>
+   void length(const double *x, const double *y, const double *z, double *lengths, std::size_t size)
+   {
+      forEachReduce<S>(x,y,z,lengths,size,[](typename S::Type x, typename S::Type y, typename S::Type z)
+      {
+         return S::sqrt(squared<S>(x,y,z));
+      });
+   }
+
+   template<class S>
+   void distance(const double *x, const double *y, const double *z, double px, double py, double pz, double *distances, std::size_t size)
+   {
+      typename S::Type tx=S::set(px),ty=S::set(py),tz=S::set(pz);
+      forEachReduce<S>(x,y,z,distances,size,[tx,ty,tz](typename S::Type x, typename S::Type y, typename S::Type z)
+      {
+         return S::sqrt(squared<S>(S::sub(tx,x),S::sub(ty,y),S::sub(tz,z)));
+      });
+   }
+
+   /**
+    * @brief Clamped cosine of the angle to (vx,vy,vz), or 1.0 where Vector3D::angle() returns zero
+    */
+   template<class S>
+   void angleCosine(const double *x, const double *y, const double *z, double vx, double vy, double vz, double *cosines, std::size_t size)
+   {
+      typename S::Type tx=S::set(vx),ty=S::set(vy),tz=S::set(vz),one=S::set(1.0),minusOne=S::set(-1.0);
+      typename S::Mask vectorNotZero=notZero<S>(tx,ty,tz);
+      typename S::Type vectorLength=S::sqrt(squared<S>(tx,ty,tz));
+      forEachReduce<S>(x,y,z,cosines,size,[=](typename S::Type x, typename S::Type y, typename S::Type z)
+      {
+         typename S::Type dot=S::add(S::add(S::mul(tx,x),S::mul(ty,y)),S::mul(tz,z));
+         typename S::Type cosine=S::div(dot,S::mul(vectorLength,S::sqrt(squared<S>(x,y,z))));
+         cosine=S::max(minusOne,S::min(one,cosine));
+         return S::select(S::maskAnd(vectorNotZero,notZero<S>(x,y,z)),cosine,one);
+      });
+   }
+
+   /**
+    * @brief angleCosine() with the lengths of the vectors and of (vx,vy,vz) computed beforehand
+    */
+   template<class S>
+   void angleCosines(const double *x, const double *y, const double *z, const double *lengths, double vx, double vy, double vz, double vectorLength, double *cosines, std::size_t size)
+   {
+      typename S::Type tx=S::set(vx),ty=S::set(vy),tz=S::set(vz),tl=S::set(vectorLength),one=S::set(1.0),minusOne=S::set(-1.0);
+      typename S::Mask vectorNotZero=notZero<S>(tx,ty,tz);
+      auto lanes=[=](const double *x, const double *y, const double *z, const double *lengths, double *cosines)
+      {
+         typename S::Type ex=S::load(x),ey=S::load(y),ez=S::load(z);
+         typename S::Type dot=S::add(S::add(S::mul(tx,ex),S::mul(ty,ey)),S::mul(tz,ez));
+         typename S::Type cosine=S::div(dot,S::mul(tl,S::load(lengths)));
+         cosine=S::max(minusOne,S::min(one,cosine));
+         S::store(cosines,S::select(S::maskAnd(vectorNotZero,notZero<S>(ex,ey,ez)),cosine,one));
+      };
+      std::size_t i=0;
+      for(;i+S::width<=size;i+=S::width) lanes(x+i,y+i,z+i,lengths+i,cosines+i);
+      if(i<size)
+      {
+         std::size_t count=size-i;
+         Tail<S> tx(x+i,count),ty(y+i,count),tz(z+i,count),tl(lengths+i,count),tc;
+         lanes(tx.data,ty.data,tz.data,tl.data,tc.data);
+         tc.copyTo(cosines+i,count);
+      }
+   }
+
+   /**
+    * @brief Dot products of pairs, in the same operation order as Vector3D::dot()
+    */
+   template<class S>
+   void dot(const double *ax, const double *ay, const double *az, const double *bx, const double *by, const double *bz, double *dots, std::size_t size)
+   {
+      auto lanes=[](const double *ax, const double *ay, const double *az, const double *bx, const double *by, const double *bz, double *dots)
+      {
+         S::store(dots,S::add(S::add(S::mul(S::load(ax),S::load(bx)),S::mul(S::load(ay),S::load(by))),S::mul(S::load(az),S::load(bz))));
+      };
+      std::size_t i=0;
+      for(;i+S::width<=size;i+=S::width) lanes(ax+i,ay+i,az+i,bx+i,by+i,bz+i,dots+i);
+      if(i<size)
+      {
+         std::size_t count=size-i;
+         Tail<S> tax(ax+i,count),tay(ay+i,count),taz(az+i,count),tbx(bx+i,count),tby(by+i,count),tbz(bz+i,count),tdots;
+         lanes(tax.data,tay.data,taz.data,tbx.data,tby.data,tbz.data,tdots.data);
+         tdots.copyTo(dots+i,count);
+      }
+   }
+
+   template<class S>
+   void dotVector(const double *x, const double *y, const double *z, double vx, double vy, double vz, double *dots, std::size_t size)
+   {
+      typename S::Type tx=S::set(vx),ty=S::set(vy),tz=S::set(vz);
+      forEachReduce<S>(x,y,z,dots,size,[tx,ty,tz](typename S::Type x, typename S::Type y, typename S::Type z)
+      {
+         return S::add(S::add(S::mul(x,tx),S::mul(y,ty)),S::mul(z,tz));
+      });
+   }
+
+   template<class S>
+   void cross(const double *ax, const double *ay, const double *az, const double *bx, const double *by, const double *bz, double *x, double *y, double *z, std::size_t size)
+   {
+      forEachBinary<S>(ax,ay,az,bx,by,bz,x,y,z,size,[](const double *ax, const double *ay, const double *az, const double *bx, const double *by, const double *bz, double *x, double *y, double *z)
+      {
+         typename S::Type vax=S::load(ax),vay=S::load(ay),vaz=S::load(az),vbx=S::load(bx),vby=S::load(by),vbz=S::load(bz);
+         S::store(x,S::sub(S::mul(vay,vbz),S::mul(vaz,vby)));
+         S::store(y,S::sub(S::mul(vaz,vbx),S::mul(vax,vbz)));
+         S::store(z,S::sub(S::mul(vax,vby),S::mul(vay,vbx)));
+      });
+   }
+
+   /**
+    * @brief Projection onto the axis (vx,vy,vz), in the same operation order as Vector3D::project(). The caller handles zero axes.
+    */
+   template<class S>
+   void project(const double *ax, const double *ay, const double *az, double vx, double vy, double vz, double axisSquared, double *x, double *y, double *z, std::size_t size)
+   {
+      typename S::Type tx=S::set(vx),ty=S::set(vy),tz=S::set(vz),tsquared=S::set(axisSquared);
+      forEachUnary<S>(ax,ay,az,x,y,z,size,[=](const double *ax, const double *ay, const double *az, double *x, double *y, double *z)
+      {
+         typename S::Type scale=S::div(S::add(S::add(S::mul(S::load(ax),tx),S::mul(S::load(ay),ty)),S::mul(S::load(az),tz)),tsquared);
+         S::store(x,S::mul(tx,scale));
+         S::store(y,S::mul(ty,scale));
+         S::store(z,S::mul(tz,scale));
+      });
+   }
+
+   template<class S>
+   void reject(const double *ax, const double *ay, const double *az, double vx, double vy, double vz, double axisSquared, double *x, double *y, double *z, std::size_t size)
+   {
+      typename S::Type tx=S::set(vx),ty=S::set(vy),tz=S::set(vz),tsquared=S::set(axisSquared);
+      forEachUnary<S>(ax,ay,az,x,y,z,size,[=](const double *ax, const double *ay, const double *az, double *x, double *y, double *z)
+      {
+         typename S::Type ex=S::load(ax),ey=S::load(ay),ez=S::load(az);
+         typename S::Type scale=S::div(S::add(S::add(S::mul(ex,tx),S::mul(ey,ty)),S::mul(ez,tz)),tsquared);
+         S::store(x,S::sub(ex,S::mul(tx,scale)));
+         S::store(y,S::sub(ey,S::mul(ty,scale)));
+         S::store(z,S::sub(ez,S::mul(tz,scale)));
+      });
+   }
+
+   template<class S>
+   inline typename S::Mask zeroLanes(typename S::Type x, typename S::Type y, typename S::Type z)
+   {
+      typename S::Type epsilon=S::set(std::numeric_limits<double>::epsilon());
+      return S::maskAnd(S::maskAnd(S::less(S::abs(x),epsilon),S::less(S::abs(y),epsilon)),S::less(S::abs(z),epsilon));
+   }
+
+   template<class S>
+   inline typename S::Mask nanLanes(typename S::Type x, typename S::Type y, typename S::Type z)
+   {
+      return S::maskOr(S::maskOr(S::isNaN(x),S::isNaN(y)),S::isNaN(z));
+   }
+
+   template<class S>
+   void isZero(const double *x, const double *y, const double *z, std::uint8_t *flags, std::size_t size)
+   {
+      forEachFlag<S>(x,y,z,flags,size,[](typename S::Type x, typename S::Type y, typename S::Type z) { return zeroLanes<S>(x,y,z); });
+   }
+
+   template<class S>
+   void isNaN(const double *x, const double *y, const double *z, std::uint8_t *flags, std::size_t size)
+   {
+      forEachFlag<S>(x,y,z,flags,size,[](typename S::Type x, typename S::Type y, typename S::Type z) { return nanLanes<S>(x,y,z); });
+   }
+
+   /**
+    * @brief Vector3D::setLength() with Precise accuracy and a length that is not zero, zero vectors are copied unchanged
+    */
+   template<class S>
+   void setLength(const double *ax, const double *ay, const double *az, double length, double *x, double *y, double *z, std::size_t size)
+   {
+      typename S::Type target=S::set(length);
+      forEachUnary<S>(ax,ay,az,x,y,z,size,[=](const double *ax, const double *ay, const double *az, double *x, double *y, double *z)
+      {
+         typename S::Type ex=S::load(ax),ey=S::load(ay),ez=S::load(az);
+         typename S::Type factor=S::div(S::sqrt(squared<S>(ex,ey,ez)),target);
+         typename S::Mask zero=zeroLanes<S>(ex,ey,ez);
+         S::store(x,S::select(zero,ex,S::div(ex,factor)));
+         S::store(y,S::select(zero,ey,S::div(ey,factor)));
+         S::store(z,S::select(zero,ez,S::div(ez,factor)));
+      });
+   }
+
+   /**
+    * @brief Nearest integer of values below 2^51 in magnitude, ties to even, by pushing the fraction out of the mantissa
+    */
+   template<class S>
+   inline typename S::Type round(typename S::Type value)
+   {
+      typename S::Type shift=S::set(6755399441055744.0);
+      return S::sub(S::add(value,shift),shift);
+   }
+
+   /**
+    * @brief value where mask is clear, -value where it is set
+    */
+   template<class S>
+   inline typename S::Type negate(typename S::Mask mask, typename S::Type value)
+   {
+      return S::mul(value,S::select(mask,S::set(-1.0),S::set(1.0)));
+   }
+
+   /**
+    * @brief atan2(y,x) from the Cephes rational approximation of atan on [-tan(pi/8),tan(pi/8)], after folding the
+    * ratio of the smaller to the larger magnitude into that range. atan2(0,0) is 0 and the sign of a zero y is not kept.
+    */
+   template<class S>
+   inline typename S::Type atan2(typename S::Type y, typename S::Type x)
+   {
+      typename S::Type one=S::set(1.0),ax=S::abs(x),ay=S::abs(y);
+      typename S::Type ratio=S::div(S::min(ax,ay),S::max(S::max(ax,ay),S::set(std::numeric_limits<double>::denorm_min())));
+      typename S::Mask folded=S::less(S::set(0.41421356237309504880),ratio);
+      typename S::Type t=S::select(folded,S::div(S::sub(ratio,one),S::add(ratio,one)),ratio),t2=S::mul(t,t);
+      typename S::Type p=S::set(-8.750608600031904122785e-1);
+      p=S::add(S::mul(p,t2),S::set(-1.615753718733365076637e1));
+      p=S::add(S::mul(p,t2),S::set(-7.500855792314704667340e1));
+      p=S::add(S::mul(p,t2),S::set(-1.228866684490136173410e2));
+      p=S::add(S::mul(p,t2),S::set(-6.485021904942025371773e1));
+      typename S::Type q=S::add(t2,S::set(2.485846490142306297962e1));
+      q=S::add(S::mul(q,t2),S::set(1.650270098316988542046e2));
+      q=S::add(S::mul(q,t2),S::set(4.328810604912902668951e2));
+      q=S::add(S::mul(q,t2),S::set(4.853903996359136964868e2));
+      q=S::add(S::mul(q,t2),S::set(1.945506571482613964425e2));
+      typename S::Type angle=S::add(t,S::div(S::mul(S::mul(t,t2),p),q));
+      angle=S::select(folded,S::add(S::set(0.78539816339744830962),S::add(angle,S::set(3.061616997868382943065e-17))),angle);
+      angle=S::select(S::less(ax,ay),S::add(S::sub(S::set(1.57079632679489661923),angle),S::set(6.123233995736765886130e-17)),angle);
+      angle=S::select(S::less(x,S::set(0.0)),S::add(S::sub(S::set(3.14159265358979323846),angle),S::set(1.224646799147353177226e-16)),angle);
+      angle=negate<S>(S::less(y,S::set(0.0)),angle);
+      return S::select(S::maskOr(S::isNaN(x),S::isNaN(y)),S::add(x,y),angle);
+   }
+
+   constexpr double sinCosRange=1.0e5;
+
+   /**
+    * @brief Sine and cosine from a reduction to [-pi/4,pi/4] and Taylor polynomials of degree 15 and 16. Lanes beyond
+    * sinCosRange radians, and NaN lanes, go through libm.
+    */
+   template<class S>
+   inline void sinCos(typename S::Type angle, typename S::Type &sine, typename S::Type &cosine)
+   {
+      typename S::Type k=round<S>(S::mul(angle,S::set(0.636619772367581343075535053490057448)));
+      typename S::Type r=S::sub(S::sub(angle,S::mul(k,S::set(1.57079632673412561417e+00))),S::mul(k,S::set(6.07710050650619224932e-11))),r2=S::mul(r,r);
+
+      typename S::Type s=S::set(-1.0/1307674368000.0);
+      s=S::add(S::mul(s,r2),S::set(1.0/6227020800.0));
+      s=S::sub(S::mul(s,r2),S::set(1.0/39916800.0));
+      s=S::add(S::mul(s,r2),S::set(1.0/362880.0));
+      s=S::sub(S::mul(s,r2),S::set(1.0/5040.0));
+      s=S::add(S::mul(s,r2),S::set(1.0/120.0));
+      s=S::sub(S::mul(s,r2),S::set(1.0/6.0));
+      s=S::add(r,S::mul(S::mul(r,r2),s));
+
+      typename S::Type c=S::set(1.0/20922789888000.0);
+      c=S::sub(S::mul(c,r2),S::set(1.0/87178291200.0));
+      c=S::add(S::mul(c,r2),S::set(1.0/479001600.0));
+      c=S::sub(S::mul(c,r2),S::set(1.0/3628800.0));
+      c=S::add(S::mul(c,r2),S::set(1.0/40320.0));
+      c=S::sub(S::mul(c,r2),S::set(1.0/720.0));
+      c=S::add(S::mul(c,r2),S::set(1.0/24.0));
+      c=S::sub(S::mul(c,r2),S::set(0.5));
+      c=S::add(S::set(1.0),S::mul(r2,c));
+
+      // quadrant k mod 4 as 0, 1, 2 or 3: odd quadrants swap sine and cosine, 2 and 3 negate the sine, 1 and 2 the cosine
+      typename S::Type quadrant=S::sub(k,S::mul(S::set(4.0),round<S>(S::sub(S::mul(k,S::set(0.25)),S::set(0.375)))));
+      typename S::Type fromOdd=S::abs(S::sub(quadrant,S::set(2.0)));
+      typename S::Mask odd=S::maskAnd(S::less(fromOdd,S::set(1.5)),S::notLess(fromOdd,S::set(0.5)));
+      sine=negate<S>(S::notLess(quadrant,S::set(1.5)),S::select(odd,c,s));
+      cosine=negate<S>(S::less(S::abs(S::sub(quadrant,S::set(1.5))),S::set(1.0)),S::select(odd,s,c));
+
+      if(S::bits(S::notLess(S::abs(angle),S::set(sinCosRange)))!=0)
+      {
+         double angles[S::width],sines[S::width],cosines[S::width];
+         S::store(angles,angle); S::store(sines,sine); S::store(cosines,cosine);
+         for(std::size_t i=0;i<S::width;i++)
+         {
+            if(!(std::fabs(angles[i])<sinCosRange))
+            {
+               sines[i]=std::sin(angles[i]);
+               cosines[i]=std::cos(angles[i]);
+            }
+         }
+         sine=S::load(sines); cosine=S::load(cosines);
+      }
+   }
+
+   /**
+    * @brief (r,theta,phi) with theta from +z and phi from +x towards +y, the angles multiplied by scale
+    */
+   template<class S>
+   void toSpherical(const double *ax, const double *ay, const double *az, double scale, double *x, double *y, double *z, std::size_t size)
+   {
+      typename S::Type factor=S::set(scale);
+      forEachUnary<S>(ax,ay,az,x,y,z,size,[=](const double *ax, const double *ay, const double *az, double *x, double *y, double *z)
+      {
+         typename S::Type ex=S::load(ax),ey=S::load(ay),ez=S::load(az);
+         typename S::Type planar=S::add(S::mul(ex,ex),S::mul(ey,ey));
+         S::store(x,S::sqrt(S::add(planar,S::mul(ez,ez))));
+         S::store(y,S::mul(atan2<S>(S::sqrt(planar),ez),factor));
+         S::store(z,S::mul(atan2<S>(ey,ex),factor));
+      });
+   }
+
+   template<class S>
+   void fromSpherical(const double *ax, const double *ay, const double *az, double scale, double *x, double *y, double *z, std::size_t size)
+   {
+      typename S::Type factor=S::set(scale);
+      forEachUnary<S>(ax,ay,az,x,y,z,size,[=](const double *ax, const double *ay, const double *az, double *x, double *y, double *z)
+      {
+         typename S::Type radius=S::load(ax),thetaSine,thetaCosine,phiSine,phiCosine;
+         sinCos<S>(S::mul(S::load(ay),factor),thetaSine,thetaCosine);
+         sinCos<S>(S::mul(S::load(az),factor),phiSine,phiCosine);
+         typename S::Type planar=S::mul(radius,thetaSine);
+         S::store(x,S::mul(planar,phiCosine));
+         S::store(y,S::mul(planar,phiSine));
+         S::store(z,S::mul(radius,thetaCosine));
+      });
+   }
+
+   /**
+    * @brief (rho,phi,z) with phi from +x towards +y, multiplied by scale
+    */
+   template<class S>
+   void toCylindrical(const double *ax, const double *ay, const double *az, double scale, double *x, double *y, double *z, std::size_t size)
+   {
+      typename S::Type factor=S::set(scale);
+      forEachUnary<S>(ax,ay,az,x,y,z,size,[=](const double *ax, const double *ay, const double *az, double *x, double *y, double *z)
+      {
+         typename S::Type ex=S::load(ax),ey=S::load(ay);
+         S::store(x,S::sqrt(S::add(S::mul(ex,ex),S::mul(ey,ey))));
+         S::store(y,S::mul(atan2<S>(ey,ex),factor));
+         S::store(z,S::load(az));
+      });
+   }
+
+   template<class S>
+   void fromCylindrical(const double *ax, const double *ay, const double *az, double scale, double *x, double *y, double *z, std::size_t size)
+   {
+      typename S::Type factor=S::set(scale);
+      forEachUnary<S>(ax,ay,az,x,y,z,size,[=](const double *ax, const double *ay, const double *az, double *x, double *y, double *z)
+      {
+         typename S::Type radius=S::load(ax),sine,cosine;
+         sinCos<S>(S::mul(S::load(ay),factor),sine,cosine);
+         S::store(x,S::mul(radius,cosine));
+         S::store(y,S::mul(radius,sine));
+         S::store(z,S::load(az));
+      });
+   }
+
+   /**
+    * @brief Sets bit i%64 of mask[i/64] when vector i is NaN (nan), zero (zero) or has a squared length below
+    * squaredLength. Whole words are written, the bits past size cleared.
+    */
+   template<class S>
+   void filterMask(const double *x, const double *y, const double *z, std::size_t size, bool nan, bool zero, double squaredLength, std::uint64_t *mask)
+   {
+      typename S::Type minimum=S::set(squaredLength);
+      auto lanes=[&](typename S::Type x, typename S::Type y, typename S::Type z)
+      {
+         unsigned bits=S::bits(S::less(squared<S>(x,y,z),minimum));
+         if(nan) bits|=S::bits(nanLanes<S>(x,y,z));
+         if(zero) bits|=S::bits(zeroLanes<S>(x,y,z));
+         return static_cast<std::uint64_t>(bits);
+      };
+      for(std::size_t first=0;first<size;first+=64)
+      {
+         std::size_t count=size-first<64 ? size-first : 64,i=0;
+         std::uint64_t word=0;
+         for(;i+S::width<=count;i+=S::width) word|=lanes(S::load(x+first+i),S::load(y+first+i),S::load(z+first+i))<<i;
+         if(i<count)
+         {
+            Tail<S> tx(x+first+i,count-i),ty(y+first+i,count-i),tz(z+first+i,count-i);
+            word|=(lanes(S::load(tx.data),S::load(ty.data),S::load(tz.data))&((std::uint64_t(1)<<(count-i))-1))<<i;
+         }
+         mask[first/64]=word;
+      }
+   }
+
+   /**
+    * @brief Number of set bits of a keep mask of up to eight lanes
+    */
+   template<class S>
+   inline std::size_t keptLanes(unsigned keep)
+   {
+      keep=keep-((keep>>1)&0x55u);
+      keep=(keep&0x33u)+((keep>>2)&0x33u);
+      return (keep+(keep>>4))&0x0Fu;
+   }
+
+   /**
+    * @brief Moves the vectors whose bit of mask is clear to the front, in order, and returns their count. Each register
+    * of vectors is compressed and stored whole at the write position, which never passes the read position, so the
+    * junk lanes only land on vectors already read. Words with nothing to move are skipped.
+    */
+   template<class S>
+   std::size_t compact(double *x, double *y, double *z, std::size_t size, const std::uint64_t *mask)
+   {
+      std::size_t kept=0;
+      for(std::size_t first=0;first<size;first+=64)
+      {
+         std::uint64_t word=mask[first/64];
+         std::size_t count=size-first<64 ? size-first : 64,i=0;
+         if(word==0 && kept==first)
+         {
+            kept+=count;
+            continue;
+         }
+         if(~word==0) continue;
+         for(;i+S::width<=count;i+=S::width)
+         {
+            unsigned keep=static_cast<unsigned>(~word>>i)&((1u<<S::width)-1);
+            typename S::Type vx=S::load(x+first+i),vy=S::load(y+first+i),vz=S::load(z+first+i);
+            S::compress(x+kept,vx,keep);
+            S::compress(y+kept,vy,keep);
+            S::compress(z+kept,vz,keep);
+            kept+=keptLanes<S>(keep);
+         }
+         for(;i<count;i++)
+         {
+            x[kept]=x[first+i];
+            y[kept]=y[first+i];
+            z[kept]=z[first+i];
+            kept+=1-((word>>i)&1);
+         }
+      }
+      return kept;
+   }
+
+   /**
+    * @brief Adds x, y and z into channels 0 to 2 of lanes
+    */
+   template<class S>
+   void sum(const double *x, const double *y, const double *z, std::size_t size, double *lanes)
+   {
+      Accumulator<S,3> sums(lanes);
+      forEachLaneGroup<S>(x,y,z,size,0.0,0.0,0.0,[&](std::size_t r, typename S::Type x, typename S::Type y, typename S::Type z)
+      {
+         sums.value[0][r]=S::add(sums.value[0][r],x);
+         sums.value[1][r]=S::add(sums.value[1][r],y);
+         sums.value[2][r]=S::add(sums.value[2][r],z);
+      });
+      sums.store(lanes);
+   }
+
+   /**
+    * @brief Compensated sum(), with the compensations in channels 3 to 5
+    */
+   template<class S>
+   void compensatedSum(const double *x, const double *y, const double *z, std::size_t size, double *lanes)
+   {
+      Accumulator<S,6> sums(lanes);
+      forEachLaneGroup<S>(x,y,z,size,0.0,0.0,0.0,[&](std::size_t r, typename S::Type x, typename S::Type y, typename S::Type z)
+      {
+         compensatedAdd<S>(sums.value[0][r],sums.value[3][r],x);
+         compensatedAdd<S>(sums.value[1][r],sums.value[4][r],y);
+         compensatedAdd<S>(sums.value[2][r],sums.value[5][r],z);
+      });
+      sums.store(lanes);
+   }
+
+   /**
+    * @brief Adds the products xx, xy, xz, yy, yz and zz of the offsets from (cx,cy,cz) into channels 0 to 5 of lanes
+    */
+   template<class S>
+   void moments(const double *x, const double *y, const double *z, std::size_t size, double cx, double cy, double cz, double *lanes)
+   {
+      Accumulator<S,6> sums(lanes);
+      typename S::Type tx=S::set(cx),ty=S::set(cy),tz=S::set(cz);
+      forEachLaneGroup<S>(x,y,z,size,cx,cy,cz,[&](std::size_t r, typename S::Type x, typename S::Type y, typename S::Type z)
+      {
+         typename S::Type dx=S::sub(x,tx),dy=S::sub(y,ty),dz=S::sub(z,tz);
+         sums.value[0][r]=S::add(sums.value[0][r],S::mul(dx,dx));
+         sums.value[1][r]=S::add(sums.value[1][r],S::mul(dx,dy));
+         sums.value[2][r]=S::add(sums.value[2][r],S::mul(dx,dz));
+         sums.value[3][r]=S::add(sums.value[3][r],S::mul(dy,dy));
+         sums.value[4][r]=S::add(sums.value[4][r],S::mul(dy,dz));
+         sums.value[5][r]=S::add(sums.value[5][r],S::mul(dz,dz));
+      });
+      sums.store(lanes);
+   }
+
+   /**
+    * @brief Compensated moments(), with the compensations in channels 6 to 11
+    */
+   template<class S>
+   void compensatedMoments(const double *x, const double *y, const double *z, std::size_t size, double cx, double cy, double cz, double *lanes)
+   {
+      Accumulator<S,12> sums(lanes);
+      typename S::Type tx=S::set(cx),ty=S::set(cy),tz=S::set(cz);
+      forEachLaneGroup<S>(x,y,z,size,cx,cy,cz,[&](std::size_t r, typename S::Type x, typename S::Type y, typename S::Type z)
+      {
+         typename S::Type dx=S::sub(x,tx),dy=S::sub(y,ty),dz=S::sub(z,tz);
+         compensatedAdd<S>(sums.value[0][r],sums.value[6][r],S::mul(dx,dx));
+         compensatedAdd<S>(sums.value[1][r],sums.value[7][r],S::mul(dx,dy));
+         compensatedAdd<S>(sums.value[2][r],sums.value[8][r],S::mul(dx,dz));
+         compensatedAdd<S>(sums.value[3][r],sums.value[9][r],S::mul(dy,dy));
+         compensatedAdd<S>(sums.value[4][r],sums.value[10][r],S::mul(dy,dz));
+         compensatedAdd<S>(sums.value[5][r],sums.value[11][r],S::mul(dz,dz));
+      });
+      sums.store(lanes);
+   }
+
+   /**
+    * @brief Minimum x, y and z into channels 0 to 2 and maximum into channels 3 to 5, skipping NaN components
+    */
+   template<class S>
+   void bounds(const double *x, const double *y, const double *z, std::size_t size, double *lanes)
+   {
+      Accumulator<S,6> limits(lanes);
+      double nan=std::numeric_limits<double>::quiet_NaN();
+      forEachLaneGroup<S>(x,y,z,size,nan,nan,nan,[&](std::size_t r, typename S::Type x, typename S::Type y, typename S::Type z)
+      {
+         limits.value[0][r]=S::min(x,limits.value[0][r]);
+         limits.value[1][r]=S::min(y,limits.value[1][r]);
+         limits.value[2][r]=S::min(z,limits.value[2][r]);
+         limits.value[3][r]=S::max(x,limits.value[3][r]);
+         limits.value[4][r]=S::max(y,limits.value[4][r]);
+         limits.value[5][r]=S::max(z,limits.value[5][r]);
+      });
+      limits.store(lanes);
+   }
+
+   /**
+    * @brief Minimum squared length into channel 0 and maximum into channel 1, skipping NaN lengths
+    */
+   template<class S>
+   void squaredLengthBounds(const double *x, const double *y, const double *z, std::size_t size, double *lanes)
+   {
+      Accumulator<S,2> limits(lanes);
+      double nan=std::numeric_limits<double>::quiet_NaN();
+      forEachLaneGroup<S>(x,y,z,size,nan,nan,nan,[&](std::size_t r, typename S::Type x, typename S::Type y, typename S::Type z)
+      {
+         typename S::Type value=squared<S>(x,y,z);
+         limits.value[0][r]=S::min(value,limits.value[0][r]);
+         limits.value[1][r]=S::max(value,limits.value[1][r]);
+      });
+      limits.store(lanes);
+   }
+
+   template<class S>
+   constexpr Table makeTable(const char *name)
+   {
+      return Table{name,&add<S>,&subtract<S>,&translate<S>,&scale<S>,&rotate<S>,&transform<S>,&length<S>,&distance<S>,&angleCosine<S>,&angleCosines<S>,
+                   &dot<S>,&dotVector<S>,&cross<S>,&project<S>,&reject<S>,&setLength<S>,&isZero<S>,&isNaN<S>,&toSpherical<S>,&fromSpherical<S>,&toCylindrical<S>,&fromCylindrical<S>,&filterMask<S>,&compact<S>,
+                   &sum<S>,&compensatedSum<S>,&moments<S>,&compensatedMoments<S>,&bounds<S>,&squaredLengthBounds<S>};
+   }
+}
+
+#endif // VECTOR3DKERNELS_H
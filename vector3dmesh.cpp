@@ -0,0 +1,142 @@
+#include "vector3dmesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+   bool isValid(const Vector3DArrayConstView &vertices, std::span<const std::uint32_t> indices)
+   {
+      return indices.size()%3==0 && std::all_of(indices.begin(),indices.end(),[&vertices](std::uint32_t index) { return index<vertices.size(); });
+   }
+
+   /**
+    * @brief Runs function(face,a,b,c) over the faces and their vertices
+    */
+   template<class Function>
+   void forEachFace(const Vector3DExecution &execution, const Vector3DArrayConstView &vertices, std::span<const std::uint32_t> indices, Function function)
+   {
+      execution.forEachRange(indices.size()/3,[&](std::size_t offset, std::size_t count)
+      {
+         for(std::size_t face=offset;face<offset+count;face++)
+         {
+            function(face,vertices[indices[3*face]],vertices[indices[3*face+1]],vertices[indices[3*face+2]]);
+         }
+      });
+   }
+
+   /**
+    * @brief Scales a non-zero normal that setLength() would take for zero by the power of two that brings its largest
+    * component near one, exactly, so tiny faces still get a unit normal. Other normals are returned unchanged.
+    */
+   Vector3D scaledUp(const Vector3D &normal)
+   {
+      if(!normal.isZero() || (normal.x()==0.0 && normal.y()==0.0 && normal.z()==0.0)) return normal;
+      int exponent=std::ilogb(std::max({std::fabs(normal.x()),std::fabs(normal.y()),std::fabs(normal.z())}));
+      return Vector3D(std::ldexp(normal.x(),-exponent),std::ldexp(normal.y(),-exponent),std::ldexp(normal.z(),-exponent));
+   }
+
+   /**
+    * @brief The normal a face adds to its vertices: the cross product for area weights, the unit normal for angle
+    * weights, with the corner angles in angles. Degenerate faces add nothing to angle weighted normals.
+    */
+   Vector3D faceNormal(const Vector3D &a, const Vector3D &b, const Vector3D &c, Vector3DMesh::Weighting weighting, double *angles)
+   {
+      Vector3D normal=(b-a).cross(c-a);
+      if(weighting==Vector3DMesh::Angle)
+      {
+         normal=scaledUp(normal);
+         bool degenerate=!normal.setLength(1.0,Vector3D::Precise);
+         angles[0]=degenerate ? 0.0 : (b-a).angle(c-a,Vector3D::Radians,Vector3D::Precise);
+         angles[1]=degenerate ? 0.0 : (c-b).angle(a-b,Vector3D::Radians,Vector3D::Precise);
+         angles[2]=degenerate ? 0.0 : (a-c).angle(b-c,Vector3D::Radians,Vector3D::Precise);
+      }
+      return normal;
+   }
+
+   Vector3D cornerNormal(const Vector3D &normal, double angle, Vector3DMesh::Weighting weighting)
+   {
+      return weighting==Vector3DMesh::Angle ? normal*angle : normal;
+   }
+
+   /**
+    * @brief The face corners of every vertex in face order, as positions in the index buffer: the corners of vertex v
+    * are corners[offsets[v]] to corners[offsets[v+1]-1]. Built by a counting sort, one pass to count and one to place.
+    */
+   struct Adjacency
+   {
+      std::vector<std::uint32_t> offsets;
+      std::vector<std::uint32_t> corners;
+
+      Adjacency(std::size_t vertices, std::span<const std::uint32_t> indices) : offsets(vertices+1), corners(indices.size())
+      {
+         for(std::uint32_t index : indices) offsets[index+1]++;
+         for(std::size_t vertex=0;vertex<vertices;vertex++) offsets[vertex+1]+=offsets[vertex];
+         std::vector<std::uint32_t> next(offsets.begin(),offsets.end()-1);
+         for(std::size_t corner=0;corner<indices.size();corner++) corners[next[indices[corner]]++]=static_cast<std::uint32_t>(corner);
+      }
+   };
+}
+
+bool Vector3DMesh::faceNormals(Vector3DArrayConstView vertices, std::span<const std::uint32_t> indices, Vector3DArrayView normals)
+{
+   return faceNormals(Vector3DExecution::sequential(),vertices,indices,normals);
+}
+
+bool Vector3DMesh::faceNormals(const Vector3DExecution &execution, Vector3DArrayConstView vertices, std::span<const std::uint32_t> indices, Vector3DArrayView normals)
+{
+   if(indices.size()!=3*normals.size() || !isValid(vertices,indices)) return false;
+   forEachFace(execution,vertices,indices,[&normals](std::size_t face, const Vector3D &a, const Vector3D &b, const Vector3D &c)
+   {
+      normals.set(face,scaledUp((b-a).cross(c-a)));
+   });
+   return Vector3DBatch::setLength(execution,normals,1.0,normals);
+}
+
+bool Vector3DMesh::vertexNormals(Vector3DArrayConstView vertices, std::span<const std::uint32_t> indices, Vector3DArrayView normals, Weighting weighting)
+{
+   return vertexNormals(Vector3DExecution::sequential(),vertices,indices,normals,weighting);
+}
+
+bool Vector3DMesh::vertexNormals(const Vector3DExecution &execution, Vector3DArrayConstView vertices, std::span<const std::uint32_t> indices, Vector3DArrayView normals, Weighting weighting)
+{
+   if(vertices.size()!=normals.size() || !isValid(vertices,indices)) return false;
+   if(!execution.isParallel())
+   {
+      // scattering in face order adds the same terms in the same order as the gather below
+      for(std::size_t vertex=0;vertex<normals.size();vertex++) normals.set(vertex,Vector3D());
+      for(std::size_t face=0;face<indices.size()/3;face++)
+      {
+         const std::uint32_t *corner=indices.data()+3*face;
+         double angles[3]={};
+         Vector3D normal=faceNormal(vertices[corner[0]],vertices[corner[1]],vertices[corner[2]],weighting,angles);
+         for(std::size_t i=0;i<3;i++) normals.set(corner[i],normals[corner[i]]+cornerNormal(normal,angles[i],weighting));
+      }
+      for(std::size_t vertex=0;vertex<normals.size();vertex++) normals.set(vertex,scaledUp(normals[vertex]));
+      return Vector3DBatch::setLength(normals,1.0,normals);
+   }
+
+   std::vector<Vector3D> faces(indices.size()/3);
+   std::vector<double> angles(weighting==Angle ? indices.size() : 0);
+   forEachFace(execution,vertices,indices,[&](std::size_t face, const Vector3D &a, const Vector3D &b, const Vector3D &c)
+   {
+      faces[face]=faceNormal(a,b,c,weighting,weighting==Angle ? angles.data()+3*face : nullptr);
+   });
+
+   Adjacency adjacency(vertices.size(),indices);
+   execution.forEachRange(vertices.size(),[&](std::size_t offset, std::size_t count)
+   {
+      for(std::size_t vertex=offset;vertex<offset+count;vertex++)
+      {
+         Vector3D sum;
+         for(std::uint32_t i=adjacency.offsets[vertex];i<adjacency.offsets[vertex+1];i++)
+         {
+            std::uint32_t corner=adjacency.corners[i];
+            sum+=cornerNormal(faces[corner/3],weighting==Angle ? angles[corner] : 0.0,weighting);
+         }
+         normals.set(vertex,scaledUp(sum));
+      }
+   });
+   return Vector3DBatch::setLength(execution,normals,1.0,normals);
+}
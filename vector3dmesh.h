@@ -0,0 +1,32 @@
+#ifndef VECTOR3DMESH_H
+#define VECTOR3DMESH_H
+
+#include "vector3d.h"
+#include "vector3darray.h"
+#include "vector3dexecution.h"
+
+#include <cstdint>
+#include <span>
+
+/**
+ * @brief Normals of triangle meshes given as a vertex buffer and a triangle list index buffer, three vertex indices
+ * per face in counter-clockwise order. Face normals follow the right-hand rule, are unit length and zero for
+ * degenerate faces, whose cross product is exactly zero; faces of any non-zero size get a unit normal. Vertex normals add up the faces around every vertex in face order, weighted by face area or by
+ * the angle of the face at the vertex, and are normalized; vertices without faces get a zero normal. Sequential
+ * policies scatter the faces into their vertices. Parallel ones group the face corners by vertex with a counting sort
+ * and let every vertex gather its own, so no two threads write the same normal. Both add in face order, so results
+ * do not depend on the policy.
+ * Functions return false, without touching the output, when the sizes do not match or an index is out of range.
+ */
+namespace Vector3DMesh
+{
+   enum Weighting {Area,Angle};
+
+   bool faceNormals(Vector3DArrayConstView vertices, std::span<const std::uint32_t> indices, Vector3DArrayView normals);
+   bool faceNormals(const Vector3DExecution &execution, Vector3DArrayConstView vertices, std::span<const std::uint32_t> indices, Vector3DArrayView normals);
+
+   bool vertexNormals(Vector3DArrayConstView vertices, std::span<const std::uint32_t> indices, Vector3DArrayView normals, Weighting weighting=Area);
+   bool vertexNormals(const Vector3DExecution &execution, Vector3DArrayConstView vertices, std::span<const std::uint32_t> indices, Vector3DArrayView normals, Weighting weighting=Area);
+}
+
+#endif // VECTOR3DMESH_H
@@ -0,0 +1,83 @@
+#ifndef VECTOR3DRADIXSORT_H
+#define VECTOR3DRADIXSORT_H
+
+#include "vector3dexecution.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Parallel stable radix sort shared by the spatial modules, on entries carrying an unsigned integer key
+ */
+namespace Vector3DRadixSort
+{
+   /**
+    * @brief Runs function(part) for parts 0 to count-1, on the pool of a parallel policy
+    */
+   template<class Function>
+   void forEachPart(const Vector3DExecution &execution, std::size_t count, Function function)
+   {
+      if(!execution.isParallel() || count<2)
+      {
+         for(std::size_t part=0;part<count;part++) function(part);
+         return;
+      }
+      execution.pool()->parallelFor(count,1,[&](std::size_t offset, std::size_t size)
+      {
+         for(std::size_t part=offset;part<offset+size;part++) function(part);
+      });
+   }
+
+   /**
+    * @brief Stable least significant digit radix sort on the low bits of entry.*key. Every part histograms and
+    * scatters its own range, so the threads never share a counter. Digits every entry has in common are skipped.
+    */
+   template<class Entry, class Key>
+   void sort(const Vector3DExecution &execution, std::vector<Entry> &entries, Key Entry::*key, unsigned bits)
+   {
+      constexpr unsigned digitBits=8;
+      constexpr std::size_t digits=std::size_t(1)<<digitBits;
+      std::size_t size=entries.size(),parts=1;
+      if(execution.isParallel()) parts=std::clamp<std::size_t>(size/execution.grain(),1,4*execution.pool()->size());
+      std::vector<Entry> buffer(size);
+      std::vector<std::size_t> counts(parts*digits);
+      auto range=[&](std::size_t part) { return std::pair<std::size_t,std::size_t>(size*part/parts,size*(part+1)/parts); };
+
+      for(unsigned shift=0;shift<bits;shift+=digitBits)
+      {
+         forEachPart(execution,parts,[&](std::size_t part)
+         {
+            std::size_t *count=counts.data()+part*digits;
+            std::fill(count,count+digits,0);
+            auto [first,last]=range(part);
+            for(std::size_t i=first;i<last;i++) count[(entries[i].*key>>shift)&(digits-1)]++;
+         });
+         std::size_t offset=0;
+         bool common=false;
+         for(std::size_t digit=0;digit<digits;digit++)
+         {
+            std::size_t total=0;
+            for(std::size_t part=0;part<parts;part++)
+            {
+               std::size_t count=counts[part*digits+digit];
+               counts[part*digits+digit]=offset;
+               offset+=count;
+               total+=count;
+            }
+            common=common || total==size;
+         }
+         if(common) continue;
+         forEachPart(execution,parts,[&](std::size_t part)
+         {
+            std::size_t *position=counts.data()+part*digits;
+            auto [first,last]=range(part);
+            for(std::size_t i=first;i<last;i++) buffer[position[(entries[i].*key>>shift)&(digits-1)]++]=entries[i];
+         });
+         entries.swap(buffer);
+      }
+   }
+}
+
+#endif // VECTOR3DRADIXSORT_H
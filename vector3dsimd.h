@@ -0,0 +1,155 @@
+#ifndef VECTOR3DSIMD_H
+#define VECTOR3DSIMD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(__AVX2__) || defined(__AVX512F__)
+   #include <immintrin.h>
+#endif
+
+/**
+ * @brief Thin wrappers over the double precision SIMD registers of one instruction set,
+ * used to write the batch kernels once and instantiate them per instruction set.
+ * Every wrapper is only defined when the translation unit is compiled for its instruction set.
+ * min() and max() follow the x86 rule: the second operand is returned if either is NaN.
+ * compress() stores the lanes whose keep bit is set packed at data, the lanes above them are written with junk.
+ */
+namespace Vector3DSimd
+{
+   struct Scalar
+   {
+      using Type=double;
+      using Mask=bool;
+      static constexpr std::size_t width=1;
+
+      static inline Type set(double value) { return value; }
+      static inline Type load(const double *data) { return *data; }
+      static inline void store(double *data, Type value) { *data=value; }
+
+      static inline Type add(Type a, Type b) { return a+b; }
+      static inline Type sub(Type a, Type b) { return a-b; }
+      static inline Type mul(Type a, Type b) { return a*b; }
+      static inline Type div(Type a, Type b) { return a/b; }
+      static inline Type sqrt(Type a) { return std::sqrt(a); }
+      static inline Type min(Type a, Type b) { return a<b ? a : b; }
+      static inline Type max(Type a, Type b) { return a>b ? a : b; }
+      static inline Type abs(Type a) { return std::fabs(a); }
+
+      static inline Mask less(Type a, Type b) { return a<b; }
+      static inline Mask notLess(Type a, Type b) { return !(a<b); }
+      static inline Mask isNaN(Type a) { return a!=a; }
+      static inline Mask maskAnd(Mask a, Mask b) { return a && b; }
+      static inline Mask maskOr(Mask a, Mask b) { return a || b; }
+      static inline Type select(Mask mask, Type a, Type b) { return mask ? a : b; }
+      static inline unsigned bits(Mask mask) { return mask ? 1u : 0u; }
+      static inline void compress(double *data, Type value, unsigned) { *data=value; }
+   };
+
+#ifdef __SSE2__
+   struct SSE2
+   {
+      using Type=__m128d;
+      using Mask=__m128d;
+      static constexpr std::size_t width=2;
+
+      static inline Type set(double value) { return _mm_set1_pd(value); }
+      static inline Type load(const double *data) { return _mm_loadu_pd(data); }
+      static inline void store(double *data, Type value) { _mm_storeu_pd(data,value); }
+
+      static inline Type add(Type a, Type b) { return _mm_add_pd(a,b); }
+      static inline Type sub(Type a, Type b) { return _mm_sub_pd(a,b); }
+      static inline Type mul(Type a, Type b) { return _mm_mul_pd(a,b); }
+      static inline Type div(Type a, Type b) { return _mm_div_pd(a,b); }
+      static inline Type sqrt(Type a) { return _mm_sqrt_pd(a); }
+      static inline Type min(Type a, Type b) { return _mm_min_pd(a,b); }
+      static inline Type max(Type a, Type b) { return _mm_max_pd(a,b); }
+      static inline Type abs(Type a) { return _mm_andnot_pd(_mm_set1_pd(-0.0),a); }
+
+      static inline Mask less(Type a, Type b) { return _mm_cmplt_pd(a,b); }
+      static inline Mask notLess(Type a, Type b) { return _mm_cmpnlt_pd(a,b); }
+      static inline Mask isNaN(Type a) { return _mm_cmpunord_pd(a,a); }
+      static inline Mask maskAnd(Mask a, Mask b) { return _mm_and_pd(a,b); }
+      static inline Mask maskOr(Mask a, Mask b) { return _mm_or_pd(a,b); }
+      static inline Type select(Mask mask, Type a, Type b) { return _mm_or_pd(_mm_and_pd(mask,a),_mm_andnot_pd(mask,b)); }
+      static inline unsigned bits(Mask mask) { return static_cast<unsigned>(_mm_movemask_pd(mask)); }
+      static inline void compress(double *data, Type value, unsigned keep) { _mm_storeu_pd(data,keep==2 ? _mm_unpackhi_pd(value,value) : value); }
+   };
+#endif
+
+#ifdef __AVX2__
+   struct AVX2
+   {
+      using Type=__m256d;
+      using Mask=__m256d;
+      static constexpr std::size_t width=4;
+
+      static inline Type set(double value) { return _mm256_set1_pd(value); }
+      static inline Type load(const double *data) { return _mm256_loadu_pd(data); }
+      static inline void store(double *data, Type value) { _mm256_storeu_pd(data,value); }
+
+      static inline Type add(Type a, Type b) { return _mm256_add_pd(a,b); }
+      static inline Type sub(Type a, Type b) { return _mm256_sub_pd(a,b); }
+      static inline Type mul(Type a, Type b) { return _mm256_mul_pd(a,b); }
+      static inline Type div(Type a, Type b) { return _mm256_div_pd(a,b); }
+      static inline Type sqrt(Type a) { return _mm256_sqrt_pd(a); }
+      static inline Type min(Type a, Type b) { return _mm256_min_pd(a,b); }
+      static inline Type max(Type a, Type b) { return _mm256_max_pd(a,b); }
+      static inline Type abs(Type a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0),a); }
+
+      static inline Mask less(Type a, Type b) { return _mm256_cmp_pd(a,b,_CMP_LT_OQ); }
+      static inline Mask notLess(Type a, Type b) { return _mm256_cmp_pd(a,b,_CMP_NLT_UQ); }
+      static inline Mask isNaN(Type a) { return _mm256_cmp_pd(a,a,_CMP_UNORD_Q); }
+      static inline Mask maskAnd(Mask a, Mask b) { return _mm256_and_pd(a,b); }
+      static inline Mask maskOr(Mask a, Mask b) { return _mm256_or_pd(a,b); }
+      static inline Type select(Mask mask, Type a, Type b) { return _mm256_blendv_pd(b,a,mask); }
+      static inline unsigned bits(Mask mask) { return static_cast<unsigned>(_mm256_movemask_pd(mask)); }
+      static inline void compress(double *data, Type value, unsigned keep)
+      {
+         __m256i indices=_mm256_load_si256(reinterpret_cast<const __m256i*>(compressIndices[keep]));
+         _mm256_storeu_pd(data,_mm256_castsi256_pd(_mm256_permutevar8x32_epi32(_mm256_castpd_si256(value),indices)));
+      }
+
+      // 32-bit halves of the kept lanes first, for every 4-bit keep mask
+      alignas(32) static constexpr std::int32_t compressIndices[16][8]={
+         {0,1,2,3,4,5,6,7},{0,1,2,3,4,5,6,7},{2,3,0,1,4,5,6,7},{0,1,2,3,4,5,6,7},
+         {4,5,0,1,2,3,6,7},{0,1,4,5,2,3,6,7},{2,3,4,5,0,1,6,7},{0,1,2,3,4,5,6,7},
+         {6,7,0,1,2,3,4,5},{0,1,6,7,2,3,4,5},{2,3,6,7,0,1,4,5},{0,1,2,3,6,7,4,5},
+         {4,5,6,7,0,1,2,3},{0,1,4,5,6,7,2,3},{2,3,4,5,6,7,0,1},{0,1,2,3,4,5,6,7}};
+   };
+#endif
+
+#ifdef __AVX512F__
+   struct AVX512
+   {
+      using Type=__m512d;
+      using Mask=__mmask8;
+      static constexpr std::size_t width=8;
+
+      static inline Type set(double value) { return _mm512_set1_pd(value); }
+      static inline Type load(const double *data) { return _mm512_loadu_pd(data); }
+      static inline void store(double *data, Type value) { _mm512_storeu_pd(data,value); }
+
+      static inline Type add(Type a, Type b) { return _mm512_add_pd(a,b); }
+      static inline Type sub(Type a, Type b) { return _mm512_sub_pd(a,b); }
+      static inline Type mul(Type a, Type b) { return _mm512_mul_pd(a,b); }
+      static inline Type div(Type a, Type b) { return _mm512_div_pd(a,b); }
+      static inline Type sqrt(Type a) { return _mm512_sqrt_pd(a); }
+      static inline Type min(Type a, Type b) { return _mm512_min_pd(a,b); }
+      static inline Type max(Type a, Type b) { return _mm512_max_pd(a,b); }
+      static inline Type abs(Type a) { return _mm512_abs_pd(a); }
+
+      static inline Mask less(Type a, Type b) { return _mm512_cmp_pd_mask(a,b,_CMP_LT_OQ); }
+      static inline Mask notLess(Type a, Type b) { return _mm512_cmp_pd_mask(a,b,_CMP_NLT_UQ); }
+      static inline Mask isNaN(Type a) { return _mm512_cmp_pd_mask(a,a,_CMP_UNORD_Q); }
+      static inline Mask maskAnd(Mask a, Mask b) { return static_cast<Mask>(a & b); }
+      static inline Mask maskOr(Mask a, Mask b) { return static_cast<Mask>(a | b); }
+      static inline Type select(Mask mask, Type a, Type b) { return _mm512_mask_blend_pd(mask,b,a); }
+      static inline unsigned bits(Mask mask) { return static_cast<unsigned>(mask); }
+      static inline void compress(double *data, Type value, unsigned keep) { _mm512_storeu_pd(data,_mm512_maskz_compress_pd(static_cast<__mmask8>(keep),value)); }
+   };
+#endif
+}
+
+#endif // VECTOR3DSIMD_H
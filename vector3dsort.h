@@ -0,0 +1,141 @@
+#ifndef VECTOR3DSORT_H
+#define VECTOR3DSORT_H
+
+#include "vector3d.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Bulk ordering of Vector3D ranges by length or by distance to a point.
+ * The squared key of every element is computed once up front, the algorithm then runs on
+ * (key, index) pairs and the elements are moved into place in a single pass.
+ * Ties keep their original order and NaN keys sort last, so the result is fully deterministic.
+ */
+namespace Vector3DSort
+{
+namespace Detail
+{
+   template<class T>
+   struct Entry
+   {
+      T key;
+      std::size_t index;
+   };
+
+   template<class T>
+   inline bool isBefore(const Entry<T> &entry1, const Entry<T> &entry2)
+   {
+      if(entry1.key<entry2.key) return true;
+      if(entry2.key<entry1.key) return false;
+      bool isNaN1=entry1.key!=entry1.key,isNaN2=entry2.key!=entry2.key;
+      if(isNaN1!=isNaN2) return isNaN2;
+      return entry1.index<entry2.index;
+   }
+
+   enum Algorithm {Sort,PartialSort,NthElement};
+
+   template<class Iterator, class Key>
+   auto order(Iterator first, Iterator last, std::size_t position, Algorithm algorithm, Key key)
+   {
+      using T=decltype(key(*first));
+      std::size_t size=static_cast<std::size_t>(std::distance(first,last));
+      std::vector<Entry<T>> entries(size);
+      Iterator it=first;
+      for(std::size_t i=0;i<size;i++,++it) entries[i]={key(*it),i};
+
+      auto middle=entries.begin()+static_cast<std::ptrdiff_t>(position<size ? position : size);
+      switch(algorithm)
+      {
+         case PartialSort: std::partial_sort(entries.begin(),middle,entries.end(),isBefore<T>); break;
+         case NthElement: if(middle!=entries.end()) std::nth_element(entries.begin(),middle,entries.end(),isBefore<T>); break;
+         default: std::sort(entries.begin(),entries.end(),isBefore<T>); break;
+      }
+      return entries;
+   }
+
+   template<class Iterator, class Entries>
+   void permute(Iterator first, const Entries &entries)
+   {
+      using Value=typename std::iterator_traits<Iterator>::value_type;
+      std::vector<Value> sorted;
+      sorted.reserve(entries.size());
+      for(const auto &entry : entries) sorted.push_back(std::move(first[static_cast<std::ptrdiff_t>(entry.index)]));
+      std::move(sorted.begin(),sorted.end(),first);
+   }
+
+   template<class Iterator, class Key>
+   std::vector<std::size_t> indices(Iterator first, Iterator last, Key key)
+   {
+      auto entries=order(first,last,0,Sort,key);
+      std::vector<std::size_t> result(entries.size());
+      for(std::size_t i=0;i<entries.size();i++) result[i]=entries[i].index;
+      return result;
+   }
+
+   struct LengthKey
+   {
+      template<class Vector> auto operator()(const Vector &vector) const { return vector.lengthSquared(); }
+   };
+
+   template<class Vector>
+   struct DistanceKey
+   {
+      Vector point;
+      auto operator()(const Vector &vector) const { return vector.distanceSquared(point); }
+   };
+}
+
+   template<class Iterator>
+   void sortByLength(Iterator first, Iterator last)
+   {
+      Detail::permute(first,Detail::order(first,last,0,Detail::Sort,Detail::LengthKey()));
+   }
+
+   template<class Iterator>
+   void partialSortByLength(Iterator first, Iterator middle, Iterator last)
+   {
+      Detail::permute(first,Detail::order(first,last,static_cast<std::size_t>(std::distance(first,middle)),Detail::PartialSort,Detail::LengthKey()));
+   }
+
+   template<class Iterator>
+   void nthElementByLength(Iterator first, Iterator nth, Iterator last)
+   {
+      Detail::permute(first,Detail::order(first,last,static_cast<std::size_t>(std::distance(first,nth)),Detail::NthElement,Detail::LengthKey()));
+   }
+
+   template<class Iterator>
+   std::vector<std::size_t> orderByLength(Iterator first, Iterator last)
+   {
+      return Detail::indices(first,last,Detail::LengthKey());
+   }
+
+   template<class Iterator, class Vector>
+   void sortByDistance(Iterator first, Iterator last, const Vector &point)
+   {
+      Detail::permute(first,Detail::order(first,last,0,Detail::Sort,Detail::DistanceKey<Vector>{point}));
+   }
+
+   template<class Iterator, class Vector>
+   void partialSortByDistance(Iterator first, Iterator middle, Iterator last, const Vector &point)
+   {
+      Detail::permute(first,Detail::order(first,last,static_cast<std::size_t>(std::distance(first,middle)),Detail::PartialSort,Detail::DistanceKey<Vector>{point}));
+   }
+
+   template<class Iterator, class Vector>
+   void nthElementByDistance(Iterator first, Iterator nth, Iterator last, const Vector &point)
+   {
+      Detail::permute(first,Detail::order(first,last,static_cast<std::size_t>(std::distance(first,nth)),Detail::NthElement,Detail::DistanceKey<Vector>{point}));
+   }
+
+   template<class Iterator, class Vector>
+   std::vector<std::size_t> orderByDistance(Iterator first, Iterator last, const Vector &point)
+   {
+      return Detail::indices(first,last,Detail::DistanceKey<Vector>{point});
+   }
+}
+
+#endif // VECTOR3DSORT_H
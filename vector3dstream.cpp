@@ -0,0 +1,286 @@
+#include "vector3dstream.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+   /**
+    * @brief Runs a source on a dedicated thread, one chunk ahead of its consumer. The worker fills the source chunk
+    * while the previous one waits in the slot, and take() swaps the slot with the consumer chunk, so the three
+    * buffers are recycled rather than reallocated.
+    */
+   class Prefetcher
+   {
+      public:
+         explicit Prefetcher(Vector3DStream source);
+         ~Prefetcher();
+
+         Prefetcher(const Prefetcher &)=delete;
+         Prefetcher &operator=(const Prefetcher &)=delete;
+
+         bool take(Vector3DArray &chunk);
+         bool failed() const;
+
+      private:
+         void run();
+
+         Vector3DStream pSource;
+         Vector3DArray pSlot;
+         std::mutex pMutex;
+         std::condition_variable pChanged;
+         std::exception_ptr pException;
+         bool pReady;
+         bool pDone;
+         bool pFailed;
+         bool pStop;
+         std::thread pThread;
+   };
+
+   Prefetcher::Prefetcher(Vector3DStream source) : pSource(std::move(source)), pReady(false), pDone(false), pFailed(false), pStop(false), pThread(&Prefetcher::run,this)
+   {
+   }
+
+   Prefetcher::~Prefetcher()
+   {
+      {
+         std::lock_guard<std::mutex> lock(pMutex);
+         pStop=true;
+      }
+      pChanged.notify_all();
+      pThread.join();
+   }
+
+   bool Prefetcher::take(Vector3DArray &chunk)
+   {
+      std::unique_lock<std::mutex> lock(pMutex);
+      pChanged.wait(lock,[this] { return pReady || pDone; });
+      if(pReady)
+      {
+         std::swap(chunk,pSlot);
+         pReady=false;
+         lock.unlock();
+         pChanged.notify_all();
+         return true;
+      }
+      if(pException) std::rethrow_exception(std::exchange(pException,nullptr));
+      return false;
+   }
+
+   bool Prefetcher::failed() const
+   {
+      return pFailed;
+   }
+
+   void Prefetcher::run()
+   {
+      try
+      {
+         while(pSource.next())
+         {
+            std::unique_lock<std::mutex> lock(pMutex);
+            pChanged.wait(lock,[this] { return !pReady || pStop; });
+            if(pStop) return;
+            std::swap(pSlot,pSource.chunk());
+            pReady=true;
+            lock.unlock();
+            pChanged.notify_all();
+         }
+      } catch(...)
+      {
+         std::lock_guard<std::mutex> lock(pMutex);
+         pException=std::current_exception();
+      }
+      {
+         std::lock_guard<std::mutex> lock(pMutex);
+         pFailed=pException!=nullptr || pSource.failed();
+         pDone=true;
+      }
+      pChanged.notify_all();
+   }
+
+   Vector3DStream viewSource(Vector3DArrayConstView vectors, std::size_t chunkSize)
+   {
+      if(chunkSize==0) co_return false;
+      Vector3DArray chunk;
+      for(std::size_t offset=0;offset<vectors.size();offset+=chunkSize)
+      {
+         Vector3DArrayConstView part=vectors.subview(offset,std::min(chunkSize,vectors.size()-offset));
+         chunk.resize(part.size());
+         Vector3DBatch::copy(part,chunk);
+         co_yield chunk;
+      }
+      co_return true;
+   }
+
+   Vector3DStream fileSource(const Vector3DFile &file)
+   {
+      if(!file.isOpen()) co_return false;
+      Vector3DArray chunk;
+      for(std::size_t offset=0;offset<file.size();offset+=file.chunkSize())
+      {
+         chunk.resize(std::min(file.chunkSize(),file.size()-offset));
+         if(!file.read(offset,chunk)) co_return false;
+         co_yield chunk;
+      }
+      co_return true;
+   }
+
+   Vector3DStream dropStage(Vector3DStream source, Vector3DBatch::Filter filter)
+   {
+      while(source.next())
+      {
+         Vector3DBatch::compact(source.chunk(),filter);
+         co_yield source.chunk();
+      }
+      co_return !source.failed();
+   }
+
+   Vector3DStream rotateStage(Vector3DStream source, Rotation3D rotation, Vector3DExecution execution)
+   {
+      while(source.next())
+      {
+         Vector3DBatch::rotate(execution,source.chunk(),rotation,source.chunk());
+         co_yield source.chunk();
+      }
+      co_return !source.failed();
+   }
+
+   Vector3DStream scaleStage(Vector3DStream source, double factor, Vector3DExecution execution)
+   {
+      while(source.next())
+      {
+         Vector3DBatch::scale(execution,source.chunk(),factor,source.chunk());
+         co_yield source.chunk();
+      }
+      co_return !source.failed();
+   }
+
+   Vector3DStream translateStage(Vector3DStream source, Vector3D vector, Vector3DExecution execution)
+   {
+      while(source.next())
+      {
+         Vector3DBatch::add(execution,source.chunk(),vector,source.chunk());
+         co_yield source.chunk();
+      }
+      co_return !source.failed();
+   }
+
+   Vector3DStream transformStage(Vector3DStream source, Transform3D transform, Vector3DExecution execution)
+   {
+      while(source.next())
+      {
+         Vector3DBatch::transform(execution,source.chunk(),transform,source.chunk());
+         co_yield source.chunk();
+      }
+      co_return !source.failed();
+   }
+
+   Vector3DStream prefetchStage(Vector3DStream source)
+   {
+      Prefetcher prefetcher(std::move(source));
+      Vector3DArray chunk;
+      while(prefetcher.take(chunk)) co_yield chunk;
+      co_return !prefetcher.failed();
+   }
+}
+
+Vector3DStream Vector3DStream::fromView(Vector3DArrayConstView vectors, std::size_t chunkSize)
+{
+   return viewSource(vectors,chunkSize);
+}
+
+Vector3DStream Vector3DStream::fromFile(const Vector3DFile &file)
+{
+   return fileSource(file);
+}
+
+Vector3DStream Vector3DStream::dropNaN() &&
+{
+   return dropStage(std::move(*this),Vector3DBatch::DropNaN);
+}
+
+Vector3DStream Vector3DStream::dropZero() &&
+{
+   return dropStage(std::move(*this),Vector3DBatch::DropZero);
+}
+
+Vector3DStream Vector3DStream::rotate(const Rotation3D &rotation, const Vector3DExecution &execution) &&
+{
+   return rotateStage(std::move(*this),rotation,execution);
+}
+
+Vector3DStream Vector3DStream::scale(double factor, const Vector3DExecution &execution) &&
+{
+   return scaleStage(std::move(*this),factor,execution);
+}
+
+Vector3DStream Vector3DStream::translate(const Vector3D &vector, const Vector3DExecution &execution) &&
+{
+   return translateStage(std::move(*this),vector,execution);
+}
+
+Vector3DStream Vector3DStream::transform(const Transform3D &transform, const Vector3DExecution &execution) &&
+{
+   return transformStage(std::move(*this),transform,execution);
+}
+
+Vector3DStream Vector3DStream::prefetch() &&
+{
+   return prefetchStage(std::move(*this));
+}
+
+bool Vector3DStream::next()
+{
+   if(!pHandle || pHandle.done()) return false;
+   pHandle.resume();
+   promise_type &promise=pHandle.promise();
+   if(promise.exception) std::rethrow_exception(std::exchange(promise.exception,nullptr));
+   return !pHandle.done();
+}
+
+bool Vector3DStream::count(std::size_t &count)
+{
+   count=0;
+   while(next()) count+=chunk().size();
+   return !failed();
+}
+
+bool Vector3DStream::sum(Vector3D &sum, Vector3DBatch::Summation summation)
+{
+   sum=Vector3D(0,0,0);
+   while(next()) sum+=Vector3DBatch::sum(chunk(),summation);
+   return !failed();
+}
+
+bool Vector3DStream::collect(Vector3DArray &vectors)
+{
+   vectors.clear();
+   while(next())
+   {
+      std::size_t offset=vectors.size();
+      vectors.resize(offset+chunk().size());
+      Vector3DBatch::copy(chunk(),Vector3DArrayView(vectors).subview(offset,chunk().size()));
+   }
+   return !failed();
+}
+
+bool Vector3DStream::write(Vector3DFileWriter &writer)
+{
+   while(next())
+   {
+      if(!writer.append(chunk())) return false;
+   }
+   return !failed();
+}
+
+bool Vector3DStream::writeXYZ(std::ostream &out, int precision)
+{
+   while(next())
+   {
+      if(!Vector3DText::writeXYZ(out,chunk(),precision)) return false;
+   }
+   return !failed();
+}
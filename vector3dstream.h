@@ -0,0 +1,168 @@
+#ifndef VECTOR3DSTREAM_H
+#define VECTOR3DSTREAM_H
+
+#include "vector3d.h"
+#include "vector3darray.h"
+#include "vector3dexecution.h"
+#include "vector3dfile.h"
+#include "vector3dtext.h"
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <ostream>
+#include <utility>
+
+/**
+ * @brief The Vector3DStream class is a coroutine generator of Vector3DArray chunks, chaining sources, stages and sinks.
+ * Chunks are pulled one at a time, so a producer only runs when its consumer asks for the next chunk, and a pipeline
+ * holds a fixed number of chunks whatever the input size: one per source and two more per prefetch(). Stages work on
+ * their input chunk in place and may take its storage by swapping, so producers refill their chunk from scratch.
+ * A chunk stays valid until the next call to next(). Sinks drain the stream and return false when a source or stage
+ * failed, or when they fail themselves. Exceptions thrown inside a stage are rethrown by next().
+ */
+class Vector3DStream
+{
+   public:
+      struct promise_type;
+      using Handle=std::coroutine_handle<promise_type>;
+
+      static constexpr std::size_t defaultChunkSize=Vector3DFile::defaultChunkSize;
+
+      Vector3DStream();
+      Vector3DStream(Vector3DStream &&stream) noexcept;
+      Vector3DStream &operator=(Vector3DStream &&stream) noexcept;
+      ~Vector3DStream();
+
+      Vector3DStream(const Vector3DStream &)=delete;
+      Vector3DStream &operator=(const Vector3DStream &)=delete;
+
+      /**
+       * @brief Chunks of chunkSize vectors copied from a view, which must outlive the stream
+       */
+      static Vector3DStream fromView(Vector3DArrayConstView vectors, std::size_t chunkSize=defaultChunkSize);
+      /**
+       * @brief The file chunk by chunk, converted to double. The file must stay open for the life of the stream
+       */
+      static Vector3DStream fromFile(const Vector3DFile &file);
+      /**
+       * @brief Chunks filled by function(chunk), which returns false once there is nothing left
+       */
+      template<class Function>
+      static Vector3DStream generate(Function function);
+
+      Vector3DStream dropNaN() &&;
+      Vector3DStream dropZero() &&;
+      Vector3DStream rotate(const Rotation3D &rotation, const Vector3DExecution &execution=Vector3DExecution::sequential()) &&;
+      Vector3DStream scale(double factor, const Vector3DExecution &execution=Vector3DExecution::sequential()) &&;
+      Vector3DStream translate(const Vector3D &vector, const Vector3DExecution &execution=Vector3DExecution::sequential()) &&;
+      Vector3DStream transform(const Transform3D &transform, const Vector3DExecution &execution=Vector3DExecution::sequential()) &&;
+      /**
+       * @brief Runs function(chunk) on every chunk, stopping the stream as failed when it returns false
+       */
+      template<class Function>
+      Vector3DStream apply(Function function) &&;
+      /**
+       * @brief Produces the next chunk on a background thread while the consumer works on the current one
+       */
+      Vector3DStream prefetch() &&;
+
+      /**
+       * @brief Runs the pipeline up to the next chunk, false at the end of the stream
+       */
+      bool next();
+      Vector3DArray &chunk() const;
+      bool failed() const;
+
+      bool count(std::size_t &count);
+      bool sum(Vector3D &sum, Vector3DBatch::Summation summation=Vector3DBatch::Simple);
+      bool collect(Vector3DArray &vectors);
+      bool write(Vector3DFileWriter &writer);
+      bool writeXYZ(std::ostream &out, int precision=Vector3DText::shortest);
+
+   private:
+      explicit Vector3DStream(Handle handle);
+
+      Handle pHandle;
+
+      template<class Function>
+      static Vector3DStream applyStage(Vector3DStream source, Function function);
+};
+
+struct Vector3DStream::promise_type
+{
+   Vector3DArray *chunk=nullptr;
+   bool failed=false;
+   std::exception_ptr exception;
+
+   Vector3DStream get_return_object() { return Vector3DStream(Handle::from_promise(*this)); }
+   std::suspend_always initial_suspend() noexcept { return {}; }
+   std::suspend_always final_suspend() noexcept { return {}; }
+   std::suspend_always yield_value(Vector3DArray &chunk) noexcept { this->chunk=&chunk; return {}; }
+   void return_value(bool succeeded) { failed=!succeeded; }
+   void unhandled_exception() { exception=std::current_exception(); failed=true; }
+};
+
+inline Vector3DStream::Vector3DStream() : pHandle(nullptr)
+{
+}
+
+inline Vector3DStream::Vector3DStream(Handle handle) : pHandle(handle)
+{
+}
+
+inline Vector3DStream::Vector3DStream(Vector3DStream &&stream) noexcept : pHandle(std::exchange(stream.pHandle,nullptr))
+{
+}
+
+inline Vector3DStream &Vector3DStream::operator=(Vector3DStream &&stream) noexcept
+{
+   if(this!=&stream)
+   {
+      if(pHandle) pHandle.destroy();
+      pHandle=std::exchange(stream.pHandle,nullptr);
+   }
+   return *this;
+}
+
+inline Vector3DStream::~Vector3DStream()
+{
+   if(pHandle) pHandle.destroy();
+}
+
+inline Vector3DArray &Vector3DStream::chunk() const
+{
+   return *pHandle.promise().chunk;
+}
+
+inline bool Vector3DStream::failed() const
+{
+   return pHandle && pHandle.promise().failed;
+}
+
+template<class Function>
+Vector3DStream Vector3DStream::generate(Function function)
+{
+   Vector3DArray chunk;
+   while(function(chunk)) co_yield chunk;
+   co_return true;
+}
+
+template<class Function>
+Vector3DStream Vector3DStream::apply(Function function) &&
+{
+   return applyStage(std::move(*this),std::move(function));
+}
+
+template<class Function>
+Vector3DStream Vector3DStream::applyStage(Vector3DStream source, Function function)
+{
+   while(source.next())
+   {
+      if(!function(source.chunk())) co_return false;
+      co_yield source.chunk();
+   }
+   co_return !source.failed();
+}
+
+#endif // VECTOR3DSTREAM_H
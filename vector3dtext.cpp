@@ -0,0 +1,132 @@
+#include "vector3dtext.h"
+#include "vector3darray.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace
+{
+   constexpr std::size_t readBlock=1<<20;
+   constexpr std::size_t writeBlock=1<<16;
+
+   bool write(std::ostream &out, Vector3DArrayConstView vectors, int precision, char separator)
+   {
+      std::size_t numberSize=precision<0 ? 32 : std::numeric_limits<double>::max_exponent10+static_cast<std::size_t>(precision)+8;
+      std::size_t rowSize=3*numberSize+3;
+      std::vector<char> buffer(std::max(writeBlock,4*rowSize));
+      char *begin=buffer.data(),*end=begin+buffer.size(),*position=begin;
+      for(std::size_t i=0;i<vectors.size() && out;i++)
+      {
+         if(static_cast<std::size_t>(end-position)<rowSize)
+         {
+            out.write(begin,position-begin);
+            position=begin;
+         }
+         Vector3D vector=vectors[i];
+         position=Vector3DText::Detail::number(position,end,vector.x(),precision).ptr;
+         *position++=separator;
+         position=Vector3DText::Detail::number(position,end,vector.y(),precision).ptr;
+         *position++=separator;
+         position=Vector3DText::Detail::number(position,end,vector.z(),precision).ptr;
+         *position++='\n';
+      }
+      out.write(begin,position-begin);
+      return static_cast<bool>(out);
+   }
+
+   /**
+    * @brief Parses one line into vectors, returns false when it is malformed.
+    * header is cleared by the first line holding data, a CSV line before it that does not parse is skipped.
+    */
+   bool readLine(const char *first, const char *last, bool csv, bool &header, Vector3DArray &vectors)
+   {
+      if(first<last && last[-1]=='\r') last--;
+      const char *position=Vector3DText::Detail::skipSpaces(first,last);
+      if(position==last || *position=='#') return true;
+
+      double values[3];
+      for(int i=0;i<3;i++)
+      {
+         std::from_chars_result result=Vector3DText::Detail::number(position,last,values[i]);
+         bool valid=result.ec==std::errc();
+         position=result.ptr;
+         if(valid && i<2)
+         {
+            if(csv)
+            {
+               position=Vector3DText::Detail::skipSpaces(position,last);
+               valid=position<last && *position==',';
+               if(valid) position=Vector3DText::Detail::skipSpaces(position+1,last);
+            } else
+            {
+               const char *next=Vector3DText::Detail::skipSpaces(position,last);
+               valid=next>position;
+               position=next;
+            }
+         }
+         if(!valid)
+         {
+            bool skip=csv && header;
+            header=false;
+            return skip;
+         }
+      }
+      header=false;
+
+      const char *next=Vector3DText::Detail::skipSpaces(position,last);
+      if(next<last && (csv ? *next!=',' : next==position)) return false;
+      vectors.append(Vector3D(values[0],values[1],values[2]));
+      return true;
+   }
+
+   bool read(std::istream &in, Vector3DArray &vectors, bool csv)
+   {
+      std::vector<char> buffer(readBlock);
+      std::size_t used=0;
+      bool header=csv;
+      while(true)
+      {
+         if(used==buffer.size()) buffer.resize(buffer.size()*2);
+         in.read(buffer.data()+used,static_cast<std::streamsize>(buffer.size()-used));
+         used+=static_cast<std::size_t>(in.gcount());
+         bool finished=!in;
+
+         const char *first=buffer.data(),*last=first+used;
+         while(first<last)
+         {
+            const char *newline=static_cast<const char*>(std::memchr(first,'\n',static_cast<std::size_t>(last-first)));
+            if(newline==nullptr)
+            {
+               if(!finished) break;
+               newline=last;
+            }
+            if(!readLine(first,newline,csv,header,vectors)) return false;
+            first=newline<last ? newline+1 : last;
+         }
+         if(finished) return !in.bad();
+         used=static_cast<std::size_t>(last-first);
+         std::memmove(buffer.data(),first,used);
+      }
+   }
+}
+
+bool Vector3DText::writeXYZ(std::ostream &out, Vector3DArrayConstView vectors, int precision)
+{
+   return write(out,vectors,precision,' ');
+}
+
+bool Vector3DText::writeCSV(std::ostream &out, Vector3DArrayConstView vectors, int precision)
+{
+   return write(out,vectors,precision,',');
+}
+
+bool Vector3DText::readXYZ(std::istream &in, Vector3DArray &vectors)
+{
+   return read(in,vectors,false);
+}
+
+bool Vector3DText::readCSV(std::istream &in, Vector3DArray &vectors)
+{
+   return read(in,vectors,true);
+}
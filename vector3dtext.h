@@ -0,0 +1,161 @@
+#ifndef VECTOR3DTEXT_H
+#define VECTOR3DTEXT_H
+
+#include "vector3d.h"
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <system_error>
+
+class Vector3DArray;
+class Vector3DArrayConstView;
+
+/**
+ * @brief Allocation-free text conversion of vectors built on std::to_chars and std::from_chars.
+ * Single vectors use the operator<< form "Vector3D(x,y,z)", optionally followed by ", length=l".
+ * Arrays are read and written as XYZ (whitespace separated) or CSV lines of three numbers.
+ * A precision of shortest gives the shortest text that reads back to the same value,
+ * any other precision gives that many fixed decimals.
+ */
+namespace Vector3DText
+{
+   constexpr int shortest=-1;
+
+   struct Format
+   {
+      int precision=shortest;
+      bool length=false;
+   };
+
+   template<class T>
+   std::to_chars_result toChars(char *first, char *last, const BasicVector3D<T> &vector, Format format=Format());
+   template<class T>
+   std::from_chars_result fromChars(const char *first, const char *last, BasicVector3D<T> &vector);
+   template<class T>
+   std::string toString(const BasicVector3D<T> &vector, Format format=Format());
+
+   /**
+    * @brief Writes one line per vector, returns false when the stream fails
+    */
+   bool writeXYZ(std::ostream &out, Vector3DArrayConstView vectors, int precision=shortest);
+   bool writeCSV(std::ostream &out, Vector3DArrayConstView vectors, int precision=shortest);
+
+   /**
+    * @brief Appends the vectors of every line to vectors, skipping blank lines, lines starting with '#'
+    * and, for CSV, a header line. Extra columns are ignored. Returns false at the first malformed line,
+    * with the vectors read so far appended.
+    */
+   bool readXYZ(std::istream &in, Vector3DArray &vectors);
+   bool readCSV(std::istream &in, Vector3DArray &vectors);
+
+   namespace Detail
+   {
+      template<class T>
+      std::to_chars_result number(char *first, char *last, T value, int precision)
+      {
+         if(precision<0) return std::to_chars(first,last,value);
+         return std::to_chars(first,last,value,std::chars_format::fixed,precision);
+      }
+
+      template<class T>
+      std::from_chars_result number(const char *first, const char *last, T &value)
+      {
+         if(first<last && *first=='+')
+         {
+            if(last-first>1 && first[1]=='-') return {first,std::errc::invalid_argument};
+            first++;
+         }
+         return std::from_chars(first,last,value);
+      }
+
+      inline std::to_chars_result literal(char *first, char *last, const char *text, std::size_t size)
+      {
+         if(static_cast<std::size_t>(last-first)<size) return {last,std::errc::value_too_large};
+         std::memcpy(first,text,size);
+         return {first+size,std::errc()};
+      }
+
+      inline const char *skipSpaces(const char *first, const char *last)
+      {
+         while(first<last && (*first==' ' || *first=='\t')) first++;
+         return first;
+      }
+
+      inline const char *skipLiteral(const char *first, const char *last, const char *text)
+      {
+         std::size_t size=std::strlen(text);
+         if(static_cast<std::size_t>(last-first)<size || std::memcmp(first,text,size)!=0) return nullptr;
+         return first+size;
+      }
+   }
+}
+
+template<class T>
+std::to_chars_result Vector3DText::toChars(char *first, char *last, const BasicVector3D<T> &vector, Format format)
+{
+   std::to_chars_result result=Detail::literal(first,last,"Vector3D(",9);
+   const T values[3]={vector.x(),vector.y(),vector.z()};
+   for(int i=0;i<3 && result.ec==std::errc();i++)
+   {
+      if(i>0) result=Detail::literal(result.ptr,last,",",1);
+      if(result.ec==std::errc()) result=Detail::number(result.ptr,last,values[i],format.precision);
+   }
+   if(format.length && result.ec==std::errc())
+   {
+      result=Detail::literal(result.ptr,last,", length=",9);
+      if(result.ec==std::errc()) result=Detail::number(result.ptr,last,vector.length(),format.precision);
+   }
+   if(result.ec==std::errc()) result=Detail::literal(result.ptr,last,")",1);
+   if(result.ec!=std::errc()) return {last,std::errc::value_too_large};
+   return result;
+}
+
+template<class T>
+std::from_chars_result Vector3DText::fromChars(const char *first, const char *last, BasicVector3D<T> &vector)
+{
+   const std::from_chars_result failure={first,std::errc::invalid_argument};
+   const char *position=Detail::skipLiteral(first,last,"Vector3D(");
+   T values[3];
+   for(int i=0;i<3;i++)
+   {
+      if(position==nullptr) return failure;
+      if(i>0) position=Detail::skipLiteral(position,last,",");
+      if(position==nullptr) return failure;
+      std::from_chars_result result=Detail::number(Detail::skipSpaces(position,last),last,values[i]);
+      if(result.ec!=std::errc()) return {first,result.ec};
+      position=result.ptr;
+   }
+   if(const char *length=Detail::skipLiteral(position,last,", length="))
+   {
+      T value;
+      std::from_chars_result result=Detail::number(length,last,value);
+      if(result.ec!=std::errc()) return {first,result.ec};
+      position=result.ptr;
+   }
+   position=Detail::skipLiteral(position,last,")");
+   if(position==nullptr) return failure;
+   vector=BasicVector3D<T>(values[0],values[1],values[2]);
+   return {position,std::errc()};
+}
+
+template<class T>
+std::string Vector3DText::toString(const BasicVector3D<T> &vector, Format format)
+{
+   std::string text(64,'\0');
+   while(true)
+   {
+      std::to_chars_result result=toChars(text.data(),text.data()+text.size(),vector,format);
+      if(result.ec==std::errc())
+      {
+         text.resize(static_cast<std::size_t>(result.ptr-text.data()));
+         return text;
+      }
+      text.resize(text.size()*4);
+   }
+}
+
+#endif // VECTOR3DTEXT_H
@@ -0,0 +1,301 @@
+#include "vector3dweld.h"
+#include "vector3dradixsort.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace
+{
+   /**
+    * @brief Unresolved vectors are welded but wait for the final state of a lower match to pick their representative
+    */
+   enum State : std::uint8_t {Undecided,Representative,Welded,Unresolved};
+
+   constexpr std::size_t npos=std::numeric_limits<std::size_t>::max();
+
+   /**
+    * @brief Buckets of vector indices hashed by cell. Cells are eight times the tolerance wide, so the matches of a vector
+    * lie in at most two cells per axis and in one cell per axis three times out of four. Cell ranges come from the rounded bounds x-tolerance and x+tolerance:
+    * rounding is monotonic, so the cell of any match falls inside them whatever the magnitude.
+    */
+   class Grid
+   {
+      public:
+         /**
+          * @brief Bucket entries carry a copy of their vector, so scanning a bucket reads one contiguous run
+          */
+         struct Entry
+         {
+            Vector3D vector;
+            std::size_t index;
+         };
+
+         Grid(const Vector3DExecution &execution, const Vector3DArrayConstView &vectors, double tolerance);
+
+         std::size_t size() const;
+         std::size_t finiteSize() const;
+         const Entry &entry(std::size_t position) const;
+
+         template<class Function>
+         void forEachMatch(const Entry &entry, Function function) const;
+
+      private:
+         double pTolerance;
+         double pInverse;
+         std::size_t pMask;
+         std::vector<std::size_t> pOffsets;
+         std::vector<Entry> pEntries;
+
+         double cell(double value) const;
+         std::size_t bucket(double cx, double cy, double cz) const;
+         std::size_t bucket(const Vector3D &vector) const;
+   };
+
+   bool isFinite(const Vector3D &vector)
+   {
+      return std::isfinite(vector.x()) && std::isfinite(vector.y()) && std::isfinite(vector.z());
+   }
+
+   bool isMatch(const Vector3D &vector1, const Vector3D &vector2, double tolerance)
+   {
+      return std::fabs(vector1.x()-vector2.x())<tolerance && std::fabs(vector1.y()-vector2.y())<tolerance && std::fabs(vector1.z()-vector2.z())<tolerance;
+   }
+
+   /**
+    * @brief The next cell coordinate, stepping by representable values where cells are wider than one and ending after infinity
+    */
+   double nextCell(double cell)
+   {
+      if(cell==std::numeric_limits<double>::infinity()) return std::numeric_limits<double>::quiet_NaN();
+      double next=cell+1.0;
+      return next>cell ? next : std::nextafter(cell,std::numeric_limits<double>::infinity());
+   }
+
+   struct Key
+   {
+      std::size_t bucket;
+      std::size_t index;
+   };
+
+   // Subnormal tolerances would overflow the inverse to infinity and every cell range to [-inf,inf],
+   // clamped cells are wider than eight tolerances but still hold every match
+   Grid::Grid(const Vector3DExecution &execution, const Vector3DArrayConstView &vectors, double tolerance) : pTolerance(tolerance), pInverse(std::min(0.125/tolerance,std::numeric_limits<double>::max()))
+   {
+      std::size_t size=vectors.size();
+      pMask=std::bit_ceil(std::max<std::size_t>(size,1))-1;
+      // Vectors that are not finite go to bucket pMask+1, past every bucket a lookup reaches
+      std::vector<Key> keys(size);
+      execution.forEachRange(size,[&](std::size_t offset, std::size_t count)
+      {
+         for(std::size_t i=offset;i<offset+count;i++)
+         {
+            Vector3D vector=vectors[i];
+            keys[i]={isFinite(vector) ? bucket(vector) : pMask+1,i};
+         }
+      });
+      Vector3DRadixSort::sort(execution,keys,&Key::bucket,static_cast<unsigned>(std::bit_width(pMask+1)));
+
+      pOffsets.resize(pMask+2);
+      pEntries.resize(size);
+      execution.forEachRange(size,[&](std::size_t offset, std::size_t count)
+      {
+         for(std::size_t k=offset;k<offset+count;k++)
+         {
+            std::size_t first=k==0 ? 0 : keys[k-1].bucket+1;
+            for(std::size_t b=first;b<=keys[k].bucket && b<=pMask+1;b++) pOffsets[b]=k;
+            pEntries[k]={vectors[keys[k].index],keys[k].index};
+         }
+      });
+      for(std::size_t b=size==0 ? 0 : keys.back().bucket+1;b<=pMask+1;b++) pOffsets[b]=size;
+   }
+
+   inline std::size_t Grid::size() const
+   {
+      return pEntries.size();
+   }
+
+   /**
+    * @brief Entries are sorted by bucket, the finite vectors come first
+    */
+   inline std::size_t Grid::finiteSize() const
+   {
+      return pOffsets[pMask+1];
+   }
+
+   inline const Grid::Entry &Grid::entry(std::size_t position) const
+   {
+      return pEntries[position];
+   }
+
+   /**
+    * @brief Calls function(j) for every vector j with a lower index than entry matching it, in no particular order
+    */
+   template<class Function>
+   void Grid::forEachMatch(const Entry &entry, Function function) const
+   {
+      const Vector3D &vector=entry.vector;
+      double lowX=cell(vector.x()-pTolerance),highX=cell(vector.x()+pTolerance);
+      double lowY=cell(vector.y()-pTolerance),highY=cell(vector.y()+pTolerance);
+      double lowZ=cell(vector.z()-pTolerance),highZ=cell(vector.z()+pTolerance);
+      for(double cx=lowX;cx<=highX;cx=nextCell(cx))
+      {
+         for(double cy=lowY;cy<=highY;cy=nextCell(cy))
+         {
+            for(double cz=lowZ;cz<=highZ;cz=nextCell(cz))
+            {
+               std::size_t b=bucket(cx,cy,cz);
+               for(std::size_t k=pOffsets[b];k<pOffsets[b+1];k++)
+               {
+                  const Entry &other=pEntries[k];
+                  if(other.index<entry.index && isMatch(other.vector,vector,pTolerance)) function(other.index);
+               }
+            }
+         }
+      }
+   }
+
+   inline double Grid::cell(double value) const
+   {
+      return std::floor(value*pInverse)+0.0;
+   }
+
+   /**
+    * @brief Hashes the 2x2x2 block holding the cell and puts the eight cells of a block in consecutive buckets,
+    * so the neighbor cells of a vector mostly share the cache lines of its own bucket
+    */
+   inline std::size_t Grid::bucket(double cx, double cy, double cz) const
+   {
+      double bx=std::floor(cx*0.5)+0.0,by=std::floor(cy*0.5)+0.0,bz=std::floor(cz*0.5)+0.0;
+      std::uint64_t hash=std::bit_cast<std::uint64_t>(bx)*0x9E3779B97F4A7C15ull;
+      hash^=std::bit_cast<std::uint64_t>(by)*0xC2B2AE3D27D4EB4Full;
+      hash^=std::bit_cast<std::uint64_t>(bz)*0x165667B19E3779F9ull;
+      hash^=hash>>29;
+      hash*=0xBF58476D1CE4E5B9ull;
+      hash^=hash>>32;
+      std::uint64_t position=(cx>2.0*bx ? 4u : 0u)|(cy>2.0*by ? 2u : 0u)|(cz>2.0*bz ? 1u : 0u);
+      return static_cast<std::size_t>((hash<<3)|position)&pMask;
+   }
+
+   inline std::size_t Grid::bucket(const Vector3D &vector) const
+   {
+      return bucket(cell(vector.x()),cell(vector.y()),cell(vector.z()));
+   }
+
+   /**
+    * @brief Decides the vector of entry from the states of its earlier matches: welded as soon as one of them is a representative,
+    * a representative once all of them are welded. Decided states are final, so reading them while other threads write is safe.
+    */
+   void decide(const Grid &grid, const Grid::Entry &entry, std::atomic<std::uint8_t> *states, std::size_t *representatives)
+   {
+      bool pending=false;
+      std::size_t target=npos;
+      grid.forEachMatch(entry,[&](std::size_t j)
+      {
+         std::uint8_t state=states[j].load(std::memory_order_acquire);
+         if(state==Representative) target=std::min(target,j);
+         pending=pending || state==Undecided;
+      });
+      if(target==npos)
+      {
+         if(pending) return;
+         representatives[entry.index]=entry.index;
+         states[entry.index].store(Representative,std::memory_order_release);
+      } else
+      {
+         representatives[entry.index]=target;
+         states[entry.index].store(pending ? Unresolved : Welded,std::memory_order_release);
+      }
+   }
+}
+
+bool Vector3DWeld::representatives(Vector3DArrayConstView vectors, std::span<std::size_t> representatives, double tolerance)
+{
+   return Vector3DWeld::representatives(Vector3DExecution::sequential(),vectors,representatives,tolerance);
+}
+
+bool Vector3DWeld::representatives(const Vector3DExecution &execution, Vector3DArrayConstView vectors, std::span<std::size_t> representatives, double tolerance)
+{
+   if(vectors.size()!=representatives.size() || !(tolerance>0.0 && tolerance<std::numeric_limits<double>::infinity())) return false;
+   Grid grid(execution,vectors,tolerance);
+   std::unique_ptr<std::atomic<std::uint8_t>[]> states(new std::atomic<std::uint8_t>[vectors.size()]());
+   for(std::size_t position=grid.finiteSize();position<grid.size();position++)
+   {
+      std::size_t index=grid.entry(position).index;
+      representatives[index]=index;
+      states[index].store(Representative,std::memory_order_relaxed);
+   }
+
+   // Rounds visit the vectors in grid order, so the bucket scans of neighbors share cache lines. Buckets list their
+   // vectors in index order, so a cluster inside one bucket settles in one round. Rounds repeat while they halve
+   // the backlog, a last round in index order settles the rest.
+   std::vector<std::size_t> pending(grid.finiteSize()),unresolved;
+   for(std::size_t position=0;position<pending.size();position++) pending[position]=position;
+   while(!pending.empty())
+   {
+      std::size_t before=pending.size();
+      execution.forEachRange(before,[&](std::size_t offset, std::size_t count)
+      {
+         for(std::size_t k=offset;k<offset+count;k++) decide(grid,grid.entry(pending[k]),states.get(),representatives.data());
+      });
+      std::size_t kept=0;
+      for(std::size_t position : pending)
+      {
+         std::uint8_t state=states[grid.entry(position).index].load(std::memory_order_relaxed);
+         if(state==Undecided) pending[kept++]=position;
+         else if(state==Unresolved) unresolved.push_back(position);
+      }
+      pending.resize(kept);
+      if(kept*2>before)
+      {
+         std::sort(pending.begin(),pending.end(),[&](std::size_t position1, std::size_t position2) { return grid.entry(position1).index<grid.entry(position2).index; });
+         for(std::size_t position : pending) decide(grid,grid.entry(position),states.get(),representatives.data());
+         break;
+      }
+   }
+
+   execution.forEachRange(unresolved.size(),[&](std::size_t offset, std::size_t count)
+   {
+      for(std::size_t k=offset;k<offset+count;k++)
+      {
+         const Grid::Entry &entry=grid.entry(unresolved[k]);
+         grid.forEachMatch(entry,[&](std::size_t j)
+         {
+            if(states[j].load(std::memory_order_relaxed)==Representative) representatives[entry.index]=std::min(representatives[entry.index],j);
+         });
+      }
+   });
+   return true;
+}
+
+bool Vector3DWeld::weld(Vector3DArrayConstView vectors, std::span<std::size_t> remap, Vector3DArray &unique, double tolerance)
+{
+   return weld(Vector3DExecution::sequential(),vectors,remap,unique,tolerance);
+}
+
+bool Vector3DWeld::weld(const Vector3DExecution &execution, Vector3DArrayConstView vectors, std::span<std::size_t> remap, Vector3DArray &unique, double tolerance)
+{
+   if(!representatives(execution,vectors,remap,tolerance)) return false;
+   std::size_t count=0;
+   for(std::size_t i=0;i<remap.size();i++) count+=remap[i]==i ? 1 : 0;
+   unique.resize(count);
+   count=0;
+   for(std::size_t i=0;i<remap.size();i++)
+   {
+      if(remap[i]==i)
+      {
+         unique.set(count,vectors[i]);
+         remap[i]=count++;
+      } else
+      {
+         remap[i]=remap[remap[i]];
+      }
+   }
+   return true;
+}
@@ -0,0 +1,34 @@
+#ifndef VECTOR3DWELD_H
+#define VECTOR3DWELD_H
+
+#include "vector3d.h"
+#include "vector3darray.h"
+#include "vector3dexecution.h"
+
+#include <cstddef>
+#include <span>
+
+/**
+ * @brief Vertex welding over a spatial hash. Two vectors match when every component differs by less than
+ * tolerance, the Vector3D operator== rule with tolerance in place of epsilon. Vectors are visited in index
+ * order: a vector matching an earlier representative is welded to the lowest-indexed one, any other vector
+ * becomes a representative itself, so no vector moves by tolerance or more. Vectors with a NaN or infinite
+ * component are never welded. Results do not depend on the policy.
+ * Functions return false, without touching the output, when the sizes do not match or tolerance is not positive and finite.
+ */
+namespace Vector3DWeld
+{
+   /**
+    * @brief Stores in representatives[i] the index of the representative vector i is welded to, i itself for representatives
+    */
+   bool representatives(Vector3DArrayConstView vectors, std::span<std::size_t> representatives, double tolerance=Vector3D::Traits::epsilon);
+   bool representatives(const Vector3DExecution &execution, Vector3DArrayConstView vectors, std::span<std::size_t> representatives, double tolerance=Vector3D::Traits::epsilon);
+
+   /**
+    * @brief Replaces unique with the representatives in index order and stores in remap[i] the position of the one vector i is welded to
+    */
+   bool weld(Vector3DArrayConstView vectors, std::span<std::size_t> remap, Vector3DArray &unique, double tolerance=Vector3D::Traits::epsilon);
+   bool weld(const Vector3DExecution &execution, Vector3DArrayConstView vectors, std::span<std::size_t> remap, Vector3DArray &unique, double tolerance=Vector3D::Traits::epsilon);
+}
+
+#endif // VECTOR3DWELD_H